@@ -0,0 +1,80 @@
+#include "bench_common.hpp"
+
+#include <stdio.h>
+#include <time.h>
+
+#include "host_test_common.hpp"
+#include "test_wifi_manager_accessor.hpp"
+#include "wifi_manager.hpp"
+
+int64_t bench_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static int64_t bench_esp_timer_get_time(int /* cmock_num_calls */)
+{
+    return bench_now_us();
+}
+
+static esp_err_t bench_esp_wifi_start(int /* cmock_num_calls */)
+{
+    WiFiManagerTestAccessor accessor(WiFiManager::get_instance());
+    accessor.test_simulate_wifi_event(WIFI_EVENT_STA_START);
+    return ESP_OK;
+}
+
+static esp_err_t bench_esp_wifi_stop(int /* cmock_num_calls */)
+{
+    WiFiManagerTestAccessor accessor(WiFiManager::get_instance());
+    accessor.test_simulate_wifi_event(WIFI_EVENT_STA_STOP);
+    return ESP_OK;
+}
+
+static esp_err_t bench_esp_wifi_connect(int /* cmock_num_calls */)
+{
+    WiFiManagerTestAccessor accessor(WiFiManager::get_instance());
+    accessor.test_simulate_wifi_event(WIFI_EVENT_STA_CONNECTED);
+    accessor.test_simulate_ip_event(IP_EVENT_STA_GOT_IP);
+    return ESP_OK;
+}
+
+static esp_err_t bench_esp_wifi_disconnect(int /* cmock_num_calls */)
+{
+    WiFiManagerTestAccessor accessor(WiFiManager::get_instance());
+    accessor.test_simulate_disconnect(WIFI_REASON_ASSOC_LEAVE);
+    return ESP_OK;
+}
+
+void bench_setup_mocks(void)
+{
+    host_test_setup_common_mocks();
+
+    esp_timer_get_time_Stub(bench_esp_timer_get_time);
+    esp_wifi_start_Stub(bench_esp_wifi_start);
+    esp_wifi_stop_Stub(bench_esp_wifi_stop);
+    esp_wifi_connect_Stub(bench_esp_wifi_connect);
+    esp_wifi_disconnect_Stub(bench_esp_wifi_disconnect);
+}
+
+void bench_report(const char *name, const char *unit, double value)
+{
+    printf("BENCH {\"name\":\"%s\",\"unit\":\"%s\",\"value\":%.3f}\n", name, unit, value);
+}
+
+void bench_print_latency(const char *name, const wifi_manager::LatencyStats &stats)
+{
+    unsigned long long avg = stats.count ? stats.total_us / stats.count : 0;
+    printf("BENCH {\"name\":\"%s\",\"unit\":\"us\",\"count\":%lu,\"avg\":%llu,\"min\":%lu,\"max\":%lu,\"hist\":{", name,
+           (unsigned long)stats.count, avg, (unsigned long)stats.min_us, (unsigned long)stats.max_us);
+    const char *sep = "";
+    for (uint8_t i = 0; i < wifi_manager::LATENCY_BUCKETS; i++) {
+        if (stats.histogram[i] != 0) {
+            printf("%s\"%u\":%lu", sep, i, (unsigned long)stats.histogram[i]);
+            sep = ",";
+        }
+    }
+    printf("}}\n");
+}
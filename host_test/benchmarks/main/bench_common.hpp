@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include "wifi_types.hpp"
+
+/**
+ * @file bench_common.hpp
+ * @brief Shared helpers for the host benchmark suite.
+ */
+
+/**
+ * @brief Monotonic wall clock in microseconds (independent of the esp_timer mock).
+ */
+int64_t bench_now_us(void);
+
+/**
+ * @brief Install the common mocks plus a real-time esp_timer and event-simulating
+ *        driver stubs, so the manager runs its full message flow on the host.
+ */
+void bench_setup_mocks(void);
+
+/*
+ * Every measurement is printed as one line: "BENCH " followed by a JSON object with at
+ * least "name", "unit" and the value(s). pytest_host_tests.py collects them into
+ * build/bench_results.jsonl so runs can be diffed between releases.
+ */
+
+/**
+ * @brief Print a scalar measurement as a BENCH line.
+ */
+void bench_report(const char *name, const char *unit, double value);
+
+/**
+ * @brief Print a latency series as a single BENCH line (avg/min/max and non-empty buckets).
+ */
+void bench_print_latency(const char *name, const wifi_manager::LatencyStats &stats);
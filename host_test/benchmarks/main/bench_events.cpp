@@ -0,0 +1,73 @@
+#include <stdio.h>
+
+#include "nvs_flash.h"
+#include "unity.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "bench_common.hpp"
+#include "test_wifi_manager_accessor.hpp"
+#include "wifi_manager.hpp"
+
+static constexpr int EVENT_ITERATIONS = 200;
+
+TEST_CASE("Bench: event post to dequeue latency", "[bench][events]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    TEST_ASSERT_EQUAL(ESP_OK, wm.init());
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(1000));
+    WiFiManagerTestAccessor accessor(wm);
+
+    wm.reset_metrics();
+    for (int i = 0; i < EVENT_ITERATIONS; i++) {
+        // STA_CONNECTED while STARTED is a no-op transition: pure delivery cost
+        accessor.test_simulate_wifi_event(WIFI_EVENT_STA_CONNECTED);
+        while (wm.get_event_latency().count <= (uint32_t)i) {
+            vTaskDelay(1);
+        }
+    }
+
+    wifi_manager::LatencyStats stats = wm.get_event_latency();
+    TEST_ASSERT_EQUAL(EVENT_ITERATIONS, stats.count);
+    bench_print_latency("events.post_to_dequeue_us", stats);
+
+    wifi_manager::DispatchMetrics metrics = wm.get_metrics();
+    bench_print_latency("events.dispatch_us", metrics.dispatch[(int)wifi_manager::MessageType::EVENT]);
+    bench_print_latency("events.exec_us", metrics.event_exec);
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+TEST_CASE("Bench: command dwell and handler time", "[bench][events]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    TEST_ASSERT_EQUAL(ESP_OK, wm.init());
+    wm.set_credentials("BenchSSID", "pass");
+    wm.reset_metrics();
+
+    for (int i = 0; i < EVENT_ITERATIONS / 10; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, wm.start(1000));
+        TEST_ASSERT_EQUAL(ESP_OK, wm.connect(1000));
+        TEST_ASSERT_EQUAL(ESP_OK, wm.stop(1000));
+    }
+
+    wifi_manager::DispatchMetrics metrics = wm.get_metrics();
+    bench_print_latency("commands.dwell_us", metrics.dwell[(int)wifi_manager::MessageType::COMMAND]);
+    bench_print_latency("commands.dispatch_us", metrics.dispatch[(int)wifi_manager::MessageType::COMMAND]);
+    bench_print_latency("commands.start_exec_us", metrics.command_exec[(int)wifi_manager::CommandId::START]);
+    bench_print_latency("commands.connect_exec_us", metrics.command_exec[(int)wifi_manager::CommandId::CONNECT]);
+    bench_print_latency("commands.stop_exec_us", metrics.command_exec[(int)wifi_manager::CommandId::STOP]);
+    TEST_ASSERT_EQUAL(EVENT_ITERATIONS / 10, metrics.command_exec[(int)wifi_manager::CommandId::CONNECT].count);
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
@@ -0,0 +1,70 @@
+#include <stdio.h>
+
+#include "unity.h"
+
+#include "bench_common.hpp"
+#include "wifi_state_machine.hpp"
+
+using namespace wifi_manager;
+
+static constexpr int FSM_ROUNDS = 20000;
+
+// Keeps the lookups from being optimized away
+static volatile uint32_t s_sink;
+
+static void report_rate(const char *name, int64_t elapsed_us, uint32_t ops)
+{
+    char metric[64];
+    snprintf(metric, sizeof(metric), "%s.ns_per_op", name);
+    bench_report(metric, "ns", (double)elapsed_us * 1000.0 / ops);
+    snprintf(metric, sizeof(metric), "%s.ops_per_s", name);
+    bench_report(metric, "ops/s", elapsed_us ? (double)ops * 1000000.0 / elapsed_us : 0.0);
+}
+
+TEST_CASE("Bench: validate_command throughput", "[bench][fsm]")
+{
+    WiFiStateMachine fsm;
+    uint32_t ops = 0;
+    uint32_t acc = 0;
+
+    // Every (state, command) cell of the matrix, round robin
+    int64_t t0 = bench_now_us();
+    for (int round = 0; round < FSM_ROUNDS; round++) {
+        for (int s = 0; s < (int)State::COUNT; s++) {
+            fsm.transition_to((State)s);
+            for (int c = 0; c < (int)CommandId::COUNT; c++) {
+                acc += (uint32_t)fsm.validate_command((CommandId)c);
+                ops++;
+            }
+        }
+    }
+    int64_t elapsed = bench_now_us() - t0;
+    s_sink          = acc;
+
+    report_rate("fsm.validate_command", elapsed, ops);
+    TEST_ASSERT_EQUAL(FSM_ROUNDS * (int)State::COUNT * (int)CommandId::COUNT, ops);
+}
+
+TEST_CASE("Bench: resolve_event throughput", "[bench][fsm]")
+{
+    WiFiStateMachine fsm;
+    uint32_t ops = 0;
+    uint32_t acc = 0;
+
+    int64_t t0 = bench_now_us();
+    for (int round = 0; round < FSM_ROUNDS; round++) {
+        for (int s = 0; s < (int)State::COUNT; s++) {
+            fsm.transition_to((State)s);
+            for (int e = 0; e < (int)EventId::COUNT; e++) {
+                WiFiStateMachine::EventOutcome outcome = fsm.resolve_event((EventId)e);
+                acc += (uint32_t)outcome.next_state + outcome.bits_to_set;
+                ops++;
+            }
+        }
+    }
+    int64_t elapsed = bench_now_us() - t0;
+    s_sink          = acc;
+
+    report_rate("fsm.resolve_event", elapsed, ops);
+    TEST_ASSERT_EQUAL(FSM_ROUNDS * (int)State::COUNT * (int)EventId::COUNT, ops);
+}
@@ -0,0 +1,106 @@
+#include "nvs_flash.h"
+#include "unity.h"
+
+#include "bench_common.hpp"
+#include "wifi_manager.hpp"
+
+void setUp(void)
+{
+    bench_setup_mocks();
+}
+
+void tearDown(void)
+{
+}
+
+static constexpr int CYCLE_ITERATIONS = 50;
+
+TEST_CASE("Bench: init/deinit cycle", "[bench][lifecycle]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+
+    int64_t init_total   = 0;
+    int64_t deinit_total = 0;
+
+    for (int i = 0; i < CYCLE_ITERATIONS; i++) {
+        int64_t t0 = bench_now_us();
+        TEST_ASSERT_EQUAL(ESP_OK, wm.init());
+        int64_t t1 = bench_now_us();
+        TEST_ASSERT_EQUAL(ESP_OK, wm.deinit());
+        int64_t t2 = bench_now_us();
+
+        init_total += t1 - t0;
+        deinit_total += t2 - t1;
+    }
+
+    // deinit() used to poll the task handle every 10 ms and then sleep another 50 ms: a
+    // deinit_us close to that floor means the join on wifi_task's exit regressed. Reported
+    // rather than asserted, host scheduling makes any fixed bound flaky.
+    bench_report("lifecycle.init_us", "us", (double)(init_total / CYCLE_ITERATIONS));
+    bench_report("lifecycle.deinit_us", "us", (double)(deinit_total / CYCLE_ITERATIONS));
+    bench_report("lifecycle.cycle_us", "us", (double)((init_total + deinit_total) / CYCLE_ITERATIONS));
+    nvs_flash_deinit();
+}
+
+TEST_CASE("Bench: started init/deinit cycle", "[bench][lifecycle]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+
+    int64_t cycle_total = 0;
+
+    for (int i = 0; i < CYCLE_ITERATIONS; i++) {
+        int64_t t0 = bench_now_us();
+        TEST_ASSERT_EQUAL(ESP_OK, wm.init());
+        TEST_ASSERT_EQUAL(ESP_OK, wm.start(1000));
+        TEST_ASSERT_EQUAL(ESP_OK, wm.deinit());
+        cycle_total += bench_now_us() - t0;
+    }
+
+    bench_report("lifecycle.started_cycle_us", "us", (double)(cycle_total / CYCLE_ITERATIONS));
+    nvs_flash_deinit();
+}
+
+TEST_CASE("Bench: provisioning round trips vs transaction", "[bench][lifecycle]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    TEST_ASSERT_EQUAL(ESP_OK, wm.init());
+
+    int64_t separate_total = 0;
+    int64_t txn_total      = 0;
+
+    for (int i = 0; i < CYCLE_ITERATIONS; i++) {
+        int64_t t0 = bench_now_us();
+        TEST_ASSERT_EQUAL(ESP_OK, wm.set_credentials("BenchSSID", "pass"));
+        TEST_ASSERT_EQUAL(ESP_OK, wm.start(1000));
+        TEST_ASSERT_EQUAL(ESP_OK, wm.connect(1000));
+        separate_total += bench_now_us() - t0;
+        TEST_ASSERT_EQUAL(ESP_OK, wm.stop(1000));
+
+        WiFiManager::Transaction txn = {};
+        txn.add_credentials("BenchSSID", "pass");
+        txn.add(WiFiManager::Transaction::Step::START);
+        txn.add(WiFiManager::Transaction::Step::CONNECT);
+        int64_t t1 = bench_now_us();
+        TEST_ASSERT_EQUAL(ESP_OK, wm.run_transaction(txn, 1000));
+        txn_total += bench_now_us() - t1;
+        TEST_ASSERT_EQUAL(ESP_OK, wm.stop(1000));
+    }
+
+    bench_report("provisioning.separate_us", "us", (double)(separate_total / CYCLE_ITERATIONS));
+    bench_report("provisioning.transaction_us", "us", (double)(txn_total / CYCLE_ITERATIONS));
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
@@ -0,0 +1,44 @@
+#include <stdio.h>
+
+#include "unity.h"
+
+#include "bench_common.hpp"
+#include "wifi_log_ring.hpp"
+
+using namespace wifi_manager;
+
+static constexpr int LOG_ROUNDS = 20000;
+
+// Keeps the formatted lines from being optimized away
+static volatile size_t s_sink;
+
+TEST_CASE("Bench: deferred record vs formatted line", "[bench][log]")
+{
+    LogRecord storage[64];
+    WiFiLogRing ring(storage, 64, 0, 1);
+    LogRecord record;
+    char line[128];
+    size_t acc = 0;
+
+    // What wifi_task pays per disconnect with CONFIG_WIFI_MANAGER_DEFERRED_LOG: one record
+    int64_t t0 = bench_now_us();
+    for (int i = 0; i < LOG_ROUNDS; i++) {
+        bool was_empty;
+        ring.write(i, LogId::STA_DISCONNECTED, 201, -70 - (i & 15), 0, was_empty);
+        ring.read(record);
+    }
+    int64_t elapsed = bench_now_us() - t0;
+    bench_report("log.record_write_read_ns", "ns", (double)elapsed * 1000.0 / LOG_ROUNDS);
+
+    // Formatting the same line on the spot (console output excluded)
+    t0 = bench_now_us();
+    for (int i = 0; i < LOG_ROUNDS; i++) {
+        record = {(uint32_t)i, LogId::STA_DISCONNECTED, {201, -70 - (i & 15), 0}};
+        acc += format_record(record, line, sizeof(line));
+    }
+    elapsed = bench_now_us() - t0;
+    s_sink  = acc;
+    bench_report("log.format_line_ns", "ns", (double)elapsed * 1000.0 / LOG_ROUNDS);
+
+    TEST_ASSERT_EQUAL_UINT32(LOG_ROUNDS, ring.stats().written);
+}
@@ -0,0 +1,134 @@
+#include "nvs_flash.h"
+#include "unity.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "bench_common.hpp"
+#include "test_wifi_manager_accessor.hpp"
+#include "wifi_manager.hpp"
+#include "wifi_sync_manager.hpp"
+
+static constexpr int QUEUE_ITERATIONS = 2000;
+static constexpr int ROUND_TRIPS      = 100;
+static constexpr int STORM_EVENTS     = 1000;
+
+TEST_CASE("Bench: WiFiSyncManager post to drain", "[bench][sync]")
+{
+    wifi_manager::WiFiSyncManager sync;
+    TEST_ASSERT_EQUAL(ESP_OK, sync.init());
+
+    wifi_manager::Message msg = {};
+    msg.type                  = wifi_manager::MessageType::EVENT;
+    msg.event                 = wifi_manager::EventId::STA_CONNECTED;
+    wifi_manager::Message batch[wifi_manager::WiFiSyncManager::QUEUE_SIZE];
+    wifi_manager::LatencyStats single = {};
+
+    // Queue cost alone: no task switch, one message per drain
+    for (int i = 0; i < QUEUE_ITERATIONS; i++) {
+        int64_t t0 = bench_now_us();
+        TEST_ASSERT_EQUAL(ESP_OK, sync.post_message(msg));
+        TEST_ASSERT_EQUAL(1, sync.drain(batch, wifi_manager::WiFiSyncManager::QUEUE_SIZE));
+        single.record((uint32_t)(bench_now_us() - t0));
+    }
+    bench_print_latency("sync.post_drain_us", single);
+
+    // Full batches: what wifi_task sees under load
+    int64_t t0 = bench_now_us();
+    for (int i = 0; i < QUEUE_ITERATIONS / wifi_manager::WiFiSyncManager::QUEUE_SIZE; i++) {
+        for (size_t n = 0; n < wifi_manager::WiFiSyncManager::QUEUE_SIZE; n++) {
+            sync.post_message(msg);
+        }
+        TEST_ASSERT_EQUAL(wifi_manager::WiFiSyncManager::QUEUE_SIZE,
+                          sync.drain(batch, wifi_manager::WiFiSyncManager::QUEUE_SIZE));
+    }
+    int64_t elapsed = bench_now_us() - t0;
+    bench_report("sync.batched_msg_ns", "ns", (double)elapsed * 1000.0 / QUEUE_ITERATIONS);
+
+    sync.deinit();
+}
+
+TEST_CASE("Bench: sync API round trip", "[bench][sync]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    TEST_ASSERT_EQUAL(ESP_OK, wm.init());
+    wm.set_credentials("BenchSSID", "pass");
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(1000));
+
+    wifi_manager::LatencyStats connect    = {};
+    wifi_manager::LatencyStats disconnect = {};
+    wifi_manager::LatencyStats skipped    = {};
+
+    for (int i = 0; i < ROUND_TRIPS; i++) {
+        int64_t t0 = bench_now_us();
+        TEST_ASSERT_EQUAL(ESP_OK, wm.connect(1000));
+        int64_t t1 = bench_now_us();
+        // Already connected: validated and answered without reaching the queue
+        TEST_ASSERT_EQUAL(ESP_OK, wm.connect(1000));
+        int64_t t2 = bench_now_us();
+        TEST_ASSERT_EQUAL(ESP_OK, wm.disconnect(1000));
+        int64_t t3 = bench_now_us();
+
+        connect.record((uint32_t)(t1 - t0));
+        skipped.record((uint32_t)(t2 - t1));
+        disconnect.record((uint32_t)(t3 - t2));
+    }
+
+    bench_print_latency("api.connect_us", connect);
+    bench_print_latency("api.connect_skipped_us", skipped);
+    bench_print_latency("api.disconnect_us", disconnect);
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+TEST_CASE("Bench: event storm", "[bench][sync]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    TEST_ASSERT_EQUAL(ESP_OK, wm.init());
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(1000));
+    WiFiManagerTestAccessor accessor(wm);
+
+    // Back-to-back events as the driver would post them; the handler drops on a full queue
+    wm.reset_metrics();
+    int64_t t0 = bench_now_us();
+    for (int i = 0; i < STORM_EVENTS; i++) {
+        accessor.test_simulate_wifi_event(WIFI_EVENT_STA_CONNECTED);
+    }
+    int64_t posted_us = bench_now_us() - t0;
+
+    // Wait until the queue went quiet (10 ms resolution)
+    uint32_t processed       = 0;
+    int64_t last_progress_us = bench_now_us();
+    for (int idle = 0; idle < 10; idle++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        uint32_t count = wm.get_event_latency().count;
+        if (count != processed) {
+            processed        = count;
+            last_progress_us = bench_now_us();
+            idle             = 0;
+        }
+    }
+    int64_t handled_us = last_progress_us - t0;
+
+    bench_report("storm.post_ns_per_event", "ns", (double)posted_us * 1000.0 / STORM_EVENTS);
+    bench_report("storm.processed", "events", (double)processed);
+    bench_report("storm.dropped", "events", (double)(STORM_EVENTS - processed));
+    bench_report("storm.handled_per_s", "events/s", handled_us ? (double)processed * 1000000.0 / handled_us : 0.0);
+    bench_print_latency("storm.post_to_dequeue_us", wm.get_event_latency());
+    bench_print_latency("storm.exec_us", wm.get_metrics().event_exec);
+
+    TEST_ASSERT_TRUE(processed > 0);
+    TEST_ASSERT_TRUE(processed <= (uint32_t)STORM_EVENTS);
+    TEST_ASSERT_EQUAL(WiFiManager::State::STARTED, wm.get_state());
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
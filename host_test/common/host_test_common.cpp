@@ -1,8 +1,14 @@
 #include "host_test_common.hpp"
+#include "esp_idf_version.h"
 #include <string.h>
 
 wifi_config_t g_host_test_wifi_config;
 bool g_host_test_auto_simulate_events = true;
+int8_t g_host_test_rssi = -50;
+uint8_t g_host_test_bssid[6];
+wifi_ap_record_t g_host_test_scan[HOST_TEST_SCAN_MAX];
+uint16_t g_host_test_scan_count;
+esp_netif_t* g_host_test_default_netif;
 
 // Define event bases
 ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
@@ -22,6 +28,49 @@ static esp_err_t stub_esp_wifi_get_config(wifi_interface_t interface, wifi_confi
     return ESP_OK;
 }
 
+// Driver defaults of an ESP32: 802.11b/g/n at HT20
+static esp_err_t stub_esp_wifi_get_protocol(wifi_interface_t ifx, uint8_t *protocol_bitmap, int cmock_num_calls) {
+    *protocol_bitmap = WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N;
+    return ESP_OK;
+}
+
+static esp_err_t stub_esp_wifi_get_bandwidth(wifi_interface_t ifx, wifi_bandwidth_t *bw, int cmock_num_calls) {
+    *bw = WIFI_BW_HT20;
+    return ESP_OK;
+}
+
+// 19.5 dBm, the ESP32 PHY init default
+static esp_err_t stub_esp_wifi_get_max_tx_power(int8_t *power, int cmock_num_calls) {
+    *power = 78;
+    return ESP_OK;
+}
+
+static esp_err_t stub_esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info, int cmock_num_calls) {
+    memset(ap_info, 0, sizeof(*ap_info));
+    ap_info->rssi = g_host_test_rssi;
+    memcpy(ap_info->bssid, g_host_test_bssid, sizeof(ap_info->bssid));
+    return ESP_OK;
+}
+
+static esp_err_t stub_esp_wifi_scan_get_ap_records(uint16_t *number, wifi_ap_record_t *ap_records, int cmock_num_calls) {
+    if (*number > g_host_test_scan_count) {
+        *number = g_host_test_scan_count;
+    }
+    memcpy(ap_records, g_host_test_scan, *number * sizeof(wifi_ap_record_t));
+    g_host_test_scan_count = 0; // Read once, like the driver's list
+    return ESP_OK;
+}
+
+// Fake handles: the low byte stands for the lwIP index
+static int stub_esp_netif_get_netif_impl_index(esp_netif_t* esp_netif, int cmock_num_calls) {
+    return (int)((uintptr_t)esp_netif & 0xFF);
+}
+
+static esp_err_t stub_esp_netif_set_default_netif(esp_netif_t* esp_netif, int cmock_num_calls) {
+    g_host_test_default_netif = esp_netif;
+    return ESP_OK;
+}
+
 static esp_err_t stub_esp_wifi_restore(int cmock_num_calls) {
     memset(&g_host_test_wifi_config, 0, sizeof(wifi_config_t));
     return ESP_OK;
@@ -30,6 +79,10 @@ static esp_err_t stub_esp_wifi_restore(int cmock_num_calls) {
 void host_test_setup_common_mocks(void) {
     memset(&g_host_test_wifi_config, 0, sizeof(wifi_config_t));
     g_host_test_auto_simulate_events = true;
+    g_host_test_rssi = -50;
+    memset(g_host_test_bssid, 0, sizeof(g_host_test_bssid));
+    g_host_test_scan_count = 0;
+    g_host_test_default_netif = NULL;
 
     esp_wifi_init_IgnoreAndReturn(ESP_OK);
     esp_wifi_set_mode_IgnoreAndReturn(ESP_OK);
@@ -41,9 +94,26 @@ void host_test_setup_common_mocks(void) {
     esp_wifi_connect_IgnoreAndReturn(ESP_OK);
     esp_wifi_disconnect_IgnoreAndReturn(ESP_OK);
     esp_wifi_deinit_IgnoreAndReturn(ESP_OK);
+    esp_wifi_set_country_IgnoreAndReturn(ESP_OK);
+    esp_wifi_get_protocol_Stub(stub_esp_wifi_get_protocol);
+    esp_wifi_get_bandwidth_Stub(stub_esp_wifi_get_bandwidth);
+    esp_wifi_set_protocol_IgnoreAndReturn(ESP_OK);
+    esp_wifi_set_bandwidth_IgnoreAndReturn(ESP_OK);
+    esp_wifi_set_max_tx_power_IgnoreAndReturn(ESP_OK);
+    esp_wifi_get_max_tx_power_Stub(stub_esp_wifi_get_max_tx_power);
+    esp_wifi_sta_get_ap_info_Stub(stub_esp_wifi_sta_get_ap_info);
+    esp_wifi_scan_start_IgnoreAndReturn(ESP_OK);
+    esp_wifi_scan_get_ap_records_Stub(stub_esp_wifi_scan_get_ap_records);
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+    esp_wifi_set_scan_parameters_IgnoreAndReturn(ESP_OK);
+#endif
 
     esp_netif_init_IgnoreAndReturn(ESP_OK);
     esp_netif_get_handle_from_ifkey_IgnoreAndReturn(NULL);
+    esp_netif_create_ip6_linklocal_IgnoreAndReturn(ESP_OK);
+    esp_netif_get_ip_info_IgnoreAndReturn(ESP_FAIL); // Other netifs start without an address
+    esp_netif_get_netif_impl_index_Stub(stub_esp_netif_get_netif_impl_index);
+    esp_netif_set_default_netif_Stub(stub_esp_netif_set_default_netif);
 
     esp_event_loop_create_default_IgnoreAndReturn(ESP_OK);
     esp_event_handler_instance_register_IgnoreAndReturn(ESP_OK);
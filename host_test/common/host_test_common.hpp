@@ -39,6 +39,30 @@ extern wifi_config_t g_host_test_wifi_config;
  */
 extern bool g_host_test_auto_simulate_events;
 
+/**
+ * @brief RSSI reported by the esp_wifi_sta_get_ap_info() stub (default -50 dBm).
+ */
+extern int8_t g_host_test_rssi;
+
+/**
+ * @brief BSSID reported by the esp_wifi_sta_get_ap_info() stub (default all zero).
+ */
+extern uint8_t g_host_test_bssid[6];
+
+#define HOST_TEST_SCAN_MAX 8
+
+/**
+ * @brief APs returned once by the esp_wifi_scan_get_ap_records() stub (default none).
+ */
+extern wifi_ap_record_t g_host_test_scan[HOST_TEST_SCAN_MAX];
+extern uint16_t g_host_test_scan_count;
+
+/**
+ * @brief Default netif last set through esp_netif_set_default_netif() (default nullptr).
+ *        The esp_netif_get_netif_impl_index() stub returns the low byte of the handle.
+ */
+extern esp_netif_t* g_host_test_default_netif;
+
 #ifdef __cplusplus
 }
 #endif
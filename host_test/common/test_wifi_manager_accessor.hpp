@@ -143,4 +143,142 @@ public:
     {
         wifi_manager::WiFiEventHandler::ip_event_handler(wifi_manager.sync_manager.get_queue(), IP_EVENT, id, data);
     }
+
+    // === Snapshots (state exploration) ===
+
+    /**
+     * @brief Everything wifi_task changes while handling messages and timers.
+     *
+     * Configuration set through the API (timeouts, TWT, roam and channel settings, uplink
+     * priorities), the metrics and the HAL's caches of driver settings are left out: handling
+     * a message never changes the first, and the others do not decide any transition.
+     */
+    struct Snapshot
+    {
+        WiFiStateMachine state_machine;
+        wifi_manager::WiFiTimerScheduler timers;
+        wifi_manager::WiFiRoamPolicy roam_policy;
+        wifi_manager::WiFiTxPowerController tx_power;
+        wifi_manager::WiFiUplinkArbiter uplinks;
+        wifi_manager::WiFiRetryGuard::Record retry_record;
+        bool storage_valid;
+        bool auto_connect_pending;
+        uint8_t disconnect_echoes;
+        uint32_t boot_backoff_retries;
+        bool roam_scan_pending;
+        bool roam_notice_pending;
+        wifi_manager::RoamCandidate roam_notice_target;
+        uint8_t sta_channel;
+        uint8_t notified_channel;
+        bool notified_pending;
+        uint8_t probe_channel;
+        bool probe_missed;
+        int8_t last_rssi;
+        int8_t wifi_uplink;
+        bool eap_configured;
+        bool eap_session_cached;
+    };
+
+    /**
+     * @brief Capture the manager's state (call with the manager task suspended).
+     */
+    Snapshot test_save_snapshot()
+    {
+        WiFiManager &wm = wifi_manager;
+        return {wm.state_machine, wm.timers, wm.roam_policy, wm.tx_power, wm.uplinks,
+                wifi_manager::WiFiRetryGuard::rtc_record(), wm.storage.is_valid(), wm.auto_connect_pending,
+                wm.disconnect_echoes, wm.boot_backoff_retries, wm.roam_scan_pending, wm.roam_notice_pending,
+                wm.roam_notice_target, wm.sta_channel, wm.notified_channel, wm.notified_pending, wm.probe_channel,
+                wm.probe_missed, wm.last_rssi, wm.wifi_uplink, wm.eap_configured, wm.eap_session_cached};
+    }
+
+    /**
+     * @brief Put the manager back into a captured state (call with the manager task suspended).
+     *
+     * The credentials' valid flag is only written to NVS when it differs.
+     */
+    void test_load_snapshot(const Snapshot &snapshot)
+    {
+        WiFiManager &wm = wifi_manager;
+        xSemaphoreTakeRecursive(wm.state_mutex, portMAX_DELAY);
+        wm.state_machine                           = snapshot.state_machine;
+        wm.timers                                  = snapshot.timers;
+        wm.roam_policy                             = snapshot.roam_policy;
+        wm.tx_power                                = snapshot.tx_power;
+        wm.uplinks                                 = snapshot.uplinks;
+        wifi_manager::WiFiRetryGuard::rtc_record() = snapshot.retry_record;
+        if (wm.storage.is_valid() != snapshot.storage_valid) {
+            wm.storage.save_valid_flag(snapshot.storage_valid);
+        }
+        wm.auto_connect_pending = snapshot.auto_connect_pending;
+        wm.disconnect_echoes    = snapshot.disconnect_echoes;
+        wm.boot_backoff_retries = snapshot.boot_backoff_retries;
+        wm.roam_scan_pending    = snapshot.roam_scan_pending;
+        wm.roam_notice_pending  = snapshot.roam_notice_pending;
+        wm.roam_notice_target   = snapshot.roam_notice_target;
+        wm.sta_channel          = snapshot.sta_channel;
+        wm.notified_channel     = snapshot.notified_channel;
+        wm.notified_pending     = snapshot.notified_pending;
+        wm.probe_channel        = snapshot.probe_channel;
+        wm.probe_missed         = snapshot.probe_missed;
+        wm.last_rssi            = snapshot.last_rssi;
+        wm.wifi_uplink          = snapshot.wifi_uplink;
+        wm.eap_configured       = snapshot.eap_configured;
+        wm.eap_session_cached   = snapshot.eap_session_cached;
+        xSemaphoreGiveRecursive(wm.state_mutex);
+    }
+
+    /**
+     * @brief Run one dequeued message through wifi_task's dispatcher, as a batch of one.
+     * @return false if the message was EXIT.
+     */
+    bool test_dispatch(const wifi_manager::Message &msg)
+    {
+        wifi_manager::Message batch[1] = {msg};
+        xSemaphoreTakeRecursive(wifi_manager.state_mutex, portMAX_DELAY);
+        bool running = wifi_manager.dispatch_batch(batch, 1, msg.timestamp_us);
+        wifi_manager.sync_timers();
+        xSemaphoreGiveRecursive(wifi_manager.state_mutex);
+        return running;
+    }
+
+    /**
+     * @brief Drop a command compacted away by a later one in its batch, as wifi_task does.
+     */
+    void test_supersede(const wifi_manager::Message &msg)
+    {
+        xSemaphoreTakeRecursive(wifi_manager.state_mutex, portMAX_DELAY);
+        wifi_manager.supersede(msg);
+        xSemaphoreGiveRecursive(wifi_manager.state_mutex);
+    }
+
+    /**
+     * @brief Process a message directly, as run_async_init() chains its START.
+     */
+    void test_process_message(const wifi_manager::Message &msg)
+    {
+        xSemaphoreTakeRecursive(wifi_manager.state_mutex, portMAX_DELAY);
+        wifi_manager.process_message(msg, wifi_manager.state_machine.get_current_state());
+        xSemaphoreGiveRecursive(wifi_manager.state_mutex);
+    }
+
+    /**
+     * @brief Expire a timer now, whatever its deadline, as wifi_task does.
+     */
+    void test_fire_timer(wifi_manager::TimerId id)
+    {
+        xSemaphoreTakeRecursive(wifi_manager.state_mutex, portMAX_DELAY);
+        wifi_manager.timers.cancel(id);
+        wifi_manager.handle_timer(id);
+        wifi_manager.sync_timers();
+        xSemaphoreGiveRecursive(wifi_manager.state_mutex);
+    }
+
+    /**
+     * @brief Read and clear the synchronization bits set for API callers.
+     */
+    uint32_t test_take_sync_bits()
+    {
+        return xEventGroupClearBits(wifi_manager.sync_manager.get_event_group(), wifi_manager::ALL_SYNC_BITS);
+    }
 };
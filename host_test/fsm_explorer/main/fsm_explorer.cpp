@@ -0,0 +1,213 @@
+#include "fsm_explorer.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <unordered_map>
+
+using namespace wifi_manager;
+
+namespace fsm_explorer {
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+namespace {
+
+class Explorer
+{
+public:
+    Explorer(const ExploreConfig &config, ExploreResult &result)
+        : m_config(config)
+        , m_result(result)
+    {
+    }
+
+    void run(const FsmModel &root)
+    {
+        if (!visit(root, 0)) {
+            return;
+        }
+        descend(root, 0);
+    }
+
+private:
+    const ExploreConfig &m_config;
+    ExploreResult &m_result;
+    Step m_path[MAX_DEPTH];
+
+    // Steps left when a configuration was last explored from (liveness is checked on first sight)
+    std::unordered_map<uint64_t, uint8_t> m_seen;
+
+    bool failed() const
+    {
+        return m_result.violation != Violation::NONE;
+    }
+
+    void fail(Violation violation, uint8_t depth)
+    {
+        m_result.violation = violation;
+        m_result.trace_len = depth;
+        memcpy(m_result.trace, m_path, depth * sizeof(Step));
+    }
+
+    void record(const FsmModel &model)
+    {
+        m_result.states_reached |= 1UL << (int)model.state_machine().get_current_state();
+
+        size_t count;
+        const FsmModel::Dispatch *dispatched = model.last_dispatched(count);
+        for (size_t i = 0; i < count; i++) {
+            const FsmModel::Dispatch &d = dispatched[i];
+            if (d.type == MessageType::COMMAND) {
+                m_result.command_cells |= 1ULL << ((int)d.state * (int)CommandId::COUNT + d.id);
+            }
+            else if (d.type == MessageType::EVENT) {
+                m_result.event_cells[(int)d.state] |= (uint16_t)(1U << d.id);
+            }
+        }
+    }
+
+    /**
+     * @return false if the subtree below this configuration must not be explored.
+     */
+    bool visit(const FsmModel &model, uint8_t depth)
+    {
+        uint8_t left = m_config.depth - depth;
+        auto seen    = m_seen.emplace(model.hash(), left);
+
+        if (seen.second) {
+            m_result.distinct++;
+            Violation violation = model.check_settle();
+            if (violation != Violation::NONE) {
+                fail(violation, depth);
+                return false;
+            }
+        }
+        else if (m_config.prune) {
+            if (seen.first->second >= left) {
+                m_result.sequences++;
+                return false;
+            }
+            seen.first->second = left;
+        }
+        return true;
+    }
+
+    void descend(const FsmModel &model, uint8_t depth)
+    {
+        if (depth == m_config.depth) {
+            m_result.sequences++;
+            return;
+        }
+
+        for (int s = 0; s < (int)Step::COUNT && !failed(); s++) {
+            Step step = (Step)s;
+            if (!model.is_enabled(step)) {
+                continue;
+            }
+
+            FsmModel next = model;
+            next.apply(step);
+            m_path[depth] = step;
+            m_result.steps++;
+            record(next);
+
+            Violation violation = next.check_step();
+            if (violation != Violation::NONE) {
+                fail(violation, depth + 1);
+                return;
+            }
+            if (visit(next, depth + 1)) {
+                descend(next, depth + 1);
+            }
+        }
+    }
+};
+
+} // namespace
+
+void explore(const ExploreConfig &config, ExploreResult &result)
+{
+    memset(&result, 0, sizeof(result));
+    ExploreConfig bounded = config;
+    if (bounded.depth > MAX_DEPTH) {
+        bounded.depth = MAX_DEPTH;
+    }
+
+    int64_t t0 = now_us();
+    FsmModel root(bounded.storage_valid, bounded.auto_connect || bounded.connected);
+    if (bounded.connected) {
+        // STA_START chains into connect, the AP accepts and the lease follows: roams start from here
+        static const Step prefix[] = {Step::DRIVER_EMIT, Step::DELIVER,    Step::AP_ACCEPT,
+                                      Step::DELIVER,     Step::DHCP_LEASE, Step::DELIVER};
+        for (Step step : prefix) {
+            root.apply(step);
+        }
+    }
+    Explorer explorer(bounded, result);
+    explorer.run(root);
+    result.elapsed_us = now_us() - t0;
+}
+
+uint32_t count_command_cells(const ExploreResult &result)
+{
+    return (uint32_t)__builtin_popcountll(result.command_cells);
+}
+
+uint32_t count_event_cells(const ExploreResult &result)
+{
+    uint32_t cells = 0;
+    for (int s = 0; s < (int)State::COUNT; s++) {
+        cells += (uint32_t)__builtin_popcount(result.event_cells[s]);
+    }
+    return cells;
+}
+
+uint32_t count_command_columns(const ExploreResult &result)
+{
+    uint32_t columns = 0;
+    for (int s = 0; s < (int)State::COUNT; s++) {
+        columns |= (uint32_t)(result.command_cells >> (s * (int)CommandId::COUNT));
+    }
+    return (uint32_t)__builtin_popcount(columns & ((1U << (int)CommandId::COUNT) - 1));
+}
+
+uint32_t count_event_columns(const ExploreResult &result)
+{
+    uint32_t columns = 0;
+    for (int s = 0; s < (int)State::COUNT; s++) {
+        columns |= result.event_cells[s];
+    }
+    return (uint32_t)__builtin_popcount(columns);
+}
+
+void print_result(const char *name, const ExploreConfig &config, const ExploreResult &result)
+{
+    double per_second = result.elapsed_us ? (double)result.sequences * 1e6 / (double)result.elapsed_us : 0.0;
+
+    printf("EXPLORE {\"name\":\"%s\",\"depth\":%u,\"prune\":%s,\"sequences\":%llu,\"steps\":%llu,"
+           "\"distinct\":%llu,\"elapsed_ms\":%lld,\"sequences_per_sec\":%.0f,\"states\":%d,"
+           "\"commands\":%lu,\"events\":%lu,\"command_cells\":%lu,\"event_cells\":%lu,\"violation\":\"%s\"}\n",
+           name, (unsigned)config.depth, config.prune ? "true" : "false", (unsigned long long)result.sequences,
+           (unsigned long long)result.steps, (unsigned long long)result.distinct,
+           (long long)(result.elapsed_us / 1000), per_second, __builtin_popcount(result.states_reached),
+           (unsigned long)count_command_columns(result), (unsigned long)count_event_columns(result),
+           (unsigned long)count_command_cells(result), (unsigned long)count_event_cells(result),
+           violation_name(result.violation));
+
+    if (result.violation != Violation::NONE) {
+        printf("Counterexample (%u steps):", (unsigned)result.trace_len);
+        for (uint8_t i = 0; i < result.trace_len; i++) {
+            printf(" %s", step_name(result.trace[i]));
+        }
+        printf("\n");
+    }
+}
+
+} // namespace fsm_explorer
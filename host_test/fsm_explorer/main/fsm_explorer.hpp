@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+
+#include "fsm_model.hpp"
+
+/**
+ * @file fsm_explorer.hpp
+ * @brief Bounded depth-first exploration of FsmModel with invariant checking.
+ */
+
+namespace fsm_explorer {
+
+static constexpr uint8_t MAX_DEPTH = 32;
+
+// Bounds run by the test suite, sized so that the whole app stays within the host test runner's
+// timeout (the auto-connect roots branch the most)
+static constexpr uint8_t EXHAUSTIVE_DEPTH = 9;  ///< Every sequence, without state merging
+static constexpr uint8_t PRUNED_DEPTH     = 12; ///< Configurations revisited only with more steps left
+
+// Deeper runs, outside the runner: the ELF started with FSM_EXPLORER_DEPTH=<n> (PRUNED_DEPTH < n <= MAX_DEPTH)
+// also explores every root pruned at that depth
+static constexpr const char *DEEP_DEPTH_ENV = "FSM_EXPLORER_DEPTH";
+
+// Coverage the suite expects: every State but UNINITIALIZED and INITIALIZING, and on the pruned runs
+// every column of both matrices dispatched in some state (EXIT only comes from deinit()). A command
+// or event added to the matrices fails the suite until the model generates it.
+static constexpr int EXPECTED_STATES        = 10;
+static constexpr uint32_t EXPECTED_COMMANDS = (uint32_t)wifi_manager::CommandId::COUNT - 1;
+static constexpr uint32_t EXPECTED_EVENTS   = (uint32_t)wifi_manager::EventId::COUNT;
+
+struct ExploreConfig
+{
+    uint8_t depth;      ///< Steps per sequence (at most MAX_DEPTH)
+    bool storage_valid; ///< Credentials already connected once
+    bool auto_connect;  ///< Begin as init_async(true, true) does
+    bool prune;         ///< Skip configurations already explored with as many steps left
+    bool connected;     ///< Begin with the auto-connect completed (CONNECTED_GOT_IP on the AP the driver picks)
+};
+
+struct ExploreResult
+{
+    uint64_t sequences;       ///< Sequences enumerated (paths ending at the depth bound or at a pruned node)
+    uint64_t steps;           ///< Steps applied
+    uint64_t distinct;        ///< Distinct configurations reached
+    int64_t elapsed_us;       ///< Wall time of the exploration
+    uint32_t states_reached;  ///< One bit per State
+    uint64_t command_cells;   ///< Bit `state * CommandId::COUNT + cmd`: command dispatched in that state
+    uint16_t event_cells[(int)wifi_manager::State::COUNT]; ///< One bit per EventId dispatched in that state
+
+    Violation violation;      ///< First violation found (NONE if the bound was explored cleanly)
+    Step trace[MAX_DEPTH];    ///< Steps leading to the violation
+    uint8_t trace_len;
+};
+
+/**
+ * @brief Explores every step sequence up to the configured depth, stopping at the first violation.
+ *
+ * Safety invariants are checked after each step; liveness invariants (FsmModel::check_settle)
+ * once per distinct configuration.
+ */
+void explore(const ExploreConfig &config, ExploreResult &result);
+
+static_assert((int)wifi_manager::State::COUNT * (int)wifi_manager::CommandId::COUNT <= 64,
+              "command_cells holds one bit per command matrix cell");
+static_assert((int)wifi_manager::EventId::COUNT <= 16, "event_cells holds one bit per EventId");
+
+/**
+ * @brief Number of command and transition matrix cells the exploration dispatched through.
+ */
+uint32_t count_command_cells(const ExploreResult &result);
+uint32_t count_event_cells(const ExploreResult &result);
+
+/**
+ * @brief Number of commands and events the exploration dispatched in at least one state.
+ */
+uint32_t count_command_columns(const ExploreResult &result);
+uint32_t count_event_columns(const ExploreResult &result);
+
+/**
+ * @brief Prints the result as one "EXPLORE {json}" line, plus the trace of a violation.
+ */
+void print_result(const char *name, const ExploreConfig &config, const ExploreResult &result);
+
+} // namespace fsm_explorer
@@ -0,0 +1,888 @@
+#include "fsm_model.hpp"
+
+#include <cstring>
+
+#include "host_test_common.hpp"
+#if FSM_MODEL_HAS_TWT
+#include "Mockesp_wifi_he.h"
+#endif
+
+using namespace wifi_manager;
+
+namespace fsm_explorer {
+
+static constexpr int8_t RSSI_LINK_LOST = -70;
+static constexpr int8_t RSSI_GOOD      = -50;
+static constexpr int8_t RSSI_CRITICAL  = -90;
+static constexpr int8_t RSSI_WEAK      = -80; ///< Below the roam trigger
+
+static constexpr uint8_t AP_CHANNEL  = 6;    ///< Channel of AP_ACCEPT
+static constexpr uint8_t NETIF_INDEX = 0x42; ///< lwIP index of the backup uplink
+
+// Backup uplink of NETIF_UP/NETIF_DOWN; host_test_common reports the low byte as its lwIP index
+static esp_netif_t *const BACKUP_NETIF   = (esp_netif_t *)(uintptr_t)(0x5500 | NETIF_INDEX);
+static constexpr uint8_t BACKUP_PRIORITY = CONFIG_WIFI_MANAGER_UPLINK_WIFI_PRIORITY / 2;
+
+static const TwtConfig TWT_CONFIG   = {1000000, 10000};   ///< Requested after every association
+static const RoamConfig ROAM_CONFIG = {-75, 8, true, 0, 4}; ///< 802.11r, a scan at every weak sample
+
+// The network: the driver associates with AP_HOME unless a BSSID is pinned, the roam scan finds both
+static constexpr uint8_t AP_HOME     = 0;
+static constexpr uint8_t AP_ROAM     = 1;
+static const RoamCandidate NETWORK[] = {
+    {{0x02, 0x00, 0x00, 0x00, 0x00, 0x01}, RSSI_WEAK, AP_CHANNEL},
+    {{0x02, 0x00, 0x00, 0x00, 0x00, 0x02}, RSSI_GOOD, AP_CHANNEL},
+};
+static constexpr uint8_t NETWORK_SIZE = sizeof(NETWORK) / sizeof(NETWORK[0]);
+
+static WiFiManager *s_manager;     ///< Manager attached to the explorer
+static FsmModel::Snapshot *s_root; ///< Its state at attach(), the root of every exploration
+static FsmModel *s_active;         ///< Model whose step is running (receives the driver calls)
+static int64_t s_now_us;           ///< esp_timer clock
+
+static WiFiManagerTestAccessor accessor()
+{
+    return WiFiManagerTestAccessor(*s_manager);
+}
+
+static constexpr TimerId timer_of(Step step)
+{
+    return (TimerId)((int)step - (int)FIRST_TIMER_STEP);
+}
+
+// Bits each blocking API call waits for (see WiFiManager::start/stop/connect/disconnect)
+static uint32_t done_bits_for(CommandId cmd)
+{
+    switch (cmd) {
+    case CommandId::START:
+        return STARTED_BIT | START_FAILED_BIT | INVALID_STATE_BIT | START_SUPERSEDED_BIT;
+    case CommandId::STOP:
+        return STOPPED_BIT | STOP_FAILED_BIT | INVALID_STATE_BIT;
+    case CommandId::CONNECT:
+        return CONNECTED_BIT | CONNECT_FAILED_BIT | INVALID_STATE_BIT | CONNECT_SUPERSEDED_BIT;
+    case CommandId::DISCONNECT:
+        return DISCONNECTED_BIT | CONNECT_FAILED_BIT | INVALID_STATE_BIT | DISCONNECT_SUPERSEDED_BIT;
+    default:
+        return 0;
+    }
+}
+
+// The stale command check of dispatch_batch(): the command matrix only looks at the state
+static bool executes(FsmModel::State state, CommandId cmd)
+{
+    WiFiStateMachine fsm;
+    fsm.transition_to(state);
+    return fsm.validate_command(cmd) == WiFiStateMachine::Action::EXECUTE;
+}
+
+static uint64_t fnv1a(uint64_t h, const uint8_t *bytes, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static uint64_t fnv1a(uint64_t h, const Message &msg)
+{
+    const uint8_t bytes[2] = {(uint8_t)msg.type, (uint8_t)msg.cmd};
+    h                      = fnv1a(h, bytes, sizeof(bytes));
+    return fnv1a(h, reinterpret_cast<const uint8_t *>(&msg.payload), sizeof(msg.payload));
+}
+
+// Event arguments with only `member` set (the other bytes zero, so equal events hash alike)
+template <typename T> static Message::Payload payload_of(T Message::Payload::*member, T value)
+{
+    Message::Payload payload = {};
+    payload.*member          = value;
+    return payload;
+}
+
+// STA_DISCONNECTED the driver reports for a disconnect or stop issued by the manager
+static Message::Payload leave_payload()
+{
+    Message::Payload payload    = {};
+    payload.disconnected.reason = WIFI_REASON_ASSOC_LEAVE;
+    return payload;
+}
+
+// AP of the BSSID the manager pinned (WiFiDriverHAL::pin_bssid()), or the one the driver picks
+static uint8_t pinned_ap()
+{
+    const wifi_sta_config_t &sta = g_host_test_wifi_config.sta;
+    for (uint8_t i = 0; sta.bssid_set && i < NETWORK_SIZE; i++) {
+        if (memcmp(sta.bssid, NETWORK[i].bssid, sizeof(sta.bssid)) == 0) {
+            return i;
+        }
+    }
+    return AP_HOME;
+}
+
+static bool is_transient(FsmModel::State state)
+{
+    switch (state) {
+    case FsmModel::State::STARTING:
+    case FsmModel::State::CONNECTING:
+    case FsmModel::State::CONNECTED_NO_IP:
+    case FsmModel::State::DISCONNECTING:
+    case FsmModel::State::WAITING_RECONNECT:
+    case FsmModel::State::STOPPING:
+        return true;
+    default:
+        return false;
+    }
+}
+
+const char *step_name(Step step)
+{
+    static const char *const names[(int)Step::COUNT] = {
+        "CMD_START",            "CMD_STOP",          "CMD_CONNECT",            "CMD_DISCONNECT",
+        "CANCEL",               "AP_ACCEPT",         "DHCP_LEASE",             "LEASE_LOST",
+        "LINK_LOST",            "AUTH_FAIL_GOOD",    "AUTH_FAIL_CRITICAL",     "AP_LEAVE",
+        "APP_SCAN_DONE",        "TWT_ACCEPT",        "TWT_REJECT",             "TWT_TEARDOWN",
+        "NETIF_UP",             "NETIF_DOWN",        "DRIVER_FAULT",           "DRIVER_EMIT",
+        "DELIVER",              "TIMER_RECONNECT",   "TIMER_CONNECT_WATCHDOG", "TIMER_DHCP_TIMEOUT",
+        "TIMER_RSSI_SAMPLE",    "TIMER_LINK_STABLE", "TIMER_ROAM_DEADLINE",    "TIMER_UPLINK_HOLD",
+        "TIMER_CHANNEL_NOTICE",
+    };
+    return ((int)step < (int)Step::COUNT) ? names[(int)step] : "?";
+}
+
+const char *violation_name(Violation violation)
+{
+    static const char *const names[(int)Violation::COUNT] = {
+        "NONE",           "ACTIVE_MISMATCH", "STA_NOT_READY", "PHANTOM_LINK",
+        "STUCK",          "LINK_LEAK",       "LOST_WAKEUP",   "PHANTOM_TWT",
+        "QUEUE_OVERFLOW", "MISROUTED",
+    };
+    return ((int)violation < (int)Violation::COUNT) ? names[(int)violation] : "?";
+}
+
+// =================================================================================================
+// Manager attachment
+// =================================================================================================
+
+esp_err_t FsmModel::stub_start(int cmock_num_calls)
+{
+    return s_active != nullptr ? s_active->driver_start() : ESP_OK;
+}
+
+esp_err_t FsmModel::stub_stop(int cmock_num_calls)
+{
+    return s_active != nullptr ? s_active->driver_stop() : ESP_OK;
+}
+
+esp_err_t FsmModel::stub_connect(int cmock_num_calls)
+{
+    return s_active != nullptr ? s_active->driver_connect() : ESP_OK;
+}
+
+esp_err_t FsmModel::stub_disconnect(int cmock_num_calls)
+{
+    return s_active != nullptr ? s_active->driver_disconnect() : ESP_OK;
+}
+
+esp_err_t FsmModel::stub_scan_start(const wifi_scan_config_t *config, bool block, int cmock_num_calls)
+{
+    return s_active != nullptr ? s_active->driver_scan_start() : ESP_OK;
+}
+
+esp_err_t FsmModel::stub_scan_get_ap_records(uint16_t *number, wifi_ap_record_t *ap_records, int cmock_num_calls)
+{
+    if (*number > NETWORK_SIZE) {
+        *number = NETWORK_SIZE;
+    }
+    for (uint16_t i = 0; i < *number; i++) {
+        memset(&ap_records[i], 0, sizeof(ap_records[i]));
+        memcpy(ap_records[i].bssid, NETWORK[i].bssid, sizeof(ap_records[i].bssid));
+        ap_records[i].rssi    = NETWORK[i].rssi;
+        ap_records[i].primary = NETWORK[i].channel;
+    }
+    return ESP_OK;
+}
+
+esp_err_t FsmModel::stub_sta_get_ap_info(wifi_ap_record_t *ap_info, int cmock_num_calls)
+{
+    return s_active != nullptr ? s_active->driver_get_ap_info(*ap_info) : ESP_ERR_WIFI_NOT_CONNECT;
+}
+
+esp_err_t FsmModel::stub_set_default_netif(esp_netif_t *netif, int cmock_num_calls)
+{
+    if (s_active != nullptr) {
+        s_active->m_route = netif == BACKUP_NETIF ? Route::BACKUP : Route::STA;
+    }
+    return ESP_OK;
+}
+
+int64_t FsmModel::stub_get_time(int cmock_num_calls)
+{
+    return s_now_us;
+}
+
+#if FSM_MODEL_HAS_TWT
+esp_err_t FsmModel::stub_twt_setup(wifi_itwt_setup_config_t *setup_config, int cmock_num_calls)
+{
+    return s_active != nullptr ? s_active->driver_twt_setup() : ESP_OK;
+}
+
+esp_err_t FsmModel::stub_twt_teardown(int flow_id, int cmock_num_calls)
+{
+    return s_active != nullptr ? s_active->driver_twt_teardown() : ESP_OK;
+}
+#endif
+
+void FsmModel::attach(WiFiManager &manager)
+{
+    s_manager = &manager;
+    manager.set_twt_config(TWT_CONFIG);
+    manager.set_roam_config(ROAM_CONFIG);
+    // Posts an UPLINK_UP the parked task only sees after detach(), on the restored root
+    manager.add_uplink(BACKUP_NETIF, BACKUP_PRIORITY);
+    s_root = new Snapshot(accessor().test_save_snapshot());
+
+    esp_wifi_start_Stub(stub_start);
+    esp_wifi_stop_Stub(stub_stop);
+    esp_wifi_connect_Stub(stub_connect);
+    esp_wifi_disconnect_Stub(stub_disconnect);
+    esp_wifi_scan_start_Stub(stub_scan_start);
+    esp_wifi_scan_get_ap_records_Stub(stub_scan_get_ap_records);
+    esp_wifi_sta_get_ap_info_Stub(stub_sta_get_ap_info);
+    esp_netif_set_default_netif_Stub(stub_set_default_netif);
+    esp_timer_get_time_Stub(stub_get_time);
+#if FSM_MODEL_HAS_TWT
+    esp_wifi_sta_itwt_setup_Stub(stub_twt_setup);
+    esp_wifi_sta_itwt_teardown_Stub(stub_twt_teardown);
+#endif
+}
+
+void FsmModel::detach()
+{
+    accessor().test_load_snapshot(*s_root);
+    accessor().test_take_sync_bits();
+    s_manager->set_twt_config({0, 0});
+    s_manager->set_roam_config({});
+    delete s_root;
+    s_root    = nullptr;
+    s_manager = nullptr;
+}
+
+FsmModel::FsmModel(bool storage_valid, bool auto_connect)
+    : m_manager(*s_root)
+    , m_queue_len(0)
+    , m_overflow(false)
+    , m_outbox_len(0)
+    , m_driver_running(false)
+    , m_link(Link::NONE)
+    , m_has_ip(false)
+    , m_fail_next_call(false)
+    , m_twt(TwtAgreement::NONE)
+    , m_ap(AP_HOME)
+    , m_netif_up(false)
+    , m_route(Route::NONE)
+    , m_waiter_bits(0)
+    , m_waiter_cmd(CommandId::COUNT)
+    , m_dispatched_count(0)
+{
+    memset(m_queue, 0, sizeof(m_queue));
+    memset(m_outbox, 0, sizeof(m_outbox));
+    memset(m_dispatched, 0, sizeof(m_dispatched));
+    m_manager.storage_valid = storage_valid;
+
+    // run_async_init(): START runs in the task, STA_START then chains into connect
+    if (auto_connect) {
+        m_manager.auto_connect_pending = true;
+        Message msg                    = {};
+        msg.type                       = MessageType::COMMAND;
+        msg.cmd                        = CommandId::START;
+
+        WiFiManagerTestAccessor manager = accessor();
+        manager.test_load_snapshot(m_manager);
+        manager.test_take_sync_bits();
+        s_active = this;
+        manager.test_process_message(msg);
+        s_active  = nullptr;
+        m_manager = manager.test_save_snapshot();
+        manager.test_take_sync_bits();
+    }
+}
+
+// =================================================================================================
+// Steps
+// =================================================================================================
+
+bool FsmModel::is_enabled(Step step) const
+{
+    // Owed events take up queue slots as soon as the driver posts them
+    bool room = m_queue_len + m_outbox_len < POST_LIMIT;
+    bool idle = m_queue_len == 0 && m_outbox_len == 0;
+    // The driver posts in order: a radio event cannot overtake one it already owes
+    bool radio = room && m_outbox_len == 0;
+
+    const WiFiStateMachine &fsm = m_manager.state_machine;
+
+    switch (step) {
+    case Step::CMD_START:
+        return room && fsm.validate_command(CommandId::START) == WiFiStateMachine::Action::EXECUTE;
+    case Step::CMD_STOP:
+        return room && fsm.validate_command(CommandId::STOP) == WiFiStateMachine::Action::EXECUTE;
+    case Step::CMD_CONNECT:
+        return room && fsm.validate_command(CommandId::CONNECT) == WiFiStateMachine::Action::EXECUTE;
+    case Step::CMD_DISCONNECT:
+        return room && fsm.validate_command(CommandId::DISCONNECT) == WiFiStateMachine::Action::EXECUTE;
+    case Step::CANCEL:
+        return room && m_waiter_bits != 0;
+    case Step::AP_ACCEPT:
+    case Step::AUTH_FAIL_GOOD:
+    case Step::AUTH_FAIL_CRITICAL:
+        return radio && m_link == Link::ASSOCIATING;
+    case Step::DHCP_LEASE:
+        return radio && m_link == Link::ASSOCIATED && !m_has_ip;
+    case Step::LEASE_LOST:
+        return radio && m_has_ip;
+    case Step::LINK_LOST:
+    case Step::AP_LEAVE:
+    case Step::TWT_TEARDOWN:
+        return radio && m_link == Link::ASSOCIATED;
+    case Step::TWT_ACCEPT:
+    case Step::TWT_REJECT:
+        return radio && m_twt == TwtAgreement::REQUESTED;
+    case Step::APP_SCAN_DONE:
+        return radio && m_driver_running;
+    case Step::NETIF_UP:
+        return room && !m_netif_up;
+    case Step::NETIF_DOWN:
+        return room && m_netif_up;
+    case Step::DRIVER_FAULT:
+        return !m_fail_next_call;
+    case Step::DRIVER_EMIT:
+        return m_outbox_len != 0;
+    case Step::DELIVER:
+        return m_queue_len != 0;
+    default:
+        // Deadlines are seconds away, far longer than the driver and the queue take to catch up
+        return step >= FIRST_TIMER_STEP && step < Step::COUNT && idle && m_manager.timers.is_armed(timer_of(step));
+    }
+}
+
+void FsmModel::apply(Step step)
+{
+    m_dispatched_count = 0;
+
+    switch (step) {
+    case Step::CMD_START:
+        post_command(CommandId::START);
+        break;
+    case Step::CMD_STOP:
+        post_command(CommandId::STOP);
+        break;
+    case Step::CMD_CONNECT:
+        post_command(CommandId::CONNECT);
+        break;
+    case Step::CMD_DISCONNECT:
+        post_command(CommandId::DISCONNECT);
+        break;
+    case Step::CANCEL:
+    {
+        // The token wakes its caller; only START and CONNECT roll back their attempt
+        CommandId cmd = m_waiter_cmd;
+        m_waiter_bits = 0;
+        m_waiter_cmd  = CommandId::COUNT;
+        if (cmd == CommandId::START || cmd == CommandId::CONNECT) {
+            Message msg = {};
+            msg.type    = MessageType::CANCEL;
+            msg.cmd     = cmd;
+            push(msg);
+        }
+        break;
+    }
+    case Step::AP_ACCEPT:
+        m_link = Link::ASSOCIATED;
+        push_event(EventId::STA_CONNECTED, payload_of(&Message::Payload::channel, AP_CHANNEL));
+        break;
+    case Step::DHCP_LEASE:
+        m_has_ip = true;
+        push_event(EventId::GOT_IP, payload_of(&Message::Payload::address, AddressKind::IPV4));
+        break;
+    case Step::LEASE_LOST:
+        m_has_ip = false;
+        push_event(EventId::LOST_IP, payload_of(&Message::Payload::address, AddressKind::IPV4));
+        break;
+    case Step::LINK_LOST:
+        lose_link(WIFI_REASON_BEACON_TIMEOUT, RSSI_LINK_LOST);
+        break;
+    case Step::AUTH_FAIL_GOOD:
+        lose_link(WIFI_REASON_AUTH_FAIL, RSSI_GOOD);
+        break;
+    case Step::AUTH_FAIL_CRITICAL:
+        lose_link(WIFI_REASON_AUTH_FAIL, RSSI_CRITICAL);
+        break;
+    case Step::AP_LEAVE:
+        lose_link(WIFI_REASON_ASSOC_LEAVE, RSSI_GOOD);
+        break;
+    case Step::APP_SCAN_DONE:
+        push_event(EventId::SCAN_DONE);
+        break;
+    case Step::TWT_ACCEPT:
+        m_twt = TwtAgreement::ACTIVE;
+        push_event(EventId::TWT, payload_of(&Message::Payload::twt, TwtState::ACTIVE));
+        break;
+    case Step::TWT_REJECT:
+        m_twt = TwtAgreement::NONE;
+        push_event(EventId::TWT, payload_of(&Message::Payload::twt, TwtState::REJECTED));
+        break;
+    case Step::TWT_TEARDOWN:
+        m_twt = TwtAgreement::NONE;
+        push_event(EventId::TWT, payload_of(&Message::Payload::twt, TwtState::OFF));
+        break;
+    case Step::NETIF_UP:
+    case Step::NETIF_DOWN:
+        m_netif_up = step == Step::NETIF_UP;
+        push_event(m_netif_up ? EventId::UPLINK_UP : EventId::UPLINK_DOWN,
+                   payload_of(&Message::Payload::netif_index, NETIF_INDEX));
+        break;
+    case Step::DRIVER_FAULT:
+        m_fail_next_call = true;
+        break;
+    case Step::DRIVER_EMIT:
+        push(m_outbox[0]);
+        m_outbox_len--;
+        memmove(&m_outbox[0], &m_outbox[1], m_outbox_len * sizeof(Message));
+        break;
+    case Step::DELIVER:
+        deliver();
+        break;
+    default:
+        fire_timer(timer_of(step));
+        break;
+    }
+}
+
+// =================================================================================================
+// Invariants
+// =================================================================================================
+
+Violation FsmModel::check_step() const
+{
+    if (m_overflow) {
+        return Violation::QUEUE_OVERFLOW;
+    }
+
+    const WiFiStateMachine &fsm = m_manager.state_machine;
+
+    // STOPPING is still active while STA_STOP is on its way
+    bool driver_active = m_driver_running || pending(EventId::STA_STOP);
+    if (fsm.is_active() != driver_active) {
+        return Violation::ACTIVE_MISMATCH;
+    }
+
+    if (fsm.is_sta_ready() && !m_driver_running) {
+        return Violation::STA_NOT_READY;
+    }
+
+    State state = fsm.get_current_state();
+    if ((state == State::CONNECTED_NO_IP || state == State::CONNECTED_GOT_IP) && m_link != Link::ASSOCIATED &&
+        !pending(EventId::STA_DISCONNECTED) && !roaming_in_place()) {
+        return Violation::PHANTOM_LINK;
+    }
+
+    if (fsm.get_twt_state() == TwtState::ACTIVE && m_twt != TwtAgreement::ACTIVE && !pending(EventId::TWT) &&
+        !pending(EventId::STA_DISCONNECTED)) {
+        return Violation::PHANTOM_TWT;
+    }
+
+    // Failover is immediate: the step that ended the routed uplink moved the route, unless the manager
+    // has not seen the backup's address change yet
+    bool routed_up = (m_route == Route::STA && state == State::CONNECTED_GOT_IP) ||
+                     (m_route == Route::BACKUP && m_netif_up);
+    if (!routed_up && best_route() != Route::NONE && !pending(EventId::UPLINK_UP) &&
+        !pending(EventId::UPLINK_DOWN)) {
+        return Violation::MISROUTED;
+    }
+
+    return Violation::NONE;
+}
+
+Violation FsmModel::check_settle() const
+{
+    FsmModel quiet = *this;
+    bool settled   = false;
+
+    for (uint32_t i = 0; i < SETTLE_LIMIT && !settled; i++) {
+        settled = true;
+        for (int s = (int)Step::DRIVER_EMIT; s < (int)Step::COUNT; s++) {
+            if ((Step)s != Step::TIMER_RSSI_SAMPLE && quiet.is_enabled((Step)s)) {
+                quiet.apply((Step)s);
+                settled = false;
+                // The hold re-arms until the STA takes the route back: that would look like a cycle
+                if ((Step)s == Step::TIMER_UPLINK_HOLD && quiet.m_route != quiet.best_route()) {
+                    return Violation::MISROUTED;
+                }
+                break;
+            }
+        }
+        Violation violation = quiet.check_step();
+        if (violation != Violation::NONE) {
+            return violation;
+        }
+    }
+
+    // A run that never settles is a retry cycle; it still has to answer the caller
+    if (quiet.m_waiter_bits != 0) {
+        return Violation::LOST_WAKEUP;
+    }
+    if (!settled) {
+        return Violation::NONE;
+    }
+
+    State state = quiet.m_manager.state_machine.get_current_state();
+    if (is_transient(state) || quiet.m_manager.roam_policy.in_progress()) {
+        return Violation::STUCK;
+    }
+    if (quiet.m_link != Link::NONE && state != State::CONNECTED_GOT_IP) {
+        return Violation::LINK_LEAK;
+    }
+    // The hold is over: the STA has taken the route back
+    if (quiet.best_route() != Route::NONE && quiet.m_route != quiet.best_route()) {
+        return Violation::MISROUTED;
+    }
+    return Violation::NONE;
+}
+
+uint64_t FsmModel::hash() const
+{
+    const Snapshot &mgr         = m_manager;
+    const WiFiStateMachine &fsm = mgr.state_machine;
+    const WiFiRoamPolicy &roam  = mgr.roam_policy;
+
+    // Past MAX_BACKOFF_EXPONENT the retry count only grows; the delays are abstract anyway
+    uint32_t retries = fsm.get_retry_count();
+    if (retries > WiFiStateMachine::MAX_BACKOFF_EXPONENT + 1) {
+        retries = WiFiStateMachine::MAX_BACKOFF_EXPONENT + 1;
+    }
+    uint32_t suspects = fsm.get_suspect_retry_count();
+    if (suspects > WiFiStateMachine::RETRY_LIMIT_WEAK) {
+        suspects = WiFiStateMachine::RETRY_LIMIT_WEAK;
+    }
+    uint16_t armed_timers = 0;
+    for (int t = 0; t < (int)TimerId::COUNT; t++) {
+        armed_timers |= (uint16_t)(mgr.timers.is_armed((TimerId)t) << t);
+    }
+
+    uint64_t h = (uint64_t)fsm.get_current_state();
+    h          = (h << 4) | retries;
+    h          = (h << 3) | suspects;
+    h          = (h << 2) | (uint64_t)m_link;
+    h          = (h << 1) | (m_link != Link::NONE && m_ap == AP_ROAM);
+    h          = (h << 1) | m_driver_running;
+    h          = (h << 1) | m_has_ip;
+    h          = (h << 1) | m_fail_next_call;
+    h          = (h << 2) | (uint64_t)m_twt;
+    h          = (h << 1) | m_netif_up;
+    h          = (h << 2) | (uint64_t)m_route;
+    h          = (h << 1) | mgr.storage_valid;
+    h          = (h << 1) | mgr.auto_connect_pending;
+    h          = (h << 3) | (mgr.disconnect_echoes > 7 ? 7 : mgr.disconnect_echoes);
+    h          = (h << 1) | m_overflow;
+    h          = (h << 3) | (uint64_t)m_waiter_cmd;
+    h          = (h << 4) | m_queue_len;
+    h          = (h << 4) | m_outbox_len;
+
+    // FNV-1a over the rest of the manager and the pending messages; timestamps are never set. The
+    // arbiter's readiness follows the state and the UPLINK events delivered, only its choice is kept
+    const uint8_t manager_bytes[] = {
+        (uint8_t)armed_timers,         (uint8_t)(armed_timers >> 8),  fsm.get_addresses(),
+        (uint8_t)fsm.get_twt_state(),  fsm.get_phy_fallback(),        (uint8_t)mgr.tx_power.get_power(),
+        mgr.roam_scan_pending,         mgr.roam_notice_pending,       mgr.sta_channel,
+        mgr.notified_channel,          mgr.notified_pending,          mgr.probe_missed,
+        (uint8_t)mgr.last_rssi,        (uint8_t)roam.get_mode(),      roam.link_lost(),
+        (uint8_t)roam.get_status().ft, roam.get_status().domain_size, (uint8_t)mgr.uplinks.get_active(),
+    };
+    h = fnv1a(h, manager_bytes, sizeof(manager_bytes));
+    for (const Message *msg = m_queue; msg != m_queue + m_queue_len; msg++) {
+        h = fnv1a(h, *msg);
+    }
+    for (const Message *msg = m_outbox; msg != m_outbox + m_outbox_len; msg++) {
+        h = fnv1a(h, *msg);
+    }
+    return h;
+}
+
+// =================================================================================================
+// Queue and driver
+// =================================================================================================
+
+bool FsmModel::pending(EventId event) const
+{
+    for (uint8_t i = 0; i < m_queue_len; i++) {
+        if (m_queue[i].type == MessageType::EVENT && m_queue[i].event == event) {
+            return true;
+        }
+    }
+    for (uint8_t i = 0; i < m_outbox_len; i++) {
+        if (m_outbox[i].event == event) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FsmModel::roaming_in_place() const
+{
+    // The link left the old AP of a fast transition; ROAM_DEADLINE bounds the wait for the new one
+    return m_manager.roam_policy.is_fast_transition() && m_manager.timers.is_armed(TimerId::ROAM_DEADLINE);
+}
+
+Route FsmModel::best_route() const
+{
+    // The STA ranks above the backup
+    if (m_manager.state_machine.get_current_state() == State::CONNECTED_GOT_IP) {
+        return Route::STA;
+    }
+    return m_netif_up ? Route::BACKUP : Route::NONE;
+}
+
+void FsmModel::push(const Message &msg)
+{
+    if (m_queue_len >= QUEUE_DEPTH) {
+        m_overflow = true;
+        return;
+    }
+    m_queue[m_queue_len++] = msg;
+}
+
+void FsmModel::push_event(EventId event, const Message::Payload &payload)
+{
+    Message msg = {};
+    msg.type    = MessageType::EVENT;
+    msg.event   = event;
+    msg.payload = payload;
+    push(msg);
+}
+
+void FsmModel::owe_event(EventId event, const Message::Payload &payload)
+{
+    if (m_outbox_len >= QUEUE_DEPTH) {
+        m_overflow = true;
+        return;
+    }
+    Message &msg = m_outbox[m_outbox_len++];
+    msg          = {};
+    msg.type     = MessageType::EVENT;
+    msg.event    = event;
+    msg.payload  = payload;
+}
+
+void FsmModel::lose_link(uint8_t reason, int8_t rssi)
+{
+    m_link   = Link::NONE;
+    m_has_ip = false;
+    m_twt    = TwtAgreement::NONE;
+    Message::Payload payload    = {};
+    payload.disconnected.reason = reason;
+    payload.disconnected.rssi   = rssi;
+    push_event(EventId::STA_DISCONNECTED, payload);
+}
+
+void FsmModel::set_bits(uint32_t bits)
+{
+    if (m_waiter_bits & bits) {
+        m_waiter_bits = 0;
+        m_waiter_cmd  = CommandId::COUNT;
+    }
+}
+
+void FsmModel::record(State state, const Message &msg)
+{
+    if (m_dispatched_count < MAX_DISPATCHED) {
+        m_dispatched[m_dispatched_count++] = {state, msg.type, (uint8_t)msg.cmd};
+    }
+}
+
+esp_err_t FsmModel::driver_start()
+{
+    if (m_fail_next_call) {
+        m_fail_next_call = false;
+        return ESP_FAIL;
+    }
+    if (!m_driver_running) {
+        m_driver_running = true;
+        owe_event(EventId::STA_START);
+    }
+    return ESP_OK;
+}
+
+esp_err_t FsmModel::driver_stop()
+{
+    if (m_fail_next_call) {
+        m_fail_next_call = false;
+        return ESP_FAIL;
+    }
+    if (m_driver_running) {
+        if (m_link != Link::NONE) {
+            m_link   = Link::NONE;
+            m_has_ip = false;
+            m_twt    = TwtAgreement::NONE;
+            owe_event(EventId::STA_DISCONNECTED, leave_payload());
+        }
+        m_driver_running = false;
+        owe_event(EventId::STA_STOP);
+    }
+    return ESP_OK;
+}
+
+esp_err_t FsmModel::driver_connect()
+{
+    if (m_fail_next_call) {
+        m_fail_next_call = false;
+        return ESP_FAIL;
+    }
+    if (!m_driver_running) {
+        return ESP_FAIL;
+    }
+    uint8_t target = pinned_ap();
+    if (m_link == Link::NONE) {
+        m_link = Link::ASSOCIATING;
+        m_ap   = target;
+    }
+    else if (target != m_ap) {
+        // Pinned to another AP: the driver reassociates, leaving the current one first
+        if (m_link == Link::ASSOCIATED) {
+            m_twt = TwtAgreement::NONE;
+            owe_event(EventId::STA_DISCONNECTED, leave_payload());
+        }
+        m_link = Link::ASSOCIATING;
+        m_ap   = target;
+    }
+    return ESP_OK;
+}
+
+esp_err_t FsmModel::driver_disconnect()
+{
+    // Like esp_wifi_disconnect(), only fails on a stopped driver (DRIVER_FAULT does not apply)
+    if (!m_driver_running) {
+        return ESP_FAIL;
+    }
+    // The driver reports its own disconnect, even mid-association
+    if (m_link != Link::NONE) {
+        m_link   = Link::NONE;
+        m_has_ip = false;
+        m_twt    = TwtAgreement::NONE;
+        owe_event(EventId::STA_DISCONNECTED, leave_payload());
+    }
+    return ESP_OK;
+}
+
+esp_err_t FsmModel::driver_twt_setup()
+{
+    if (m_fail_next_call) {
+        m_fail_next_call = false;
+        return ESP_FAIL;
+    }
+    if (m_link != Link::ASSOCIATED) {
+        return ESP_FAIL;
+    }
+    m_twt = TwtAgreement::REQUESTED;
+    return ESP_OK;
+}
+
+esp_err_t FsmModel::driver_twt_teardown()
+{
+    // Our own teardown is not reported back
+    m_twt = TwtAgreement::NONE;
+    return ESP_OK;
+}
+
+esp_err_t FsmModel::driver_scan_start()
+{
+    if (!m_driver_running) {
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+    owe_event(EventId::SCAN_DONE);
+    return ESP_OK;
+}
+
+esp_err_t FsmModel::driver_get_ap_info(wifi_ap_record_t &ap_info) const
+{
+    if (m_link != Link::ASSOCIATED) {
+        return ESP_ERR_WIFI_NOT_CONNECT;
+    }
+    memset(&ap_info, 0, sizeof(ap_info));
+    memcpy(ap_info.bssid, NETWORK[m_ap].bssid, sizeof(ap_info.bssid));
+    ap_info.rssi    = NETWORK[m_ap].rssi;
+    ap_info.primary = NETWORK[m_ap].channel;
+    return ESP_OK;
+}
+
+// =================================================================================================
+// Manager task
+// =================================================================================================
+
+void FsmModel::post_command(CommandId cmd)
+{
+    // A second command while the caller is blocked comes from another task, asynchronously
+    if (m_waiter_bits == 0) {
+        m_waiter_bits = done_bits_for(cmd);
+        m_waiter_cmd  = cmd;
+    }
+    Message msg = {};
+    msg.type    = MessageType::COMMAND;
+    msg.cmd     = cmd;
+    push(msg);
+}
+
+void FsmModel::deliver()
+{
+    // Events posted while the batch runs land behind it, as in the real queue
+    Message batch[QUEUE_DEPTH];
+    size_t count = m_queue_len;
+    memcpy(batch, m_queue, sizeof(Message) * count);
+    m_queue_len = 0;
+
+    WiFiManagerTestAccessor manager = accessor();
+    manager.test_load_snapshot(m_manager);
+    s_active = this;
+
+    // WiFiManager::dispatch_batch() one message at a time, so each finds the state it runs in
+    uint32_t superseded = WiFiStateMachine::find_superseded(batch, count);
+    for (size_t i = 0; i < count; i++) {
+        if (superseded & (1UL << i)) {
+            manager.test_supersede(batch[i]);
+            continue;
+        }
+        State state = manager.test_get_internal_state();
+        if (batch[i].type != MessageType::COMMAND || executes(state, batch[i].cmd)) {
+            record(state, batch[i]);
+        }
+        manager.test_dispatch(batch[i]);
+    }
+
+    s_active  = nullptr;
+    m_manager = manager.test_save_snapshot();
+    set_bits(manager.test_take_sync_bits());
+}
+
+void FsmModel::fire_timer(TimerId id)
+{
+    WiFiManagerTestAccessor manager = accessor();
+    manager.test_load_snapshot(m_manager);
+
+    // The phase watchdogs feed a TIMEOUT through the transition matrix
+    if (id == TimerId::CONNECT_WATCHDOG || id == TimerId::DHCP_TIMEOUT) {
+        Message timeout = {};
+        timeout.type    = MessageType::EVENT;
+        timeout.event   = EventId::TIMEOUT;
+        record(m_manager.state_machine.get_current_state(), timeout);
+    }
+
+    // The arbiter checks the hold against the clock: the expiry runs at the end of it
+    s_now_us = id == TimerId::UPLINK_HOLD ? m_manager.timers.get_deadline(id) : 0;
+    s_active = this;
+    manager.test_fire_timer(id);
+    s_active  = nullptr;
+    s_now_us  = 0;
+    m_manager = manager.test_save_snapshot();
+    set_bits(manager.test_take_sync_bits());
+}
+
+} // namespace fsm_explorer
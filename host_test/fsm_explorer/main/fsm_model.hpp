@@ -0,0 +1,319 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_idf_version.h"
+#include "sdkconfig.h"
+#include "test_wifi_manager_accessor.hpp"
+#include "wifi_manager.hpp"
+
+// The driver negotiates TWT, as in WiFiDriverHAL::setup_twt(); otherwise it refuses every request
+#if CONFIG_WIFI_MANAGER_TWT && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+#include "esp_wifi_he.h"
+#define FSM_MODEL_HAS_TWT 1
+#endif
+
+/**
+ * @file fsm_model.hpp
+ * @brief Closed system around the real WiFiManager for exhaustive exploration.
+ *
+ * Every step runs the manager's own code: messages go through its dispatcher (batch compaction,
+ * stale command checks, handlers, uplink arbitration, timers), expiries through its timer handler.
+ * Around it sit a driver that emits events only when the real one could, the task queue and one
+ * blocking API caller. The driver calls reach the model through the esp_wifi mocks, and the
+ * manager's state is saved after each step and restored before the next one
+ * (WiFiManagerTestAccessor::Snapshot), so a configuration can be copied and explored from again.
+ * Events the driver owes for a call (STA_START, STA_STOP, the echo of a disconnect) are posted by a
+ * separate step, so API commands and radio events can overtake them.
+ *
+ * Time is abstract: an armed timer may expire at any step where no event is pending. The clock reads
+ * 0, except while UPLINK_HOLD expires: the arbiter times the hold itself, so that expiry runs at its
+ * deadline. The hourly attempt budget is disabled (CONFIG_WIFI_MANAGER_ATTEMPT_BUDGET=0 in
+ * sdkconfig.defaults). TWT is requested after every association; the AP answers a request through
+ * TWT_ACCEPT or TWT_REJECT.
+ *
+ * A backup uplink ranked below the STA is registered (WiFiManager::add_uplink()); NETIF_UP and
+ * NETIF_DOWN give and take its address, and the model records where the manager puts the default route.
+ *
+ * Roaming is enabled with 802.11r: the AP the driver picks is below the roam trigger, so an RSSI
+ * sample starts a scan, whose SCAN_DONE the driver owes, and the scan finds a stronger AP of the
+ * network. A connect pinned to it while associated reassociates in place: the driver leaves the old
+ * AP (STA_DISCONNECTED) and AP_ACCEPT completes the transition.
+ */
+
+namespace fsm_explorer {
+
+/**
+ * @brief One transition of the closed system.
+ */
+enum class Step : uint8_t
+{
+    // API caller: post a command validated against the current state
+    CMD_START,
+    CMD_STOP,
+    CMD_CONNECT,
+    CMD_DISCONNECT,
+    CANCEL, ///< The blocking caller's token fires
+
+    // Radio environment: changes the driver and queues the matching event
+    AP_ACCEPT,          ///< Association completes on channel 6 (STA_CONNECTED)
+    DHCP_LEASE,         ///< Lease obtained (GOT_IP)
+    LEASE_LOST,         ///< Lease lost (LOST_IP)
+    LINK_LOST,          ///< Beacon timeout at -70 dBm (recoverable)
+    AUTH_FAIL_GOOD,     ///< Auth failure at -50 dBm (suspect, credentials blamed)
+    AUTH_FAIL_CRITICAL, ///< Auth failure at -90 dBm (suspect, signal blamed)
+    AP_LEAVE,           ///< The AP ends the session (ASSOC_LEAVE)
+    APP_SCAN_DONE,      ///< A scan the application started ends (SCAN_DONE)
+    TWT_ACCEPT,         ///< The AP accepts the requested TWT agreement (TWT ACTIVE)
+    TWT_REJECT,         ///< The AP rejects it or counter-offers (TWT REJECTED)
+    TWT_TEARDOWN,       ///< The AP tears down flow 0, whether or not it holds an agreement (TWT OFF)
+    NETIF_UP,           ///< The backup uplink gets its address (UPLINK_UP)
+    NETIF_DOWN,         ///< It loses it again (UPLINK_DOWN)
+    DRIVER_FAULT,       ///< The next start/stop/connect/TWT setup driver call returns an error
+
+    // Always eventually taken
+    DRIVER_EMIT, ///< The driver posts the oldest event it owes (STA_START, STA_STOP, our disconnect)
+    DELIVER,     ///< wifi_task drains the queue and dispatches the batch
+
+    // One expiry per wifi_manager::TimerId, in the same order
+    TIMER_RECONNECT,
+    TIMER_CONNECT_WATCHDOG,
+    TIMER_DHCP_TIMEOUT,
+    TIMER_RSSI_SAMPLE,
+    TIMER_LINK_STABLE,
+    TIMER_ROAM_DEADLINE,
+    TIMER_UPLINK_HOLD,
+    TIMER_CHANNEL_NOTICE,
+
+    COUNT
+};
+
+static constexpr Step FIRST_TIMER_STEP = Step::TIMER_RECONNECT;
+static_assert((int)Step::COUNT - (int)FIRST_TIMER_STEP == (int)wifi_manager::TimerId::COUNT,
+              "One timer step per TimerId");
+
+/**
+ * @brief Invariants checked by the explorer.
+ */
+enum class Violation : uint8_t
+{
+    NONE,
+    ACTIVE_MISMATCH, ///< is_active() disagrees with the driver (started, or a STA_STOP still pending)
+    STA_NOT_READY,   ///< is_sta_ready() while the driver is stopped
+    PHANTOM_LINK,    ///< A CONNECTED_* state with no link, no STA_DISCONNECTED pending and no transition due
+    STUCK,           ///< Settled in a transient state or mid-roam: nothing left that can move it
+    LINK_LEAK,       ///< Settled idle while the driver still holds or seeks a link
+    LOST_WAKEUP,     ///< The blocking caller is never woken
+    PHANTOM_TWT,     ///< TWT active with no agreement in the driver and no teardown or link loss pending
+    QUEUE_OVERFLOW,  ///< More messages in flight than the model queue holds
+    MISROUTED,       ///< Default route on a dead uplink while another one is up, or settled off the best one
+    COUNT
+};
+
+/**
+ * @brief Human-readable name of a step (for traces).
+ */
+const char *step_name(Step step);
+
+/**
+ * @brief Human-readable name of a violation.
+ */
+const char *violation_name(Violation violation);
+
+/**
+ * @brief Driver association progress, as seen by the radio.
+ */
+enum class Link : uint8_t
+{
+    NONE,
+    ASSOCIATING,
+    ASSOCIATED,
+};
+
+/**
+ * @brief Uplink the default route was last set to (esp_netif_set_default_netif()).
+ */
+enum class Route : uint8_t
+{
+    NONE, ///< Never set
+    STA,
+    BACKUP,
+};
+
+/**
+ * @brief Individual TWT agreement (flow 0), as held by the driver.
+ */
+enum class TwtAgreement : uint8_t
+{
+    NONE,
+    REQUESTED, ///< Setup sent, the AP has not answered
+    ACTIVE,
+};
+
+class FsmModel
+{
+public:
+    using State     = wifi_manager::State;
+    using CommandId = wifi_manager::CommandId;
+    using EventId   = wifi_manager::EventId;
+    using Snapshot  = WiFiManagerTestAccessor::Snapshot;
+
+    /// Messages queued or owed by the driver before the API and the radio hold back; deeper queues only
+    /// add longer batches
+    static constexpr size_t POST_LIMIT = 4;
+
+    /// Room for the events a batch makes the driver post (a STOP owes STA_DISCONNECTED and STA_STOP)
+    static constexpr size_t QUEUE_DEPTH = 8;
+
+    /// Messages one step can dispatch (a full batch plus a watchdog TIMEOUT)
+    static constexpr size_t MAX_DISPATCHED = QUEUE_DEPTH + 1;
+
+    /// Quiet steps tried before a settle check gives up and treats the remaining run as a cycle
+    static constexpr uint32_t SETTLE_LIMIT = 64;
+
+    /**
+     * @brief Routes the driver calls of the manager to the model. The manager must be initialized,
+     *        with its task suspended, and the common mocks installed; detach() before resuming it.
+     */
+    static void attach(WiFiManager &manager);
+
+    /**
+     * @brief Leaves the manager idle (INITIALIZED, nothing armed) and stops routing driver calls.
+     */
+    static void detach();
+
+    /**
+     * @brief Manager freshly initialized (INITIALIZED, driver stopped, nothing armed or retried).
+     * @param storage_valid Whether the stored credentials already connected once.
+     * @param auto_connect Start chained into connect, as init_async(true, true) does.
+     */
+    FsmModel(bool storage_valid, bool auto_connect);
+
+    /**
+     * @brief Whether a step can be taken in the current configuration.
+     */
+    bool is_enabled(Step step) const;
+
+    /**
+     * @brief Takes an enabled step.
+     */
+    void apply(Step step);
+
+    /**
+     * @brief Safety invariants, valid after every step.
+     */
+    Violation check_step() const;
+
+    /**
+     * @brief Runs only the driver, DELIVER and timer steps until nothing is enabled, then checks
+     *        the liveness invariants on the settled configuration.
+     *
+     * The radio stays silent while settling (no AP answers, no lease), so every phase must be
+     * left through its watchdog or an event the driver owes us. RSSI_SAMPLE is periodic and never
+     * settles; it is left out.
+     */
+    Violation check_settle() const;
+
+    /**
+     * @brief 64-bit digest of the whole configuration (the retry counts are capped where the
+     *        backoff stops growing).
+     */
+    uint64_t hash() const;
+
+    const WiFiStateMachine &state_machine() const
+    {
+        return m_manager.state_machine;
+    }
+
+    /**
+     * @brief A message dispatched by the manager and the state it found, for coverage.
+     */
+    struct Dispatch
+    {
+        State state;
+        wifi_manager::MessageType type;
+        uint8_t id; ///< CommandId or EventId
+    };
+
+    /**
+     * @brief Messages dispatched by the last apply() (batch members and synthetic TIMEOUTs).
+     */
+    const Dispatch *last_dispatched(size_t &count) const
+    {
+        count = m_dispatched_count;
+        return m_dispatched;
+    }
+
+private:
+    using Message = wifi_manager::Message;
+
+    Snapshot m_manager; ///< WiFiManager between two steps
+
+    // Task queue
+    Message m_queue[QUEUE_DEPTH];
+    uint8_t m_queue_len;
+    bool m_overflow;
+
+    // Driver
+    Message m_outbox[QUEUE_DEPTH]; ///< Events owed, not posted yet
+    uint8_t m_outbox_len;
+    bool m_driver_running;
+    Link m_link;
+    bool m_has_ip;
+    bool m_fail_next_call;
+    TwtAgreement m_twt;
+    uint8_t m_ap; ///< AP the link is with or heading to (index into the network, see fsm_model.cpp)
+
+    // Netifs
+    bool m_netif_up; ///< The backup uplink has its address
+    Route m_route;
+
+    // Blocking API caller
+    uint32_t m_waiter_bits; ///< Bits the caller waits for (0: no caller blocked)
+    CommandId m_waiter_cmd;
+
+    Dispatch m_dispatched[MAX_DISPATCHED];
+    uint8_t m_dispatched_count;
+
+    bool pending(EventId event) const;
+    bool roaming_in_place() const;
+    Route best_route() const;
+    void push(const Message &msg);
+    void push_event(EventId event, const Message::Payload &payload = {});
+    void owe_event(EventId event, const Message::Payload &payload = {});
+    void lose_link(uint8_t reason, int8_t rssi);
+    void set_bits(uint32_t bits);
+    void record(State state, const Message &msg);
+
+    // Manager task: runs WiFiManager on this configuration
+    void post_command(CommandId cmd);
+    void deliver();
+    void fire_timer(wifi_manager::TimerId id);
+
+    // Driver, reached through the esp_wifi stubs while a step runs
+    esp_err_t driver_start();
+    esp_err_t driver_stop();
+    esp_err_t driver_connect();
+    esp_err_t driver_disconnect();
+    esp_err_t driver_twt_setup();
+    esp_err_t driver_twt_teardown();
+    esp_err_t driver_scan_start();
+    esp_err_t driver_get_ap_info(wifi_ap_record_t &ap_info) const;
+
+    static esp_err_t stub_start(int cmock_num_calls);
+    static esp_err_t stub_stop(int cmock_num_calls);
+    static esp_err_t stub_connect(int cmock_num_calls);
+    static esp_err_t stub_disconnect(int cmock_num_calls);
+    static esp_err_t stub_scan_start(const wifi_scan_config_t *config, bool block, int cmock_num_calls);
+    static esp_err_t stub_scan_get_ap_records(uint16_t *number, wifi_ap_record_t *ap_records, int cmock_num_calls);
+    static esp_err_t stub_sta_get_ap_info(wifi_ap_record_t *ap_info, int cmock_num_calls);
+    static esp_err_t stub_set_default_netif(esp_netif_t *netif, int cmock_num_calls);
+    static int64_t stub_get_time(int cmock_num_calls);
+#if FSM_MODEL_HAS_TWT
+    static esp_err_t stub_twt_setup(wifi_itwt_setup_config_t *setup_config, int cmock_num_calls);
+    static esp_err_t stub_twt_teardown(int flow_id, int cmock_num_calls);
+#endif
+};
+
+} // namespace fsm_explorer
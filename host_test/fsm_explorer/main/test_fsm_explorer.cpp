@@ -0,0 +1,110 @@
+#include <stdlib.h>
+
+#include "unity.h"
+
+#include "fsm_explorer.hpp"
+#include "host_test_common.hpp"
+#include "nvs_flash.h"
+#include "test_wifi_manager_accessor.hpp"
+
+using namespace fsm_explorer;
+
+// Every test explores from the same manager: initialized, with its task parked so that only the
+// model dispatches
+void setUp(void)
+{
+    host_test_setup_common_mocks();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    wm.init();
+    WiFiManagerTestAccessor(wm).test_suspend_manager_task();
+    FsmModel::attach(wm);
+}
+
+void tearDown(void)
+{
+    FsmModel::detach();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    WiFiManagerTestAccessor(wm).test_resume_manager_task();
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+static void run_and_check(const char *name, const ExploreConfig &config)
+{
+    ExploreResult result;
+    explore(config, result);
+    print_result(name, config, result);
+
+    TEST_ASSERT_EQUAL_STRING(violation_name(Violation::NONE), violation_name(result.violation));
+    TEST_ASSERT_EQUAL(EXPECTED_STATES, __builtin_popcount(result.states_reached));
+
+    // Only the pruned runs are deep enough for every column (a TWT teardown needs an association)
+    if (config.prune) {
+        TEST_ASSERT_EQUAL_UINT32(EXPECTED_COMMANDS, count_command_columns(result));
+        TEST_ASSERT_EQUAL_UINT32(EXPECTED_EVENTS, count_event_columns(result));
+    }
+}
+
+TEST_CASE("Explorer: exhaustive, fresh credentials", "[fsm_explorer]")
+{
+    run_and_check("exhaustive.fresh", {EXHAUSTIVE_DEPTH, false, false, false, false});
+}
+
+TEST_CASE("Explorer: exhaustive, proven credentials", "[fsm_explorer]")
+{
+    run_and_check("exhaustive.proven", {EXHAUSTIVE_DEPTH, true, false, false, false});
+}
+
+TEST_CASE("Explorer: exhaustive, auto-connect", "[fsm_explorer]")
+{
+    run_and_check("exhaustive.auto_connect", {EXHAUSTIVE_DEPTH, false, true, false, false});
+    run_and_check("exhaustive.auto_connect_proven", {EXHAUSTIVE_DEPTH, true, true, false, false});
+}
+
+TEST_CASE("Explorer: pruned, long sequences", "[fsm_explorer]")
+{
+    run_and_check("pruned.fresh", {PRUNED_DEPTH, false, false, true, false});
+    run_and_check("pruned.proven", {PRUNED_DEPTH, true, false, true, false});
+    run_and_check("pruned.auto_connect", {PRUNED_DEPTH, false, true, true, false});
+    run_and_check("pruned.auto_connect_proven", {PRUNED_DEPTH, true, true, true, false});
+}
+
+TEST_CASE("Explorer: pruned, from an established link", "[fsm_explorer]")
+{
+    run_and_check("pruned.connected", {PRUNED_DEPTH, true, true, true, true});
+}
+
+TEST_CASE("Explorer: pruned, at the depth given by FSM_EXPLORER_DEPTH", "[fsm_explorer]")
+{
+    const char *value = getenv(DEEP_DEPTH_ENV);
+    int depth         = value != nullptr ? atoi(value) : 0;
+    if (depth <= PRUNED_DEPTH || depth > MAX_DEPTH) {
+        TEST_IGNORE_MESSAGE("Deep run not requested (FSM_EXPLORER_DEPTH)");
+    }
+
+    run_and_check("deep.fresh", {(uint8_t)depth, false, false, true, false});
+    run_and_check("deep.proven", {(uint8_t)depth, true, false, true, false});
+    run_and_check("deep.auto_connect", {(uint8_t)depth, false, true, true, false});
+    run_and_check("deep.auto_connect_proven", {(uint8_t)depth, true, true, true, false});
+    run_and_check("deep.connected", {(uint8_t)depth, true, true, true, true});
+}
+
+TEST_CASE("Explorer: model steps follow the command matrix and the queue", "[fsm_explorer]")
+{
+    FsmModel model(true, false);
+    TEST_ASSERT_TRUE(model.is_enabled(Step::CMD_START));
+    TEST_ASSERT_FALSE(model.is_enabled(Step::CMD_DISCONNECT));
+    TEST_ASSERT_FALSE(model.is_enabled(Step::DELIVER));
+
+    model.apply(Step::CMD_START);
+    TEST_ASSERT_TRUE(model.is_enabled(Step::DELIVER));
+    model.apply(Step::DELIVER);
+    TEST_ASSERT_EQUAL(WiFiStateMachine::State::STARTING, model.state_machine().get_current_state());
+    TEST_ASSERT_TRUE(model.is_enabled(Step::DRIVER_EMIT));
+    TEST_ASSERT_EQUAL_STRING(violation_name(Violation::NONE), violation_name(model.check_step()));
+    TEST_ASSERT_EQUAL_STRING(violation_name(Violation::NONE), violation_name(model.check_settle()));
+}
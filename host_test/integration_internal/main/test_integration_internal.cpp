@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "esp_timer.h"
 #include "esp_wifi.h"
@@ -46,6 +47,24 @@ esp_err_t integration_esp_wifi_connect(int cmock_num_calls)
     return ESP_OK;
 }
 
+esp_err_t integration_esp_wifi_disconnect(int cmock_num_calls)
+{
+    if (g_host_test_auto_simulate_events) {
+        WiFiManager &wm = WiFiManager::get_instance();
+        WiFiManagerTestAccessor accessor(wm);
+        accessor.test_simulate_disconnect(WIFI_REASON_ASSOC_LEAVE);
+    }
+    return ESP_OK;
+}
+
+// Deadlines (watchdogs, RSSI samples) only expire on a clock that moves
+int64_t integration_esp_timer_get_time(int cmock_num_calls)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
 void setUp(void)
 {
     host_test_setup_common_mocks();
@@ -54,6 +73,8 @@ void setUp(void)
     esp_wifi_start_Stub(integration_esp_wifi_start);
     esp_wifi_stop_Stub(integration_esp_wifi_stop);
     esp_wifi_connect_Stub(integration_esp_wifi_connect);
+    esp_wifi_disconnect_Stub(integration_esp_wifi_disconnect);
+    esp_timer_get_time_Stub(integration_esp_timer_get_time);
 }
 
 void tearDown(void)
@@ -539,3 +560,641 @@ TEST_CASE("Internal: Backoff Graceful Shutdown", "[wifi][internal][lifecycle]")
     TEST_ASSERT_EQUAL(WiFiManager::State::UNINITIALIZED, wm.get_state());
     nvs_flash_deinit();
 }
+
+TEST_CASE("Internal: Async Init Chains Start and Connect", "[wifi][internal][lifecycle]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, wm.wait_for_init(10));
+
+    TEST_ASSERT_EQUAL(ESP_OK, wm.init_async(true, true));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.wait_for_init(1000));
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(WiFiManager::State::CONNECTED_GOT_IP, wm.get_state());
+
+    // Subsequent init calls are idempotent and a second wait returns immediately
+    TEST_ASSERT_EQUAL(ESP_OK, wm.init());
+    TEST_ASSERT_EQUAL(ESP_OK, wm.wait_for_init(10));
+
+    TEST_ASSERT_EQUAL(ESP_OK, wm.deinit());
+    TEST_ASSERT_EQUAL(WiFiManager::State::UNINITIALIZED, wm.get_state());
+    nvs_flash_deinit();
+}
+
+TEST_CASE("Internal: Async Init Failure Is Reported", "[wifi][internal][lifecycle]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+
+    esp_wifi_init_IgnoreAndReturn(ESP_ERR_NO_MEM);
+    TEST_ASSERT_EQUAL(ESP_OK, wm.init_async());
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, wm.wait_for_init(1000));
+    TEST_ASSERT_EQUAL(WiFiManager::State::UNINITIALIZED, wm.get_state());
+
+    // A later init succeeds once the driver recovers
+    esp_wifi_init_IgnoreAndReturn(ESP_OK);
+    TEST_ASSERT_EQUAL(ESP_OK, wm.init());
+    TEST_ASSERT_EQUAL(WiFiManager::State::INITIALIZED, wm.get_state());
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+static volatile esp_err_t s_superseded_connect_ret = ESP_OK;
+
+static void superseded_connect_task(void *pvParameters)
+{
+    s_superseded_connect_ret = WiFiManager::get_instance().connect(2000);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("Internal: Stop Supersedes Queued Commands", "[wifi][internal][compaction]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    wm.init();
+    wm.set_credentials("CompactSSID", "pass");
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(5000));
+    wm.reset_metrics();
+    WiFiManagerTestAccessor accessor(wm);
+
+    // Queue CONNECT (sync caller), DISCONNECT and CONNECT ahead of a STOP while the task is held
+    accessor.test_suspend_manager_task();
+    s_superseded_connect_ret = ESP_OK;
+    xTaskCreate(superseded_connect_task, "sup_connect", 4096, NULL, 5, NULL);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    accessor.test_send_disconnect_command();
+    accessor.test_send_connect_command();
+    accessor.test_send_stop_command();
+    accessor.test_resume_manager_task();
+
+    vTaskDelay(pdMS_TO_TICKS(200));
+    TEST_ASSERT_EQUAL(wifi_manager::ERR_SUPERSEDED, s_superseded_connect_ret);
+    TEST_ASSERT_EQUAL(WiFiManager::State::STOPPED, wm.get_state());
+
+    wifi_manager::DispatchMetrics metrics = wm.get_metrics();
+    TEST_ASSERT_EQUAL(2, metrics.superseded[(int)wifi_manager::CommandId::CONNECT]);
+    TEST_ASSERT_EQUAL(1, metrics.superseded[(int)wifi_manager::CommandId::DISCONNECT]);
+    TEST_ASSERT_EQUAL(0, metrics.command_exec[(int)wifi_manager::CommandId::CONNECT].count);
+
+    // A STOP that finds the driver already stopped completes immediately
+    TEST_ASSERT_EQUAL(ESP_OK, accessor.test_send_stop_command());
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::STOPPED, wm.get_state());
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+TEST_CASE("Internal: Transaction Runs Steps In Order", "[wifi][internal][transaction]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    wm.init();
+
+    // Provisioning flow as a single round trip
+    WiFiManager::Transaction txn = {};
+    TEST_ASSERT_EQUAL(ESP_OK, txn.add_credentials("TxnSSID", "txn_pass"));
+    TEST_ASSERT_EQUAL(ESP_OK, txn.add(WiFiManager::Transaction::Step::START));
+    TEST_ASSERT_EQUAL(ESP_OK, txn.add(WiFiManager::Transaction::Step::CONNECT));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.run_transaction(txn, 3000));
+    for (uint8_t i = 0; i < txn.count; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, txn.results[i]);
+    }
+    TEST_ASSERT_EQUAL(WiFiManager::State::CONNECTED_GOT_IP, wm.get_state());
+
+    std::string ssid, password;
+    wm.get_credentials(ssid, password);
+    TEST_ASSERT_EQUAL_STRING("TxnSSID", ssid.c_str());
+
+    // The first failing step aborts the rest
+    WiFiManager::Transaction failing = {};
+    failing.add(WiFiManager::Transaction::Step::STOP);
+    failing.add(WiFiManager::Transaction::Step::DISCONNECT);
+    failing.add(WiFiManager::Transaction::Step::START);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, wm.run_transaction(failing, 3000));
+    TEST_ASSERT_EQUAL(ESP_OK, failing.results[0]);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, failing.results[1]);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FINISHED, failing.results[2]);
+    TEST_ASSERT_EQUAL(WiFiManager::State::STOPPED, wm.get_state());
+
+    WiFiManager::Transaction empty = {};
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, wm.run_transaction(empty, 100));
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+static void cancel_after_delay_task(void *pvParameters)
+{
+    vTaskDelay(pdMS_TO_TICKS(100));
+    static_cast<WiFiManager::CancellationToken *>(pvParameters)->cancel();
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("Internal: Cancellation Token Aborts Connect", "[wifi][internal][cancel]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    wm.init();
+    wm.set_credentials("CancelSSID", "pass");
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(5000));
+
+    // The AP never answers: only the token can end this call before its 30 s timeout
+    g_host_test_auto_simulate_events = false;
+    WiFiManager::CancellationToken token;
+    xTaskCreate(cancel_after_delay_task, "canceller", 4096, &token, 5, NULL);
+    TEST_ASSERT_EQUAL(wifi_manager::ERR_CANCELLED, wm.connect(30000, &token));
+
+    // wifi_task aborted the attempt
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::DISCONNECTED, wm.get_state());
+
+    // A cancelled token fails fast without queuing anything
+    TEST_ASSERT_EQUAL(wifi_manager::ERR_CANCELLED, wm.connect(1000, &token));
+    TEST_ASSERT_EQUAL(WiFiManager::State::DISCONNECTED, wm.get_state());
+
+    // Once re-armed, the token does not disturb a normal call
+    token.reset();
+    g_host_test_auto_simulate_events = true;
+    TEST_ASSERT_EQUAL(ESP_OK, wm.connect(1000, &token));
+    TEST_ASSERT_EQUAL(WiFiManager::State::CONNECTED_GOT_IP, wm.get_state());
+
+    // A cancelled transaction: the caller gets ERR_CANCELLED, the steps it left report not finished
+    TEST_ASSERT_EQUAL(ESP_OK, wm.disconnect(5000));
+    g_host_test_auto_simulate_events = false;
+    token.reset();
+    WiFiManager::Transaction txn = {};
+    txn.add(WiFiManager::Transaction::Step::CONNECT);
+    txn.add(WiFiManager::Transaction::Step::DISCONNECT);
+    xTaskCreate(cancel_after_delay_task, "canceller", 4096, &token, 5, NULL);
+    TEST_ASSERT_EQUAL(wifi_manager::ERR_CANCELLED, wm.run_transaction(txn, 30000, &token));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FINISHED, txn.results[0]);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FINISHED, txn.results[1]);
+    TEST_ASSERT_EQUAL_STRING("ERR_CANCELLED", WiFiManager::err_to_name(wifi_manager::ERR_CANCELLED));
+    g_host_test_auto_simulate_events = true;
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+TEST_CASE("Internal: Phase Watchdogs Recover Stuck Attempts", "[wifi][internal][watchdog]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    wm.init();
+    wm.set_watchdog_timeouts(100, 100);
+    WiFiManagerTestAccessor accessor(wm);
+
+    // A first successful connection validates the credentials
+    wm.set_credentials("WatchdogSSID", "pass");
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(5000));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.connect(5000));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.disconnect(5000));
+
+    // The AP never answers the association
+    g_host_test_auto_simulate_events = false;
+    accessor.test_send_connect_command(false);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::CONNECTING, wm.get_state());
+    vTaskDelay(pdMS_TO_TICKS(150));
+    TEST_ASSERT_EQUAL(WiFiManager::State::WAITING_RECONNECT, wm.get_state());
+
+    // The driver echo of our own abort does not count as a second failure
+    accessor.test_simulate_disconnect(WIFI_REASON_ASSOC_LEAVE);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::WAITING_RECONNECT, wm.get_state());
+
+    // Associated, but DHCP never completes
+    g_host_test_auto_simulate_events = true;
+    TEST_ASSERT_EQUAL(ESP_OK, wm.disconnect(5000));
+    g_host_test_auto_simulate_events = false;
+    accessor.test_send_connect_command(false);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    accessor.test_simulate_wifi_event(WIFI_EVENT_STA_CONNECTED);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::CONNECTED_NO_IP, wm.get_state());
+    vTaskDelay(pdMS_TO_TICKS(150));
+    TEST_ASSERT_EQUAL(WiFiManager::State::WAITING_RECONNECT, wm.get_state());
+
+    g_host_test_auto_simulate_events = true;
+    wm.set_watchdog_timeouts(CONFIG_WIFI_MANAGER_CONNECT_TIMEOUT_MS, CONFIG_WIFI_MANAGER_DHCP_TIMEOUT_MS);
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+static esp_err_t failing_esp_wifi_connect(int cmock_num_calls)
+{
+    return ESP_FAIL;
+}
+
+TEST_CASE("Internal: Reconnect That Cannot Start Backs Off", "[wifi][internal][reconnect]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    wm.init();
+    WiFiManagerTestAccessor accessor(wm);
+
+    wm.set_credentials("BackoffSSID", "pass");
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(5000));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.connect(5000));
+    accessor.test_simulate_disconnect(WIFI_REASON_BEACON_TIMEOUT);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::WAITING_RECONNECT, wm.get_state());
+
+    // The driver refuses the attempt: no event will follow, so the next backoff must
+    esp_wifi_connect_Stub(failing_esp_wifi_connect);
+    accessor.test_fire_timer(wifi_manager::TimerId::RECONNECT);
+    TEST_ASSERT_EQUAL(WiFiManager::State::WAITING_RECONNECT, wm.get_state());
+
+    esp_wifi_connect_Stub(integration_esp_wifi_connect);
+    accessor.test_fire_timer(wifi_manager::TimerId::RECONNECT);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::CONNECTED_GOT_IP, wm.get_state());
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+TEST_CASE("Internal: Hidden SSID Probes Its Cached Channel", "[wifi][internal][hidden]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    wm.init();
+    WiFiManagerTestAccessor accessor(wm);
+
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_credentials("HiddenSSID", "pass", true));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(5000));
+
+    // No channel known yet: directed probes on every channel
+    g_host_test_auto_simulate_events = false;
+    accessor.test_send_connect_command(false);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(0, g_host_test_wifi_config.sta.channel);
+    TEST_ASSERT_EQUAL(WIFI_FAST_SCAN, g_host_test_wifi_config.sta.scan_method);
+
+    wifi_event_sta_connected_t connected = {};
+    connected.channel                    = 6;
+    accessor.test_simulate_wifi_event(WIFI_EVENT_STA_CONNECTED, &connected);
+    accessor.test_simulate_ip_event(IP_EVENT_STA_GOT_IP);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::CONNECTED_GOT_IP, wm.get_state());
+
+    // The next attempt starts on the channel learnt from the association
+    g_host_test_auto_simulate_events = true;
+    TEST_ASSERT_EQUAL(ESP_OK, wm.disconnect(5000));
+    g_host_test_auto_simulate_events = false;
+    accessor.test_send_connect_command(false);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(6, g_host_test_wifi_config.sta.channel);
+    TEST_ASSERT_EQUAL_STRING("HiddenSSID", (const char *)g_host_test_wifi_config.sta.ssid);
+
+    // The AP is not there any more: the following attempt widens to all channels
+    accessor.test_simulate_disconnect(WIFI_REASON_NO_AP_FOUND);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::WAITING_RECONNECT, wm.get_state());
+    accessor.test_send_connect_command(false);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::CONNECTING, wm.get_state());
+    TEST_ASSERT_EQUAL(0, g_host_test_wifi_config.sta.channel);
+
+    g_host_test_auto_simulate_events = true;
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+TEST_CASE("Internal: TWT Requested After Each Association", "[wifi][internal][twt]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    wm.init();
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, wm.set_twt_config({10000, 10000}));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_twt_config({1000000, 10000}));
+
+    wifi_manager::TwtStatus status = wm.get_twt_status();
+    TEST_ASSERT_EQUAL(wifi_manager::TwtState::OFF, status.state);
+    TEST_ASSERT_EQUAL(1000000, status.wake_interval_us);
+    TEST_ASSERT_EQUAL(10240, status.wake_duration_us);
+    TEST_ASSERT_EQUAL(1000000, status.duty_cycle_ppm);
+
+    // The host target has no 802.11ax: the setup is tried once the IP is there, then given up
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_credentials("TwtSSID", "pass"));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(5000));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.connect(5000));
+    status = wm.get_twt_status();
+    TEST_ASSERT_EQUAL(wifi_manager::TwtState::UNSUPPORTED, status.state);
+    TEST_ASSERT_EQUAL(0, status.setups);
+    TEST_ASSERT_EQUAL(1000000, status.duty_cycle_ppm);
+
+    TEST_ASSERT_EQUAL(ESP_OK, wm.disconnect(5000));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.connect(5000));
+    TEST_ASSERT_EQUAL(wifi_manager::TwtState::UNSUPPORTED, wm.get_twt_status().state);
+
+    // Disabling starts over
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_twt_config({0, 0}));
+    TEST_ASSERT_EQUAL(wifi_manager::TwtState::OFF, wm.get_twt_status().state);
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+static int8_t s_applied_tx_power;
+
+static esp_err_t integration_esp_wifi_set_max_tx_power(int8_t power, int cmock_num_calls)
+{
+    s_applied_tx_power = power;
+    return ESP_OK;
+}
+
+TEST_CASE("Internal: TX Power Follows The RSSI Samples", "[wifi][internal][tx_power]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    wm.init();
+
+    // One sample of headroom is enough to step down, 2 dB per 200 ms sample
+    wifi_manager::WiFiTxPowerController::Config config = {-70, 6, 8 * 4, 20 * 4, 2 * 4, 1};
+    wifi_manager::WiFiTxPowerController::Config bad    = config;
+    bad.step                                           = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, wm.set_tx_power_control(true, &bad));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_tx_power_control(true, &config));
+
+    // Next to the AP: the limit walks down to the minimum
+    g_host_test_rssi = -30;
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_credentials("TxPowerSSID", "pass"));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(5000));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.connect(5000));
+    vTaskDelay(pdMS_TO_TICKS(2000));
+    wifi_manager::TxPowerStatus status = wm.get_tx_power_status();
+    TEST_ASSERT_TRUE(status.enabled);
+    TEST_ASSERT_EQUAL(-30, status.last_rssi);
+    TEST_ASSERT_EQUAL(config.min_power, status.power);
+    TEST_ASSERT_EQUAL(6, status.decreases);
+
+    // Moving away: one weak sample restores what the link needs
+    g_host_test_rssi = -62;
+    vTaskDelay(pdMS_TO_TICKS(500));
+    status = wm.get_tx_power_status();
+    TEST_ASSERT_EQUAL(72, status.power);
+    TEST_ASSERT_EQUAL(1, status.increases);
+
+    // A disconnect reconnects at full power
+    TEST_ASSERT_EQUAL(ESP_OK, wm.disconnect(5000));
+    TEST_ASSERT_EQUAL(config.max_power, wm.get_tx_power_status().power);
+
+    // Switched off: the driver gets its own limit back, not the controller's full power
+    esp_wifi_set_max_tx_power_Stub(integration_esp_wifi_set_max_tx_power);
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_tx_power_control(false, nullptr));
+    TEST_ASSERT_FALSE(wm.get_tx_power_status().enabled);
+    TEST_ASSERT_EQUAL(78, s_applied_tx_power);
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+TEST_CASE("Internal: Enterprise Certificates And Support", "[wifi][internal][eap]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    wm.init();
+
+    static const uint8_t pem[] = "-----BEGIN CERTIFICATE-----";
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, wm.register_certificate("", pem, sizeof(pem)));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, wm.register_certificate("name_far_too_long", pem, sizeof(pem)));
+
+    // Four slots; re-registering a name replaces it, nullptr frees the slot
+    TEST_ASSERT_EQUAL(ESP_OK, wm.register_certificate("ca", pem, sizeof(pem)));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.register_certificate("cert", pem, sizeof(pem)));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.register_certificate("key", pem, sizeof(pem)));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.register_certificate("old_ca", pem, sizeof(pem)));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.register_certificate("ca", pem, sizeof(pem) - 1));
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, wm.register_certificate("new_ca", pem, sizeof(pem)));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.register_certificate("old_ca", nullptr, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.register_certificate("new_ca", pem, sizeof(pem)));
+
+    // The host target builds without CONFIG_WIFI_MANAGER_ENTERPRISE
+    wifi_manager::EnterpriseProfile profile = {};
+    profile.method                          = wifi_manager::EapMethod::TLS;
+    strcpy(profile.identity, "device42");
+    strcpy(profile.ca_cert, "ca");
+    strcpy(profile.client_cert, "cert");
+    strcpy(profile.client_key, "key");
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, wm.set_enterprise_credentials("corp", profile));
+    TEST_ASSERT_EQUAL(0, wm.get_eap_status().full_handshakes);
+
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+TEST_CASE("Internal: Default Route Fails Over To Another Uplink", "[wifi][internal][uplink]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    WiFiManagerTestAccessor accessor(wm);
+    esp_netif_t *eth = (esp_netif_t *)0x5678;
+    wm.deinit();
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, wm.add_uplink(eth, 200));
+    wm.init();
+
+    // Ethernet preferred over Wi-Fi (Kconfig default 100), cable not plugged yet
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, wm.add_uplink(nullptr, 200));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.add_uplink(eth, 200));
+    TEST_ASSERT_EQUAL(2, wm.get_uplink_status().count);
+    TEST_ASSERT_NULL(wm.get_active_uplink());
+
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_credentials("UplinkSSID", "pass"));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(5000));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.connect(5000));
+    esp_netif_t *sta = wm.get_active_uplink();
+    TEST_ASSERT_NOT_NULL(sta);
+    TEST_ASSERT_EQUAL_PTR(sta, g_host_test_default_netif);
+
+    // Ethernet gets its address: Wi-Fi keeps the route for the hold (time stands still here)
+    ip_event_got_ip_t got = {};
+    got.esp_netif         = eth;
+    accessor.test_simulate_ip_event(IP_EVENT_ETH_GOT_IP, &got);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL_PTR(sta, wm.get_active_uplink());
+
+    // Wi-Fi leaves CONNECTED_GOT_IP: Ethernet takes over without waiting
+    TEST_ASSERT_EQUAL(ESP_OK, wm.disconnect(5000));
+    TEST_ASSERT_EQUAL_PTR(eth, wm.get_active_uplink());
+    TEST_ASSERT_EQUAL_PTR(eth, g_host_test_default_netif);
+    wifi_manager::UplinkStatus status = wm.get_uplink_status();
+    TEST_ASSERT_EQUAL(1, status.failovers);
+    TEST_ASSERT_EQUAL(1, status.failover_latency.count);
+
+    // Its probes fail too: no route left
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, wm.set_uplink_health((esp_netif_t *)0x9999, false));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_uplink_health(eth, false));
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_NULL(wm.get_active_uplink());
+    TEST_ASSERT_EQUAL(1, wm.get_uplink_status().outages);
+
+    // Back to Wi-Fi as soon as it reconnects
+    TEST_ASSERT_EQUAL(ESP_OK, wm.connect(5000));
+    TEST_ASSERT_EQUAL_PTR(sta, wm.get_active_uplink());
+
+    wm.deinit();
+    TEST_ASSERT_EQUAL(0, wm.get_uplink_status().count);
+    nvs_flash_deinit();
+}
+
+static wifi_manager::ChannelChange s_channel_changes[4];
+static int s_channel_change_count;
+
+static void record_channel_change(const wifi_manager::ChannelChange &change, void *arg)
+{
+    if (s_channel_change_count < 4) {
+        s_channel_changes[s_channel_change_count] = change;
+    }
+    s_channel_change_count++;
+}
+
+TEST_CASE("Internal: Channel Lock And Change Notifications", "[wifi][internal][channel]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    wm.init();
+    WiFiManagerTestAccessor accessor(wm);
+    s_channel_change_count = 0;
+    wm.set_channel_listener(record_channel_change, nullptr);
+
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_credentials("EspNowSSID", "pass"));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(5000));
+
+    // The first association announces its channel
+    g_host_test_auto_simulate_events = false;
+    accessor.test_send_connect_command(false);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    wifi_event_sta_connected_t connected = {};
+    connected.channel                    = 6;
+    accessor.test_simulate_wifi_event(WIFI_EVENT_STA_CONNECTED, &connected);
+    accessor.test_simulate_ip_event(IP_EVENT_STA_GOT_IP);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::CONNECTED_GOT_IP, wm.get_state());
+    TEST_ASSERT_EQUAL(6, wm.get_channel());
+    TEST_ASSERT_EQUAL(1, s_channel_change_count);
+    TEST_ASSERT_EQUAL(0, s_channel_changes[0].from);
+    TEST_ASSERT_EQUAL(6, s_channel_changes[0].to);
+    TEST_ASSERT_FALSE(s_channel_changes[0].pending);
+
+    // Locked on 6: the next connect scan starts there
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, wm.set_channel_lock(178));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_channel_lock(6));
+    g_host_test_auto_simulate_events = true;
+    TEST_ASSERT_EQUAL(ESP_OK, wm.disconnect(5000));
+    TEST_ASSERT_EQUAL(0, wm.get_channel());
+    g_host_test_auto_simulate_events = false;
+    accessor.test_send_connect_command(false);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(6, g_host_test_wifi_config.sta.channel);
+    TEST_ASSERT_EQUAL(WIFI_FAST_SCAN, g_host_test_wifi_config.sta.scan_method);
+
+    // Same channel again: the peers already know it
+    accessor.test_simulate_wifi_event(WIFI_EVENT_STA_CONNECTED, &connected);
+    accessor.test_simulate_ip_event(IP_EVENT_STA_GOT_IP);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(1, s_channel_change_count);
+
+    // Unlocked, the network moved to 11: reported once associated there
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_channel_lock(0));
+    g_host_test_auto_simulate_events = true;
+    TEST_ASSERT_EQUAL(ESP_OK, wm.disconnect(5000));
+    g_host_test_auto_simulate_events = false;
+    accessor.test_send_connect_command(false);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(0, g_host_test_wifi_config.sta.channel);
+    connected.channel = 11;
+    accessor.test_simulate_wifi_event(WIFI_EVENT_STA_CONNECTED, &connected);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(11, wm.get_channel());
+    TEST_ASSERT_EQUAL(2, s_channel_change_count);
+    TEST_ASSERT_EQUAL(6, s_channel_changes[1].from);
+    TEST_ASSERT_EQUAL(11, s_channel_changes[1].to);
+    TEST_ASSERT_FALSE(s_channel_changes[1].pending);
+
+    g_host_test_auto_simulate_events = true;
+    wm.set_channel_listener(nullptr, nullptr);
+    wm.deinit();
+    nvs_flash_deinit();
+}
+
+TEST_CASE("Internal: Lease Loss Keeps The Association", "[wifi][internal][ip]")
+{
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    WiFiManager &wm = WiFiManager::get_instance();
+    wm.deinit();
+    wm.init();
+    WiFiManagerTestAccessor accessor(wm);
+
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_credentials("LeaseSSID", "pass"));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.start(5000));
+    TEST_ASSERT_EQUAL(ESP_OK, wm.connect(5000));
+
+    // The lease expired: back to waiting for DHCP, then renewed
+    accessor.test_simulate_ip_event(IP_EVENT_STA_LOST_IP);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::CONNECTED_NO_IP, wm.get_state());
+    accessor.test_simulate_ip_event(IP_EVENT_STA_GOT_IP);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::CONNECTED_GOT_IP, wm.get_state());
+
+    // A global IPv6 address still meets ANY without the lease
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_ip_readiness(wifi_manager::IpReadiness::ANY));
+    ip_event_got_ip6_t got = {}; // The stubbed STA netif handle is NULL
+    uint8_t *bytes         = reinterpret_cast<uint8_t *>(got.ip6_info.ip.addr);
+    bytes[0]               = 0x20;
+    bytes[1]               = 0x01;
+    bytes[15]              = 1;
+    accessor.test_simulate_ip_event(IP_EVENT_GOT_IP6, &got);
+    accessor.test_simulate_ip_event(IP_EVENT_STA_LOST_IP);
+    vTaskDelay(pdMS_TO_TICKS(50));
+    TEST_ASSERT_EQUAL(WiFiManager::State::CONNECTED_GOT_IP, wm.get_state());
+
+    TEST_ASSERT_EQUAL(ESP_OK, wm.set_ip_readiness(wifi_manager::IpReadiness::IPV4));
+    wm.deinit();
+    nvs_flash_deinit();
+}
@@ -10,7 +10,15 @@ HOST_TESTS = [
     'wifi_event_handler',
     'wifi_state_machine',
     'wifi_sync_manager',
-    'integration_internal'
+    'wifi_timer_scheduler',
+    'wifi_retry_guard',
+    'wifi_log_ring',
+    'wifi_tx_power',
+    'wifi_roam_policy',
+    'wifi_uplink_arbiter',
+    'integration_internal',
+    'fsm_explorer',
+    'benchmarks'
 ]
 
 HOST_TEST_ROOT = os.path.dirname(os.path.abspath(__file__))
@@ -48,6 +56,12 @@ def test_host_component(test_dir):
 
     print(stdout)
 
+    # Benchmark measurements ("BENCH {json}") are kept for comparison between releases
+    bench_lines = [line[len("BENCH "):] for line in stdout.splitlines() if line.startswith("BENCH {")]
+    if bench_lines:
+        with open(os.path.join(build_dir, "bench_results.jsonl"), "w") as results:
+            results.write("\n".join(bench_lines) + "\n")
+
     # 4. Check results (Unity output)
     summary_match = re.search(r"(\d+) Tests (\d+) Failures (\d+) Ignored", stdout)
     assert summary_match is not None, f"Unity test summary not found in output for {test_dir}"
@@ -3,6 +3,7 @@
 #include "wifi_config_storage.hpp"
 #include "wifi_driver_hal.hpp"
 #include <unity.h>
+#include <cstring>
 #include <string>
 #include "host_test_common.hpp"
 
@@ -58,6 +59,27 @@ TEST_CASE("WiFiConfigStorage credentials save and load", "[config_storage]")
     nvs_flash_deinit();
 }
 
+TEST_CASE("WiFiConfigStorage rejects null credentials", "[config_storage]")
+{
+    WiFiDriverHAL hal;
+    WiFiConfigStorage storage(hal, "test_wifi");
+
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    hal.init_wifi();
+    hal.set_mode_sta();
+
+    storage.init();
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, storage.save_credentials(nullptr, "test_pass"));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, storage.save_credentials("test_ssid", nullptr));
+    TEST_ASSERT_FALSE(storage.is_valid());
+
+    hal.deinit();
+    nvs_flash_deinit();
+}
+
 TEST_CASE("WiFiConfigStorage clear and valid flag", "[config_storage]")
 {
     WiFiDriverHAL hal;
@@ -130,3 +152,134 @@ TEST_CASE("WiFiConfigStorage fallback to Kconfig", "[config_storage]")
     hal.deinit();
     nvs_flash_deinit();
 }
+
+TEST_CASE("WiFiConfigStorage hidden network and channel", "[config_storage]")
+{
+    WiFiDriverHAL hal;
+
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    hal.init_wifi();
+
+    {
+        WiFiConfigStorage storage(hal, "test_wifi");
+        storage.init();
+        TEST_ASSERT_FALSE(storage.is_hidden());
+        TEST_ASSERT_EQUAL(0, storage.get_channel());
+
+        TEST_ASSERT_EQUAL(ESP_OK, storage.save_credentials("hidden_ap", "pass", true));
+        TEST_ASSERT_EQUAL(ESP_OK, storage.save_channel(6));
+    }
+
+    // Both survive a reboot
+    {
+        WiFiConfigStorage storage(hal, "test_wifi");
+        storage.init();
+        TEST_ASSERT_TRUE(storage.is_hidden());
+        TEST_ASSERT_EQUAL(6, storage.get_channel());
+
+        // A new network starts without a channel
+        TEST_ASSERT_EQUAL(ESP_OK, storage.save_credentials("other_ap", "pass"));
+        TEST_ASSERT_FALSE(storage.is_hidden());
+        TEST_ASSERT_EQUAL(0, storage.get_channel());
+
+        storage.save_credentials("hidden_ap", "pass", true);
+        storage.save_channel(11);
+        TEST_ASSERT_EQUAL(ESP_OK, storage.clear_credentials());
+        TEST_ASSERT_FALSE(storage.is_hidden());
+        TEST_ASSERT_EQUAL(0, storage.get_channel());
+    }
+
+    hal.deinit();
+    nvs_flash_deinit();
+}
+
+TEST_CASE("WiFiConfigStorage PHY modes", "[config_storage]")
+{
+    using wifi_manager::PhyConfig;
+    WiFiDriverHAL hal;
+
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    hal.init_wifi();
+
+    PhyConfig phy;
+    phy.protocols = PhyConfig::PROTOCOL_11B | PhyConfig::PROTOCOL_11G;
+    phy.bandwidth = wifi_manager::Bandwidth::HT20;
+    {
+        WiFiConfigStorage storage(hal, "test_wifi");
+        storage.init();
+        TEST_ASSERT_TRUE(storage.get_phy() == PhyConfig{});
+
+        storage.save_credentials("legacy_ap", "pass");
+        TEST_ASSERT_EQUAL(ESP_OK, storage.save_phy(phy));
+    }
+
+    // Survives a reboot, and goes with the network
+    {
+        WiFiConfigStorage storage(hal, "test_wifi");
+        storage.init();
+        TEST_ASSERT_TRUE(storage.get_phy() == phy);
+
+        TEST_ASSERT_EQUAL(ESP_OK, storage.save_credentials("other_ap", "pass"));
+        TEST_ASSERT_TRUE(storage.get_phy() == PhyConfig{});
+    }
+
+    hal.deinit();
+    nvs_flash_deinit();
+}
+
+TEST_CASE("WiFiConfigStorage enterprise profile", "[config_storage]")
+{
+    using wifi_manager::EnterpriseProfile;
+    WiFiDriverHAL hal;
+
+    nvs_flash_erase();
+    nvs_flash_init();
+
+    hal.init_wifi();
+
+    EnterpriseProfile profile = {};
+    profile.method            = wifi_manager::EapMethod::PEAP;
+    profile.resumption        = true;
+    strcpy(profile.identity, "anonymous@corp");
+    strcpy(profile.username, "device42");
+    {
+        WiFiConfigStorage storage(hal, "test_wifi");
+        storage.init();
+        TEST_ASSERT_FALSE(storage.get_enterprise().is_enterprise());
+
+        // No password for PEAP
+        TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, storage.save_enterprise_credentials("corp", profile));
+        strcpy(profile.password, "secret");
+        TEST_ASSERT_EQUAL(ESP_OK, storage.save_enterprise_credentials("corp", profile, true));
+        TEST_ASSERT_EQUAL(WIFI_AUTH_WPA2_ENTERPRISE, g_host_test_wifi_config.sta.threshold.authmode);
+        TEST_ASSERT_EQUAL(0, g_host_test_wifi_config.sta.password[0]);
+    }
+
+    // Survives a reboot, and goes with the network
+    {
+        WiFiConfigStorage storage(hal, "test_wifi");
+        storage.init();
+        TEST_ASSERT_TRUE(storage.is_valid());
+        TEST_ASSERT_TRUE(storage.is_hidden());
+        const EnterpriseProfile &loaded = storage.get_enterprise();
+        TEST_ASSERT_EQUAL(wifi_manager::EapMethod::PEAP, loaded.method);
+        TEST_ASSERT_TRUE(loaded.resumption);
+        TEST_ASSERT_EQUAL_STRING("device42", loaded.username);
+        TEST_ASSERT_EQUAL_STRING("secret", loaded.password);
+
+        TEST_ASSERT_EQUAL(ESP_OK, storage.save_credentials("home", "pass"));
+        TEST_ASSERT_FALSE(storage.get_enterprise().is_enterprise());
+    }
+    {
+        WiFiConfigStorage storage(hal, "test_wifi");
+        storage.init();
+        TEST_ASSERT_FALSE(storage.get_enterprise().is_enterprise());
+    }
+
+    hal.deinit();
+    nvs_flash_deinit();
+}
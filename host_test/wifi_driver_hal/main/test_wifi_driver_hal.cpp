@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include "nvs_flash.h"
 #include "unity.h"
 #include "wifi_driver_hal.hpp"
@@ -60,3 +62,277 @@ TEST_CASE("WiFiDriverHAL: Set Mode and Start/Stop", "[driver]")
     driver.deinit();
     nvs_flash_deinit();
 }
+
+static wifi_country_t s_country;
+
+static esp_err_t stub_set_country(const wifi_country_t *country, int cmock_num_calls)
+{
+    s_country = *country;
+    return ESP_OK;
+}
+
+TEST_CASE("WiFiDriverHAL: Channel Plan", "[driver]")
+{
+    WiFiDriverHAL driver;
+    wifi_manager::ChannelPlan plan = {"US", 1, 11, false, 30, 80, 200};
+
+    // Inconsistent plans never reach the driver
+    esp_wifi_set_country_Stub(stub_set_country);
+    s_country = {};
+    wifi_manager::ChannelPlan bad = plan;
+    bad.channel_count             = 14; // Channels 1-14 fit, 1-15 do not
+    bad.first_channel             = 2;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, driver.apply_channel_plan(bad));
+    bad            = plan;
+    bad.country[0] = '\0';
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, driver.apply_channel_plan(bad));
+    bad               = plan;
+    bad.active_min_ms = 100; // Above active_max_ms
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, driver.apply_channel_plan(bad));
+    TEST_ASSERT_EQUAL(0, s_country.nchan);
+
+    // The country is forced, the credentials are kept and the method is patched in
+    memcpy(g_host_test_wifi_config.sta.ssid, "plan_ap", 7);
+    g_host_test_wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    TEST_ASSERT_EQUAL(ESP_OK, driver.apply_channel_plan(plan));
+    TEST_ASSERT_EQUAL_STRING("US", s_country.cc);
+    TEST_ASSERT_EQUAL(1, s_country.schan);
+    TEST_ASSERT_EQUAL(11, s_country.nchan);
+    TEST_ASSERT_EQUAL(WIFI_COUNTRY_POLICY_MANUAL, s_country.policy);
+    TEST_ASSERT_EQUAL_STRING("plan_ap", (const char *)g_host_test_wifi_config.sta.ssid);
+    TEST_ASSERT_EQUAL(WIFI_ALL_CHANNEL_SCAN, g_host_test_wifi_config.sta.scan_method);
+
+    plan.fast_scan = true;
+    TEST_ASSERT_EQUAL(ESP_OK, driver.apply_channel_plan(plan));
+    TEST_ASSERT_EQUAL(WIFI_FAST_SCAN, g_host_test_wifi_config.sta.scan_method);
+
+    // A driver error is reported
+    esp_wifi_set_country_IgnoreAndReturn(ESP_ERR_INVALID_ARG);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, driver.apply_channel_plan(plan));
+}
+
+static uint8_t s_protocol;
+static wifi_bandwidth_t s_bandwidth;
+static int s_phy_writes;
+
+static esp_err_t stub_set_protocol(wifi_interface_t ifx, uint8_t protocol_bitmap, int cmock_num_calls)
+{
+    s_protocol = protocol_bitmap;
+    s_phy_writes++;
+    return ESP_OK;
+}
+
+static esp_err_t stub_set_bandwidth(wifi_interface_t ifx, wifi_bandwidth_t bw, int cmock_num_calls)
+{
+    s_bandwidth = bw;
+    return ESP_OK;
+}
+
+TEST_CASE("WiFiDriverHAL: PHY Modes", "[driver]")
+{
+    using wifi_manager::PhyConfig;
+    WiFiDriverHAL driver;
+    esp_wifi_set_protocol_Stub(stub_set_protocol);
+    esp_wifi_set_bandwidth_Stub(stub_set_bandwidth);
+    s_phy_writes = 0;
+
+    // Defaults while nothing was changed: no driver call at all
+    TEST_ASSERT_EQUAL(ESP_OK, driver.set_phy(PhyConfig{}));
+    TEST_ASSERT_EQUAL(0, s_phy_writes);
+
+    // 802.11n without 802.11g, or HT40 without 802.11n, never reaches the driver
+    PhyConfig bad;
+    bad.protocols = PhyConfig::PROTOCOL_11B | PhyConfig::PROTOCOL_11N;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, driver.set_phy(bad));
+    bad.protocols = PhyConfig::PROTOCOL_11B | PhyConfig::PROTOCOL_11G;
+    bad.bandwidth = wifi_manager::Bandwidth::HT40;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, driver.set_phy(bad));
+    TEST_ASSERT_EQUAL(0, s_phy_writes);
+
+    PhyConfig bg;
+    bg.protocols = PhyConfig::PROTOCOL_11B | PhyConfig::PROTOCOL_11G;
+    TEST_ASSERT_EQUAL(ESP_OK, driver.set_phy(bg));
+    TEST_ASSERT_EQUAL_HEX8(WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G, s_protocol);
+    TEST_ASSERT_EQUAL(WIFI_BW_HT20, s_bandwidth); // Driver default
+    TEST_ASSERT_EQUAL(1, s_phy_writes);
+
+    // Reapplying before every association costs nothing
+    TEST_ASSERT_EQUAL(ESP_OK, driver.set_phy(bg));
+    TEST_ASSERT_EQUAL(1, s_phy_writes);
+
+    PhyConfig ht40;
+    ht40.bandwidth = wifi_manager::Bandwidth::HT40;
+    TEST_ASSERT_EQUAL(ESP_OK, driver.set_phy(ht40));
+    TEST_ASSERT_EQUAL_HEX8(WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N, s_protocol);
+    TEST_ASSERT_EQUAL(WIFI_BW_HT40, s_bandwidth);
+
+    // Back to the defaults restores what the driver started with
+    TEST_ASSERT_EQUAL(ESP_OK, driver.set_phy(PhyConfig{}));
+    TEST_ASSERT_EQUAL_HEX8(WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N, s_protocol);
+    TEST_ASSERT_EQUAL(WIFI_BW_HT20, s_bandwidth);
+    TEST_ASSERT_EQUAL(3, s_phy_writes);
+}
+
+static int8_t s_tx_power;
+static int s_tx_power_writes;
+
+static esp_err_t stub_set_max_tx_power(int8_t power, int cmock_num_calls)
+{
+    s_tx_power = power;
+    s_tx_power_writes++;
+    return ESP_OK;
+}
+
+TEST_CASE("WiFiDriverHAL: TX Power Limit", "[driver]")
+{
+    WiFiDriverHAL driver;
+    esp_wifi_set_max_tx_power_Stub(stub_set_max_tx_power);
+    s_tx_power_writes = 0;
+
+    // Nothing changed: nothing to restore
+    TEST_ASSERT_EQUAL(ESP_OK, driver.restore_max_tx_power());
+    TEST_ASSERT_EQUAL(0, s_tx_power_writes);
+
+    // Only changes reach the driver
+    TEST_ASSERT_EQUAL(ESP_OK, driver.set_max_tx_power(80));
+    TEST_ASSERT_EQUAL(ESP_OK, driver.set_max_tx_power(80));
+    TEST_ASSERT_EQUAL(ESP_OK, driver.set_max_tx_power(32));
+    TEST_ASSERT_EQUAL(32, s_tx_power);
+    TEST_ASSERT_EQUAL(2, s_tx_power_writes);
+
+    // Back to the limit the driver had before the first change, not to full power
+    TEST_ASSERT_EQUAL(ESP_OK, driver.restore_max_tx_power());
+    TEST_ASSERT_EQUAL(78, s_tx_power);
+    TEST_ASSERT_EQUAL(ESP_OK, driver.restore_max_tx_power());
+    TEST_ASSERT_EQUAL(3, s_tx_power_writes);
+}
+
+TEST_CASE("WiFiDriverHAL: TWT Without 802.11ax", "[driver]")
+{
+    WiFiDriverHAL driver;
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, driver.setup_twt({0, 0}));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, driver.setup_twt({10000, 20000}));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, driver.setup_twt({1000000, 10000}));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, driver.teardown_twt());
+}
+
+TEST_CASE("WiFiDriverHAL: Enterprise Without A Supplicant", "[driver]")
+{
+    WiFiDriverHAL driver;
+
+    wifi_manager::EnterpriseProfile profile = {};
+    profile.method                          = wifi_manager::EapMethod::TLS;
+    strcpy(profile.identity, "device42");
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, driver.configure_enterprise(profile, nullptr, nullptr, nullptr));
+
+    // A valid profile still needs its certificates resolved
+    strcpy(profile.client_cert, "cert");
+    strcpy(profile.client_key, "key");
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, driver.configure_enterprise(profile, nullptr, nullptr, nullptr));
+
+    // The linux host target has no wpa_supplicant
+    static const uint8_t pem[] = "-----BEGIN CERTIFICATE-----";
+
+    wifi_manager::Certificate cert = {"cert", pem, sizeof(pem)};
+    wifi_manager::Certificate key  = {"key", pem, sizeof(pem)};
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, driver.configure_enterprise(profile, nullptr, &cert, &key));
+    TEST_ASSERT_EQUAL(ESP_OK, driver.disable_enterprise());
+}
+
+static int s_config_writes;
+
+static esp_err_t stub_counting_set_config(wifi_interface_t ifx, wifi_config_t *conf, int cmock_num_calls)
+{
+    memcpy(&g_host_test_wifi_config, conf, sizeof(wifi_config_t));
+    s_config_writes++;
+    return ESP_OK;
+}
+
+static uint8_t s_scan_channel;
+
+static esp_err_t stub_scan_start(const wifi_scan_config_t *config, bool block, int cmock_num_calls)
+{
+    s_scan_channel = config->channel;
+    return ESP_OK;
+}
+
+TEST_CASE("WiFiDriverHAL: Roam Scan And BSSID Pinning", "[driver]")
+{
+    WiFiDriverHAL driver;
+    esp_wifi_set_config_Stub(stub_counting_set_config);
+    esp_wifi_scan_start_Stub(stub_scan_start);
+    s_config_writes = 0;
+
+    // ft_enabled and the pinned AP are only written when they change
+    TEST_ASSERT_EQUAL(ESP_OK, driver.set_ft(true));
+    TEST_ASSERT_EQUAL(ESP_OK, driver.set_ft(true));
+    TEST_ASSERT_TRUE(g_host_test_wifi_config.sta.ft_enabled);
+    TEST_ASSERT_EQUAL(1, s_config_writes);
+
+    wifi_manager::RoamCandidate target = {{0x02, 0, 0, 0, 0, 0xB}, -50, 6};
+    TEST_ASSERT_EQUAL(ESP_OK, driver.pin_bssid(&target));
+    TEST_ASSERT_EQUAL(ESP_OK, driver.pin_bssid(&target));
+    TEST_ASSERT_TRUE(g_host_test_wifi_config.sta.bssid_set);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(target.bssid, g_host_test_wifi_config.sta.bssid, 6);
+    TEST_ASSERT_EQUAL(6, g_host_test_wifi_config.sta.channel);
+    TEST_ASSERT_EQUAL(2, s_config_writes);
+
+    TEST_ASSERT_EQUAL(ESP_OK, driver.pin_bssid(nullptr));
+    TEST_ASSERT_EQUAL(ESP_OK, driver.pin_bssid(nullptr));
+    TEST_ASSERT_FALSE(g_host_test_wifi_config.sta.bssid_set);
+    TEST_ASSERT_EQUAL(0, g_host_test_wifi_config.sta.channel);
+    TEST_ASSERT_TRUE(g_host_test_wifi_config.sta.ft_enabled);
+    TEST_ASSERT_EQUAL(3, s_config_writes);
+
+    // The records are converted, up to the caller's buffer, and read once
+    for (uint8_t i = 0; i < 3; i++) {
+        memset(&g_host_test_scan[i], 0, sizeof(wifi_ap_record_t));
+        g_host_test_scan[i].bssid[5] = i;
+        g_host_test_scan[i].rssi     = (int8_t)(-60 - i);
+        g_host_test_scan[i].primary  = (uint8_t)(1 + 5 * i);
+    }
+    g_host_test_scan_count = 3;
+    TEST_ASSERT_EQUAL(ESP_OK, driver.start_roam_scan(6));
+    TEST_ASSERT_EQUAL(6, s_scan_channel);
+    TEST_ASSERT_EQUAL(ESP_OK, driver.start_roam_scan(0));
+    TEST_ASSERT_EQUAL(0, s_scan_channel);
+
+    wifi_manager::RoamCandidate candidates[WiFiDriverHAL::ROAM_RECORDS_MAX];
+    size_t count = 2;
+    TEST_ASSERT_EQUAL(ESP_OK, driver.get_roam_candidates(candidates, count));
+    TEST_ASSERT_EQUAL(2, count);
+    TEST_ASSERT_EQUAL(1, candidates[1].bssid[5]);
+    TEST_ASSERT_EQUAL(-61, candidates[1].rssi);
+    TEST_ASSERT_EQUAL(6, candidates[1].channel);
+
+    count = WiFiDriverHAL::ROAM_RECORDS_MAX;
+    TEST_ASSERT_EQUAL(ESP_OK, driver.get_roam_candidates(candidates, count));
+    TEST_ASSERT_EQUAL(0, count);
+
+    uint8_t bssid[6];
+    g_host_test_bssid[5] = 0xA;
+    TEST_ASSERT_EQUAL(ESP_OK, driver.get_bssid(bssid));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(g_host_test_bssid, bssid, 6);
+}
+
+static esp_err_t stub_get_ip_info_assigned(esp_netif_t *esp_netif, esp_netif_ip_info_t *ip_info, int cmock_num_calls)
+{
+    ip_info->ip.addr = 0x0101a8c0; // 192.168.1.1
+    return ESP_OK;
+}
+
+TEST_CASE("WiFiDriverHAL: Uplink Netifs", "[hal]")
+{
+    WiFiDriverHAL driver;
+    esp_netif_t *eth = (esp_netif_t *)0x5602;
+
+    // No address until the netif reports one
+    TEST_ASSERT_FALSE(driver.netif_has_ip(eth));
+    esp_netif_get_ip_info_Stub(stub_get_ip_info_assigned);
+    TEST_ASSERT_TRUE(driver.netif_has_ip(eth));
+
+    TEST_ASSERT_EQUAL(2, driver.netif_index(eth));
+    TEST_ASSERT_EQUAL(ESP_OK, driver.set_default_netif(eth));
+    TEST_ASSERT_EQUAL_PTR(eth, g_host_test_default_netif);
+}
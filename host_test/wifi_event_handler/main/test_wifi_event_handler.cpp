@@ -36,13 +36,130 @@ TEST_CASE("WiFiEventHandler: Translator Test", "[event]")
     TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
     TEST_ASSERT_EQUAL(EventId::STA_CONNECTED, msg.event);
 
+    // The association channel travels in the payload
+    wifi_event_sta_connected_t conn_data = {};
+    conn_data.channel                    = 11;
+    WiFiEventHandler::wifi_event_handler(queue, WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &conn_data);
+    TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
+    TEST_ASSERT_EQUAL(EventId::STA_CONNECTED, msg.event);
+    TEST_ASSERT_EQUAL(11, msg.payload.channel);
+
     // 3. Test WIFI_EVENT_STA_DISCONNECTED -> EventId::STA_DISCONNECTED
     wifi_event_sta_disconnected_t disc_data = {};
     disc_data.reason                        = WIFI_REASON_AUTH_EXPIRE;
+    disc_data.rssi                          = -82;
 
     WiFiEventHandler::wifi_event_handler(queue, WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disc_data);
     TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
     TEST_ASSERT_EQUAL(EventId::STA_DISCONNECTED, msg.event);
+    TEST_ASSERT_EQUAL(WIFI_REASON_AUTH_EXPIRE, msg.payload.disconnected.reason);
+    TEST_ASSERT_EQUAL(-82, msg.payload.disconnected.rssi);
+
+    // 4. Test WIFI_EVENT_SCAN_DONE -> EventId::SCAN_DONE (the roam scan)
+    WiFiEventHandler::wifi_event_handler(queue, WIFI_EVENT, WIFI_EVENT_SCAN_DONE, nullptr);
+    TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
+    TEST_ASSERT_EQUAL(EventId::SCAN_DONE, msg.event);
+
+    vQueueDelete(queue);
+}
+
+TEST_CASE("WiFiEventHandler: Events Are Timestamped", "[event]")
+{
+    QueueHandle_t queue = xQueueCreate(10, sizeof(Message));
+    TEST_ASSERT_NOT_NULL(queue);
+
+    esp_timer_get_time_IgnoreAndReturn(123456);
+
+    Message msg;
+    WiFiEventHandler::wifi_event_handler(queue, WIFI_EVENT, WIFI_EVENT_STA_START, nullptr);
+    TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
+    TEST_ASSERT_EQUAL_UINT32(123456, msg.timestamp_us);
+
+    WiFiEventHandler::ip_event_handler(queue, IP_EVENT, IP_EVENT_STA_GOT_IP, nullptr);
+    TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
+    TEST_ASSERT_EQUAL(EventId::GOT_IP, msg.event);
+    TEST_ASSERT_EQUAL_UINT32(123456, msg.timestamp_us);
+
+    vQueueDelete(queue);
+}
+
+TEST_CASE("WiFiEventHandler: IPv6 Addresses", "[event]")
+{
+    QueueHandle_t queue = xQueueCreate(10, sizeof(Message));
+    TEST_ASSERT_NOT_NULL(queue);
+    esp_netif_t *sta = (esp_netif_t *)0x1234;
+    esp_netif_get_handle_from_ifkey_IgnoreAndReturn(sta);
+
+    Message msg;
+    WiFiEventHandler::ip_event_handler(queue, IP_EVENT, IP_EVENT_STA_GOT_IP, nullptr);
+    TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
+    TEST_ASSERT_EQUAL(EventId::GOT_IP, msg.event);
+    TEST_ASSERT_EQUAL(AddressKind::IPV4, msg.payload.address);
+
+    // The lease expired without renewal
+    WiFiEventHandler::ip_event_handler(queue, IP_EVENT, IP_EVENT_STA_LOST_IP, nullptr);
+    TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
+    TEST_ASSERT_EQUAL(EventId::LOST_IP, msg.event);
+    TEST_ASSERT_EQUAL(AddressKind::IPV4, msg.payload.address);
+
+    // fe80::1 on the STA netif
+    ip_event_got_ip6_t got = {};
+    got.esp_netif          = sta;
+    uint8_t *bytes         = reinterpret_cast<uint8_t *>(got.ip6_info.ip.addr);
+    bytes[0]               = 0xfe;
+    bytes[1]               = 0x80;
+    bytes[15]              = 1;
+    WiFiEventHandler::ip_event_handler(queue, IP_EVENT, IP_EVENT_GOT_IP6, &got);
+    TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
+    TEST_ASSERT_EQUAL(EventId::GOT_IP, msg.event);
+    TEST_ASSERT_EQUAL(AddressKind::IPV6_LINK_LOCAL, msg.payload.address);
+
+    // 2001:db8::1
+    bytes[0] = 0x20;
+    bytes[1] = 0x01;
+    bytes[2] = 0x0d;
+    bytes[3] = 0xb8;
+    WiFiEventHandler::ip_event_handler(queue, IP_EVENT, IP_EVENT_GOT_IP6, &got);
+    TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
+    TEST_ASSERT_EQUAL(AddressKind::IPV6_GLOBAL, msg.payload.address);
+
+    // Another interface (e.g. Ethernet) is not ours
+    got.esp_netif = (esp_netif_t *)0x5678;
+    WiFiEventHandler::ip_event_handler(queue, IP_EVENT, IP_EVENT_GOT_IP6, &got);
+    TEST_ASSERT_FALSE(xQueueReceive(queue, &msg, 0));
+
+    vQueueDelete(queue);
+}
+
+TEST_CASE("WiFiEventHandler: Other Uplinks", "[event]")
+{
+    QueueHandle_t queue = xQueueCreate(10, sizeof(Message));
+    TEST_ASSERT_NOT_NULL(queue);
+
+    // Ethernet and PPP addresses reach the arbiter tagged with the lwIP index (stub: low byte)
+    ip_event_got_ip_t got = {};
+    got.esp_netif         = (esp_netif_t *)0x5607;
+
+    Message msg;
+    WiFiEventHandler::ip_event_handler(queue, IP_EVENT, IP_EVENT_ETH_GOT_IP, &got);
+    TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
+    TEST_ASSERT_EQUAL(EventId::UPLINK_UP, msg.event);
+    TEST_ASSERT_EQUAL(7, msg.payload.netif_index);
+
+    WiFiEventHandler::ip_event_handler(queue, IP_EVENT, IP_EVENT_ETH_LOST_IP, &got);
+    TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
+    TEST_ASSERT_EQUAL(EventId::UPLINK_DOWN, msg.event);
+    TEST_ASSERT_EQUAL(7, msg.payload.netif_index);
+
+    got.esp_netif = (esp_netif_t *)0x5608;
+    WiFiEventHandler::ip_event_handler(queue, IP_EVENT, IP_EVENT_PPP_GOT_IP, &got);
+    TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
+    TEST_ASSERT_EQUAL(EventId::UPLINK_UP, msg.event);
+    TEST_ASSERT_EQUAL(8, msg.payload.netif_index);
+
+    WiFiEventHandler::ip_event_handler(queue, IP_EVENT, IP_EVENT_PPP_LOST_IP, &got);
+    TEST_ASSERT_TRUE(xQueueReceive(queue, &msg, 0));
+    TEST_ASSERT_EQUAL(EventId::UPLINK_DOWN, msg.event);
 
     vQueueDelete(queue);
 }
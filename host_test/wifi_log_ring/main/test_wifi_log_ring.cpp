@@ -0,0 +1,199 @@
+#include <cstring>
+#include <thread>
+
+#include "sdkconfig.h"
+#include "unity.h"
+#include "wifi_log_ring.hpp"
+#include "host_test_common.hpp"
+
+using namespace wifi_manager;
+
+void setUp(void)
+{
+    host_test_setup_common_mocks();
+}
+
+void tearDown(void)
+{
+}
+
+static bool write_record(WiFiLogRing &ring, int64_t now_us, int32_t arg)
+{
+    bool was_empty;
+    return ring.write(now_us, LogId::RECONNECT_SCHEDULED, arg, 0, 0, was_empty);
+}
+
+TEST_CASE("WiFiLogRing: FIFO Order and Wrap-around", "[log]")
+{
+    LogRecord storage[4];
+    WiFiLogRing ring(storage, 4, 0, 1);
+    LogRecord record;
+    bool was_empty;
+
+    TEST_ASSERT_FALSE(ring.read(record));
+
+    // Only the first write of an empty ring asks for a wake-up
+    TEST_ASSERT_TRUE(ring.write(1000, LogId::TRANSITION, 1, 2, 3, was_empty));
+    TEST_ASSERT_TRUE(was_empty);
+    TEST_ASSERT_TRUE(ring.write(2000, LogId::GOT_IP, 0, 0, 0, was_empty));
+    TEST_ASSERT_FALSE(was_empty);
+
+    TEST_ASSERT_TRUE(ring.read(record));
+    TEST_ASSERT_EQUAL(LogId::TRANSITION, record.id);
+    TEST_ASSERT_EQUAL_UINT32(5120, record.age_us(1000 + 5120)); // 256 us steps
+    TEST_ASSERT_EQUAL_INT32(3, record.args[2]);
+    TEST_ASSERT_TRUE(ring.read(record));
+    TEST_ASSERT_EQUAL(LogId::GOT_IP, record.id);
+    TEST_ASSERT_FALSE(ring.read(record));
+
+    // Several laps over the 4 slots keep the order
+    for (int32_t i = 0; i < 10; i++) {
+        TEST_ASSERT_TRUE(write_record(ring, 3000 + i, i));
+        TEST_ASSERT_TRUE(ring.read(record));
+        TEST_ASSERT_EQUAL_INT32(i, record.args[0]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(12, ring.stats().written);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.take_dropped());
+
+    // The age survives the wrap of the 24-bit timestamp
+    const int64_t wrap_us = (int64_t)(LogRecord::TIME_MASK + 1) << LogRecord::TIME_SHIFT;
+    TEST_ASSERT_TRUE(ring.write(wrap_us - 512, LogId::GOT_IP, 0, 0, 0, was_empty));
+    TEST_ASSERT_TRUE(ring.read(record));
+    TEST_ASSERT_EQUAL_UINT32(1024, record.age_us(wrap_us + 512));
+}
+
+TEST_CASE("WiFiLogRing: Full Ring Drops Newest", "[log]")
+{
+    LogRecord storage[4];
+    WiFiLogRing ring(storage, 4, 0, 1);
+    LogRecord record;
+
+    for (int32_t i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL(i < 4, write_record(ring, 0, i));
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, ring.stats().dropped_full);
+    TEST_ASSERT_EQUAL_UINT32(2, ring.take_dropped());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.take_dropped()); // Reported once
+
+    // The records already queued are intact
+    for (int32_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(ring.read(record));
+        TEST_ASSERT_EQUAL_INT32(i, record.args[0]);
+    }
+    TEST_ASSERT_TRUE(write_record(ring, 0, 4));
+}
+
+TEST_CASE("WiFiLogRing: Rate Limit", "[log]")
+{
+    LogRecord storage[64];
+    WiFiLogRing ring(storage, 64, 10, 5); // 10 records/s, burst of 5
+    LogRecord record;
+
+    // The burst goes through, then nothing until a token refills (100 ms at 10/s)
+    int accepted = 0;
+    for (int i = 0; i < 20; i++) {
+        accepted += write_record(ring, 1000000, i) ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL(5, accepted);
+    TEST_ASSERT_FALSE(write_record(ring, 1099000, 0));
+    TEST_ASSERT_TRUE(write_record(ring, 1100000, 0));
+    TEST_ASSERT_FALSE(write_record(ring, 1100000, 0));
+
+    // A storm over one second keeps to the sustained rate
+    accepted = 0;
+    for (int64_t t = 1100000; t <= 2100000; t += 1000) {
+        accepted += write_record(ring, t, 0) ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL(10, accepted);
+
+    // A long silence refills the burst, not more
+    accepted = 0;
+    for (int i = 0; i < 20; i++) {
+        accepted += write_record(ring, 60000000, i) ? 1 : 0;
+    }
+    TEST_ASSERT_EQUAL(5, accepted);
+
+    LogRingStats stats = ring.stats();
+    TEST_ASSERT_EQUAL_UINT32(21, stats.written);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped_full);
+    TEST_ASSERT_EQUAL_UINT32(15 + 2 + 991 + 15, stats.dropped_rate);
+    while (ring.read(record)) {
+    }
+}
+
+TEST_CASE("WiFiLogRing: Formatting", "[log]")
+{
+    char line[128];
+    LogRecord record = {0, LogId::STA_DISCONNECTED, {201, -50, 0}};
+
+    format_record(record, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("Task Event: STA_DISCONNECTED (reason: 201, RSSI=-50 dBm [GOOD])", line);
+
+    // The quality label is derived from the RSSI argument
+    record.args[1] = -90;
+    format_record(record, line, sizeof(line));
+    TEST_ASSERT_NOT_NULL(strstr(line, "[CRITICAL]"));
+
+    record = {0, LogId::RECONNECT_SCHEDULED, {3, 4000, 0}};
+    TEST_ASSERT_EQUAL(strlen("Reconnection attempt 3 in 4000 ms..."), format_record(record, line, sizeof(line)));
+    TEST_ASSERT_EQUAL_STRING("Reconnection attempt 3 in 4000 ms...", line);
+
+    // Truncation always leaves a terminated string
+    TEST_ASSERT_EQUAL(7, format_record(record, line, 8));
+    TEST_ASSERT_EQUAL_STRING("Reconne", line);
+
+    // Texts above CONFIG_WIFI_MANAGER_LOG_LEVEL are not linked; the id and arguments remain
+#if CONFIG_WIFI_MANAGER_LOG_LEVEL < 4
+    record = {0, LogId::TRANSITION, {1, 2, 3}};
+    format_record(record, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("Record 1 (1, 2, 3)", line);
+#endif
+
+    // Every id has a text and a level
+    for (int i = 0; i < (int)LogId::COUNT; i++) {
+        record.id = (LogId)i;
+        TEST_ASSERT_GREATER_THAN(0, format_record(record, line, sizeof(line)));
+        TEST_ASSERT_NULL(strstr(line, "Unknown"));
+        TEST_ASSERT_NOT_EQUAL((int)LogLevel::NONE, (int)log_level(record.id));
+    }
+}
+
+TEST_CASE("WiFiLogRing: Concurrent Producer and Consumer", "[log]")
+{
+    static constexpr int32_t RECORDS = 200000;
+    LogRecord storage[8];
+    WiFiLogRing ring(storage, 8, 0, 1);
+
+    std::thread producer([&ring]() {
+        for (int32_t i = 0; i < RECORDS;) {
+            bool was_empty;
+            if (ring.write(0, LogId::TRANSITION, i, ~i, i * 3, was_empty)) {
+                i++;
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // Every accepted record arrives once, in order and with consistent arguments
+    LogRecord record;
+    int32_t next = 0;
+    int32_t torn = 0;
+    while (next < RECORDS) {
+        if (ring.read(record)) {
+            if (record.args[0] != next || record.args[1] != ~next || record.args[2] != next * 3) {
+                torn++;
+            }
+            next++;
+        }
+        else {
+            std::this_thread::yield(); // A single-core host must let the producer run
+        }
+    }
+    producer.join();
+
+    TEST_ASSERT_EQUAL_INT32(0, torn);
+    TEST_ASSERT_FALSE(ring.read(record));
+    TEST_ASSERT_EQUAL_UINT32(RECORDS, ring.stats().written);
+}
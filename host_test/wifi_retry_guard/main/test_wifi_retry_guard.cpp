@@ -0,0 +1,108 @@
+#include <cstring>
+
+#include "unity.h"
+#include "wifi_retry_guard.hpp"
+#include "host_test_common.hpp"
+
+using namespace wifi_manager;
+
+static constexpr int64_t MS = 1000;
+
+void setUp(void)
+{
+    host_test_setup_common_mocks();
+}
+
+void tearDown(void)
+{
+}
+
+TEST_CASE("WiFiRetryGuard: Corrupt Record Starts Clean", "[retry_guard]")
+{
+    // Power-on leaves random RTC contents
+    WiFiRetryGuard::Record record;
+    memset(&record, 0xA5, sizeof(record));
+
+    WiFiRetryGuard guard(record);
+    guard.begin_boot(0);
+    TEST_ASSERT_EQUAL(1, guard.get_boot_count());
+    TEST_ASSERT_EQUAL(0, guard.get_retry_count());
+    TEST_ASSERT_EQUAL(0, guard.get_window_attempts());
+    TEST_ASSERT_FALSE(guard.is_crash_loop(3));
+
+    // A single flipped field is detected as well
+    guard.save_retry_count(4);
+    record.retry_count = 5;
+    WiFiRetryGuard after_reset(record);
+    after_reset.begin_boot(0);
+    TEST_ASSERT_EQUAL(1, after_reset.get_boot_count());
+    TEST_ASSERT_EQUAL(0, after_reset.get_retry_count());
+}
+
+TEST_CASE("WiFiRetryGuard: State Survives Resets", "[retry_guard]")
+{
+    WiFiRetryGuard::Record record = {};
+
+    // Every "reset" builds a fresh guard on the same record
+    for (int boot = 1; boot <= 4; boot++) {
+        WiFiRetryGuard guard(record);
+        guard.begin_boot(0);
+        TEST_ASSERT_EQUAL(boot, guard.get_boot_count());
+        guard.save_retry_count(boot);
+    }
+
+    WiFiRetryGuard guard(record);
+    guard.begin_boot(0);
+    TEST_ASSERT_EQUAL(5, guard.get_boot_count());
+    TEST_ASSERT_EQUAL(4, guard.get_retry_count());
+    TEST_ASSERT_TRUE(guard.is_crash_loop(3));
+    TEST_ASSERT_FALSE(guard.is_crash_loop(0)); // Detection disabled
+
+    // A stable link ends the loop; this boot stays counted
+    guard.mark_stable();
+    TEST_ASSERT_EQUAL(1, guard.get_boot_count());
+    TEST_ASSERT_FALSE(guard.is_crash_loop(3));
+
+    WiFiRetryGuard next_boot(record);
+    next_boot.begin_boot(0);
+    TEST_ASSERT_EQUAL(2, next_boot.get_boot_count());
+}
+
+TEST_CASE("WiFiRetryGuard: Hourly Attempt Budget", "[retry_guard]")
+{
+    WiFiRetryGuard::Record record = {};
+    WiFiRetryGuard guard(record);
+    guard.begin_boot(0);
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(0, guard.acquire_attempt(i * 1000 * MS, 3));
+    }
+
+    // Exhausted: the wait runs to the end of the window
+    TEST_ASSERT_EQUAL(WiFiRetryGuard::BUDGET_WINDOW_MS - 10000, guard.acquire_attempt(10000 * MS, 3));
+    TEST_ASSERT_EQUAL(3, guard.get_window_attempts());
+
+    // Unlimited budget still counts
+    TEST_ASSERT_EQUAL(0, guard.acquire_attempt(10000 * MS, 0));
+    TEST_ASSERT_EQUAL(4, guard.get_window_attempts());
+
+    // The window reopens after an hour
+    TEST_ASSERT_EQUAL(0, guard.acquire_attempt((int64_t)WiFiRetryGuard::BUDGET_WINDOW_MS * MS, 3));
+    TEST_ASSERT_EQUAL(1, guard.get_window_attempts());
+}
+
+TEST_CASE("WiFiRetryGuard: Budget Window Survives Resets", "[retry_guard]")
+{
+    WiFiRetryGuard::Record record = {};
+    {
+        WiFiRetryGuard guard(record);
+        guard.begin_boot(0);
+        TEST_ASSERT_EQUAL(0, guard.acquire_attempt(0, 2));
+        TEST_ASSERT_EQUAL(0, guard.acquire_attempt(600000 * MS, 2));
+    }
+
+    // After the reset the clock restarts at 0, but the window keeps its age (10 min)
+    WiFiRetryGuard guard(record);
+    guard.begin_boot(0);
+    TEST_ASSERT_EQUAL(WiFiRetryGuard::BUDGET_WINDOW_MS - 600000 - 5000, guard.acquire_attempt(5000 * MS, 2));
+}
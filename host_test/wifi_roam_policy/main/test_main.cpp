@@ -0,0 +1,10 @@
+#include "esp_system.h"
+#include "unity.h"
+
+extern "C" void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    UNITY_END();
+    esp_restart();
+}
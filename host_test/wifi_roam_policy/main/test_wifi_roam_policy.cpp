@@ -0,0 +1,248 @@
+#include <cstring>
+
+#include "unity.h"
+#include "wifi_roam_policy.hpp"
+#include "host_test_common.hpp"
+
+using namespace wifi_manager;
+
+void setUp(void)
+{
+    host_test_setup_common_mocks();
+}
+
+void tearDown(void)
+{
+}
+
+// Roam below -75 dBm to an AP 8 dB stronger, scanning at most every 30 s, with FT; APs on
+// the current channel count 4 dB stronger
+static const RoamConfig CONFIG = {-75, 8, true, 30000, 4};
+
+static const uint8_t AP_A[6] = {0x02, 0, 0, 0, 0, 0xA};
+static const uint8_t AP_B[6] = {0x02, 0, 0, 0, 0, 0xB};
+static const uint8_t AP_C[6] = {0x02, 0, 0, 0, 0, 0xC};
+
+static RoamCandidate candidate(const uint8_t (&bssid)[6], int8_t rssi, uint8_t channel)
+{
+    RoamCandidate c = {};
+    memcpy(c.bssid, bssid, sizeof(c.bssid));
+    c.rssi    = rssi;
+    c.channel = channel;
+    return c;
+}
+
+TEST_CASE("WiFiRoamPolicy: Scan Trigger", "[roam]")
+{
+    WiFiRoamPolicy policy(CONFIG);
+    TEST_ASSERT_EQUAL(FtState::UNKNOWN, policy.get_ft_state());
+
+    TEST_ASSERT_FALSE(policy.should_scan(-60, 0));
+    TEST_ASSERT_FALSE(policy.should_scan(-75, 0));
+    TEST_ASSERT_TRUE(policy.should_scan(-76, 1000));
+
+    // At most one scan per interval, across the 32-bit wrap of the time base
+    TEST_ASSERT_FALSE(policy.should_scan(-80, 1000 + 29999999));
+    TEST_ASSERT_TRUE(policy.should_scan(-80, 1000 + 30000000));
+    TEST_ASSERT_TRUE(policy.should_scan(-80, 0xFFFFFF00u));
+    TEST_ASSERT_FALSE(policy.should_scan(-80, 0xFFFFFF00u + 29999999));
+    TEST_ASSERT_TRUE(policy.should_scan(-80, 0xFFFFFF00u + 30000000));
+    TEST_ASSERT_EQUAL(4, policy.get_status().scans);
+
+    // Disabled by a zero trigger
+    RoamConfig off   = CONFIG;
+    off.trigger_rssi = 0;
+    TEST_ASSERT_TRUE(off.is_valid());
+    policy.set_config(off);
+    TEST_ASSERT_FALSE(policy.should_scan(-90, 0));
+
+    RoamConfig bad   = CONFIG;
+    bad.trigger_rssi = 5;
+    TEST_ASSERT_FALSE(bad.is_valid());
+}
+
+TEST_CASE("WiFiRoamPolicy: Candidate Selection", "[roam]")
+{
+    WiFiRoamPolicy policy(CONFIG);
+    RoamCandidate target;
+
+    // The current AP is ignored, whatever its scanned RSSI
+    RoamCandidate only_self[] = {candidate(AP_A, -40, 1)};
+    TEST_ASSERT_FALSE(policy.select(AP_A, -80, 1, only_self, 1, target));
+
+    // Within the hysteresis: not worth the gap
+    RoamCandidate weak[] = {candidate(AP_A, -80, 1), candidate(AP_B, -73, 6)};
+    TEST_ASSERT_FALSE(policy.select(AP_A, -80, 1, weak, 2, target));
+
+    // The strongest candidate above the hysteresis wins
+    RoamCandidate scan[] = {candidate(AP_A, -80, 1), candidate(AP_B, -72, 6), candidate(AP_C, -60, 11)};
+    TEST_ASSERT_TRUE(policy.select(AP_A, -80, 1, scan, 3, target));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(AP_C, target.bssid, 6);
+    TEST_ASSERT_EQUAL(11, target.channel);
+    TEST_ASSERT_EQUAL(-60, target.rssi);
+}
+
+TEST_CASE("WiFiRoamPolicy: Same Channel Preference And Channel Lock", "[roam]")
+{
+    WiFiRoamPolicy policy(CONFIG);
+    RoamCandidate target;
+
+    // B shares channel 6 with A: its 4 dB bonus beats the 2 dB of C on channel 11
+    RoamCandidate scan[] = {candidate(AP_B, -62, 6), candidate(AP_C, -60, 11)};
+    TEST_ASSERT_TRUE(policy.select(AP_A, -80, 6, scan, 2, target));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(AP_B, target.bssid, 6);
+
+    // Not on an unknown channel, nor beyond the bias
+    TEST_ASSERT_TRUE(policy.select(AP_A, -80, 0, scan, 2, target));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(AP_C, target.bssid, 6);
+    RoamCandidate far[] = {candidate(AP_B, -62, 6), candidate(AP_C, -55, 11)};
+    TEST_ASSERT_TRUE(policy.select(AP_A, -80, 6, far, 2, target));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(AP_C, target.bssid, 6);
+
+    // The bonus also counts towards the hysteresis
+    RoamCandidate close[] = {candidate(AP_B, -76, 6)};
+    TEST_ASSERT_TRUE(policy.select(AP_A, -80, 6, close, 1, target));
+    TEST_ASSERT_FALSE(policy.select(AP_A, -80, 1, close, 1, target));
+
+    // Locked on channel 6: the stronger AP elsewhere never qualifies
+    policy.set_channel_lock(6);
+    TEST_ASSERT_TRUE(policy.select(AP_A, -80, 6, far, 2, target));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(AP_B, target.bssid, 6);
+    RoamCandidate elsewhere[] = {candidate(AP_C, -40, 11)};
+    TEST_ASSERT_FALSE(policy.select(AP_A, -80, 6, elsewhere, 1, target));
+
+    // The lock survives new credentials and configurations
+    policy.reset();
+    policy.set_config(CONFIG);
+    TEST_ASSERT_EQUAL(6, policy.get_channel_lock());
+    policy.set_channel_lock(0);
+    TEST_ASSERT_TRUE(policy.select(AP_A, -80, 6, elsewhere, 1, target));
+
+    RoamConfig bad      = CONFIG;
+    bad.channel_bias_db = 41;
+    TEST_ASSERT_FALSE(bad.is_valid());
+}
+
+TEST_CASE("WiFiRoamPolicy: Fast Transition Learns The Domain", "[roam]")
+{
+    WiFiRoamPolicy policy(CONFIG);
+    RoamCandidate b = candidate(AP_B, -50, 6);
+
+    TEST_ASSERT_EQUAL(WiFiRoamPolicy::Mode::FAST_TRANSITION, policy.begin(AP_A, b, 1000000));
+    TEST_ASSERT_TRUE(policy.in_progress());
+    TEST_ASSERT_FALSE(policy.should_scan(-90, 2000000)); // No scan while roaming
+
+    // The driver leaves the old AP once: that disconnect belongs to the transition
+    TEST_ASSERT_TRUE(policy.absorb_link_loss(1010000));
+    TEST_ASSERT_FALSE(policy.absorb_link_loss(1015000));
+
+    // 25 ms from leaving A to STA_CONNECTED on B
+    TEST_ASSERT_EQUAL_UINT32(25000, policy.finish(1035000));
+    TEST_ASSERT_FALSE(policy.in_progress());
+    TEST_ASSERT_EQUAL(FtState::AVAILABLE, policy.get_ft_state());
+    TEST_ASSERT_TRUE(policy.in_domain(AP_A));
+    TEST_ASSERT_TRUE(policy.in_domain(AP_B));
+    TEST_ASSERT_FALSE(policy.in_domain(AP_C));
+
+    const RoamStatus &status = policy.get_status();
+    TEST_ASSERT_EQUAL(FtState::AVAILABLE, status.ft);
+    TEST_ASSERT_EQUAL(2, status.domain_size);
+    TEST_ASSERT_EQUAL(1, status.fast_transitions);
+    TEST_ASSERT_EQUAL(1, status.ft_gap.count);
+    TEST_ASSERT_EQUAL_UINT32(25000, status.ft_gap.last_us);
+
+    // Without a reported disconnect the gap runs from the reassociation request
+    RoamCandidate a = candidate(AP_A, -50, 1);
+    policy.begin(AP_B, a, 2000000);
+    TEST_ASSERT_EQUAL_UINT32(18000, policy.finish(2018000));
+    TEST_ASSERT_EQUAL(2, policy.get_status().domain_size);
+
+    // Equal RSSI: the known member of the domain is preferred
+    RoamCandidate tie[] = {candidate(AP_C, -50, 11), candidate(AP_B, -50, 6)};
+    RoamCandidate target;
+    TEST_ASSERT_TRUE(policy.select(AP_A, -80, 1, tie, 2, target));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(AP_B, target.bssid, 6);
+
+    // New credentials: another network, nothing known
+    policy.reset();
+    TEST_ASSERT_EQUAL(FtState::UNKNOWN, policy.get_ft_state());
+    TEST_ASSERT_FALSE(policy.in_domain(AP_A));
+    TEST_ASSERT_EQUAL(0, policy.get_status().fast_transitions);
+}
+
+TEST_CASE("WiFiRoamPolicy: Falls Back To A Reconnect", "[roam]")
+{
+    WiFiRoamPolicy policy(CONFIG);
+    RoamCandidate b = candidate(AP_B, -50, 6);
+    RoamCandidate c = candidate(AP_C, -50, 11);
+
+    // Reassociated, but in 180 ms: a full authentication, the APs share no domain
+    policy.begin(AP_A, b, 0);
+    policy.absorb_link_loss(0);
+    policy.finish(180000);
+    TEST_ASSERT_EQUAL(FtState::UNAVAILABLE, policy.get_ft_state());
+    TEST_ASSERT_EQUAL(0, policy.get_status().domain_size);
+
+    // Later roams reconnect; the gap runs to GOT_IP
+    TEST_ASSERT_EQUAL(WiFiRoamPolicy::Mode::RECONNECT, policy.begin(AP_B, c, 1000000));
+    TEST_ASSERT_FALSE(policy.absorb_link_loss(1000000));
+    TEST_ASSERT_EQUAL_UINT32(450000, policy.finish(1450000));
+    TEST_ASSERT_EQUAL(1, policy.get_status().reconnects);
+    TEST_ASSERT_EQUAL_UINT32(450000, policy.get_status().reconnect_gap.last_us);
+
+    // A failed transition: the same, and it counts as a failure
+    policy.set_config(CONFIG);
+    TEST_ASSERT_EQUAL(WiFiRoamPolicy::Mode::FAST_TRANSITION, policy.begin(AP_A, b, 0));
+    policy.abort(true);
+    TEST_ASSERT_EQUAL(FtState::UNAVAILABLE, policy.get_ft_state());
+    TEST_ASSERT_EQUAL(1, policy.get_status().failures);
+
+    // A user disconnect is not a failure
+    policy.set_config(CONFIG);
+    policy.begin(AP_A, b, 0);
+    policy.abort(false);
+    TEST_ASSERT_FALSE(policy.in_progress());
+    TEST_ASSERT_EQUAL(FtState::UNKNOWN, policy.get_ft_state());
+    TEST_ASSERT_EQUAL(0, policy.get_status().failures);
+
+    // FT disabled: every roam reconnects
+    RoamConfig no_ft = CONFIG;
+    no_ft.ft         = false;
+    policy.set_config(no_ft);
+    TEST_ASSERT_EQUAL(FtState::DISABLED, policy.get_ft_state());
+    TEST_ASSERT_EQUAL(WiFiRoamPolicy::Mode::RECONNECT, policy.begin(AP_A, b, 0));
+}
+
+TEST_CASE("WiFiRoamPolicy: Known Domain Members Still Transition", "[roam]")
+{
+    WiFiRoamPolicy policy(CONFIG);
+    RoamCandidate a = candidate(AP_A, -50, 1);
+    RoamCandidate b = candidate(AP_B, -50, 6);
+    RoamCandidate c = candidate(AP_C, -50, 11);
+
+    // A and B share a domain
+    policy.begin(AP_A, b, 0);
+    policy.finish(20000);
+
+    // C does not
+    policy.begin(AP_B, c, 100000);
+    policy.abort(true);
+    TEST_ASSERT_EQUAL(FtState::UNAVAILABLE, policy.get_ft_state());
+
+    // Back towards A (known member): FT; towards C: reconnect
+    TEST_ASSERT_EQUAL(WiFiRoamPolicy::Mode::FAST_TRANSITION, policy.begin(AP_B, a, 200000));
+    policy.abort(false);
+    TEST_ASSERT_EQUAL(WiFiRoamPolicy::Mode::RECONNECT, policy.begin(AP_A, c, 300000));
+    policy.abort(false);
+
+    // The domain keeps the latest DOMAIN_MAX members
+    policy.set_config(CONFIG);
+    for (uint8_t i = 0; i < 2 * WiFiRoamPolicy::DOMAIN_MAX; i++) {
+        uint8_t bssid[6] = {0x02, 0, 0, 0, 1, i};
+        policy.begin(AP_A, candidate(bssid, -50, 1), 0);
+        policy.finish(10000);
+    }
+    TEST_ASSERT_EQUAL(WiFiRoamPolicy::DOMAIN_MAX, policy.get_status().domain_size);
+    uint8_t newest[6] = {0x02, 0, 0, 0, 1, 2 * WiFiRoamPolicy::DOMAIN_MAX - 1};
+    TEST_ASSERT_TRUE(policy.in_domain(newest));
+}
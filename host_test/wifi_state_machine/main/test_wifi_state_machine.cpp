@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include "unity.h"
 #include "wifi_state_machine.hpp"
 #include "freertos/FreeRTOS.h"
@@ -48,6 +50,28 @@ TEST_CASE("WiFiStateMachine: Event Resolution", "[wifi_fsm]")
     TEST_ASSERT_EQUAL(WiFiStateMachine::State::STARTED, outcome.next_state);
 }
 
+TEST_CASE("WiFiStateMachine: Phase Timeout Resolution", "[wifi_fsm]")
+{
+    WiFiStateMachine fsm;
+
+    // A stuck association or DHCP phase fails the attempt
+    fsm.transition_to(WiFiStateMachine::State::CONNECTING);
+    auto outcome = fsm.resolve_event(WiFiStateMachine::EventId::TIMEOUT);
+    TEST_ASSERT_EQUAL(WiFiStateMachine::State::WAITING_RECONNECT, outcome.next_state);
+    TEST_ASSERT_EQUAL(wifi_manager::CONNECT_FAILED_BIT, outcome.bits_to_set);
+
+    fsm.transition_to(WiFiStateMachine::State::CONNECTED_NO_IP);
+    outcome = fsm.resolve_event(WiFiStateMachine::EventId::TIMEOUT);
+    TEST_ASSERT_EQUAL(WiFiStateMachine::State::WAITING_RECONNECT, outcome.next_state);
+    TEST_ASSERT_EQUAL(wifi_manager::CONNECT_FAILED_BIT, outcome.bits_to_set);
+
+    // A late timeout is harmless in any other state
+    fsm.transition_to(WiFiStateMachine::State::CONNECTED_GOT_IP);
+    outcome = fsm.resolve_event(WiFiStateMachine::EventId::TIMEOUT);
+    TEST_ASSERT_EQUAL(WiFiStateMachine::State::CONNECTED_GOT_IP, outcome.next_state);
+    TEST_ASSERT_EQUAL(0, outcome.bits_to_set);
+}
+
 TEST_CASE("WiFiStateMachine: Suspect Failure Handling (Dynamic RSSI)", "[wifi_fsm]")
 {
     WiFiStateMachine fsm;
@@ -100,6 +124,25 @@ TEST_CASE("WiFiStateMachine: Backoff Calculation", "[wifi_fsm]")
     TEST_ASSERT_EQUAL(1000, delay);
 }
 
+TEST_CASE("WiFiStateMachine: Restored Backoff", "[wifi_fsm]")
+{
+    WiFiStateMachine fsm;
+    uint32_t delay;
+
+    // Schedule persisted across a reset continues where it stopped
+    fsm.restore_retry_count(3);
+    fsm.calculate_next_backoff(delay);
+    TEST_ASSERT_EQUAL(8000, delay); // 2^3 * 1000
+    TEST_ASSERT_EQUAL(4, fsm.get_retry_count());
+
+    // Budget deferral waits without moving the exponent
+    fsm.transition_to(WiFiStateMachine::State::CONNECTING);
+    fsm.schedule_reconnect(60000);
+    TEST_ASSERT_EQUAL(WiFiStateMachine::State::WAITING_RECONNECT, fsm.get_current_state());
+    TEST_ASSERT_EQUAL(4, fsm.get_retry_count());
+    TEST_ASSERT_EQUAL(60000, fsm.get_next_reconnect_ms());
+}
+
 TEST_CASE("WiFiStateMachine: Get Wait Ticks", "[wifi_fsm]")
 {
     WiFiStateMachine fsm;
@@ -118,3 +161,324 @@ TEST_CASE("WiFiStateMachine: Get Wait Ticks", "[wifi_fsm]")
     TEST_ASSERT_TRUE(ticks > 0);
     TEST_ASSERT_TRUE(ticks <= pdMS_TO_TICKS(1000));
 }
+
+static wifi_manager::Message make_command(WiFiStateMachine::CommandId cmd)
+{
+    wifi_manager::Message msg = {};
+    msg.type                  = wifi_manager::MessageType::COMMAND;
+    msg.cmd                   = cmd;
+    return msg;
+}
+
+TEST_CASE("WiFiStateMachine: Queue Compaction", "[wifi_fsm]")
+{
+    using CommandId = WiFiStateMachine::CommandId;
+
+    // CONNECT, DISCONNECT and CONNECT queued ahead of a STOP are all dropped
+    wifi_manager::Message batch[5] = {make_command(CommandId::CONNECT), make_command(CommandId::DISCONNECT),
+                                      make_command(CommandId::CONNECT), make_command(CommandId::STOP)};
+    TEST_ASSERT_EQUAL_HEX32(0x7, WiFiStateMachine::find_superseded(batch, 4));
+
+    // Events are kept, and commands after the last STOP survive (start/stop/start collapses)
+    batch[0]       = make_command(CommandId::START);
+    batch[1]       = {};
+    batch[1].type  = wifi_manager::MessageType::EVENT;
+    batch[1].event = WiFiStateMachine::EventId::STA_START;
+    batch[2]       = make_command(CommandId::STOP);
+    batch[3]       = make_command(CommandId::START);
+    batch[4]       = make_command(CommandId::CONNECT);
+    TEST_ASSERT_EQUAL_HEX32(0x1, WiFiStateMachine::find_superseded(batch, 5));
+
+    // Nothing to compact without a STOP
+    TEST_ASSERT_EQUAL_HEX32(0x0, WiFiStateMachine::find_superseded(&batch[3], 2));
+}
+
+TEST_CASE("WiFiStateMachine: Disconnect Classification", "[wifi_fsm]")
+{
+    using State           = WiFiStateMachine::State;
+    using DisconnectClass = WiFiStateMachine::DisconnectClass;
+
+    // Requested by us, or the driver is no longer active
+    TEST_ASSERT_EQUAL(DisconnectClass::EXPECTED, WiFiStateMachine::classify_disconnect(
+                                                     State::DISCONNECTING, State::DISCONNECTED, WIFI_REASON_AUTH_FAIL));
+    TEST_ASSERT_EQUAL(DisconnectClass::EXPECTED, WiFiStateMachine::classify_disconnect(
+                                                     State::STOPPING, State::STOPPING, WIFI_REASON_BEACON_TIMEOUT));
+
+    // The AP ended the session
+    TEST_ASSERT_EQUAL(DisconnectClass::LEFT, WiFiStateMachine::classify_disconnect(
+                                                 State::CONNECTED_GOT_IP, State::WAITING_RECONNECT,
+                                                 WIFI_REASON_ASSOC_LEAVE));
+
+    // Credentials may be wrong
+    TEST_ASSERT_EQUAL(DisconnectClass::SUSPECT, WiFiStateMachine::classify_disconnect(
+                                                    State::CONNECTING, State::WAITING_RECONNECT,
+                                                    WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT));
+
+    // Plain link loss
+    TEST_ASSERT_EQUAL(DisconnectClass::RECOVERABLE, WiFiStateMachine::classify_disconnect(
+                                                        State::CONNECTED_GOT_IP, State::WAITING_RECONNECT,
+                                                        WIFI_REASON_BEACON_TIMEOUT));
+}
+
+TEST_CASE("WiFiStateMachine: Stale Command Resolution", "[wifi_fsm]")
+{
+    using State     = WiFiStateMachine::State;
+    using CommandId = WiFiStateMachine::CommandId;
+    WiFiStateMachine fsm;
+
+    // A DISCONNECT queued behind a STOP: the stop's outcome answers the caller
+    fsm.transition_to(State::STOPPING);
+    TEST_ASSERT_EQUAL(WiFiStateMachine::Action::ERROR, fsm.validate_command(CommandId::DISCONNECT));
+    TEST_ASSERT_EQUAL_HEX32(wifi_manager::INVALID_STATE_BIT, fsm.resolve_stale_command(CommandId::DISCONNECT));
+    TEST_ASSERT_EQUAL_HEX32(0, fsm.resolve_stale_command(CommandId::STOP));
+
+    // Already where the command leads: answered with its success bit
+    fsm.transition_to(State::STARTED);
+    TEST_ASSERT_EQUAL_HEX32(wifi_manager::STARTED_BIT, fsm.resolve_stale_command(CommandId::START));
+    TEST_ASSERT_EQUAL_HEX32(wifi_manager::DISCONNECTED_BIT, fsm.resolve_stale_command(CommandId::DISCONNECT));
+
+    // The same operation in flight answers the caller itself
+    fsm.transition_to(State::CONNECTING);
+    TEST_ASSERT_EQUAL_HEX32(0, fsm.resolve_stale_command(CommandId::CONNECT));
+    fsm.transition_to(State::CONNECTED_GOT_IP);
+    TEST_ASSERT_EQUAL_HEX32(wifi_manager::CONNECTED_BIT, fsm.resolve_stale_command(CommandId::CONNECT));
+}
+
+TEST_CASE("WiFiStateMachine: IP Readiness", "[wifi_fsm]")
+{
+    using AddressKind = WiFiStateMachine::AddressKind;
+    using IpReadiness = WiFiStateMachine::IpReadiness;
+    WiFiStateMachine fsm;
+
+    const uint8_t link_local[16] = {0xfe, 0x80, 0, 0, 0, 0, 0, 0, 0x12, 0x34, 0, 0, 0, 0, 0, 1};
+    const uint8_t global[16]     = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    const uint8_t unique[16]     = {0xfd, 0x00, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    TEST_ASSERT_EQUAL(AddressKind::IPV6_LINK_LOCAL, WiFiStateMachine::classify_ip6(link_local));
+    TEST_ASSERT_EQUAL(AddressKind::IPV6_GLOBAL, WiFiStateMachine::classify_ip6(global));
+    TEST_ASSERT_EQUAL(AddressKind::IPV6_GLOBAL, WiFiStateMachine::classify_ip6(unique));
+
+    // Default: only the DHCPv4 lease counts
+    TEST_ASSERT_EQUAL(IpReadiness::IPV4, fsm.get_ip_readiness());
+    TEST_ASSERT_FALSE(fsm.record_address(AddressKind::IPV6_LINK_LOCAL));
+    TEST_ASSERT_FALSE(fsm.record_address(AddressKind::IPV6_GLOBAL));
+    TEST_ASSERT_TRUE(fsm.record_address(AddressKind::IPV4));
+
+    // IPv6-only backend: a v4 lease alone is not enough
+    fsm.clear_addresses();
+    fsm.set_ip_readiness(IpReadiness::IPV6_GLOBAL);
+    TEST_ASSERT_FALSE(fsm.record_address(AddressKind::IPV4));
+    TEST_ASSERT_FALSE(fsm.record_address(AddressKind::IPV6_LINK_LOCAL));
+    TEST_ASSERT_TRUE(fsm.record_address(AddressKind::IPV6_GLOBAL));
+    TEST_ASSERT_EQUAL_HEX8(0x07, fsm.get_addresses());
+
+    fsm.clear_addresses();
+    fsm.set_ip_readiness(IpReadiness::IPV6_LINK_LOCAL);
+    TEST_ASSERT_FALSE(fsm.record_address(AddressKind::IPV4));
+    TEST_ASSERT_TRUE(fsm.record_address(AddressKind::IPV6_LINK_LOCAL));
+
+    // ANY: whichever routable address comes first
+    fsm.set_ip_readiness(IpReadiness::ANY);
+    fsm.clear_addresses();
+    TEST_ASSERT_FALSE(fsm.record_address(AddressKind::IPV6_LINK_LOCAL));
+    TEST_ASSERT_TRUE(fsm.record_address(AddressKind::IPV6_GLOBAL));
+    fsm.clear_addresses();
+    TEST_ASSERT_FALSE(fsm.is_ip_ready());
+    TEST_ASSERT_TRUE(fsm.record_address(AddressKind::IPV4));
+
+    // A lost lease only ends readiness if nothing else meets it
+    TEST_ASSERT_TRUE(fsm.record_address(AddressKind::IPV6_GLOBAL));
+    TEST_ASSERT_TRUE(fsm.forget_address(AddressKind::IPV4));
+    TEST_ASSERT_EQUAL_HEX8(0x04, fsm.get_addresses());
+    fsm.set_ip_readiness(IpReadiness::IPV4);
+    TEST_ASSERT_TRUE(fsm.record_address(AddressKind::IPV4));
+    TEST_ASSERT_FALSE(fsm.forget_address(AddressKind::IPV4));
+}
+
+TEST_CASE("WiFiStateMachine: PHY Fallback", "[wifi_fsm]")
+{
+    using PhyConfig = WiFiStateMachine::PhyConfig;
+    WiFiStateMachine fsm;
+
+    TEST_ASSERT_TRUE(WiFiStateMachine::is_phy_failure(WIFI_REASON_DISASSOC_SUPCHAN_BAD));
+    TEST_ASSERT_TRUE(WiFiStateMachine::is_phy_failure(WIFI_REASON_ASSOC_FAIL));
+    TEST_ASSERT_FALSE(WiFiStateMachine::is_phy_failure(WIFI_REASON_AUTH_FAIL));
+    TEST_ASSERT_FALSE(WiFiStateMachine::is_phy_failure(WIFI_REASON_NO_AP_FOUND));
+
+    PhyConfig ax;
+    ax.protocols = PhyConfig::PROTOCOL_ALL;
+    ax.bandwidth = wifi_manager::Bandwidth::HT40;
+    TEST_ASSERT_TRUE(fsm.effective_phy(ax) == ax);
+
+    // Threshold 0 disables the fallback
+    TEST_ASSERT_FALSE(fsm.record_phy_failure(0));
+    TEST_ASSERT_EQUAL(0, fsm.get_phy_fallback());
+
+    // A success in between starts the count over
+    TEST_ASSERT_FALSE(fsm.record_phy_failure(2));
+    fsm.clear_phy_failures();
+    TEST_ASSERT_FALSE(fsm.record_phy_failure(2));
+    TEST_ASSERT_TRUE(fsm.record_phy_failure(2));
+    TEST_ASSERT_EQUAL(1, fsm.get_phy_fallback());
+
+    // Level 1: no 802.11ax, HT20
+    PhyConfig phy = fsm.effective_phy(ax);
+    TEST_ASSERT_EQUAL_HEX8(PhyConfig::PROTOCOL_11B | PhyConfig::PROTOCOL_11G | PhyConfig::PROTOCOL_11N, phy.protocols);
+    TEST_ASSERT_EQUAL(wifi_manager::Bandwidth::HT20, phy.bandwidth);
+    TEST_ASSERT_TRUE(phy.is_valid());
+    phy = fsm.effective_phy(PhyConfig{});
+    TEST_ASSERT_EQUAL_HEX8(PhyConfig::PROTOCOL_11B | PhyConfig::PROTOCOL_11G | PhyConfig::PROTOCOL_11N, phy.protocols);
+
+    // Level 2: 802.11b/g, and no further
+    fsm.record_phy_failure(2);
+    TEST_ASSERT_TRUE(fsm.record_phy_failure(2));
+    phy = fsm.effective_phy(ax);
+    TEST_ASSERT_EQUAL_HEX8(PhyConfig::PROTOCOL_11B | PhyConfig::PROTOCOL_11G, phy.protocols);
+    TEST_ASSERT_TRUE(phy.is_valid());
+    TEST_ASSERT_FALSE(fsm.record_phy_failure(1));
+    TEST_ASSERT_EQUAL(WiFiStateMachine::MAX_PHY_FALLBACK, fsm.get_phy_fallback());
+
+    // Nothing left after the step down: 802.11b/g, never the driver default
+    PhyConfig n_only;
+    n_only.protocols = PhyConfig::PROTOCOL_11N | PhyConfig::PROTOCOL_11AX;
+    n_only.bandwidth = wifi_manager::Bandwidth::HT40;
+    phy              = fsm.effective_phy(n_only);
+    TEST_ASSERT_EQUAL_HEX8(PhyConfig::PROTOCOL_11B | PhyConfig::PROTOCOL_11G, phy.protocols);
+    TEST_ASSERT_TRUE(phy.is_valid());
+
+    fsm.reset_phy_fallback();
+    TEST_ASSERT_TRUE(fsm.effective_phy(ax) == ax);
+}
+
+TEST_CASE("WiFiStateMachine: TWT Encoding", "[wifi_fsm]")
+{
+    using wifi_manager::TwtConfig;
+
+    // 1 s fits the 16-bit mantissa after 4 halvings; 10 ms is 40 units of 256 us
+    TwtConfig twt           = {1000000, 10000};
+    TwtConfig::Encoding enc = twt.encode();
+    TEST_ASSERT_EQUAL(4, enc.exponent);
+    TEST_ASSERT_EQUAL(62500, enc.mantissa);
+    TEST_ASSERT_EQUAL(1000000, enc.interval_us());
+    TEST_ASSERT_FALSE(enc.duration_in_tu);
+    TEST_ASSERT_EQUAL(40, enc.duration);
+    TEST_ASSERT_EQUAL(10240, enc.duration_us());
+
+    // Above 255 units of 256 us the duration switches to TU
+    twt.wake_duration_us = 100000;
+    enc                  = twt.encode();
+    TEST_ASSERT_TRUE(enc.duration_in_tu);
+    TEST_ASSERT_EQUAL(98, enc.duration);
+    TEST_ASSERT_TRUE(twt.is_valid());
+
+    TEST_ASSERT_TRUE((TwtConfig{0, 0}).is_valid());
+    TEST_ASSERT_FALSE((TwtConfig{0, 0}).is_enabled());
+    TEST_ASSERT_FALSE((TwtConfig{1000, 0}).is_valid());
+    TEST_ASSERT_FALSE((TwtConfig{10000, 10000}).is_valid());
+    TEST_ASSERT_FALSE((TwtConfig{10000000, TwtConfig::MAX_DURATION_US + 1}).is_valid());
+}
+
+TEST_CASE("WiFiStateMachine: TWT Negotiation", "[wifi_fsm]")
+{
+    using TwtState = WiFiStateMachine::TwtState;
+    WiFiStateMachine fsm;
+
+    TEST_ASSERT_TRUE(fsm.twt_needs_setup());
+    TEST_ASSERT_FALSE(fsm.record_twt_event(TwtState::ACTIVE)); // Nothing requested
+
+    fsm.record_twt_request(true, true);
+    TEST_ASSERT_EQUAL(TwtState::PENDING, fsm.get_twt_state());
+    TEST_ASSERT_FALSE(fsm.twt_needs_setup());
+    TEST_ASSERT_TRUE(fsm.record_twt_event(TwtState::ACTIVE));
+    TEST_ASSERT_EQUAL(TwtState::ACTIVE, fsm.get_twt_state());
+
+    // Reconnect or roam: the agreement is renegotiated and counted as such
+    fsm.twt_link_lost();
+    TEST_ASSERT_TRUE(fsm.twt_needs_setup());
+    fsm.record_twt_request(true, true);
+    TEST_ASSERT_EQUAL(2, fsm.get_twt_setups());
+    TEST_ASSERT_EQUAL(1, fsm.get_twt_renegotiations());
+
+    // A rejection holds until the next association
+    TEST_ASSERT_TRUE(fsm.record_twt_event(TwtState::REJECTED));
+    TEST_ASSERT_FALSE(fsm.twt_needs_setup());
+    fsm.twt_link_lost();
+    fsm.record_twt_request(true, true);
+    TEST_ASSERT_EQUAL(1, fsm.get_twt_renegotiations()); // Nothing was lost
+    TEST_ASSERT_TRUE(fsm.record_twt_event(TwtState::ACTIVE));
+
+    // Teardown by the AP
+    TEST_ASSERT_TRUE(fsm.record_twt_event(TwtState::OFF));
+    TEST_ASSERT_EQUAL(TwtState::REJECTED, fsm.get_twt_state());
+    TEST_ASSERT_FALSE(fsm.record_twt_event(TwtState::OFF));
+
+    // No 802.11ax: never retried
+    fsm.reset_twt();
+    fsm.record_twt_request(false, false);
+    TEST_ASSERT_EQUAL(TwtState::UNSUPPORTED, fsm.get_twt_state());
+    fsm.twt_link_lost();
+    TEST_ASSERT_FALSE(fsm.twt_needs_setup());
+    TEST_ASSERT_EQUAL(0, fsm.get_twt_setups());
+
+    fsm.reset_twt();
+    TEST_ASSERT_TRUE(fsm.twt_needs_setup());
+}
+
+TEST_CASE("WiFiStateMachine: EAP Profile And Handshakes", "[wifi_fsm]")
+{
+    using wifi_manager::EapMethod;
+    using wifi_manager::EapStatus;
+    using wifi_manager::EnterpriseProfile;
+
+    EnterpriseProfile tls = {};
+    tls.method            = EapMethod::TLS;
+    strcpy(tls.identity, "anonymous@corp");
+    strcpy(tls.ca_cert, "radius_ca");
+    TEST_ASSERT_FALSE(tls.is_valid()); // No client certificate
+    strcpy(tls.client_cert, "device_cert");
+    strcpy(tls.client_key, "device_key");
+    TEST_ASSERT_TRUE(tls.is_valid());
+    tls.wpa3_192 = true;
+    TEST_ASSERT_TRUE(tls.is_valid());
+
+    EnterpriseProfile peap = {};
+    peap.method            = EapMethod::PEAP;
+    strcpy(peap.identity, "anonymous@corp");
+    strcpy(peap.username, "device42");
+    TEST_ASSERT_FALSE(peap.is_valid()); // No password
+    strcpy(peap.password, "secret");
+    TEST_ASSERT_TRUE(peap.is_valid());
+    peap.wpa3_192 = true; // 192-bit mode is EAP-TLS only
+    TEST_ASSERT_FALSE(peap.is_valid());
+    peap.wpa3_192 = false;
+    memset(peap.ca_cert, 'x', sizeof(peap.ca_cert)); // Unterminated
+    TEST_ASSERT_FALSE(peap.is_valid());
+
+    EnterpriseProfile personal = {};
+    TEST_ASSERT_FALSE(personal.is_enterprise());
+    TEST_ASSERT_FALSE(personal.is_valid());
+
+    // Nothing cached yet: full exchanges set the average
+    EapStatus status = {};
+    status.record(3000000, false);
+    status.record(2000000, true); // Cached, but too slow to be a resumption
+    TEST_ASSERT_EQUAL(2, status.full_handshakes);
+    TEST_ASSERT_EQUAL(0, status.likely_resumed);
+    TEST_ASSERT_EQUAL(2500000, status.full_handshake_us);
+
+    // Likely resumed: well under half the average, the difference is counted as saved
+    status.record(400000, true);
+    TEST_ASSERT_EQUAL(1, status.likely_resumed);
+    TEST_ASSERT_EQUAL(2100000, status.est_saved_us);
+    TEST_ASSERT_EQUAL(400000, status.last_handshake_us);
+
+    // The server refused to resume: a full exchange, the average follows
+    status.record(3100000, true);
+    TEST_ASSERT_EQUAL(3, status.full_handshakes);
+    TEST_ASSERT_EQUAL(1, status.likely_resumed);
+    TEST_ASSERT_EQUAL(2700000, status.full_handshake_us);
+
+    // Without a cached session a fast association is not credited
+    status.record(300000, false);
+    TEST_ASSERT_EQUAL(1, status.likely_resumed);
+    TEST_ASSERT_EQUAL(2100000, status.est_saved_us);
+}
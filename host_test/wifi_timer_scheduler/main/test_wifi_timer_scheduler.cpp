@@ -0,0 +1,97 @@
+#include "unity.h"
+#include "wifi_timer_scheduler.hpp"
+#include "wifi_types.hpp"
+#include "freertos/FreeRTOS.h"
+#include "host_test_common.hpp"
+
+using namespace wifi_manager;
+
+void setUp(void)
+{
+    host_test_setup_common_mocks();
+}
+
+void tearDown(void)
+{
+}
+
+TEST_CASE("WiFiTimerScheduler: Empty Scheduler", "[timer]")
+{
+    WiFiTimerScheduler timers;
+    TimerId id;
+
+    TEST_ASSERT_TRUE(timers.empty());
+    TEST_ASSERT_EQUAL(portMAX_DELAY, timers.get_wait_ticks(0));
+    TEST_ASSERT_FALSE(timers.pop_expired(1000000, id));
+    TEST_ASSERT_FALSE(timers.pop_next(id));
+    TEST_ASSERT_EQUAL_INT64(-1, timers.get_deadline(TimerId::RECONNECT));
+}
+
+TEST_CASE("WiFiTimerScheduler: Expiry Order", "[timer]")
+{
+    WiFiTimerScheduler timers;
+    TimerId id;
+
+    timers.arm(TimerId::DHCP_TIMEOUT, 30000);
+    timers.arm(TimerId::RECONNECT, 10000);
+    timers.arm(TimerId::RSSI_SAMPLE, 20000);
+    timers.arm(TimerId::CONNECT_WATCHDOG, 10000); // Same deadline: lower TimerId first
+
+    // Wait until the earliest deadline, rounded up to whole milliseconds
+    TEST_ASSERT_EQUAL(pdMS_TO_TICKS(10), timers.get_wait_ticks(0));
+    TEST_ASSERT_EQUAL(pdMS_TO_TICKS(1), timers.get_wait_ticks(9500));
+    TEST_ASSERT_EQUAL(0, timers.get_wait_ticks(10000));
+    // Rounded up in ticks, whatever the tick rate: never wakes before the deadline
+    TEST_ASSERT_GREATER_OR_EQUAL(10000 - 1, (int64_t)timers.get_wait_ticks(1) * 1000000 / configTICK_RATE_HZ);
+    TEST_ASSERT_LESS_THAN(10000 - 1 + 1000000 / configTICK_RATE_HZ,
+                          (int64_t)timers.get_wait_ticks(1) * 1000000 / configTICK_RATE_HZ);
+
+    TEST_ASSERT_FALSE(timers.pop_expired(9999, id));
+    TEST_ASSERT_TRUE(timers.pop_expired(20000, id));
+    TEST_ASSERT_EQUAL(TimerId::RECONNECT, id);
+    TEST_ASSERT_TRUE(timers.pop_expired(20000, id));
+    TEST_ASSERT_EQUAL(TimerId::CONNECT_WATCHDOG, id);
+    TEST_ASSERT_TRUE(timers.pop_expired(20000, id));
+    TEST_ASSERT_EQUAL(TimerId::RSSI_SAMPLE, id);
+    TEST_ASSERT_FALSE(timers.pop_expired(20000, id));
+
+    // pop_next ignores the clock
+    TEST_ASSERT_TRUE(timers.pop_next(id));
+    TEST_ASSERT_EQUAL(TimerId::DHCP_TIMEOUT, id);
+    TEST_ASSERT_TRUE(timers.empty());
+}
+
+TEST_CASE("WiFiTimerScheduler: Re-arm and Cancel", "[timer]")
+{
+    WiFiTimerScheduler timers;
+    TimerId id;
+
+    timers.arm(TimerId::RECONNECT, 5000);
+    timers.arm(TimerId::ROAM_DEADLINE, 8000);
+    timers.arm(TimerId::UPLINK_HOLD, 9000);
+
+    // Re-arming moves the single pending deadline, in both directions
+    timers.arm(TimerId::RECONNECT, 12000);
+    TEST_ASSERT_EQUAL_INT64(12000, timers.get_deadline(TimerId::RECONNECT));
+    timers.arm(TimerId::UPLINK_HOLD, 1000);
+
+    timers.cancel(TimerId::ROAM_DEADLINE);
+    timers.cancel(TimerId::ROAM_DEADLINE); // Idempotent
+    TEST_ASSERT_FALSE(timers.is_armed(TimerId::ROAM_DEADLINE));
+
+    TEST_ASSERT_TRUE(timers.pop_next(id));
+    TEST_ASSERT_EQUAL(TimerId::UPLINK_HOLD, id);
+    TEST_ASSERT_TRUE(timers.pop_next(id));
+    TEST_ASSERT_EQUAL(TimerId::RECONNECT, id);
+    TEST_ASSERT_FALSE(timers.pop_next(id));
+
+    // Every timer armed at once, then cleared
+    for (int i = 0; i < (int)TimerId::COUNT; i++) {
+        timers.arm((TimerId)i, 1000 * ((int)TimerId::COUNT - i));
+    }
+    TEST_ASSERT_TRUE(timers.pop_next(id));
+    TEST_ASSERT_EQUAL((TimerId)((int)TimerId::COUNT - 1), id);
+    timers.cancel_all();
+    TEST_ASSERT_TRUE(timers.empty());
+    TEST_ASSERT_FALSE(timers.is_armed(TimerId::RECONNECT));
+}
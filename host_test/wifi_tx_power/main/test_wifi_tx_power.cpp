@@ -0,0 +1,180 @@
+#include <algorithm>
+
+#include "unity.h"
+#include "wifi_tx_power.hpp"
+#include "host_test_common.hpp"
+
+using namespace wifi_manager;
+
+void setUp(void)
+{
+    host_test_setup_common_mocks();
+}
+
+void tearDown(void)
+{
+}
+
+// Target -70 dBm + 6 dB margin, 8-20 dBm, 2 dB steps after 3 stable samples
+static const WiFiTxPowerController::Config CONFIG = {-70, 6, 8 * 4, 20 * 4, 2 * 4, 3};
+
+/**
+ * Reciprocal link: the AP transmits at 20 dBm, both directions see the same path loss.
+ */
+struct SimLink
+{
+    int path_loss_db;
+
+    int8_t beacon_rssi() const
+    {
+        return (int8_t)(20 - path_loss_db);
+    }
+
+    // Uplink RSSI at the AP in 0.25 dBm units
+    int uplink_quarter_dbm(int8_t power) const
+    {
+        return power - path_loss_db * 4;
+    }
+};
+
+TEST_CASE("WiFiTxPowerController: Configuration", "[tx_power]")
+{
+    TEST_ASSERT_TRUE(WiFiTxPowerController::is_valid(CONFIG));
+
+    WiFiTxPowerController::Config bad = CONFIG;
+    bad.min_power                     = 4; // Below the driver's 2 dBm
+    TEST_ASSERT_FALSE(WiFiTxPowerController::is_valid(bad));
+    bad           = CONFIG;
+    bad.max_power = 90;
+    TEST_ASSERT_FALSE(WiFiTxPowerController::is_valid(bad));
+    bad           = CONFIG;
+    bad.min_power = 82;
+    TEST_ASSERT_FALSE(WiFiTxPowerController::is_valid(bad));
+    bad      = CONFIG;
+    bad.step = 0;
+    TEST_ASSERT_FALSE(WiFiTxPowerController::is_valid(bad));
+
+    WiFiTxPowerController ctrl(CONFIG);
+    TEST_ASSERT_EQUAL(80, ctrl.get_power());
+    // -20 dBm beacons: 50 dB of headroom, clamped to the lowest power
+    TEST_ASSERT_EQUAL(32, ctrl.required_power(-20));
+    // -64 dBm beacons: exactly the target plus margin at full power
+    TEST_ASSERT_EQUAL(80, ctrl.required_power(-64));
+    TEST_ASSERT_EQUAL(72, ctrl.required_power(-62));
+    TEST_ASSERT_EQUAL(80, ctrl.required_power(-85));
+}
+
+TEST_CASE("WiFiTxPowerController: Steps Down Next To The AP", "[tx_power]")
+{
+    WiFiTxPowerController ctrl(CONFIG);
+    SimLink link = {40};
+
+    // One 2 dB step every 3 samples: 12 dB take 18 samples
+    int samples = 0;
+    while (ctrl.get_power() > CONFIG.min_power && samples < 100) {
+        int8_t before = ctrl.get_power();
+        bool changed  = ctrl.on_rssi_sample(link.beacon_rssi());
+        samples++;
+        TEST_ASSERT_EQUAL(changed, ctrl.get_power() != before);
+        TEST_ASSERT_TRUE(ctrl.get_power() >= before - CONFIG.step);
+    }
+    TEST_ASSERT_EQUAL(18, samples);
+    TEST_ASSERT_EQUAL(6, ctrl.get_decreases());
+    TEST_ASSERT_EQUAL(0, ctrl.get_increases());
+
+    // Settled: no further change
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_FALSE(ctrl.on_rssi_sample(link.beacon_rssi()));
+    }
+}
+
+TEST_CASE("WiFiTxPowerController: Closed Loop Keeps The Uplink Budget", "[tx_power]")
+{
+    WiFiTxPowerController ctrl(CONFIG);
+    SimLink link    = {40};
+    const int floor = (CONFIG.target_rssi + CONFIG.margin_db) * 4;
+
+    // Walk away from the AP, then come back
+    for (int step = 0; step < 120; step++) {
+        link.path_loss_db = (step < 60) ? 40 + step : 100 - (step - 60);
+        ctrl.on_rssi_sample(link.beacon_rssi());
+
+        // Whatever full power can achieve, the limit never leaves the uplink short of it
+        int wanted = std::min(floor, link.uplink_quarter_dbm(CONFIG.max_power));
+        TEST_ASSERT_TRUE(link.uplink_quarter_dbm(ctrl.get_power()) >= wanted);
+    }
+    TEST_ASSERT_GREATER_THAN(0, ctrl.get_increases());
+    TEST_ASSERT_GREATER_THAN(0, ctrl.get_decreases());
+}
+
+TEST_CASE("WiFiTxPowerController: Fades Raise At Once, Recover Slowly", "[tx_power]")
+{
+    WiFiTxPowerController ctrl(CONFIG);
+    SimLink link = {40};
+    while (ctrl.get_power() > CONFIG.min_power) {
+        ctrl.on_rssi_sample(link.beacon_rssi());
+    }
+
+    // A deep fade: the limit jumps to what the sample needs
+    link.path_loss_db = 80;
+    TEST_ASSERT_TRUE(ctrl.on_rssi_sample(link.beacon_rssi()));
+    TEST_ASSERT_EQUAL(ctrl.required_power(link.beacon_rssi()), ctrl.get_power());
+    int8_t faded = ctrl.get_power();
+
+    // Back to normal: two good samples are not enough to step down
+    link.path_loss_db = 40;
+    TEST_ASSERT_FALSE(ctrl.on_rssi_sample(link.beacon_rssi()));
+    TEST_ASSERT_FALSE(ctrl.on_rssi_sample(link.beacon_rssi()));
+    TEST_ASSERT_TRUE(ctrl.on_rssi_sample(link.beacon_rssi()));
+    TEST_ASSERT_EQUAL(faded - CONFIG.step, ctrl.get_power());
+
+    // A dip between good samples raises the limit and restarts the stability count
+    ctrl.on_rssi_sample(link.beacon_rssi());
+    link.path_loss_db = 80;
+    ctrl.on_rssi_sample(link.beacon_rssi());
+    link.path_loss_db = 40;
+    int8_t before = ctrl.get_power();
+    ctrl.on_rssi_sample(link.beacon_rssi());
+    ctrl.on_rssi_sample(link.beacon_rssi());
+    TEST_ASSERT_EQUAL(before, ctrl.get_power());
+}
+
+TEST_CASE("WiFiTxPowerController: Noise Does Not Make It Oscillate", "[tx_power]")
+{
+    WiFiTxPowerController ctrl(CONFIG);
+    uint32_t seed = 12345;
+    int changes   = 0;
+
+    // +-2 dB of fast fading around a link that needs about 14 dBm
+    for (int i = 0; i < 300; i++) {
+        seed         = seed * 1103515245 + 12345;
+        int noise_db = (int)((seed >> 16) % 5) - 2;
+        SimLink link = {78 + noise_db};
+        if (ctrl.on_rssi_sample(link.beacon_rssi()) && i >= 30) {
+            changes++;
+        }
+    }
+    // A decrease needs a full step of headroom in stable_samples samples in a row
+    TEST_ASSERT_LESS_THAN(60, changes);
+    TEST_ASSERT_TRUE(ctrl.get_power() >= ctrl.required_power(20 - 76));
+}
+
+TEST_CASE("WiFiTxPowerController: Link Failure Restores Full Power", "[tx_power]")
+{
+    WiFiTxPowerController ctrl(CONFIG);
+    TEST_ASSERT_FALSE(ctrl.on_link_failure()); // Already at full power
+
+    SimLink link = {40};
+    for (int i = 0; i < 6; i++) {
+        ctrl.on_rssi_sample(link.beacon_rssi());
+    }
+    TEST_ASSERT_EQUAL(CONFIG.max_power - 2 * CONFIG.step, ctrl.get_power());
+
+    TEST_ASSERT_TRUE(ctrl.on_link_failure());
+    TEST_ASSERT_EQUAL(CONFIG.max_power, ctrl.get_power());
+
+    // The stability count starts over as well
+    ctrl.on_rssi_sample(link.beacon_rssi());
+    ctrl.on_rssi_sample(link.beacon_rssi());
+    TEST_ASSERT_EQUAL(CONFIG.max_power, ctrl.get_power());
+}
@@ -0,0 +1,162 @@
+#include "unity.h"
+#include "wifi_uplink_arbiter.hpp"
+#include "host_test_common.hpp"
+
+using namespace wifi_manager;
+
+void setUp(void)
+{
+    host_test_setup_common_mocks();
+}
+
+void tearDown(void)
+{
+}
+
+// Simulated gateway: Ethernet preferred, then Wi-Fi, then a cellular modem
+static const uint8_t ETH_PRIORITY      = 200;
+static const uint8_t WIFI_PRIORITY     = 100;
+static const uint8_t CELLULAR_PRIORITY = 50;
+static const uint32_t HOLD_MS          = 10000;
+
+TEST_CASE("WiFiUplinkArbiter: Priority Selection", "[uplink]")
+{
+    WiFiUplinkArbiter arbiter(HOLD_MS);
+    int8_t wifi = arbiter.add(WIFI_PRIORITY);
+    int8_t eth  = arbiter.add(ETH_PRIORITY);
+    int8_t cell = arbiter.add(CELLULAR_PRIORITY);
+    TEST_ASSERT_EQUAL(0, wifi);
+    TEST_ASSERT_EQUAL(3, arbiter.get_status().count);
+
+    // Nothing ready yet
+    TEST_ASSERT_FALSE(arbiter.arbitrate(0, 0));
+    TEST_ASSERT_EQUAL(WiFiUplinkArbiter::NONE, arbiter.get_active());
+
+    // The first usable uplink takes the route at once, even a low-priority one
+    arbiter.set_ready(cell, true, 1000);
+    TEST_ASSERT_TRUE(arbiter.arbitrate(1000, 1000));
+    TEST_ASSERT_EQUAL(cell, arbiter.get_active());
+
+    // Better uplinks come up later: the current route holds until they prove stable
+    arbiter.set_ready(eth, true, 2000);
+    arbiter.set_ready(wifi, true, 2000);
+    TEST_ASSERT_FALSE(arbiter.arbitrate(2000, 2000));
+    uint32_t remaining_us = 0;
+    TEST_ASSERT_TRUE(arbiter.failback_pending(3000, remaining_us));
+    TEST_ASSERT_EQUAL_UINT32(HOLD_MS * 1000 - 1000, remaining_us);
+
+    // Ethernet outranks Wi-Fi once the hold is over
+    TEST_ASSERT_TRUE(arbiter.arbitrate(2000 + HOLD_MS * 1000, 0));
+    TEST_ASSERT_EQUAL(eth, arbiter.get_active());
+    TEST_ASSERT_FALSE(arbiter.failback_pending(2000 + HOLD_MS * 1000, remaining_us));
+    TEST_ASSERT_EQUAL(1, arbiter.get_status().failbacks);
+    TEST_ASSERT_EQUAL(0, arbiter.get_status().failovers);
+
+    // Equal priorities keep the registration order
+    WiFiUplinkArbiter tie(0);
+    int8_t first  = tie.add(WIFI_PRIORITY);
+    int8_t second = tie.add(WIFI_PRIORITY);
+    tie.set_ready(second, true, 0);
+    tie.set_ready(first, true, 0);
+    tie.arbitrate(0, 0);
+    TEST_ASSERT_EQUAL(first, tie.get_active());
+
+    // Four slots
+    WiFiUplinkArbiter full(HOLD_MS);
+    for (int i = 0; i < WiFiUplinkArbiter::UPLINK_MAX; i++) {
+        TEST_ASSERT_EQUAL(i, full.add(WIFI_PRIORITY));
+    }
+    TEST_ASSERT_EQUAL(WiFiUplinkArbiter::NONE, full.add(ETH_PRIORITY));
+}
+
+TEST_CASE("WiFiUplinkArbiter: Failover Is Immediate", "[uplink]")
+{
+    WiFiUplinkArbiter arbiter(HOLD_MS);
+    int8_t wifi = arbiter.add(WIFI_PRIORITY);
+    int8_t cell = arbiter.add(CELLULAR_PRIORITY);
+    arbiter.set_ready(wifi, true, 0);
+    arbiter.set_ready(cell, true, 0);
+    arbiter.arbitrate(0, 0);
+    TEST_ASSERT_EQUAL(wifi, arbiter.get_active());
+
+    // Wi-Fi leaves CONNECTED_GOT_IP: the modem takes over while the event is handled,
+    // no hold applies to a lower-priority uplink
+    arbiter.set_ready(wifi, false, 5000350);
+    TEST_ASSERT_TRUE(arbiter.arbitrate(5000350, 5000000));
+    TEST_ASSERT_EQUAL(cell, arbiter.get_active());
+
+    const UplinkStatus &status = arbiter.get_status();
+    TEST_ASSERT_EQUAL(1, status.failovers);
+    TEST_ASSERT_EQUAL(1, status.failover_latency.count);
+    TEST_ASSERT_EQUAL_UINT32(350, status.failover_latency.last_us);
+
+    // Wi-Fi reconnects: the modem keeps the route for the hold, then Wi-Fi gets it back
+    arbiter.set_ready(wifi, true, 6000000);
+    TEST_ASSERT_FALSE(arbiter.arbitrate(6000000, 6000000));
+    TEST_ASSERT_FALSE(arbiter.arbitrate(6000000 + HOLD_MS * 1000 - 1, 0));
+    TEST_ASSERT_TRUE(arbiter.arbitrate(6000000 + HOLD_MS * 1000, 0));
+    TEST_ASSERT_EQUAL(wifi, arbiter.get_active());
+    TEST_ASSERT_EQUAL(1, status.failbacks);
+}
+
+TEST_CASE("WiFiUplinkArbiter: A Flapping Link Restarts Its Hold", "[uplink]")
+{
+    WiFiUplinkArbiter arbiter(HOLD_MS);
+    int8_t wifi = arbiter.add(WIFI_PRIORITY);
+    int8_t eth  = arbiter.add(ETH_PRIORITY);
+    arbiter.set_ready(wifi, true, 0);
+    arbiter.arbitrate(0, 0);
+
+    // Ethernet comes and goes: each return restarts the hold
+    arbiter.set_ready(eth, true, 1000000);
+    arbiter.set_ready(eth, false, 4000000);
+    arbiter.set_ready(eth, true, 8000000);
+    TEST_ASSERT_FALSE(arbiter.arbitrate(1000000 + HOLD_MS * 1000, 0));
+    TEST_ASSERT_EQUAL(wifi, arbiter.get_active());
+
+    // A health report that changes nothing keeps the start of the hold
+    arbiter.set_healthy(eth, true, 12000000);
+    TEST_ASSERT_TRUE(arbiter.arbitrate(8000000 + HOLD_MS * 1000, 0));
+    TEST_ASSERT_EQUAL(eth, arbiter.get_active());
+}
+
+TEST_CASE("WiFiUplinkArbiter: Health Reports And Outages", "[uplink]")
+{
+    WiFiUplinkArbiter arbiter(HOLD_MS);
+    int8_t wifi = arbiter.add(WIFI_PRIORITY);
+    int8_t eth  = arbiter.add(ETH_PRIORITY);
+    arbiter.set_ready(wifi, true, 0);
+    arbiter.set_ready(eth, true, 0);
+    arbiter.arbitrate(0, 0);
+    TEST_ASSERT_EQUAL(eth, arbiter.get_active());
+
+    // The Ethernet link is up but its probes fail (upstream router down)
+    arbiter.set_healthy(eth, false, 1000);
+    TEST_ASSERT_FALSE(arbiter.is_usable(eth));
+    TEST_ASSERT_TRUE(arbiter.arbitrate(1000, 1000));
+    TEST_ASSERT_EQUAL(wifi, arbiter.get_active());
+
+    // Then Wi-Fi goes too: no route
+    arbiter.set_ready(wifi, false, 2000);
+    TEST_ASSERT_TRUE(arbiter.arbitrate(2000, 2000));
+    TEST_ASSERT_EQUAL(WiFiUplinkArbiter::NONE, arbiter.get_active());
+    TEST_ASSERT_EQUAL(1, arbiter.get_status().outages);
+    TEST_ASSERT_FALSE(arbiter.arbitrate(3000, 3000));
+
+    // The first uplink back is taken at once, and it is not a failover
+    arbiter.set_healthy(eth, true, 4000);
+    TEST_ASSERT_TRUE(arbiter.arbitrate(4000, 4000));
+    TEST_ASSERT_EQUAL(eth, arbiter.get_active());
+    TEST_ASSERT_EQUAL(1, arbiter.get_status().failovers);
+
+    // Lowering the active uplink's priority hands the route over after the hold
+    arbiter.set_ready(wifi, true, 5000);
+    arbiter.set_priority(eth, CELLULAR_PRIORITY);
+    TEST_ASSERT_EQUAL(CELLULAR_PRIORITY, arbiter.get_priority(eth));
+    TEST_ASSERT_TRUE(arbiter.arbitrate(5000 + HOLD_MS * 1000, 0));
+    TEST_ASSERT_EQUAL(wifi, arbiter.get_active());
+
+    arbiter.clear();
+    TEST_ASSERT_EQUAL(0, arbiter.get_status().count);
+    TEST_ASSERT_EQUAL(WiFiUplinkArbiter::NONE, arbiter.get_active());
+}
@@ -1,17 +1,24 @@
 #pragma once
 
 #include "esp_err.h"
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+#include "wifi_types.hpp"
+
 class WiFiDriverHAL;
 
 /**
  * @class WiFiConfigStorage
- * @brief Handles persistence of WiFi credentials and validity flags using NVS.
+ * @brief Handles persistence of WiFi credentials, validity flag and network hints using NVS.
  */
 class WiFiConfigStorage
 {
 public:
+    static constexpr size_t SSID_MAX_LEN     = 32; ///< wifi_sta_config_t::ssid
+    static constexpr size_t PASSWORD_MAX_LEN = 64; ///< wifi_sta_config_t::password
+
     /**
      * @brief Constructor.
      * @param hal Reference to the driver HAL.
@@ -27,19 +34,57 @@ public:
 
     /**
      * @brief Save WiFi credentials to the driver and persist validity flag.
-     * @param ssid WiFi SSID.
-     * @param password WiFi password.
-     * @return ESP_OK on success.
+     *
+     * The channel learnt for the previous network and its PHY configuration are forgotten.
+     *
+     * @param ssid WiFi SSID (truncated to SSID_MAX_LEN).
+     * @param password WiFi password (truncated to PASSWORD_MAX_LEN).
+     * @param hidden The AP does not broadcast its SSID.
+     * @return ESP_OK on success, ESP_ERR_INVALID_ARG if ssid or password is nullptr.
+     */
+    esp_err_t save_credentials(const char *ssid, const char *password, bool hidden = false);
+
+    esp_err_t save_credentials(const std::string &ssid, const std::string &password, bool hidden = false)
+    {
+        return save_credentials(ssid.c_str(), password.c_str(), hidden);
+    }
+
+    /**
+     * @brief Save an enterprise network: the SSID goes to the driver, the profile to NVS.
+     *
+     * Like save_credentials(), forgets the channel and PHY modes of the previous network.
+     * @param ssid WiFi SSID (truncated to SSID_MAX_LEN).
+     * @param profile A valid profile (EnterpriseProfile::is_valid()).
+     * @param hidden The AP does not broadcast its SSID.
+     * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an invalid profile.
      */
-    esp_err_t save_credentials(const std::string &ssid, const std::string &password);
+    esp_err_t save_enterprise_credentials(const char *ssid, const wifi_manager::EnterpriseProfile &profile,
+                                          bool hidden = false);
 
     /**
      * @brief Load WiFi credentials from the driver.
-     * @param ssid [out] Loaded SSID.
-     * @param password [out] Loaded password.
-     * @return ESP_OK on success.
+     * @param ssid [out] Loaded SSID, NUL-terminated (at least SSID_MAX_LEN + 1 bytes to avoid truncation).
+     * @param ssid_size Size of the ssid buffer.
+     * @param password [out] Loaded password, NUL-terminated (at least PASSWORD_MAX_LEN + 1 bytes).
+     * @param password_size Size of the password buffer.
+     * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an empty buffer.
      */
-    esp_err_t load_credentials(std::string &ssid, std::string &password);
+    esp_err_t load_credentials(char *ssid, size_t ssid_size, char *password, size_t password_size);
+
+    /**
+     * @brief std::string variant, instantiated only by callers that use it.
+     */
+    esp_err_t load_credentials(std::string &ssid, std::string &password)
+    {
+        char ssid_buf[SSID_MAX_LEN + 1];
+        char pass_buf[PASSWORD_MAX_LEN + 1];
+        esp_err_t err = load_credentials(ssid_buf, sizeof(ssid_buf), pass_buf, sizeof(pass_buf));
+        if (err == ESP_OK) {
+            ssid     = ssid_buf;
+            password = pass_buf;
+        }
+        return err;
+    }
 
     /**
      * @brief Clear WiFi credentials from the driver and reset validity flag.
@@ -59,6 +104,54 @@ public:
      */
     bool is_valid() const;
 
+    /**
+     * @brief Whether the stored network hides its SSID.
+     */
+    bool is_hidden() const
+    {
+        return m_hidden;
+    }
+
+    /**
+     * @brief Channel of the last association with the stored network (0 if unknown).
+     */
+    uint8_t get_channel() const
+    {
+        return m_channel;
+    }
+
+    /**
+     * @brief Persist the channel of the stored network (0 forgets it).
+     *
+     * NVS is only written when the channel changes.
+     * @param channel Primary channel reported by the association.
+     * @return ESP_OK on success.
+     */
+    esp_err_t save_channel(uint8_t channel);
+
+    /**
+     * @brief PHY modes configured for the stored network (all defaults if none).
+     */
+    wifi_manager::PhyConfig get_phy() const
+    {
+        return m_phy;
+    }
+
+    /**
+     * @brief Persist the PHY modes of the stored network.
+     * @param phy A valid configuration (PhyConfig::is_valid()).
+     * @return ESP_OK on success.
+     */
+    esp_err_t save_phy(const wifi_manager::PhyConfig &phy);
+
+    /**
+     * @brief Enterprise profile of the stored network (method NONE for a personal network).
+     */
+    const wifi_manager::EnterpriseProfile &get_enterprise() const
+    {
+        return m_eap;
+    }
+
     /**
      * @brief Save the validity flag to NVS.
      * @param valid Validity status.
@@ -68,6 +161,8 @@ public:
 
     /**
      * @brief Ensure driver has a configuration, fallback to Kconfig if empty.
+     *
+     * The fallback is only built with CONFIG_WIFI_MANAGER_KCONFIG_CREDENTIALS.
      * @return ESP_OK on success.
      */
     esp_err_t ensure_config_fallback();
@@ -76,6 +171,14 @@ private:
     WiFiDriverHAL &m_hal;
     const char *m_nvs_namespace;
     bool m_is_valid;
+    bool m_hidden;                         ///< The stored network hides its SSID
+    uint8_t m_channel;                     ///< Last channel of the stored network, 0 if unknown
+    wifi_manager::PhyConfig m_phy;         ///< PHY modes of the stored network
+    wifi_manager::EnterpriseProfile m_eap; ///< EAP profile of the stored network
+
+    esp_err_t load_flags();
 
-    esp_err_t load_valid_flag();
+    // Persists the hidden flag and EAP profile of a newly saved network and clears its
+    // channel and PHY modes
+    esp_err_t save_network(bool hidden, const wifi_manager::EnterpriseProfile &eap = {});
 };
@@ -7,6 +7,8 @@
 
 #include <string>
 
+#include "wifi_types.hpp"
+
 /**
  * @class WiFiDriverHAL
  * @brief Hardware Abstraction Layer for ESP-IDF WiFi and Netif APIs.
@@ -40,12 +42,80 @@ public:
     esp_err_t disconnect();
     esp_err_t restore();
 
+    // Starts IPv6 on the STA netif (link-local, then SLAAC) once associated;
+    // ESP_ERR_NOT_SUPPORTED without CONFIG_LWIP_IPV6
+    esp_err_t enable_ipv6();
+
+    // Other uplinks (Ethernet, PPP) for the arbitration of the default route: whether the
+    // netif holds an IPv4 address, its lwIP index (as carried by UPLINK_UP/UPLINK_DOWN),
+    // and the default route itself
+    bool netif_has_ip(esp_netif_t *netif);
+    uint8_t netif_index(esp_netif_t *netif);
+    esp_err_t set_default_netif(esp_netif_t *netif);
+
     // Configuration
     esp_err_t set_config(wifi_config_t *cfg);
     esp_err_t get_config(wifi_config_t *cfg);
 
-    // Cleanup
+    // Applies the country, channel range, dwell times and scan method of the connect scan
+    // (after init_wifi()); ESP_ERR_INVALID_ARG for an inconsistent plan
+    esp_err_t apply_channel_plan(const wifi_manager::ChannelPlan &plan);
+
+    // Sets the STA protocols and bandwidth; DEFAULT fields keep the driver defaults, read
+    // before the first change. The driver is only called when the result differs.
+    esp_err_t set_phy(const wifi_manager::PhyConfig &phy);
+
+    // Requests an individual TWT agreement (flow 0) with the encoded interval and service
+    // period; the AP answers with WIFI_EVENT_ITWT_SETUP. ESP_ERR_NOT_SUPPORTED without
+    // CONFIG_WIFI_MANAGER_TWT (802.11ax targets, ESP-IDF 5.2+).
+    esp_err_t setup_twt(const wifi_manager::TwtConfig &twt);
+    esp_err_t teardown_twt();
+
+    // Hands an enterprise profile to the supplicant (esp_eap_client) and enables 802.1X;
+    // the caller resolves the certificates (nullptr when unused). Until the next call the
+    // supplicant keeps its TLS session and PMK cache, so reconnects may resume.
+    // ESP_ERR_NOT_SUPPORTED without CONFIG_WIFI_MANAGER_ENTERPRISE (ESP-IDF 5.1+).
+    esp_err_t configure_enterprise(const wifi_manager::EnterpriseProfile &profile,
+                                   const wifi_manager::Certificate *ca_cert,
+                                   const wifi_manager::Certificate *client_cert,
+                                   const wifi_manager::Certificate *client_key);
+
+    // Disables 802.1X and drops the supplicant's credentials and cached sessions
+    esp_err_t disable_enterprise();
+
+    // Limits the transmit power (0.25 dBm units, esp_wifi_set_max_tx_power()); the
+    // driver is only called when the limit changes
+    esp_err_t set_max_tx_power(int8_t power);
+
+    // Gives the driver back the limit it had before the first set_max_tx_power()
+    esp_err_t restore_max_tx_power();
+
+    // RSSI of the associated AP, from esp_wifi_sta_get_ap_info()
+    esp_err_t get_rssi(int8_t &rssi);
+
+    // BSSID of the associated AP, from esp_wifi_sta_get_ap_info()
+    esp_err_t get_bssid(uint8_t (&bssid)[6]);
+
+    // Sets ft_enabled in the STA config: the supplicant then uses 802.11r on APs that
+    // advertise a mobility domain (needs CONFIG_ESP_WIFI_11R_SUPPORT). Only written when it changes.
+    esp_err_t set_ft(bool enabled);
+
+    // Pins the next association to the AP and channel of target; nullptr lets the driver
+    // pick the AP again. Only written when it changes.
+    esp_err_t pin_bssid(const wifi_manager::RoamCandidate *target);
+
+    // Starts a non-blocking scan of the configured SSID on one channel (0: all channels);
+    // WIFI_EVENT_SCAN_DONE reports the end
+    esp_err_t start_roam_scan(uint8_t channel);
+
+    // Fetches (and frees) the results of the last scan, at most ROAM_RECORDS_MAX APs;
+    // count is the size of candidates on entry and the number written on return
+    static constexpr size_t ROAM_RECORDS_MAX = 8;
+    esp_err_t get_roam_candidates(wifi_manager::RoamCandidate *candidates, size_t &count);
+
+    // Cleanup (deinit() keeps the STA netif so the next init can reuse it)
     esp_err_t deinit();
+    void destroy_sta_netif();
 
     // Getters
     esp_netif_t *get_sta_netif() const
@@ -58,4 +128,18 @@ private:
     esp_event_handler_instance_t m_wifi_event_instance;
     esp_event_handler_instance_t m_ip_event_instance;
     bool m_wifi_init_done;
+
+    int8_t m_tx_power;         ///< Limit last applied by set_max_tx_power(), 0 if none
+    int8_t m_default_tx_power; ///< Driver limit before the first set_max_tx_power(), 0 if unchanged
+    bool m_enterprise;         ///< 802.1X enabled by configure_enterprise()
+
+    wifi_ap_record_t m_scan_records[ROAM_RECORDS_MAX]; ///< Kept off the wifi_task stack
+
+    // PHY modes (see set_phy())
+    bool m_phy_defaults_read;
+    uint8_t m_default_protocol;
+    wifi_bandwidth_t m_default_bandwidth;
+    bool m_phy_applied; ///< m_applied_* match the driver (cleared by deinit())
+    uint8_t m_applied_protocol;
+    wifi_bandwidth_t m_applied_bandwidth;
 };
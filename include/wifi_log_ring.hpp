@@ -0,0 +1,220 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "wifi_os.hpp"
+
+namespace wifi_manager {
+
+/**
+ * @brief Messages wifi_task can log as binary records.
+ *
+ * Each id has a fixed level (log_level()) and a fixed text (format_record()); the
+ * record carries only the integer arguments.
+ */
+enum class LogId : uint8_t
+{
+    ECHO_IGNORED,        ///< (no args)
+    TRANSITION,          ///< event, from state, to state
+    STA_DISCONNECTED,    ///< reason, RSSI
+    LEFT,                ///< (no args)
+    SUSPECT_INVALIDATE,  ///< reason
+    SUSPECT_RETRY,       ///< reason, delay ms
+    RECONNECT_SCHEDULED, ///< attempt, delay ms
+    TIMEOUT_ASSOC,       ///< (no args)
+    TIMEOUT_DHCP,        ///< (no args)
+    CHAIN_CONNECT,       ///< (no args)
+    ASSOCIATED,          ///< channel, ms since esp_wifi_connect()
+    PROBE_MISSED,        ///< channel
+    PHY_FALLBACK,        ///< fallback level, reason
+    PHY_FAILED,          ///< error
+    TWT_REQUESTED,       ///< wake interval (ms), service period (us)
+    TWT_STATE,           ///< TwtState answered by the AP
+    TWT_FAILED,          ///< error
+    TX_POWER,            ///< limit (0.25 dBm), RSSI
+    TX_POWER_FAILED,     ///< error
+    EAP_HANDSHAKE,       ///< ms since esp_wifi_connect(), likely resumed, estimated total ms saved
+    EAP_FAILED,          ///< error
+    ROAM_SCAN,           ///< RSSI, trigger RSSI
+    ROAM_START,          ///< fast transition, candidate RSSI, channel
+    ROAM_DONE,           ///< fast transition, link gap us
+    ROAM_FAILED,         ///< fast transition
+    UPLINK_SWITCH,       ///< uplink slot, priority, failover (1) or not (0)
+    UPLINK_NONE,         ///< (no args)
+    UPLINK_FAILED,       ///< uplink slot, error
+    CHANNEL_CHANGE,      ///< from channel, to channel, pending (1) or done (0)
+    GOT_IP,              ///< address kind
+    ADDRESS_PENDING,     ///< address kind, readiness
+    IPV6_FAILED,         ///< error
+    SUPERSEDED,          ///< command
+    COMMAND_DROPPED,     ///< command, state
+    BOOT_BACKOFF,        ///< attempt, delay ms
+    BUDGET_EXHAUSTED,    ///< budget, wait s
+    BACKOFF_DONE,        ///< (no args)
+    LINK_STABLE,         ///< (no args)
+    COUNT
+};
+
+/**
+ * @brief Same order and values as esp_log_level_t.
+ */
+enum class LogLevel : uint8_t
+{
+    NONE,
+    ERROR,
+    WARN,
+    INFO,
+    DEBUG,
+};
+
+/**
+ * @brief Level of a message, known at compile time so that records above
+ *        CONFIG_WIFI_MANAGER_LOG_LEVEL are never written and their text is not linked.
+ */
+constexpr LogLevel log_level(LogId id)
+{
+    switch (id) {
+    case LogId::SUSPECT_INVALIDATE:
+        return LogLevel::ERROR;
+    case LogId::SUSPECT_RETRY:
+    case LogId::TIMEOUT_ASSOC:
+    case LogId::TIMEOUT_DHCP:
+    case LogId::BOOT_BACKOFF:
+    case LogId::BUDGET_EXHAUSTED:
+    case LogId::IPV6_FAILED:
+    case LogId::PHY_FALLBACK:
+    case LogId::PHY_FAILED:
+    case LogId::TWT_FAILED:
+    case LogId::TX_POWER_FAILED:
+    case LogId::EAP_FAILED:
+    case LogId::ROAM_FAILED:
+    case LogId::UPLINK_NONE:
+    case LogId::UPLINK_FAILED:
+        return LogLevel::WARN;
+    case LogId::ECHO_IGNORED:
+    case LogId::TRANSITION:
+    case LogId::COMMAND_DROPPED:
+    case LogId::LINK_STABLE:
+        return LogLevel::DEBUG;
+    default:
+        return LogLevel::INFO;
+    }
+}
+
+/**
+ * @brief One deferred log line: 16 bytes, no pointers.
+ *
+ * The id shares the first word with a 24-bit timestamp in 256 us steps.
+ */
+struct LogRecord
+{
+    static constexpr uint32_t TIME_SHIFT = 8;          ///< Timestamp step: 256 us
+    static constexpr uint32_t TIME_MASK  = 0x00FFFFFF; ///< 24 bits, wraps after ~71 minutes
+
+    uint32_t time : 24; ///< esp_timer time >> TIME_SHIFT
+    LogId id : 8;
+    int32_t args[3];
+
+    /**
+     * @brief Time elapsed since the record was written, to the timestamp step.
+     */
+    uint32_t age_us(int64_t now_us) const
+    {
+        return (((uint32_t)(now_us >> TIME_SHIFT) - time) & TIME_MASK) << TIME_SHIFT;
+    }
+};
+
+static_assert(sizeof(LogRecord) == 16, "LogRecord must stay 16 bytes");
+
+/**
+ * @brief Counters of a WiFiLogRing.
+ */
+struct LogRingStats
+{
+    uint32_t written;      ///< Records accepted
+    uint32_t dropped_full; ///< Records lost because the drain lagged behind
+    uint32_t dropped_rate; ///< Records refused by the rate limiter
+};
+
+/**
+ * @brief Render a record as text (no level, tag or newline).
+ *
+ * Ids above CONFIG_WIFI_MANAGER_LOG_LEVEL have no text in the binary and render as their number.
+ *
+ * @param record The record.
+ * @param buf [out] Destination, always NUL-terminated if size > 0.
+ * @param size Size of buf.
+ * @return Length of the text, truncated to size - 1.
+ */
+size_t format_record(const LogRecord &record, char *buf, size_t size);
+
+/**
+ * @class WiFiLogRing
+ * @brief Lock-free single-producer / single-consumer ring of LogRecord.
+ *
+ * wifi_task writes a record in a few stores instead of formatting and printing a line
+ * on the UART; a low-priority task reads the records back and formats them later.
+ * The producer side also runs a token bucket so a disconnect storm cannot flood the
+ * ring or the console: beyond `burst` records, only `rate_per_s` records per second
+ * are accepted. Records refused by the limiter or lost to a full ring are counted and
+ * reported by the drain with take_dropped().
+ *
+ * write() may only be called by one thread (wifi_task) and read()/take_dropped() by
+ * one other thread; stats() may be read from anywhere.
+ */
+class WiFiLogRing
+{
+public:
+    /**
+     * @param storage Record buffer, owned by the caller.
+     * @param capacity Number of records in storage.
+     * @param rate_per_s Sustained records per second, 0 for no limit.
+     * @param burst Records accepted back to back before the rate applies.
+     */
+    WiFiLogRing(LogRecord *storage, uint32_t capacity, uint32_t rate_per_s, uint32_t burst);
+
+    /**
+     * @brief Producer: append a record.
+     * @param now_us Current time, also the record timestamp.
+     * @param was_empty [out] true if the ring was empty, i.e. the consumer may be asleep.
+     * @return false if the record was dropped (rate limit or ring full).
+     */
+    bool write(int64_t now_us, LogId id, int32_t a0, int32_t a1, int32_t a2, bool &was_empty);
+
+    /**
+     * @brief Consumer: remove the oldest record.
+     * @return false if the ring is empty.
+     */
+    bool read(LogRecord &out);
+
+    /**
+     * @brief Consumer: records dropped since the previous call.
+     */
+    uint32_t take_dropped();
+
+    LogRingStats stats() const;
+
+private:
+    LogRecord *m_storage;
+    const uint32_t m_capacity;
+
+    std::atomic<uint32_t> m_head; ///< Next slot to write, only advanced by the producer
+    std::atomic<uint32_t> m_tail; ///< Next slot to read, only advanced by the consumer
+
+    // Token bucket, producer only. Tokens are counted in 1/1000 to refill at fine steps.
+    const uint32_t m_rate_per_s;
+    const uint32_t m_burst_milli;
+    uint32_t m_tokens_milli;
+    int64_t m_refill_us;
+
+    std::atomic<uint32_t> m_written;
+    std::atomic<uint32_t> m_dropped_full;
+    std::atomic<uint32_t> m_dropped_rate;
+    uint32_t m_dropped_reported; ///< Consumer only
+
+    bool take_token(int64_t now_us);
+};
+
+} // namespace wifi_manager
@@ -7,13 +7,21 @@
  * @version 1.1.0
  */
 
+#include <atomic>
 #include <cstdint>
 #include <string>
 
+#include "sdkconfig.h"
 #include "wifi_config_storage.hpp"
 #include "wifi_driver_hal.hpp"
+#include "wifi_log_ring.hpp"
+#include "wifi_retry_guard.hpp"
+#include "wifi_roam_policy.hpp"
 #include "wifi_state_machine.hpp"
 #include "wifi_sync_manager.hpp" // Added this include
+#include "wifi_timer_scheduler.hpp"
+#include "wifi_uplink_arbiter.hpp"
+#include "wifi_tx_power.hpp"
 #include "wifi_types.hpp"
 
 class WiFiManagerTestAccessor;
@@ -24,7 +32,8 @@ class WiFiManagerTestAccessor;
  *
  * This class uses a dedicated FreeRTOS task to handle all WiFi operations,
  * ensuring thread safety and a non-blocking internal architecture.
- * It provides both synchronous (blocking) and asynchronous (non-blocking) methods.
+ * It provides both synchronous (blocking) and asynchronous (non-blocking) methods;
+ * the blocking ones and transactions are only built with CONFIG_WIFI_MANAGER_SYNC_API.
  */
 class WiFiManager
 {
@@ -44,10 +53,62 @@ public:
      */
     static WiFiManager &get_instance();
 
+    /**
+     * @brief esp_err_to_name() that also knows the component's own codes (wifi_manager::ERR_*).
+     */
+    static const char *err_to_name(esp_err_t err);
+
     // Prevent copying and assignment
     WiFiManager(const WiFiManager &)            = delete;
     WiFiManager &operator=(const WiFiManager &) = delete;
 
+    /**
+     * @class CancellationToken
+     * @brief Lets another task abandon a blocking call right away.
+     *
+     * Pass a token to any synchronous call; cancel() from any task wakes the caller,
+     * which returns wifi_manager::ERR_CANCELLED. For start() and connect() (and
+     * transactions) wifi_task is also told to abort the attempt, so no timeout-based
+     * rollback is needed. A token stays cancelled until reset().
+     *
+     * The flag lives in the token and cancel() wakes only the task waiting on it (by
+     * aborting its block, which needs INCLUDE_xTaskAbortDelay), so concurrent callers
+     * with other tokens are never disturbed. Use a token for one call at a time.
+     */
+    class CancellationToken
+    {
+    public:
+        CancellationToken()
+            : m_cancelled(false)
+            , m_waiter(nullptr)
+        {
+        }
+
+        /**
+         * @brief Cancel the call waiting on this token, if any. Safe from any task.
+         */
+        void cancel();
+
+        /**
+         * @brief Re-arm the token for another call.
+         */
+        void reset()
+        {
+            m_cancelled.store(false);
+        }
+
+        bool is_cancelled() const
+        {
+            return m_cancelled.load();
+        }
+
+    private:
+        friend class WiFiManager;
+
+        std::atomic<bool> m_cancelled;
+        mutable std::atomic<TaskHandle_t> m_waiter; ///< Task blocked on this token, woken by cancel()
+    };
+
     /**
      * @brief Initialize the WiFi stack.
      *
@@ -61,16 +122,118 @@ public:
      */
     esp_err_t init();
 
+    /**
+     * @brief Initialize the WiFi stack in the background.
+     *
+     * Creates the command queue, event group and the manager task on the caller's
+     * thread, then returns immediately. The task performs the same bring-up as
+     * init() and, if requested, chains straight into START and CONNECT, so the
+     * application can keep initializing while WiFi comes up.
+     *
+     * Commands issued before the bring-up completes are rejected with
+     * ESP_ERR_INVALID_STATE; use wait_for_init() to synchronize.
+     *
+     * @param auto_start Start the driver as soon as the bring-up completes.
+     * @param auto_connect Connect as soon as the driver is started (implies auto_start).
+     * @return
+     *  - ESP_OK: Background initialization launched (or already initialized).
+     *  - ESP_ERR_NO_MEM: Failed to allocate RTOS resources.
+     */
+    esp_err_t init_async(bool auto_start = false, bool auto_connect = false);
+
+    /**
+     * @brief Wait for a background initialization to finish.
+     *
+     * On failure, the partially initialized stack is released (as by deinit()).
+     *
+     * @param timeout_ms Maximum time to wait.
+     * @param token Optional cancellation token (the bring-up itself keeps running).
+     * @return
+     *  - ESP_OK: The manager is initialized.
+     *  - ESP_ERR_TIMEOUT: The bring-up is still running.
+     *  - wifi_manager::ERR_CANCELLED: The token was cancelled.
+     *  - ESP_ERR_INVALID_STATE: Neither init() nor init_async() was called.
+     *  - Others: The error reported by the failing bring-up step.
+     */
+    esp_err_t wait_for_init(uint32_t timeout_ms, CancellationToken *token = nullptr);
+
+    /**
+     * @brief Duration of each step of the last init() / init_async(), in microseconds.
+     */
+    struct InitTiming
+    {
+        uint32_t sync_us;       ///< Queue and event group creation
+        uint32_t task_us;       ///< Manager task creation
+        uint32_t storage_us;    ///< NVS flash and storage init
+        uint32_t netif_us;      ///< esp_netif_init()
+        uint32_t event_loop_us; ///< Default event loop creation
+        uint32_t sta_netif_us;  ///< STA netif creation (or reuse)
+        uint32_t wifi_init_us;  ///< esp_wifi_init()
+        uint32_t set_mode_us;   ///< esp_wifi_set_mode(STA)
+        uint32_t handlers_us;   ///< Event handler registration
+        uint32_t config_us;     ///< Kconfig credential fallback and channel plan
+        uint32_t total_us;      ///< From the init call until INITIALIZED
+    };
+
+    /**
+     * @brief Get the per-step timing of the last initialization.
+     * @return A copy of the timing record (zeroed steps did not run).
+     */
+    InitTiming get_init_timing() const;
+
+    /**
+     * @brief Latency from an event being posted by the event loop to wifi_task dequeuing it.
+     *
+     * Shortcut for get_metrics().dwell[MessageType::EVENT].
+     *
+     * @return A copy of the running statistics, in microseconds.
+     */
+    wifi_manager::LatencyStats get_event_latency() const;
+
+    /**
+     * @brief Get the queue and dispatch instrumentation of the manager task.
+     *
+     * Every message is stamped when posted. The task records its queue dwell time
+     * and dispatch latency (split by message type) and the handler execution time
+     * (per command, and for events as a whole).
+     *
+     * @return A consistent snapshot of all histograms, in microseconds.
+     */
+    wifi_manager::DispatchMetrics get_metrics() const;
+
+    /**
+     * @brief Reset all dispatch metrics.
+     */
+    void reset_metrics();
+
+#if CONFIG_WIFI_MANAGER_DEFERRED_LOG
+    /**
+     * @brief Counters of the deferred log ring.
+     *
+     * wifi_task writes its messages as binary records; a low-priority task formats
+     * them. Records refused by the rate limiter or lost to a full ring are counted
+     * here and reported in the log as they happen.
+     *
+     * @return Records written and dropped since boot.
+     */
+    wifi_manager::LogRingStats get_log_stats() const;
+#endif
+
     /**
      * @brief Deinitialize the WiFi stack.
      *
      * Stops the WiFi driver if running, terminates the manager task,
      * and releases all allocated RTOS and system resources.
+     * The task is joined through a dedicated semaphore, so deinit() returns as
+     * soon as the task has exited and leaves the caller's task notification
+     * alone. The STA netif is kept and reused by the next init() to make
+     * deinit/init cycles cheap.
      *
      * @return ESP_OK on success.
      */
     esp_err_t deinit();
 
+#if CONFIG_WIFI_MANAGER_SYNC_API
     /**
      * @brief Start the WiFi station mode (synchronous).
      *
@@ -78,12 +241,16 @@ public:
      * Note: This operation can take a few hundred milliseconds.
      *
      * @param timeout_ms Maximum time to wait for the operation to complete.
+     * @param token Optional cancellation token; cancelling aborts the start.
      * @return
      *  - ESP_OK: Started successfully.
      *  - ESP_ERR_TIMEOUT: Operation timed out.
      *  - ESP_ERR_INVALID_STATE: Manager is not initialized.
+     *  - wifi_manager::ERR_SUPERSEDED: A STOP queued behind it dropped the command.
+     *  - wifi_manager::ERR_CANCELLED: The token was cancelled.
      */
-    esp_err_t start(uint32_t timeout_ms);
+    esp_err_t start(uint32_t timeout_ms, CancellationToken *token = nullptr);
+#endif
 
     /**
      * @brief Start the WiFi station mode (asynchronous).
@@ -94,15 +261,18 @@ public:
      */
     esp_err_t start();
 
+#if CONFIG_WIFI_MANAGER_SYNC_API
     /**
      * @brief Stop the WiFi station mode (synchronous).
      *
      * Blocks until the WiFi driver is stopped or a timeout occurs.
      *
      * @param timeout_ms Maximum time to wait for the operation to complete.
-     * @return ESP_OK on success, ESP_ERR_TIMEOUT on timeout.
+     * @param token Optional cancellation token; cancelling only stops waiting, the driver still stops.
+     * @return ESP_OK on success, ESP_ERR_TIMEOUT on timeout, wifi_manager::ERR_CANCELLED if cancelled.
      */
-    esp_err_t stop(uint32_t timeout_ms);
+    esp_err_t stop(uint32_t timeout_ms, CancellationToken *token = nullptr);
+#endif
 
     /**
      * @brief Stop the WiFi station mode (asynchronous).
@@ -113,6 +283,7 @@ public:
      */
     esp_err_t stop();
 
+#if CONFIG_WIFI_MANAGER_SYNC_API
     /**
      * @brief Connect to the configured WiFi network (synchronous).
      *
@@ -122,12 +293,16 @@ public:
      * Note: This can take several seconds depending on network conditions.
      *
      * @param timeout_ms Maximum time to wait for connection and IP.
+     * @param token Optional cancellation token; cancelling aborts the attempt at once.
      * @return
      *  - ESP_OK: Connected and has IP.
      *  - ESP_ERR_TIMEOUT: Failed to connect within the time limit.
      *  - ESP_FAIL: Driver reported immediate failure or no credentials found.
+     *  - wifi_manager::ERR_SUPERSEDED: A STOP queued behind it dropped the command.
+     *  - wifi_manager::ERR_CANCELLED: The token was cancelled.
      */
-    esp_err_t connect(uint32_t timeout_ms);
+    esp_err_t connect(uint32_t timeout_ms, CancellationToken *token = nullptr);
+#endif
 
     /**
      * @brief Connect to the configured WiFi network (asynchronous).
@@ -138,15 +313,18 @@ public:
      */
     esp_err_t connect();
 
+#if CONFIG_WIFI_MANAGER_SYNC_API
     /**
      * @brief Disconnect from the current WiFi network (synchronous).
      *
      * Blocks until the disconnection is confirmed by the driver.
      *
      * @param timeout_ms Maximum time to wait for the operation to complete.
-     * @return ESP_OK on success.
+     * @param token Optional cancellation token; cancelling only stops waiting.
+     * @return ESP_OK on success, wifi_manager::ERR_CANCELLED if cancelled.
      */
-    esp_err_t disconnect(uint32_t timeout_ms);
+    esp_err_t disconnect(uint32_t timeout_ms, CancellationToken *token = nullptr);
+#endif
 
     /**
      * @brief Disconnect from the current WiFi network (asynchronous).
@@ -157,6 +335,316 @@ public:
      */
     esp_err_t disconnect();
 
+#if CONFIG_WIFI_MANAGER_SYNC_API
+    /**
+     * @brief An ordered list of commands executed by wifi_task as a single unit.
+     *
+     * Fill it with add() / add_credentials() and submit it with run_transaction().
+     * Steps run in order; the first failing step aborts the remaining ones, which
+     * report ESP_ERR_NOT_FINISHED.
+     */
+    struct Transaction
+    {
+        enum class Step : uint8_t
+        {
+            SET_CREDENTIALS, ///< Same as set_credentials() with the stored ssid/password
+            START,
+            CONNECT,
+            DISCONNECT,
+            STOP,
+        };
+
+        static constexpr uint8_t MAX_STEPS = 8;
+
+        Step steps[MAX_STEPS]         = {};    ///< Steps in execution order
+        esp_err_t results[MAX_STEPS]  = {};    ///< Per-step result, filled by run_transaction()
+        uint8_t count                 = 0;     ///< Number of steps
+        char ssid[33]                 = {};    ///< Credentials for SET_CREDENTIALS
+        char password[65]             = {};    ///< Credentials for SET_CREDENTIALS
+        bool hidden                   = false; ///< Hidden SSID flag for SET_CREDENTIALS
+
+        /**
+         * @brief Append a step.
+         * @return ESP_OK, or ESP_ERR_NO_MEM if MAX_STEPS is reached.
+         */
+        esp_err_t add(Step step);
+
+        /**
+         * @brief Append a SET_CREDENTIALS step carrying the given credentials.
+         * @return ESP_OK, ESP_ERR_NO_MEM if MAX_STEPS is reached, ESP_ERR_INVALID_ARG if a field is too long.
+         */
+        esp_err_t add_credentials(const char *new_ssid, const char *new_password, bool new_hidden = false);
+
+        esp_err_t add_credentials(const std::string &new_ssid, const std::string &new_password,
+                                  bool new_hidden = false)
+        {
+            return add_credentials(new_ssid.c_str(), new_password.c_str(), new_hidden);
+        }
+    };
+
+    /**
+     * @brief Execute a transaction with one overall deadline.
+     *
+     * The whole list is posted as a single message. wifi_task runs the steps back to
+     * back, waiting for each one to settle (e.g. STARTED for START, GOT_IP for CONNECT)
+     * while processing system events; other commands queued in the meantime are held
+     * until the transaction has finished; beyond QUEUE_SIZE - 1 of them a command is
+     * rejected (its caller alone gets ERR_SUPERSEDED, or ESP_FAIL for a STOP). A deinit()
+     * always gets through and aborts the remaining steps. A timed out START or CONNECT is
+     * rolled back like its synchronous counterpart.
+     *
+     * @param txn The transaction; its results[] array is filled on return, whatever the
+     *            outcome: steps that did not complete report ESP_ERR_NOT_FINISHED.
+     * @param timeout_ms Deadline for the whole transaction.
+     * @param token Optional cancellation token; cancelling aborts the step in progress
+     *              (rolled back like a timeout) and skips the remaining ones.
+     * @return
+     *  - ESP_OK: Every step succeeded.
+     *  - ESP_ERR_INVALID_ARG: Empty transaction.
+     *  - ESP_ERR_INVALID_STATE: Manager not initialized, or another transaction is running.
+     *  - ESP_ERR_TIMEOUT: The deadline expired (results[] holds the steps completed so far).
+     *  - wifi_manager::ERR_CANCELLED: The token was cancelled (same for results[]).
+     *  - Others: The error of the first failing step.
+     */
+    esp_err_t run_transaction(Transaction &txn, uint32_t timeout_ms, CancellationToken *token = nullptr);
+#endif
+
+    /**
+     * @brief Override the per-phase watchdogs configured in Kconfig.
+     *
+     * When an attempt stays in CONNECTING (no association result) or in
+     * CONNECTED_NO_IP (no DHCP lease) longer than its deadline, wifi_task injects a
+     * synthetic TIMEOUT event: the attempt is aborted and the reconnect backoff
+     * takes over, exactly as for a lost connection.
+     *
+     * @param connect_timeout_ms Deadline for CONNECTING (0 disables).
+     * @param dhcp_timeout_ms Deadline for CONNECTED_NO_IP (0 disables).
+     * @return ESP_OK.
+     */
+    esp_err_t set_watchdog_timeouts(uint32_t connect_timeout_ms, uint32_t dhcp_timeout_ms);
+
+    /**
+     * @brief Choose the addresses that make the link connected (Kconfig default:
+     *        CONFIG_WIFI_MANAGER_IP_READINESS).
+     *
+     * CONNECTED_GOT_IP, and the return of a sync connect(), wait until the STA holds
+     * the selected addresses: an IPv4 lease, an IPv6 link-local address, a routable
+     * IPv6 address, or either of a lease and a routable IPv6 address. IPv6 is enabled
+     * on the STA netif as soon as it associates. The DHCP watchdog bounds the wait.
+     * The policy is evaluated on each new address.
+     *
+     * @param readiness The policy.
+     * @return ESP_OK, or ESP_ERR_INVALID_ARG for an unknown value.
+     */
+    esp_err_t set_ip_readiness(wifi_manager::IpReadiness readiness);
+
+    /**
+     * @brief Set the PHY modes (802.11b/g/n/ax, HT20/HT40) of the stored network.
+     *
+     * Persisted with the network, forgotten by new credentials, and applied before each
+     * association. After CONFIG_WIFI_MANAGER_PHY_FALLBACK_FAILURES associations in a row
+     * refused for PHY reasons (capabilities, supported channels, invalid IE, association
+     * rejected), the manager steps down to 802.11b/g/n at HT20, then to 802.11b/g. The
+     * fallback lasts until the PHY configuration or the credentials change.
+     *
+     * @param phy The modes; zero fields keep the driver defaults.
+     * @return
+     *  - ESP_OK: Stored, applied from the next association.
+     *  - ESP_ERR_INVALID_ARG: Unsupported combination (see PhyConfig::is_valid()).
+     *  - ESP_ERR_INVALID_STATE: Manager not initialized.
+     */
+    esp_err_t set_phy_config(const wifi_manager::PhyConfig &phy);
+
+    /**
+     * @brief Get the PHY modes of the stored network.
+     * @param effective Return the modes actually applied, i.e. after the fallback.
+     */
+    wifi_manager::PhyConfig get_phy_config(bool effective = false) const;
+
+    /**
+     * @brief Restrict the connect scan to a channel plan (Kconfig default:
+     *        CONFIG_WIFI_MANAGER_CHANNEL_PLAN).
+     *
+     * Sets the country and channel range with a manual policy, the per-channel dwell
+     * times and the scan method (first match or strongest AP). The plan is kept and
+     * applied again by every init(); once initialized it applies from the next
+     * association on. get_association_latency() measures its effect.
+     *
+     * @param plan The plan.
+     * @return
+     *  - ESP_OK: Plan stored (and applied if initialized).
+     *  - ESP_ERR_INVALID_ARG: Invalid country, channel range or dwell times.
+     *  - ESP_ERR_INVALID_STATE: A background initialization is in progress.
+     *  - Others: The driver rejected the plan.
+     */
+    esp_err_t set_channel_plan(const wifi_manager::ChannelPlan &plan);
+
+    /**
+     * @brief Request individual Target Wake Time (802.11ax) after each association
+     *        (Kconfig default: CONFIG_WIFI_MANAGER_TWT).
+     *
+     * The setup is requested once the link reaches CONNECTED_GOT_IP, and again after
+     * every reconnect or roam. A rejected or torn-down agreement is retried after the
+     * next association. A new configuration tears down the current agreement and, when
+     * connected, negotiates at once.
+     *
+     * @param twt Wake interval and service period; a zero interval disables TWT.
+     * @return
+     *  - ESP_OK: Configuration stored.
+     *  - ESP_ERR_INVALID_ARG: Service period not shorter than the interval, or above 255 TU.
+     */
+    esp_err_t set_twt_config(const wifi_manager::TwtConfig &twt);
+
+    /**
+     * @brief Whether the AP accepted TWT, the negotiated service periods and the duty cycle.
+     */
+    wifi_manager::TwtStatus get_twt_status() const;
+
+    /**
+     * @brief Enable the closed-loop TX power limit (Kconfig default:
+     *        CONFIG_WIFI_MANAGER_TX_POWER_CONTROL).
+     *
+     * The controller is fed by the RSSI samples taken every
+     * CONFIG_WIFI_MANAGER_RSSI_SAMPLE_MS while CONNECTED_GOT_IP. Strong, stable samples
+     * lower the limit one step at a time, down to what keeps the uplink at the target
+     * RSSI plus a margin; a weaker sample raises it at once, and a disconnect or phase
+     * timeout restores full power. Every call restarts from full power; disabling the
+     * controller gives the driver back the limit it had before the first change.
+     *
+     * @param enabled Run the controller.
+     * @param config Thresholds and limits, nullptr to keep the current ones
+     *               (initially the CONFIG_WIFI_MANAGER_TX_POWER_* options).
+     * @return
+     *  - ESP_OK: Applied.
+     *  - ESP_ERR_INVALID_ARG: Invalid configuration (see WiFiTxPowerController::is_valid()).
+     */
+    esp_err_t set_tx_power_control(bool enabled,
+                                   const wifi_manager::WiFiTxPowerController::Config *config = nullptr);
+
+    /**
+     * @brief Current TX power limit, latest RSSI sample and controller activity.
+     */
+    wifi_manager::TxPowerStatus get_tx_power_status() const;
+
+    /**
+     * @brief Roam between the APs of the network, with 802.11r Fast BSS Transition where
+     *        available (Kconfig default: CONFIG_WIFI_MANAGER_ROAM).
+     *
+     * Each RSSI sample (CONFIG_WIFI_MANAGER_RSSI_SAMPLE_MS) below trigger_rssi may start a
+     * scan of the SSID, at most every scan_interval_ms. An AP at least hysteresis_db
+     * stronger than the current one is roamed to. With ft, associations enable ft_enabled
+     * and the roam reassociates in place: the STA stays CONNECTED_GOT_IP, keeps its
+     * address, and skips the 4-way (and 802.1X) handshake when the APs share a mobility
+     * domain. A transition that fails, or does not complete within
+     * CONFIG_WIFI_MANAGER_ROAM_TIMEOUT_MS, falls back to a regular reconnect; once FT is
+     * known to be unavailable, roams reconnect directly (see WiFiRoamPolicy).
+     *
+     * The learnt FT support and mobility domain start over with the configuration and
+     * with new credentials. A roam in progress completes.
+     *
+     * @param config Trigger, hysteresis, FT, scan interval and same-channel bias; a zero
+     *               trigger_rssi disables roaming.
+     * @return
+     *  - ESP_OK: Configuration stored.
+     *  - ESP_ERR_INVALID_ARG: Positive trigger, or hysteresis or channel bias above 40 dB.
+     */
+    esp_err_t set_roam_config(const wifi_manager::RoamConfig &config);
+
+    /**
+     * @brief FT support, known mobility domain, roam counts and the link gap of each kind of roam.
+     */
+    wifi_manager::RoamStatus get_roam_status() const;
+
+    /**
+     * @brief Keeps the STA on one primary channel, for ESP-NOW peers that share the radio.
+     *
+     * Roams only consider APs of that channel, and their scans only visit it. Connect
+     * scans start there with WIFI_FAST_SCAN. This is a preference, not a guarantee: if
+     * the network can only be joined on another channel, the association still goes
+     * ahead and the channel listener reports the move.
+     *
+     * @param channel Primary channel (1-177), or 0 to unlock.
+     * @return
+     *  - ESP_OK: Lock stored; it applies from the next scan or association.
+     *  - ESP_ERR_INVALID_ARG: channel above 177.
+     */
+    esp_err_t set_channel_lock(uint8_t channel);
+
+    /**
+     * @brief Announces the primary channel of the STA, so ESP-NOW peers can follow it.
+     *
+     * The listener gets ChannelChange::pending before a roam to another channel, then
+     * CONFIG_WIFI_MANAGER_CHANNEL_NOTICE_MS later the roam starts; a canceled roam is
+     * announced back to the current channel. Every association on a channel that differs
+     * from the last announced one, or that ends an announced roam, is reported with pending
+     * false.
+     *
+     * The listener runs on wifi_task with the state mutex held: it must return quickly and
+     * must not call blocking manager APIs. Kept across deinit().
+     *
+     * @param listener Callback, or nullptr to remove it.
+     * @param arg Passed back to the listener.
+     */
+    void set_channel_listener(wifi_manager::ChannelListener listener, void *arg);
+
+    /**
+     * @brief Primary channel of the current association, 0 when not associated.
+     */
+    uint8_t get_channel() const;
+
+    /**
+     * @brief Registers a netif (Ethernet, PPP) that can carry the default route besides the
+     *        Wi-Fi STA, or changes the priority of a registered one.
+     *
+     * The first call also registers the STA (CONFIG_WIFI_MANAGER_UPLINK_WIFI_PRIORITY,
+     * or priority when netif is the STA itself). From then on wifi_task moves the default
+     * route (esp_netif_set_default_netif()) to the usable uplink of highest priority:
+     * - The STA is ready in CONNECTED_GOT_IP, another netif while it holds an IPv4 address
+     *   (IP_EVENT_ETH_GOT_IP / IP_EVENT_PPP_GOT_IP until the matching LOST_IP).
+     * - An uplink reported unhealthy by set_uplink_health() is not usable.
+     * - When the active uplink stops being usable, the route moves while the event that ended
+     *   it is handled. A preferred uplink takes the route back once it has stayed usable for
+     *   CONFIG_WIFI_MANAGER_UPLINK_HOLD_MS.
+     *
+     * deinit() forgets the uplinks; the default route stays where it was.
+     *
+     * @param netif The netif; its readiness is read at once.
+     * @param priority Higher wins; equal priorities keep the registration order.
+     * @return
+     *  - ESP_OK: Registered.
+     *  - ESP_ERR_INVALID_ARG: netif is null.
+     *  - ESP_ERR_INVALID_STATE: Not initialized.
+     *  - ESP_ERR_NO_MEM: WiFiUplinkArbiter::UPLINK_MAX uplinks already registered.
+     */
+    esp_err_t add_uplink(esp_netif_t *netif, uint8_t priority);
+
+    /**
+     * @brief Reachability of a registered uplink, e.g. from the application's pings through it.
+     *        An unhealthy uplink keeps its address but does not carry the default route.
+     * @return ESP_OK, or ESP_ERR_NOT_FOUND if netif is not registered.
+     */
+    esp_err_t set_uplink_health(esp_netif_t *netif, bool healthy);
+
+    /**
+     * @brief Netif carrying the default route, nullptr if none is usable or none is registered.
+     */
+    esp_netif_t *get_active_uplink() const;
+
+    /**
+     * @brief Active slot, failovers, failbacks, outages and failover latency.
+     */
+    wifi_manager::UplinkStatus get_uplink_status() const;
+
+    /**
+     * @brief Time from esp_wifi_connect() to the association: connect scan, authentication
+     *        and association of every attempt that reached CONNECTED_NO_IP.
+     *
+     * Shortcut for get_metrics().association.
+     *
+     * @return A copy of the running statistics, in microseconds.
+     */
+    wifi_manager::LatencyStats get_association_latency() const;
+
     /**
      * @brief Get the current state of the WiFi manager.
      * @return The current State enum value.
@@ -166,20 +654,78 @@ public:
     /**
      * @brief Set WiFi credentials and save them to the driver's NVS.
      *
+     * For a hidden network every attempt probes for the SSID, starting on the channel
+     * of the last association (learnt and persisted on each association), and the
+     * driver only moves on to the other channels if the AP does not answer there.
+     *
      * @param ssid The network SSID.
      * @param password The network password.
-     * @return ESP_OK on success.
+     * @param hidden The AP does not broadcast its SSID.
+     * @return ESP_OK on success, ESP_ERR_INVALID_ARG for a null pointer.
      */
-    esp_err_t set_credentials(const std::string &ssid, const std::string &password);
+    esp_err_t set_credentials(const char *ssid, const char *password, bool hidden = false);
+
+    esp_err_t set_credentials(const std::string &ssid, const std::string &password, bool hidden = false)
+    {
+        return set_credentials(ssid.c_str(), password.c_str(), hidden);
+    }
+
+    /**
+     * @brief Set a WPA2/WPA3-Enterprise network (EAP-TLS, PEAP or TTLS).
+     *
+     * The profile is persisted with the network; its certificates are looked up among the
+     * registered ones when the supplicant is configured, before the next association.
+     * With profile.resumption the supplicant is configured only once, so reconnects resume
+     * the cached TLS session or PMK instead of repeating the certificate exchange;
+     * get_eap_status() estimates the handshake time this saves.
+     *
+     * @param ssid The network SSID.
+     * @param profile EAP method, identities and certificate names.
+     * @param hidden The AP does not broadcast its SSID.
+     * @return ESP_OK on success, ESP_ERR_INVALID_ARG for a null SSID or an invalid profile,
+     *         ESP_ERR_NOT_SUPPORTED without CONFIG_WIFI_MANAGER_ENTERPRISE.
+     */
+    esp_err_t set_enterprise_credentials(const char *ssid, const wifi_manager::EnterpriseProfile &profile,
+                                         bool hidden = false);
+
+    /**
+     * @brief Register certificate or key data under a name enterprise profiles refer to.
+     *
+     * The data is kept by reference (typically embedded in flash). Changing a certificate
+     * of the stored profile reconfigures the supplicant before the next association.
+     *
+     * @param name Up to EnterpriseProfile::CERT_NAME_MAX_LEN characters.
+     * @param data PEM data including its terminating NUL, or DER; nullptr unregisters the name.
+     * @param len Length of data.
+     * @return ESP_OK on success, ESP_ERR_INVALID_ARG for a bad name,
+     *         ESP_ERR_NO_MEM when all 4 slots are taken.
+     */
+    esp_err_t register_certificate(const char *name, const uint8_t *data, size_t len);
+
+    /**
+     * @brief Handshakes of the stored enterprise network, split by timing into full and likely
+     *        resumed ones, and an estimate of the time saved.
+     */
+    wifi_manager::EapStatus get_eap_status() const;
 
     /**
      * @brief Get the currently configured WiFi credentials from the driver.
      *
-     * @param ssid Output parameter for the SSID.
-     * @param password Output parameter for the password.
+     * @param ssid Output buffer for the SSID (33 bytes hold any SSID).
+     * @param ssid_size Size of the ssid buffer.
+     * @param password Output buffer for the password (65 bytes hold any password).
+     * @param password_size Size of the password buffer.
      * @return ESP_OK on success.
      */
-    esp_err_t get_credentials(std::string &ssid, std::string &password);
+    esp_err_t get_credentials(char *ssid, size_t ssid_size, char *password, size_t password_size);
+
+    /**
+     * @brief std::string variant of get_credentials(); the component itself never instantiates it.
+     */
+    esp_err_t get_credentials(std::string &ssid, std::string &password)
+    {
+        return storage.load_credentials(ssid, password);
+    }
 
     /**
      * @brief Clear WiFi credentials from the driver and reset validity flag.
@@ -203,6 +749,7 @@ public:
 
     using MessageType = wifi_manager::MessageType;
     using Message     = wifi_manager::Message;
+    using LogId       = wifi_manager::LogId;
 
 private:
     // Private constructor for singleton
@@ -213,25 +760,224 @@ private:
     // Internal helper to initialize NVS flash partition
     esp_err_t init_nvs();
 
+    // Claims the UNINITIALIZED -> INITIALIZING transition for init()/init_async()
+    esp_err_t begin_init();
+
+    // Storage, netif, event loop, driver and handler bring-up (timed per step)
+    esp_err_t bring_up();
+
+    // Background bring-up executed by wifi_task after init_async()
+    void run_async_init();
+
     // Helper to persist validity flag (DEPRECATED: used via storage)
     esp_err_t save_valid_flag(bool valid);
 
     // Main FreeRTOS task loop that executes driver operations
     static void wifi_task(void *pvParameters);
 
+#if CONFIG_WIFI_MANAGER_DEFERRED_LOG
+    // Low-priority task that formats the records of log_ring
+    static void log_task(void *pvParameters);
+
+    // Creates log_task unless it is running; deinit() stops it
+    esp_err_t start_log_task();
+#endif
+
+    // wifi_task message: a log_ring record with CONFIG_WIFI_MANAGER_DEFERRED_LOG, a line
+    // otherwise. Compiled out above CONFIG_WIFI_MANAGER_LOG_LEVEL.
+    template <LogId ID> void log_event(int32_t a0 = 0, int32_t a1 = 0, int32_t a2 = 0);
+
+    // Compacts and dispatches a batch of messages; returns false when EXIT was reached
+    // (dequeue_us: when batch[0] left the queue; the others are stamped when their turn comes)
+    bool dispatch_batch(Message *batch, size_t count, uint32_t dequeue_us);
+
+#if CONFIG_WIFI_MANAGER_SYNC_API
+    // Executes the transaction slot; commands received meanwhile are moved to deferred[]
+    void execute_transaction(Message *deferred, size_t &deferred_count);
+
+    // Processes events until a transaction step settles or the deadline passes
+    esp_err_t await_step(CommandId cmd, int64_t deadline_us, Message *deferred, size_t &deferred_count);
+
+    // ESP_OK once cmd has reached its target state, STEP_IN_PROGRESS while in progress, ESP_FAIL otherwise
+    esp_err_t step_status(CommandId cmd) const;
+#endif
+
+    // Applies the enterprise profile, then enters CONNECTING and issues esp_wifi_connect(), stamping the
+    // association latency. On error the caller rolls the state back or schedules the next backoff.
+    esp_err_t begin_association();
+
+    // Saves the credentials, or the enterprise profile when eap is set, and applies them to
+    // the driver (caller holds state_mutex)
+    esp_err_t apply_credentials(const char *ssid, const char *password, bool hidden,
+                                const wifi_manager::EnterpriseProfile *eap = nullptr);
+
+    // Hands the stored EAP profile to the supplicant, unless it holds it and may resume
+    esp_err_t apply_enterprise();
+
+    // The stored network changed: the supplicant drops the previous profile and its sessions
+    void forget_enterprise();
+
+    // Registered certificate called name, nullptr if none
+    const wifi_manager::Certificate *find_certificate(const char *name) const;
+
+    // Points the connect scan of a hidden network at its cached channel (caller holds state_mutex)
+    void apply_scan_hint();
+
+    // Requests the configured TWT agreement unless the association already has an answer
+    void request_twt();
+
+    // Hands the controller's limit to the driver while the STA runs
+    void apply_tx_power();
+
+    // Reads the roam scan and moves to the best candidate, if any (state: when the scan ended)
+    void start_roam(State state, uint32_t now_us);
+
+    // The roam reached its candidate: records the link gap
+    void finish_roam(uint32_t now_us);
+
+    // Starts the roam from current to the target selected by start_roam()
+    void execute_roam(const uint8_t (&current)[6], const wifi_manager::RoamCandidate &target, uint32_t now_us);
+
+    // The roam failed: regular reconnect to any AP of the network
+    void fall_back_from_roam();
+
+    // Ends the roam in progress; a fast transition yet to report leaving the old AP still owes
+    // that STA_DISCONNECTED, counted as an echo of the disconnect that ends it
+    void abort_roam(bool failed);
+
+    // Records the move and tells the channel listener (pending: before a roam to it)
+    void notify_channel(uint8_t channel, bool pending);
+
+    // Slot of a registered netif, by handle or by lwIP index; NONE if not registered
+    int8_t find_uplink(esp_netif_t *netif) const;
+    int8_t find_uplink_by_index(uint8_t lwip_index);
+
+    // Refreshes the STA readiness and moves the default route if the selection changed
+    // (event_us: post time of the message being handled)
+    void arbitrate_uplinks(uint32_t event_us);
+
     // Private helper to post messages to the internal queue
     esp_err_t post_message(const Message &msg, bool is_async);
 
+    // Waits for any of done_bits; returns CANCEL_BIT (never set in the event group) if the token fired
+    uint32_t wait_for_result(uint32_t done_bits, uint32_t timeout_ms, const CancellationToken *token);
+
+#if CONFIG_WIFI_MANAGER_SYNC_API
+    // Asks wifi_task to abort the attempt started by cmd
+    esp_err_t post_cancel(CommandId cmd);
+#endif
+
     // --- Sub-components ---
     WiFiConfigStorage storage;
     WiFiStateMachine state_machine;
     WiFiDriverHAL driver_hal;
     wifi_manager::WiFiSyncManager sync_manager;
+    wifi_manager::WiFiTimerScheduler timers; ///< Deadlines the task loop sleeps against
 
     // --- Private Members ---
     TaskHandle_t task_handle;              ///< Task handling internal state
+    SemaphoreHandle_t task_exit_sem;       ///< Given by wifi_task right before it deletes itself
     mutable SemaphoreHandle_t state_mutex; ///< Recursive mutex for thread-safe state access
 
+    // --- Initialization bookkeeping ---
+    InitTiming init_timing;         ///< Per-step timing of the last initialization
+    bool async_init_pending;        ///< wifi_task still has to run the bring-up
+    bool async_init_failed;         ///< Background bring-up failed, waiting for cleanup
+    esp_err_t async_init_error;     ///< Error reported by the failed bring-up step
+    bool auto_start_pending;        ///< Chain a START once the bring-up completes
+    bool auto_connect_pending;      ///< Chain a CONNECT once the driver is started
+
+    wifi_manager::DispatchMetrics metrics; ///< Queue dwell, dispatch and handler timings
+
+    // --- Phase watchdogs ---
+    uint32_t connect_timeout_ms; ///< CONNECTING deadline (0 = disabled)
+    uint32_t dhcp_timeout_ms;    ///< CONNECTED_NO_IP deadline (0 = disabled)
+    uint8_t disconnect_echoes;   ///< STA_DISCONNECTED events still owed for our own watchdog aborts and rollbacks
+
+    // --- Connect scan ---
+    wifi_manager::ChannelPlan channel_plan; ///< Applied at bring-up when channel_plan_set
+    bool channel_plan_set;                  ///< A plan came from Kconfig or set_channel_plan()
+    uint32_t connect_issued_us;             ///< esp_wifi_connect() time of the attempt in progress
+    uint8_t probe_channel;                  ///< Channel the hidden-SSID probe of the attempt starts on (0 = none)
+    bool probe_missed;                      ///< The hidden AP was not on its cached channel, scan them all
+
+    // --- Power and wake schedule ---
+    wifi_manager::TwtConfig twt_config;           ///< Individual TWT requested after GOT_IP (interval 0 = off)
+    wifi_manager::WiFiTxPowerController tx_power; ///< Closed-loop TX power limit fed by the RSSI samples
+    bool tx_power_control;                        ///< RSSI samples drive tx_power
+    int8_t last_rssi;                             ///< Latest RSSI sample (0 = none yet)
+
+    // --- Roaming ---
+    wifi_manager::WiFiRoamPolicy roam_policy; ///< Trigger, candidate, FT or reconnect, learnt mobility domain
+    bool roam_scan_pending;                   ///< The scan in progress is ours: SCAN_DONE starts the roam
+
+    // --- Channel sharing (ESP-NOW) ---
+    uint8_t channel_lock;                           ///< Channel roams and connect scans stay on (0 = none)
+    uint8_t sta_channel;                            ///< Channel of the current association (0 = none)
+    uint8_t notified_channel;                       ///< Channel of the latest notification (0 = none)
+    bool notified_pending;                          ///< The latest notification announced a roam
+    wifi_manager::ChannelListener channel_listener; ///< Told about channel changes (nullptr = none)
+    void *channel_listener_arg;                     ///< Passed back to channel_listener
+    bool roam_notice_pending;                       ///< Peers were told; CHANNEL_NOTICE starts the roam
+    wifi_manager::RoamCandidate roam_notice_target; ///< AP of the announced roam
+
+    // --- Uplink arbitration ---
+    wifi_manager::WiFiUplinkArbiter uplinks;                                 ///< Picks the default route
+    esp_netif_t *uplink_netifs[wifi_manager::WiFiUplinkArbiter::UPLINK_MAX]; ///< Netif of each slot
+    int8_t wifi_uplink;                                                      ///< Slot of the STA (NONE: no uplinks)
+
+    // --- Enterprise authentication ---
+    static constexpr size_t CERT_SLOTS = 4;             ///< Certificates register_certificate() keeps
+    wifi_manager::Certificate certificates[CERT_SLOTS]; ///< Registered by the application (empty name = free)
+    wifi_manager::EapStatus eap_status;                 ///< Handshakes of the stored enterprise network
+    bool eap_configured;                                ///< The supplicant holds the stored profile
+    bool eap_session_cached;                            ///< A handshake succeeded since: the next may resume
+
+    // --- Reset-persistent retry state ---
+    wifi_manager::WiFiRetryGuard retry_guard; ///< Backoff, boot counter and attempt budget in RTC memory
+    bool boot_recorded;                       ///< The current boot has been counted by retry_guard
+    uint32_t boot_backoff_retries;            ///< Backoff applied to the first connect of this boot
+
+#if CONFIG_WIFI_MANAGER_DEFERRED_LOG
+    // --- Deferred logging ---
+    wifi_manager::LogRecord log_storage[CONFIG_WIFI_MANAGER_LOG_RING_SIZE];
+    wifi_manager::WiFiLogRing log_ring; ///< Written by wifi_task, drained by log_task
+    TaskHandle_t log_task_handle;
+    std::atomic<bool> log_task_exit; ///< Set by deinit(): log_task drains the ring and deletes itself
+#endif
+
+#if CONFIG_WIFI_MANAGER_SYNC_API
+    // --- Transaction slot (one transaction at a time) ---
+    Transaction txn_slot;      ///< Copy of the submitted transaction, results written by wifi_task
+    int64_t txn_deadline_us;   ///< Absolute deadline (esp_timer time base)
+    bool txn_busy;             ///< Slot owned by a submitted transaction
+    bool txn_done;             ///< wifi_task has filled all results
+    bool txn_abandoned;        ///< Caller timed out; wifi_task releases the slot when done
+    bool txn_cancelled;        ///< Caller's token fired; abort the step in progress
+    uint32_t txn_generation;   ///< Incremented per submission, guards against stale callers
+#endif
+
+#if CONFIG_WIFI_MANAGER_SYNC_API
+    // step_status() of a step still running; never stored in results[] nor returned to a caller
+    static constexpr esp_err_t STEP_IN_PROGRESS = -2;
+#endif
+    // Upper bound for deinit() to wait on the driver stop
+    static constexpr uint32_t DEINIT_STOP_TIMEOUT_MS = 2000;
+    // Upper bound for deinit() to wait on the task exit notification
+    static constexpr uint32_t TASK_EXIT_TIMEOUT_MS = 1000;
+    // Upper bound for deinit() to wait on a background bring-up in progress
+    static constexpr uint32_t ASYNC_INIT_TIMEOUT_MS = 5000;
+    // Longest formatted log_event() line
+    static constexpr size_t LOG_LINE_MAX = 128;
+#if CONFIG_WIFI_MANAGER_DEFERRED_LOG
+    // log_task wakes at least this often, for records written while it was draining
+    static constexpr uint32_t LOG_DRAIN_PERIOD_MS = 200;
+#endif
+#if CONFIG_WIFI_MANAGER_SYNC_API
+    // Extra time run_transaction() waits past the deadline for wifi_task to report
+    static constexpr uint32_t TRANSACTION_GRACE_MS = 500;
+#endif
+
     /**
      * @brief Resolves the next state and sync bits for a given event.
      * @param event The system event received.
@@ -245,9 +991,29 @@ private:
     void handle_connect(const Message &msg, State state);
     void handle_disconnect(const Message &msg, State state);
 
+    void handle_cancel(const Message &msg, State state);
+
     // Event Handler (LUT-based)
     void handle_event(const Message &msg, State state);
 
+    // Drops a command compacted away by a later STOP and wakes its sync caller
+    void supersede(const Message &msg);
+
+    // Expired deadline handler (runs in wifi_task under state_mutex)
+    void handle_timer(wifi_manager::TimerId id);
+
+    // Aligns the RECONNECT timer with the state machine backoff and (re)arms the phase watchdogs
+    void sync_timers();
+
+    // Counts the boot once per reset and resumes the persisted reconnect schedule (wifi_task only)
+    void restore_retry_state();
+
+    // Fires every timer whose deadline has passed
+    void run_expired_timers();
+
+    // Records dwell, dispatch and execution time of a processed message
+    void record_dispatch(const Message &msg, uint32_t dequeue_us, uint32_t dispatch_us, uint32_t done_us);
+
     /**
      * @brief Central dispatcher for all incoming messages.
      * @param msg The message (command or event) to process.
@@ -0,0 +1,66 @@
+#pragma once
+
+/**
+ * @file wifi_os.hpp
+ * @brief OS abstraction for the portable core (WiFiStateMachine, WiFiTimerScheduler, WiFiRetryGuard, WiFiLogRing).
+ *
+ * Inside ESP-IDF this only pulls in the real headers. Anywhere else (the plain CMake build of
+ * `wifi_manager_core`) it supplies the handful of names the core uses: `esp_err_t`, the tick
+ * and event-bit types, `esp_timer_get_time()` on a monotonic clock, and the driver reason codes
+ * the disconnect classifier tests. Only the core may rely on the native half; everything that
+ * talks to the driver, NVS or FreeRTOS objects stays IDF-only.
+ */
+
+#ifdef ESP_PLATFORM
+
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_wifi_types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+
+#else
+
+#include <chrono>
+#include <cstdint>
+
+typedef int esp_err_t;
+#define ESP_OK   0
+#define ESP_FAIL -1
+
+typedef uint32_t TickType_t;
+typedef uint32_t EventBits_t;
+#define configTICK_RATE_HZ 1000
+#define portMAX_DELAY      ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000U))
+
+/**
+ * @brief Microseconds on a monotonic clock (esp_timer time base stand-in).
+ */
+inline int64_t esp_timer_get_time(void)
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief The subset of wifi_err_reason_t (esp_wifi_types.h) the core reads, same values.
+ */
+typedef enum
+{
+    WIFI_REASON_ASSOC_LEAVE            = 8,
+    WIFI_REASON_DISASSOC_PWRCAP_BAD    = 10,
+    WIFI_REASON_DISASSOC_SUPCHAN_BAD   = 11,
+    WIFI_REASON_IE_INVALID             = 13,
+    WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT = 15,
+    WIFI_REASON_802_1X_AUTH_FAILED     = 23,
+    WIFI_REASON_BEACON_TIMEOUT         = 200,
+    WIFI_REASON_NO_AP_FOUND            = 201,
+    WIFI_REASON_AUTH_FAIL              = 202,
+    WIFI_REASON_ASSOC_FAIL             = 203,
+    WIFI_REASON_HANDSHAKE_TIMEOUT      = 204,
+    WIFI_REASON_CONNECTION_FAIL        = 205,
+} wifi_err_reason_t;
+
+#endif
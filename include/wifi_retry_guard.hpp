@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+
+namespace wifi_manager {
+
+/**
+ * @class WiFiRetryGuard
+ * @brief Reconnection bookkeeping that survives resets.
+ *
+ * Holds the backoff exponent, the number of boots since the last stable connection and
+ * an hourly budget of automatic connection attempts. The record lives in RTC memory that
+ * the bootloader leaves untouched on software, panic and watchdog resets, so a device that
+ * reboots in a loop keeps backing off instead of hammering the AP on every boot. Writes
+ * are plain RAM stores plus a checksum; a power-on leaves garbage that fails the check
+ * and starts from a clean record.
+ *
+ * Not thread-safe: only wifi_task (holding the state mutex) may touch it.
+ */
+class WiFiRetryGuard
+{
+public:
+    struct Record
+    {
+        uint32_t magic;
+        uint32_t boot_count;        ///< Boots since the last stable connection
+        uint32_t retry_count;       ///< Backoff exponent of the reconnect schedule
+        uint32_t window_attempts;   ///< Automatic attempts in the current budget window
+        uint32_t window_elapsed_ms; ///< Age of the budget window at the last attempt
+        uint32_t checksum;
+    };
+
+    static constexpr uint32_t BUDGET_WINDOW_MS = 3600000UL; // 1 hour
+
+    /**
+     * @param record Backing store, normally rtc_record().
+     */
+    explicit WiFiRetryGuard(Record &record);
+
+    /**
+     * @brief Validate the record and count this boot. Call once per reset.
+     *
+     * The budget window resumes from its age at the last recorded attempt, so the time
+     * spent rebooting is never credited back.
+     *
+     * @param now_us Current time.
+     */
+    void begin_boot(int64_t now_us);
+
+    /**
+     * @brief Whether the device keeps rebooting without reaching a stable connection.
+     * @param threshold Boots tolerated before backing off (0 disables the detection).
+     */
+    bool is_crash_loop(uint32_t threshold) const;
+
+    uint32_t get_boot_count() const
+    {
+        return m_record.boot_count;
+    }
+    uint32_t get_retry_count() const
+    {
+        return m_record.retry_count;
+    }
+    uint32_t get_window_attempts() const
+    {
+        return m_record.window_attempts;
+    }
+
+    /**
+     * @brief Persist the backoff exponent. Does nothing if it did not change.
+     */
+    void save_retry_count(uint32_t retry_count);
+
+    /**
+     * @brief The link has been up long enough: the boot loop (if any) is over.
+     */
+    void mark_stable();
+
+    /**
+     * @brief Take one automatic attempt from the hourly budget.
+     * @param now_us Current time.
+     * @param budget Attempts allowed per window (0 = unlimited).
+     * @return 0 if the attempt is allowed (and counted), otherwise the time in ms
+     *         until the window reopens.
+     */
+    uint32_t acquire_attempt(int64_t now_us, uint32_t budget);
+
+    /**
+     * @brief The RTC_NOINIT record shared by every WiFiManager instance.
+     */
+    static Record &rtc_record();
+
+private:
+    static constexpr uint32_t MAGIC = 0x57524731; // "WRG1"
+
+    Record &m_record;
+    int64_t m_window_start_us;
+
+    bool is_intact() const;
+    void reset();
+    void seal();
+    uint32_t compute_checksum() const;
+};
+
+} // namespace wifi_manager
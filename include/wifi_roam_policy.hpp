@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "wifi_types.hpp"
+
+namespace wifi_manager {
+
+/**
+ * @class WiFiRoamPolicy
+ * @brief When to roam, to which AP, and how: 802.11r Fast BSS Transition or a reconnect.
+ *
+ * Below trigger_rssi the manager scans the SSID at most every scan_interval_ms. The
+ * strongest other AP at least hysteresis_db above the current one is the candidate. APs
+ * on the current channel count channel_bias_db stronger, so a roam keeps the channel of
+ * ESP-NOW peers when it can; a channel lock excludes the APs of other channels.
+ *
+ * With FT enabled the STA reassociates in place: the driver runs the FT exchange when
+ * the target shares the mobility domain, so the 4-way handshake (and the 802.1X one of
+ * an enterprise network) is skipped and the IP stays. A transition that completes
+ * within FT_GAP_MAX_US proves FT support, and both APs join the known mobility domain.
+ * A failed or slow one means the APs do not share a domain: later roams fall back to a
+ * regular reconnect, except towards APs already known to be in the domain.
+ *
+ * Times are esp_timer microseconds truncated to 32 bits, like Message::timestamp_us.
+ *
+ * Not thread-safe: only wifi_task (holding the state mutex) may touch it.
+ */
+class WiFiRoamPolicy
+{
+public:
+    enum class Mode : uint8_t
+    {
+        NONE,            ///< No roam in progress
+        FAST_TRANSITION, ///< Reassociation in place with ft_enabled
+        RECONNECT,       ///< Disconnect, then a regular association (new DHCP lease)
+    };
+
+    static constexpr uint8_t DOMAIN_MAX     = 8;     ///< APs remembered in the mobility domain
+    static constexpr uint32_t FT_GAP_MAX_US = 50000; ///< Slower transitions ran a full authentication
+
+    explicit WiFiRoamPolicy(const RoamConfig &config);
+
+    /**
+     * @brief New configuration: the learnt support and the domain start over. A roam in
+     *        progress still completes.
+     */
+    void set_config(const RoamConfig &config);
+
+    /**
+     * @brief Forget the mobility domain, the FT support and the counters (a roam in
+     *        progress is ended by abort()).
+     */
+    void reset();
+
+    /**
+     * @brief Restricts select() to the APs of a channel (0: any channel). Kept by reset().
+     */
+    void set_channel_lock(uint8_t channel)
+    {
+        m_channel_lock = channel;
+    }
+
+    uint8_t get_channel_lock() const
+    {
+        return m_channel_lock;
+    }
+
+    /**
+     * @brief Whether an RSSI sample should start a roam scan; counts the scan.
+     * @param rssi Sampled RSSI of the current AP in dBm.
+     * @param now_us Sample time.
+     */
+    bool should_scan(int8_t rssi, uint32_t now_us);
+
+    /**
+     * @brief Strongest AP other than the current one, at least hysteresis_db stronger. APs
+     *        on current_channel get channel_bias_db; with a channel lock only its APs qualify.
+     * @param current BSSID of the current AP.
+     * @param current_rssi Its latest RSSI sample.
+     * @param current_channel Its primary channel (0: unknown, no bias).
+     * @param candidates Scan results of the SSID.
+     * @param count Number of candidates.
+     * @param[out] target The selected AP.
+     * @return false if no AP is worth the roam.
+     */
+    bool select(const uint8_t (&current)[6], int8_t current_rssi, uint8_t current_channel,
+                const RoamCandidate *candidates, size_t count, RoamCandidate &target) const;
+
+    /**
+     * @brief Starts a roam from current to target.
+     * @return How to reach the target: FAST_TRANSITION if FT is enabled and not known to fail
+     *         (or target is in the known domain), RECONNECT otherwise.
+     */
+    Mode begin(const uint8_t (&current)[6], const RoamCandidate &target, uint32_t now_us);
+
+    /**
+     * @brief The driver left the old AP during a fast transition.
+     * @return true if the disconnect belongs to the transition (the first one), false if
+     *         the link was really lost.
+     */
+    bool absorb_link_loss(uint32_t now_us);
+
+    /**
+     * @brief The STA reached target (STA_CONNECTED of a transition, GOT_IP of a reconnect).
+     * @return The link gap in microseconds.
+     */
+    uint32_t finish(uint32_t now_us);
+
+    /**
+     * @brief The roam failed or was superseded by a disconnect or a stop. A failed fast
+     *        transition marks FT unavailable.
+     * @param failed Count it as a failure (false for a user disconnect or stop).
+     */
+    void abort(bool failed);
+
+    bool in_progress() const
+    {
+        return m_mode != Mode::NONE;
+    }
+
+    Mode get_mode() const
+    {
+        return m_mode;
+    }
+
+    bool is_fast_transition() const
+    {
+        return m_mode == Mode::FAST_TRANSITION;
+    }
+
+    const RoamCandidate &get_target() const
+    {
+        return m_target;
+    }
+
+    bool link_lost() const
+    {
+        return m_link_lost;
+    }
+
+    FtState get_ft_state() const
+    {
+        return m_ft;
+    }
+
+    bool in_domain(const uint8_t (&bssid)[6]) const;
+
+    const RoamConfig &get_config() const
+    {
+        return m_config;
+    }
+
+    const RoamStatus &get_status() const
+    {
+        return m_status;
+    }
+
+private:
+    void learn_domain(const uint8_t (&bssid)[6]);
+
+    RoamConfig m_config;
+    FtState m_ft;
+    Mode m_mode;                     ///< Roam in progress
+    RoamCandidate m_target;          ///< AP of the roam in progress
+    uint8_t m_origin[6];             ///< AP the roam in progress leaves
+    uint32_t m_start_us;             ///< Start of the gap: roam start, then the absorbed disconnect
+    bool m_link_lost;                ///< The fast transition in progress left the old AP
+    bool m_scanned;                  ///< m_last_scan_us holds a scan
+    uint32_t m_last_scan_us;         ///< Start of the latest roam scan
+    uint8_t m_domain[DOMAIN_MAX][6]; ///< APs known to share the mobility domain
+    uint8_t m_domain_next;           ///< Slot the next member replaces once the domain is full
+    uint8_t m_channel_lock;          ///< Only APs of this channel qualify (0: any)
+    RoamStatus m_status;
+};
+
+} // namespace wifi_manager
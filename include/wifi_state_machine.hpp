@@ -1,10 +1,9 @@
 #pragma once
 
-#include "esp_err.h"
+#include <cstddef>
 #include <cstdint>
-#include "freertos/FreeRTOS.h"
-#include "freertos/event_groups.h"
 
+#include "wifi_os.hpp"
 #include "wifi_types.hpp"
 
 /**
@@ -14,9 +13,13 @@
 class WiFiStateMachine
 {
 public:
-    using State     = wifi_manager::State;
-    using CommandId = wifi_manager::CommandId;
-    using EventId   = wifi_manager::EventId;
+    using State       = wifi_manager::State;
+    using CommandId   = wifi_manager::CommandId;
+    using EventId     = wifi_manager::EventId;
+    using AddressKind = wifi_manager::AddressKind;
+    using IpReadiness = wifi_manager::IpReadiness;
+    using PhyConfig   = wifi_manager::PhyConfig;
+    using TwtState    = wifi_manager::TwtState;
 
     enum class Action : uint8_t
     {
@@ -31,6 +34,17 @@ public:
         EventBits_t bits_to_set;
     };
 
+    /**
+     * @brief How a STA_DISCONNECTED event is handled, once the matrix transition is applied.
+     */
+    enum class DisconnectClass : uint8_t
+    {
+        EXPECTED,    ///< Requested by us, or the driver is inactive: only wake the waiters
+        LEFT,        ///< ASSOC_LEAVE: the session ended cleanly, settle in DISCONNECTED
+        SUSPECT,     ///< Wrong password or bad signal, judged by handle_suspect_failure()
+        RECOVERABLE, ///< Link loss: reconnect with backoff if the credentials ever worked
+    };
+
     struct StateProps
     {
         bool is_active;
@@ -50,6 +64,192 @@ public:
      */
     EventOutcome resolve_event(EventId event) const;
 
+    /**
+     * @brief Answers a queued command that is no longer EXECUTE when wifi_task dispatches it.
+     *
+     * The API validates a command when it posts it; a message processed in between may have
+     * moved the state. The command is then dropped and its caller answered as if it had
+     * validated now: INVALID_STATE_BIT for ERROR, the success bit for SKIP. If the same
+     * operation is already in flight (e.g. CONNECT while CONNECTING), its outcome answers
+     * the caller instead.
+     *
+     * @return Bits to set (0 if the operation in flight will set them).
+     */
+    EventBits_t resolve_stale_command(CommandId cmd) const;
+
+    /**
+     * @brief Classifies a STA_DISCONNECTED event.
+     * @param state The state the event found (before the matrix transition).
+     * @param next_state The state resolve_event() moved to.
+     * @param reason The driver reason code (wifi_err_reason_t).
+     */
+    static DisconnectClass classify_disconnect(State state, State next_state, uint8_t reason);
+
+    /**
+     * @brief Finds the queued commands made obsolete by a later command of the same batch.
+     *
+     * A STOP supersedes every START, CONNECT and DISCONNECT queued before it: none of
+     * them would survive the stop, so executing their blocking driver calls only delays
+     * the shutdown. A CANCEL likewise drops the queued commands it targets. Events
+     * are never superseded.
+     *
+     * @param batch Messages in queue order.
+     * @param count Number of messages (at most 32).
+     * @return Bitmask of the batch indexes to drop.
+     */
+    static uint32_t find_superseded(const wifi_manager::Message *batch, size_t count);
+
+    /**
+     * @brief Classifies an IPv6 address.
+     * @param addr The 16 address bytes in network order.
+     * @return IPV6_LINK_LOCAL for fe80::/10, IPV6_GLOBAL otherwise.
+     */
+    static AddressKind classify_ip6(const uint8_t addr[16]);
+
+    /**
+     * @brief Records an address assigned to the current association.
+     *
+     * GOT_IP only enters the transition matrix once this returns true, so
+     * CONNECTED_GOT_IP (and CONNECTED_BIT) wait for the configured readiness.
+     *
+     * @return true if the addresses recorded so far meet the readiness policy.
+     */
+    bool record_address(AddressKind kind);
+
+    /**
+     * @brief Drops an address the current association lost (LOST_IP).
+     *
+     * LOST_IP only enters the transition matrix once this returns false, so the
+     * connection stays up while the remaining addresses meet the readiness policy.
+     *
+     * @return true if the addresses left still meet the readiness policy.
+     */
+    bool forget_address(AddressKind kind);
+
+    /**
+     * @brief Forgets the addresses of the previous association.
+     */
+    void clear_addresses();
+
+    /**
+     * @brief Whether the addresses recorded so far meet the readiness policy.
+     */
+    bool is_ip_ready() const;
+
+    /**
+     * @brief Sets the addresses required to be connected (IPV4 by default).
+     */
+    void set_ip_readiness(IpReadiness readiness)
+    {
+        m_ip_readiness = readiness;
+    }
+    IpReadiness get_ip_readiness() const
+    {
+        return m_ip_readiness;
+    }
+
+    /**
+     * @brief Addresses recorded since the association, one bit per AddressKind.
+     */
+    uint8_t get_addresses() const
+    {
+        return m_addresses;
+    }
+
+    /**
+     * @brief Whether a disconnect reason points at a PHY mode the AP refuses
+     *        (capabilities, supported channels, invalid IE, association rejected).
+     */
+    static bool is_phy_failure(uint8_t reason);
+
+    /**
+     * @brief Counts a failed association blamed on the PHY mode.
+     *
+     * After `threshold` such failures in a row, effective_phy() steps down to a more
+     * robust mode, up to MAX_PHY_FALLBACK.
+     *
+     * @param threshold Failures per step, 0 disables the fallback.
+     * @return true if the fallback level changed.
+     */
+    bool record_phy_failure(uint32_t threshold);
+
+    /**
+     * @brief An association succeeded: the failure streak ends, the fallback level stays.
+     */
+    void clear_phy_failures()
+    {
+        m_phy_failures = 0;
+    }
+
+    /**
+     * @brief Back to the configured PHY mode (new network or new PHY configuration).
+     */
+    void reset_phy_fallback();
+
+    uint8_t get_phy_fallback() const
+    {
+        return m_phy_fallback;
+    }
+
+    /**
+     * @brief The configured PHY mode degraded to the current fallback level.
+     *
+     * Level 1 drops 802.11ax and HT40, level 2 also drops 802.11n. A default protocol
+     * set counts as 802.11b/g/n. Any fallback level keeps 802.11b/g: the result never
+     * has an empty protocol set.
+     */
+    PhyConfig effective_phy(const PhyConfig &configured) const;
+
+    /**
+     * @brief Whether a TWT setup should be requested now: no agreement and no
+     *        answer yet on the current association.
+     */
+    bool twt_needs_setup() const
+    {
+        return m_twt_state == TwtState::OFF;
+    }
+
+    /**
+     * @brief A setup request was sent (PENDING), or the driver refused it.
+     * @param sent false if the driver rejected the request.
+     * @param supported false if the target has no 802.11ax (UNSUPPORTED).
+     */
+    void record_twt_request(bool sent, bool supported);
+
+    /**
+     * @brief The AP answered the setup or tore the agreement down.
+     * @param result ACTIVE (accepted), REJECTED or OFF (teardown).
+     * @return false if the event was stale (no pending request or agreement).
+     */
+    bool record_twt_event(TwtState result);
+
+    /**
+     * @brief The association ended (disconnect, reconnect or roam): the agreement is gone.
+     *
+     * The next setup after a lost agreement counts as a renegotiation.
+     */
+    void twt_link_lost();
+
+    /**
+     * @brief New TWT configuration: state and counters start over.
+     */
+    void reset_twt();
+
+    TwtState get_twt_state() const
+    {
+        return m_twt_state;
+    }
+
+    uint16_t get_twt_setups() const
+    {
+        return m_twt_setups;
+    }
+
+    uint16_t get_twt_renegotiations() const
+    {
+        return m_twt_renegotiations;
+    }
+
     /**
      * @brief Performs the state transition.
      */
@@ -73,6 +273,18 @@ public:
      */
     void calculate_next_backoff(uint32_t &delay_ms_out);
 
+    /**
+     * @brief Resumes a backoff schedule persisted across a reset.
+     * @param retry_count Retries already performed; the next backoff continues from there.
+     */
+    void restore_retry_count(uint32_t retry_count);
+
+    /**
+     * @brief Enters WAITING_RECONNECT with an explicit delay, leaving the retry count unchanged.
+     * @param delay_ms Time until the next attempt.
+     */
+    void schedule_reconnect(uint32_t delay_ms);
+
     // Getters
     State get_current_state() const
     {
@@ -82,6 +294,10 @@ public:
     {
         return m_retry_count;
     }
+    uint32_t get_suspect_retry_count() const
+    {
+        return m_suspect_retry_count;
+    }
     uint64_t get_next_reconnect_ms() const
     {
         return m_next_reconnect_ms;
@@ -95,6 +311,7 @@ public:
     TickType_t get_wait_ticks() const;
     bool is_sta_ready() const;
     bool is_active() const;
+    bool is_connected() const;
 
     // RSSI thresholds (dBm):
     // GOOD   (-55):  Strong signal, likely credential issue
@@ -110,6 +327,9 @@ public:
     static constexpr uint32_t RETRY_LIMIT_MEDIUM = 2;
     static constexpr uint32_t RETRY_LIMIT_WEAK   = 5;
 
+    // Most robust PHY fallback level (802.11b/g, HT20)
+    static constexpr uint8_t MAX_PHY_FALLBACK = 2;
+
     // Backoff parameters
     static constexpr uint32_t MAX_BACKOFF_EXPONENT = 8;
     static constexpr uint32_t MAX_BACKOFF_MS       = 300000UL; // 5 minutes
@@ -119,6 +339,14 @@ private:
     uint32_t m_retry_count;
     uint32_t m_suspect_retry_count;
     uint64_t m_next_reconnect_ms;
+    IpReadiness m_ip_readiness;
+    uint8_t m_addresses;           ///< Bit (1 << AddressKind) per address of the current association
+    uint32_t m_phy_failures;       ///< PHY failures in a row at the current fallback level
+    uint8_t m_phy_fallback;        ///< 0 = configured PHY, up to MAX_PHY_FALLBACK
+    TwtState m_twt_state;
+    bool m_twt_lost;               ///< An agreement was lost since the last setup request
+    uint16_t m_twt_setups;         ///< Setup requests sent
+    uint16_t m_twt_renegotiations; ///< Setup requests that replaced a lost agreement
 
     static const StateProps s_state_props[(int)State::COUNT];
     static const Action s_command_matrix[(int)State::COUNT][(int)CommandId::COUNT];
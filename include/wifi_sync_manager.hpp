@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 #include "esp_err.h"
 #include "wifi_types.hpp"
 #include "freertos/FreeRTOS.h"
@@ -31,11 +33,22 @@ public:
 
     /**
      * @brief Post a message to the internal command queue.
+     *
+     * The queued copy is stamped with the enqueue time (Message::timestamp_us).
+     *
      * @param msg The message to post.
      * @return ESP_OK if successful.
      */
     esp_err_t post_message(const Message &msg);
 
+    /**
+     * @brief Move every message already waiting in the queue into a buffer, without blocking.
+     * @param out Destination buffer.
+     * @param max Capacity of the buffer.
+     * @return Number of messages copied, in queue order.
+     */
+    size_t drain(Message *out, size_t max);
+
     /**
      * @brief Clear specific synchronization bits.
      * @param bits_to_clear The bits to clear.
@@ -80,11 +93,11 @@ public:
         return m_event_group;
     }
 
+    static constexpr uint8_t QUEUE_SIZE = 10;
+
 private:
     QueueHandle_t m_command_queue;
     EventGroupHandle_t m_event_group;
-
-    static constexpr uint8_t QUEUE_SIZE = 10;
 };
 
 } // namespace wifi_manager
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+
+#include "wifi_os.hpp"
+#include "wifi_types.hpp"
+
+namespace wifi_manager {
+
+/**
+ * @class WiFiTimerScheduler
+ * @brief Deadline scheduler driven by the manager task's queue wait.
+ *
+ * Every TimerId has at most one pending deadline. Deadlines are kept in a binary
+ * min-heap stored in a fixed array (one slot per TimerId), with a reverse index so
+ * that re-arming and cancelling are O(log n). No RTOS object is involved: the task
+ * sleeps on its queue for get_wait_ticks() and then pops the expired timers.
+ *
+ * Not thread-safe: only wifi_task (holding the state mutex) may touch it.
+ */
+class WiFiTimerScheduler
+{
+public:
+    WiFiTimerScheduler();
+
+    /**
+     * @brief Arm a timer, replacing its previous deadline if it was already armed.
+     * @param id The timer.
+     * @param deadline_us Absolute deadline (esp_timer time base).
+     */
+    void arm(TimerId id, int64_t deadline_us);
+
+    /**
+     * @brief Cancel a timer. Does nothing if it is not armed.
+     */
+    void cancel(TimerId id);
+
+    /**
+     * @brief Cancel every timer.
+     */
+    void cancel_all();
+
+    bool is_armed(TimerId id) const;
+
+    /**
+     * @brief Deadline of an armed timer.
+     * @return The absolute deadline, or -1 if the timer is not armed.
+     */
+    int64_t get_deadline(TimerId id) const;
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    /**
+     * @brief Time to sleep until the earliest deadline.
+     * @param now_us Current time.
+     * @return portMAX_DELAY if no timer is armed, 0 if the earliest deadline has passed,
+     *         otherwise the whole ticks until it (rounded up, never short).
+     */
+    TickType_t get_wait_ticks(int64_t now_us) const;
+
+    /**
+     * @brief Remove the earliest timer if its deadline has passed.
+     * @param now_us Current time.
+     * @param id_out [out] The expired timer.
+     * @return true if a timer was removed.
+     */
+    bool pop_expired(int64_t now_us, TimerId &id_out);
+
+    /**
+     * @brief Remove the earliest timer regardless of the current time.
+     *
+     * @param id_out [out] The removed timer.
+     * @return false if no timer is armed.
+     */
+    bool pop_next(TimerId &id_out);
+
+private:
+    struct Entry
+    {
+        int64_t deadline_us;
+        TimerId id;
+    };
+
+    static constexpr uint8_t CAPACITY = (uint8_t)TimerId::COUNT;
+    static constexpr int8_t NOT_ARMED = -1;
+
+    Entry m_heap[CAPACITY];
+    int8_t m_index[CAPACITY]; ///< Heap position of each TimerId, NOT_ARMED when idle
+    uint8_t m_size;
+
+    bool before(uint8_t a, uint8_t b) const;
+    void swap_entries(uint8_t a, uint8_t b);
+    void sift_up(uint8_t pos);
+    void sift_down(uint8_t pos);
+    void remove_at(uint8_t pos);
+};
+
+} // namespace wifi_manager
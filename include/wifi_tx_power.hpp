@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+
+namespace wifi_manager {
+
+/**
+ * @class WiFiTxPowerController
+ * @brief Closed-loop limit of the STA transmit power.
+ *
+ * The link budget is reciprocal: the path loss the STA measures on the AP's beacons
+ * (RSSI at the AP's nominal power) is the loss its own frames see on the way back.
+ * Every RSSI sample gives the power that keeps the uplink at target_rssi plus a
+ * margin. The limit moves down one step after stable_samples samples in a row leave
+ * a full step of headroom, and rises at once to what the latest sample requires.
+ * A link failure (disconnect, failed reconnect) returns to full power.
+ *
+ * Powers are in the 0.25 dBm units of esp_wifi_set_max_tx_power().
+ *
+ * Not thread-safe: only wifi_task (holding the state mutex) may touch it.
+ */
+class WiFiTxPowerController
+{
+public:
+    struct Config
+    {
+        int8_t target_rssi;     ///< Weakest uplink RSSI wanted at the AP (dBm)
+        uint8_t margin_db;      ///< Fading margin kept above target_rssi
+        int8_t min_power;       ///< Lowest limit (0.25 dBm, at least 8)
+        int8_t max_power;       ///< Full power, also the AP power assumed by the estimate (0.25 dBm, at most 84)
+        uint8_t step;           ///< Decrease per step (0.25 dBm)
+        uint8_t stable_samples; ///< Samples in a row with a step of headroom before a decrease
+    };
+
+    static constexpr int8_t DRIVER_MIN_POWER = 8;  ///< 2 dBm
+    static constexpr int8_t DRIVER_MAX_POWER = 84; ///< 21 dBm
+
+    /**
+     * @brief Starts at full power.
+     */
+    explicit WiFiTxPowerController(const Config &config);
+
+    /**
+     * @brief A consistent configuration: driver limits, min below max, non-zero step.
+     */
+    static bool is_valid(const Config &config);
+
+    /**
+     * @brief Feed one RSSI sample of the associated AP.
+     * @param rssi Beacon RSSI in dBm.
+     * @return true if the power limit changed and must be applied.
+     */
+    bool on_rssi_sample(int8_t rssi);
+
+    /**
+     * @brief The link failed or a reconnect is needed: back to full power.
+     * @return true if the power limit changed and must be applied.
+     */
+    bool on_link_failure();
+
+    /**
+     * @brief Power the latest sample requires (what the limit converges to).
+     * @param rssi Beacon RSSI in dBm.
+     */
+    int8_t required_power(int8_t rssi) const;
+
+    int8_t get_power() const
+    {
+        return m_power;
+    }
+
+    uint32_t get_decreases() const
+    {
+        return m_decreases;
+    }
+
+    uint32_t get_increases() const
+    {
+        return m_increases;
+    }
+
+    const Config &get_config() const
+    {
+        return m_config;
+    }
+
+private:
+    Config m_config;
+    int8_t m_power;       ///< Current limit
+    uint8_t m_stable;     ///< Samples in a row that left a full step of headroom
+    uint32_t m_decreases; ///< Steps down since construction
+    uint32_t m_increases; ///< Raises since construction
+};
+
+} // namespace wifi_manager
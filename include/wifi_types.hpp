@@ -1,6 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+
+#include "wifi_os.hpp"
 
 /**
  * @file wifi_types.hpp
@@ -43,10 +48,343 @@ enum class EventId : uint8_t
 {
     STA_START,
     STA_STOP,
-    STA_CONNECTED,
+    STA_CONNECTED, ///< Associated; Message::reason holds the primary channel
     STA_DISCONNECTED,
-    GOT_IP,
+    GOT_IP,        ///< An address was assigned; Message::reason holds its AddressKind
     LOST_IP,
+    TIMEOUT,       ///< Synthetic: the watchdog of the current phase expired (never posted by the driver)
+    TWT,           ///< Individual TWT setup answered or torn down; Message::reason holds the new TwtState
+    SCAN_DONE,     ///< A scan finished (the roam scan, or one the application started)
+    UPLINK_UP,     ///< Another netif got its IPv4 address; Message::reason holds its lwIP index (0: an
+                   ///< add_uplink() or set_uplink_health() call)
+    UPLINK_DOWN,   ///< Another netif lost its IPv4 address; Message::reason as for UPLINK_UP
+    COUNT
+};
+
+/**
+ * @brief Kind of address reported by a GOT_IP event.
+ */
+enum class AddressKind : uint8_t
+{
+    IPV4,            ///< DHCPv4 lease (IP_EVENT_STA_GOT_IP)
+    IPV6_LINK_LOCAL, ///< fe80::/10 (IP_EVENT_GOT_IP6)
+    IPV6_GLOBAL,     ///< Any routable IPv6 address, unique-local included (IP_EVENT_GOT_IP6)
+    COUNT
+};
+
+/**
+ * @brief Addresses required before the link counts as connected (CONNECTED_GOT_IP).
+ */
+enum class IpReadiness : uint8_t
+{
+    IPV4,            ///< A DHCPv4 lease
+    IPV6_LINK_LOCAL, ///< An IPv6 link-local address
+    IPV6_GLOBAL,     ///< A routable IPv6 address (SLAAC or DHCPv6)
+    ANY,             ///< A DHCPv4 lease or a routable IPv6 address, whichever comes first
+    COUNT
+};
+
+/**
+ * @brief Regulatory domain and scan timing of the connect scan.
+ *
+ * The country and channel range are applied with esp_wifi_set_country() (manual
+ * policy: the APs' country IE cannot widen them), the dwell times with
+ * esp_wifi_set_scan_parameters() and the method with wifi_config_t.sta.scan_method.
+ * Zero dwell times keep the driver defaults.
+ */
+struct ChannelPlan
+{
+    static constexpr uint8_t MAX_CHANNEL = 14; ///< Last 2.4 GHz channel
+
+    char country[3];        ///< ISO 3166-1 alpha-2 code, "01" for the world-safe mode
+    uint8_t first_channel;  ///< First channel scanned (1-14)
+    uint8_t channel_count;  ///< Channels scanned from first_channel on
+    bool fast_scan;         ///< Connect to the first matching AP instead of the strongest one
+    uint16_t active_min_ms; ///< Minimum dwell per channel of an active scan
+    uint16_t active_max_ms; ///< Maximum dwell per channel of an active scan
+    uint16_t passive_ms;    ///< Dwell per channel where probing is not allowed
+
+    bool is_valid() const
+    {
+        return country[0] != '\0' && country[1] != '\0' && country[2] == '\0' && first_channel >= 1 &&
+               channel_count >= 1 && first_channel + channel_count - 1 <= MAX_CHANNEL &&
+               (active_max_ms == 0 || active_min_ms <= active_max_ms);
+    }
+};
+
+/**
+ * @brief Channel width used on 2.4 GHz.
+ */
+enum class Bandwidth : uint8_t
+{
+    DEFAULT, ///< Keep the driver default
+    HT20,
+    HT40,
+};
+
+/**
+ * @brief PHY modes of the STA, applied with esp_wifi_set_protocol() / esp_wifi_set_bandwidth()
+ *        before each association.
+ */
+struct PhyConfig
+{
+    static constexpr uint8_t PROTOCOL_11B  = 1 << 0;
+    static constexpr uint8_t PROTOCOL_11G  = 1 << 1;
+    static constexpr uint8_t PROTOCOL_11N  = 1 << 2;
+    static constexpr uint8_t PROTOCOL_11AX = 1 << 3; ///< Wi-Fi 6 targets only
+    static constexpr uint8_t PROTOCOL_ALL  = PROTOCOL_11B | PROTOCOL_11G | PROTOCOL_11N | PROTOCOL_11AX;
+
+    uint8_t protocols;   ///< PROTOCOL_* bitmask, 0 for the driver default
+    Bandwidth bandwidth; ///< HT40 requires 802.11n
+
+    /**
+     * @brief A combination the driver accepts: 11b or 11g, 11n on top of 11g, 11ax on top of 11n.
+     */
+    bool is_valid() const
+    {
+        if ((int)bandwidth > (int)Bandwidth::HT40 || (protocols & ~PROTOCOL_ALL) != 0) {
+            return false;
+        }
+        if (protocols == 0) {
+            return true;
+        }
+        return (protocols & (PROTOCOL_11B | PROTOCOL_11G)) != 0 &&
+               (!(protocols & PROTOCOL_11N) || (protocols & PROTOCOL_11G)) &&
+               (!(protocols & PROTOCOL_11AX) || (protocols & PROTOCOL_11N)) &&
+               (bandwidth != Bandwidth::HT40 || (protocols & PROTOCOL_11N));
+    }
+
+    bool operator==(const PhyConfig &other) const
+    {
+        return protocols == other.protocols && bandwidth == other.bandwidth;
+    }
+};
+
+/**
+ * @brief Individual Target Wake Time (802.11ax) requested after each association.
+ *
+ * The STA sleeps between service periods of wake_duration_us, one every
+ * wake_interval_us. On air the interval is a 16-bit mantissa and a 5-bit
+ * exponent, and the duration a count of 256 us or 1024 us (TU) units: encode()
+ * gives the values actually negotiated.
+ */
+struct TwtConfig
+{
+    static constexpr uint32_t MAX_DURATION_US = 255 * 1024; ///< 255 TU
+
+    uint32_t wake_interval_us; ///< Period of the service periods, 0 disables TWT
+    uint32_t wake_duration_us; ///< Minimum awake time of a service period
+
+    struct Encoding
+    {
+        uint16_t mantissa;   ///< wake_invl_mant
+        uint8_t exponent;    ///< wake_invl_expn
+        uint8_t duration;    ///< min_wake_dura
+        bool duration_in_tu; ///< wake_duration_unit: 1024 us instead of 256 us
+
+        uint32_t interval_us() const
+        {
+            return (uint32_t)mantissa << exponent;
+        }
+
+        uint32_t duration_us() const
+        {
+            return (uint32_t)duration * (duration_in_tu ? 1024 : 256);
+        }
+    };
+
+    bool is_enabled() const
+    {
+        return wake_interval_us != 0;
+    }
+
+    bool is_valid() const
+    {
+        return !is_enabled() || (wake_duration_us != 0 && wake_duration_us <= MAX_DURATION_US &&
+                                 encode().duration_us() < encode().interval_us());
+    }
+
+    /**
+     * @brief Nearest encodable agreement: the interval is truncated, the duration rounded up.
+     */
+    Encoding encode() const
+    {
+        Encoding enc = {};
+        uint32_t interval = wake_interval_us;
+        while (interval > UINT16_MAX) {
+            interval >>= 1;
+            enc.exponent++;
+        }
+        enc.mantissa       = (uint16_t)interval;
+        enc.duration_in_tu = wake_duration_us > 255 * 256;
+        uint32_t unit      = enc.duration_in_tu ? 1024 : 256;
+        enc.duration       = (uint8_t)std::min<uint32_t>((wake_duration_us + unit - 1) / unit, 255);
+        return enc;
+    }
+};
+
+/**
+ * @brief Individual TWT agreement of the current association.
+ */
+enum class TwtState : uint8_t
+{
+    OFF,         ///< No agreement; requested when the link next reaches CONNECTED_GOT_IP
+    PENDING,     ///< Setup request sent, waiting for the AP
+    ACTIVE,      ///< The AP accepted: the STA sleeps between service periods
+    REJECTED,    ///< The AP rejected or tore down the agreement; retried after the next association
+    UNSUPPORTED, ///< The target has no 802.11ax; not retried until the configuration changes
+};
+
+/**
+ * @brief TWT report of the manager.
+ */
+struct TwtStatus
+{
+    TwtState state;
+    uint32_t wake_interval_us; ///< Negotiated interval (ACTIVE), otherwise the encoded request
+    uint32_t wake_duration_us; ///< Negotiated service period (ACTIVE), otherwise the encoded request
+    uint32_t duty_cycle_ppm;   ///< Share of time awake in parts per million; 1000000 without agreement
+    uint16_t setups;           ///< Setup requests sent since the configuration was set
+    uint16_t renegotiations;   ///< Of which after an agreement was lost to a reconnect or roam
+};
+
+/**
+ * @brief TX power report of the manager (see WiFiTxPowerController).
+ */
+struct TxPowerStatus
+{
+    bool enabled;       ///< The controller runs while connected
+    int8_t power;       ///< Current limit in 0.25 dBm units
+    int8_t last_rssi;   ///< Latest RSSI sample in dBm, 0 before the first one
+    uint32_t decreases; ///< Steps down
+    uint32_t increases; ///< Raises after a weaker sample or a link failure
+};
+
+/**
+ * @brief EAP method of a WPA2/WPA3-Enterprise network.
+ */
+enum class EapMethod : uint8_t
+{
+    NONE = 0, ///< Personal network (PSK/SAE)
+    TLS,      ///< EAP-TLS: mutual certificate authentication
+    PEAP,     ///< PEAP/MSCHAPv2: username and password inside a TLS tunnel
+    TTLS,     ///< EAP-TTLS/MSCHAPv2
+};
+
+/**
+ * @brief Enterprise network profile, persisted with the network.
+ *
+ * Certificates are referenced by name and registered by the application
+ * (WiFiManager::register_certificate()), so no key material goes to NVS.
+ */
+struct EnterpriseProfile
+{
+    static constexpr size_t IDENTITY_MAX_LEN  = 63;
+    static constexpr size_t PASSWORD_MAX_LEN  = 63;
+    static constexpr size_t CERT_NAME_MAX_LEN = 15;
+
+    EapMethod method;
+    bool wpa3_192;                           ///< WPA3-Enterprise 192-bit mode (EAP-TLS only)
+    bool resumption;                         ///< Keep the TLS session and PMK cache across reconnects
+    char identity[IDENTITY_MAX_LEN + 1];     ///< Outer (possibly anonymous) identity
+    char username[IDENTITY_MAX_LEN + 1];     ///< Inner identity (PEAP, TTLS)
+    char password[PASSWORD_MAX_LEN + 1];     ///< Inner password (PEAP, TTLS)
+    char ca_cert[CERT_NAME_MAX_LEN + 1];     ///< Server CA; empty skips server validation
+    char client_cert[CERT_NAME_MAX_LEN + 1]; ///< Client certificate (TLS)
+    char client_key[CERT_NAME_MAX_LEN + 1];  ///< Client private key (TLS)
+
+    bool is_enterprise() const
+    {
+        return method != EapMethod::NONE;
+    }
+
+    /**
+     * @brief Terminated fields and the credentials the method needs.
+     */
+    bool is_valid() const
+    {
+        if (!is_set(identity) || !terminated(username) || !terminated(password) || !terminated(ca_cert) ||
+            !terminated(client_cert) || !terminated(client_key)) {
+            return false;
+        }
+        switch (method) {
+        case EapMethod::TLS:
+            return is_set(client_cert) && is_set(client_key);
+        case EapMethod::PEAP:
+        case EapMethod::TTLS:
+            return !wpa3_192 && is_set(username) && is_set(password);
+        default:
+            return false;
+        }
+    }
+
+private:
+    template <size_t N> static bool terminated(const char (&field)[N])
+    {
+        return memchr(field, '\0', N) != nullptr;
+    }
+
+    template <size_t N> static bool is_set(const char (&field)[N])
+    {
+        return terminated(field) && field[0] != '\0';
+    }
+};
+
+/**
+ * @brief Handshake report of an enterprise network.
+ *
+ * A handshake is the time from esp_wifi_connect() to STA_CONNECTED, which includes the
+ * connect scan. The driver does not report whether the server resumed the session, so the
+ * split is an estimate from timing: an association attempted with a cached session that
+ * took less than half the average full handshake counts as likely resumed; any other one
+ * counts as a full exchange and joins the average.
+ */
+struct EapStatus
+{
+    uint32_t full_handshakes;   ///< Associations timed as a full certificate exchange
+    uint32_t likely_resumed;    ///< Associations with a cached session timed as a resumption
+    uint32_t last_handshake_us; ///< Most recent handshake
+    uint32_t full_handshake_us; ///< Average full handshake (0 before the first one)
+    uint64_t full_total_us;     ///< Sum of the full handshakes
+    uint64_t est_saved_us;      ///< Estimate: sum over likely_resumed of their gain on the average
+
+    void record(uint32_t us, bool session_cached)
+    {
+        last_handshake_us = us;
+        if (session_cached && full_handshakes != 0 && us < full_handshake_us / 2) {
+            likely_resumed++;
+            est_saved_us += full_handshake_us - us;
+            return;
+        }
+        full_handshakes++;
+        full_total_us += us;
+        full_handshake_us = (uint32_t)(full_total_us / full_handshakes);
+    }
+};
+
+/**
+ * @brief PEM or DER data registered under a name by the application.
+ */
+struct Certificate
+{
+    char name[EnterpriseProfile::CERT_NAME_MAX_LEN + 1];
+    const uint8_t *data; ///< Owned by the application, must stay valid while registered
+    size_t len;          ///< Including the terminating NUL of PEM data
+};
+
+/**
+ * @brief Deadlines kept by the manager task (see WiFiTimerScheduler).
+ */
+enum class TimerId : uint8_t
+{
+    RECONNECT,        ///< End of the reconnect backoff
+    CONNECT_WATCHDOG, ///< Association must complete before this deadline
+    DHCP_TIMEOUT,     ///< An IP must be obtained before this deadline
+    RSSI_SAMPLE,      ///< Periodic signal sampling
+    LINK_STABLE,      ///< Connected long enough to clear the boot-loop counter
+    ROAM_DEADLINE,    ///< A fast transition must reassociate before this deadline
+    UPLINK_HOLD,      ///< A preferred uplink has been usable for the failback hold
+    CHANNEL_NOTICE,   ///< End of the lead time between a pre-change notification and its roam
     COUNT
 };
 
@@ -55,8 +393,11 @@ enum class EventId : uint8_t
  */
 enum class MessageType : uint8_t
 {
-    COMMAND, ///< Action requested by the user/API
-    EVENT,   ///< Signal reported by the system
+    COMMAND,     ///< Action requested by the user/API
+    EVENT,       ///< Signal reported by the system
+    TRANSACTION, ///< Scripted command sequence (see WiFiManager::Transaction)
+    CANCEL,      ///< Abort the attempt started by `cmd` (sent when a sync caller is cancelled)
+    COUNT
 };
 
 /**
@@ -70,10 +411,179 @@ struct Message
         CommandId cmd;
         EventId event;
     };
-    uint8_t reason; ///< Reason code (for STA_DISCONNECTED)
-    int8_t rssi;    ///< RSSI level (for STA_DISCONNECTED)
+    union Payload
+    {
+        struct
+        {
+            uint8_t reason; ///< wifi_err_reason_t
+            int8_t rssi;    ///< RSSI level when the link was lost
+        } disconnected;      ///< STA_DISCONNECTED
+        uint8_t channel;     ///< STA_CONNECTED: primary channel of the new AP
+        AddressKind address; ///< GOT_IP, LOST_IP: which address came or went
+        TwtState twt;        ///< TWT: outcome reported by the driver
+        uint8_t netif_index; ///< UPLINK_UP, UPLINK_DOWN: lwIP netif index (0 = posted by the manager)
+    } payload;               ///< Event arguments, selected by `event`; zeroed for commands
+    uint32_t timestamp_us;   ///< Post time (esp_timer, truncated to 32 bits; wraps every ~71 min)
+};
+
+static constexpr uint8_t LATENCY_BUCKETS = 20; ///< Histogram buckets of LatencyStats
+
+/**
+ * @brief Running latency statistics, in microseconds.
+ *
+ * The histogram uses power-of-two buckets: bucket 0 counts samples below 1 us,
+ * bucket i counts samples in [2^(i-1), 2^i) us, and the last bucket collects
+ * everything from 2^(LATENCY_BUCKETS - 2) us upwards (about 262 ms).
+ */
+struct LatencyStats
+{
+    uint32_t count;                      ///< Number of samples recorded
+    uint32_t last_us;                    ///< Most recent sample
+    uint32_t min_us;                     ///< Smallest sample (0 when count == 0)
+    uint32_t max_us;                     ///< Largest sample
+    uint64_t total_us;                   ///< Sum of all samples (average = total_us / count)
+    uint32_t histogram[LATENCY_BUCKETS]; ///< Power-of-two buckets, see above
+
+    static uint8_t bucket_for(uint32_t us)
+    {
+        uint8_t bucket = 0;
+        while (us != 0 && bucket < LATENCY_BUCKETS - 1) {
+            us >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    void record(uint32_t us)
+    {
+        if (count == 0 || us < min_us) {
+            min_us = us;
+        }
+        if (us > max_us) {
+            max_us = us;
+        }
+        last_us = us;
+        total_us += us;
+        histogram[bucket_for(us)]++;
+        count++;
+    }
+};
+
+/**
+ * @brief Roaming between the APs of the network (see WiFiRoamPolicy).
+ */
+struct RoamConfig
+{
+    int8_t trigger_rssi;       ///< Scan for a better AP below this RSSI (dBm); 0 disables roaming
+    uint8_t hysteresis_db;     ///< A candidate must be this much stronger than the current AP
+    bool ft;                   ///< 802.11r: enable ft_enabled and reassociate in place
+    uint32_t scan_interval_ms; ///< Minimum time between two roam scans
+    uint8_t channel_bias_db;   ///< Bonus of candidates on the current channel (ESP-NOW peers stay reachable)
+
+    bool is_enabled() const
+    {
+        return trigger_rssi != 0;
+    }
+
+    bool is_valid() const
+    {
+        return trigger_rssi <= 0 && trigger_rssi >= -100 && hysteresis_db <= 40 && channel_bias_db <= 40;
+    }
 };
 
+/**
+ * @brief 802.11r Fast BSS Transition support of the stored network.
+ *
+ * ESP-IDF does not report the Mobility Domain element of scanned APs: support is
+ * learnt from the roams themselves.
+ */
+enum class FtState : uint8_t
+{
+    DISABLED,    ///< RoamConfig::ft is off: every roam reconnects
+    UNKNOWN,     ///< No fast transition attempted yet on this network
+    AVAILABLE,   ///< A fast transition completed within WiFiRoamPolicy::FT_GAP_MAX_US
+    UNAVAILABLE, ///< A fast transition failed or ran a full authentication: roams reconnect
+};
+
+/**
+ * @brief AP of the network found by the roam scan.
+ */
+struct RoamCandidate
+{
+    uint8_t bssid[6];
+    int8_t rssi;
+    uint8_t channel;
+};
+
+/**
+ * @brief Roaming report of the manager.
+ *
+ * The gap of a fast transition runs from leaving the old AP (or from the
+ * reassociation request) to STA_CONNECTED on the new one; the gap of a reconnect
+ * runs from the disconnect to GOT_IP.
+ */
+struct RoamStatus
+{
+    FtState ft;                 ///< Fast transition support learnt so far
+    uint8_t domain_size;        ///< APs known to share the mobility domain
+    uint32_t scans;             ///< Roam scans started below the trigger RSSI
+    uint32_t fast_transitions;  ///< Roams completed by a fast transition
+    uint32_t reconnects;        ///< Roams completed by a regular reconnect
+    uint32_t failures;          ///< Roams that did not reach the candidate
+    LatencyStats ft_gap;        ///< Link gaps of the fast transitions
+    LatencyStats reconnect_gap; ///< Link gaps of the reconnects
+};
+
+/**
+ * @brief Primary channel change of the STA, for protocols that share it (ESP-NOW peers).
+ */
+struct ChannelChange
+{
+    uint8_t from; ///< Channel announced by the previous notification (0: none yet)
+    uint8_t to;   ///< New primary channel
+    bool pending; ///< true: a roam moves there next; false: the STA is now associated on it
+};
+
+/**
+ * @brief Receives ChannelChange notifications on wifi_task, with the state mutex held. It
+ *        must return quickly and must not wait for the manager (no blocking API calls).
+ */
+typedef void (*ChannelListener)(const ChannelChange &change, void *arg);
+
+/**
+ * @brief Default route arbitration between the Wi-Fi STA and other netifs (Ethernet, PPP).
+ *
+ * Slots are numbered in registration order; the Wi-Fi STA takes the first one.
+ */
+struct UplinkStatus
+{
+    int8_t active;                 ///< Slot carrying the default route (-1 = no usable uplink)
+    uint8_t count;                 ///< Registered uplinks
+    uint32_t failovers;            ///< Switches away from an uplink that stopped being usable
+    uint32_t failbacks;            ///< Switches to a preferred uplink once it held for the hold time
+    uint32_t outages;              ///< Times the last usable uplink was lost
+    LatencyStats failover_latency; ///< From the event that made the active uplink unusable to the switch
+};
+
+/**
+ * @brief Queue and dispatch instrumentation of the manager task.
+ */
+struct DispatchMetrics
+{
+    LatencyStats dwell[(int)MessageType::COUNT];      ///< Post -> dequeue (time spent in the queue)
+    LatencyStats dispatch[(int)MessageType::COUNT];   ///< Post -> handler start (adds the state mutex wait)
+    LatencyStats command_exec[(int)CommandId::COUNT]; ///< Handler execution time per command
+    LatencyStats event_exec;                          ///< Handler execution time of events
+    LatencyStats association;                         ///< esp_wifi_connect() -> STA_CONNECTED (scan, auth, association)
+    uint32_t superseded[(int)CommandId::COUNT];       ///< Commands dropped by queue compaction
+};
+
+// Component error codes, above every ESP-IDF range: no driver or IDF error reads as one of them.
+// WiFiManager::err_to_name() names them.
+static constexpr esp_err_t ERR_BASE       = 0x20000;
+static constexpr esp_err_t ERR_SUPERSEDED = ERR_BASE + 1; ///< Command dropped by a later STOP
+static constexpr esp_err_t ERR_CANCELLED  = ERR_BASE + 2; ///< Sync call cancelled by its token
+
 // FreeRTOS Event Group bits for synchronization between the API and the task
 static constexpr uint32_t STARTED_BIT        = (1 << 0); ///< WiFi driver started
 static constexpr uint32_t STOPPED_BIT        = (1 << 1); ///< WiFi driver stopped
@@ -83,8 +593,30 @@ static constexpr uint32_t CONNECT_FAILED_BIT = (1 << 4); ///< Connection attempt
 static constexpr uint32_t START_FAILED_BIT   = (1 << 5); ///< Driver start failed
 static constexpr uint32_t STOP_FAILED_BIT    = (1 << 6); ///< Driver stop failed
 static constexpr uint32_t INVALID_STATE_BIT  = (1 << 7); ///< Invalid state
+static constexpr uint32_t INIT_DONE_BIT      = (1 << 8); ///< Background init completed
+static constexpr uint32_t INIT_FAILED_BIT    = (1 << 9); ///< Background init failed
+
+// One "superseded" bit per command that can be compacted away (see WiFiStateMachine::find_superseded)
+static constexpr uint32_t START_SUPERSEDED_BIT      = (1 << 10); ///< Pending START dropped
+static constexpr uint32_t CONNECT_SUPERSEDED_BIT    = (1 << 11); ///< Pending CONNECT dropped
+static constexpr uint32_t DISCONNECT_SUPERSEDED_BIT = (1 << 12); ///< Pending DISCONNECT dropped
+static constexpr uint32_t TRANSACTION_DONE_BIT      = (1 << 13); ///< Transaction finished (all steps reported)
+static constexpr uint32_t CANCEL_BIT                = (1 << 14); ///< Token fired (wait result only, never set)
 
 static constexpr uint32_t ALL_SYNC_BITS = STARTED_BIT | STOPPED_BIT | CONNECTED_BIT | DISCONNECTED_BIT |
-                                          CONNECT_FAILED_BIT | START_FAILED_BIT | STOP_FAILED_BIT | INVALID_STATE_BIT;
+                                          CONNECT_FAILED_BIT | START_FAILED_BIT | STOP_FAILED_BIT | INVALID_STATE_BIT |
+                                          INIT_DONE_BIT | INIT_FAILED_BIT | START_SUPERSEDED_BIT |
+                                          CONNECT_SUPERSEDED_BIT | DISCONNECT_SUPERSEDED_BIT | TRANSACTION_DONE_BIT;
+
+/**
+ * @brief Superseded bit reported for a compacted command (0 for commands that are never dropped).
+ */
+constexpr uint32_t superseded_bit_for(CommandId cmd)
+{
+    return cmd == CommandId::START        ? START_SUPERSEDED_BIT
+           : cmd == CommandId::CONNECT    ? CONNECT_SUPERSEDED_BIT
+           : cmd == CommandId::DISCONNECT ? DISCONNECT_SUPERSEDED_BIT
+                                          : 0;
+}
 
 } // namespace wifi_manager
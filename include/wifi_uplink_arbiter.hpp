@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+
+#include "wifi_types.hpp"
+
+namespace wifi_manager {
+
+/**
+ * @class WiFiUplinkArbiter
+ * @brief Picks the uplink that carries the default route among the Wi-Fi STA and other netifs.
+ *
+ * An uplink is usable while it is ready (it holds an address) and healthy (the application's
+ * probes, if any, still get through). The usable uplink of highest priority wins; equal
+ * priorities keep the registration order.
+ *
+ * Leaving an unusable uplink is immediate: the switch happens while the event that ended it is
+ * handled, so the failover time is bounded by the dispatch of that event. Moving back to a
+ * preferred uplink waits until it has stayed usable for the hold time, so a flapping link
+ * does not drag the route along.
+ *
+ * Times are esp_timer microseconds truncated to 32 bits, like Message::timestamp_us.
+ *
+ * Not thread-safe: only wifi_task (holding the state mutex) may touch it.
+ */
+class WiFiUplinkArbiter
+{
+public:
+    static constexpr uint8_t UPLINK_MAX = 4; ///< Wi-Fi STA and up to three other netifs
+    static constexpr int8_t NONE        = -1;
+
+    /**
+     * @param hold_ms Time a preferred uplink must stay usable before the route moves back.
+     */
+    explicit WiFiUplinkArbiter(uint32_t hold_ms);
+
+    /**
+     * @brief Registers an uplink, not ready and healthy.
+     * @return Its slot, or NONE when all UPLINK_MAX slots are taken.
+     */
+    int8_t add(uint8_t priority);
+
+    /**
+     * @brief Forget every uplink; no route is selected.
+     */
+    void clear();
+
+    void set_priority(int8_t slot, uint8_t priority);
+
+    uint8_t get_priority(int8_t slot) const
+    {
+        return m_uplinks[slot].priority;
+    }
+
+    /**
+     * @brief The uplink got (true) or lost (false) its address.
+     */
+    void set_ready(int8_t slot, bool ready, uint32_t now_us);
+
+    /**
+     * @brief Reachability reported by the application (e.g. a ping through the uplink).
+     */
+    void set_healthy(int8_t slot, bool healthy, uint32_t now_us);
+
+    bool is_usable(int8_t slot) const
+    {
+        return m_uplinks[slot].ready && m_uplinks[slot].healthy;
+    }
+
+    /**
+     * @brief Selects the uplink for the default route.
+     * @param now_us Current time.
+     * @param event_us Post time of the event being handled: a failover records its latency from it.
+     * @return true if the selection changed (get_active() may be NONE).
+     */
+    bool arbitrate(uint32_t now_us, uint32_t event_us);
+
+    /**
+     * @brief A preferred uplink waits for the end of its hold.
+     * @param[out] remaining_us Time left until arbitrate() moves the route to it.
+     */
+    bool failback_pending(uint32_t now_us, uint32_t &remaining_us) const;
+
+    int8_t get_active() const
+    {
+        return m_status.active;
+    }
+
+    const UplinkStatus &get_status() const
+    {
+        return m_status;
+    }
+
+private:
+    struct Uplink
+    {
+        uint8_t priority;
+        bool ready;
+        bool healthy;
+        uint32_t usable_since_us; ///< Last time it became usable
+    };
+
+    // Usable uplink of highest priority, NONE if none
+    int8_t best() const;
+
+    // Starts the hold when the uplink just became usable
+    void update(int8_t slot, bool was_usable, uint32_t now_us);
+
+    uint32_t m_hold_us;
+    Uplink m_uplinks[UPLINK_MAX];
+    UplinkStatus m_status;
+};
+
+} // namespace wifi_manager
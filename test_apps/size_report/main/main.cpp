@@ -0,0 +1,40 @@
+/**
+ * @file main.cpp
+ * @brief Reference application measured by size_report.py.
+ *
+ * Uses the component the way a product does (bring-up, provisioning, connect, state polling),
+ * so the linker keeps what such a product pays for in each profile. Nothing is meant to run.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "wifi_manager.hpp"
+
+extern "C" void app_main(void)
+{
+    WiFiManager &wm = WiFiManager::get_instance();
+
+    if (wm.init_async(true, false) != ESP_OK || wm.wait_for_init(5000) != ESP_OK) {
+        return;
+    }
+    wm.set_credentials("size-report", "size-report");
+
+#if CONFIG_WIFI_MANAGER_SYNC_API
+    WiFiManager::Transaction txn = {};
+    txn.add(WiFiManager::Transaction::Step::START);
+    txn.add(WiFiManager::Transaction::Step::CONNECT);
+    wm.run_transaction(txn, 30000);
+    wm.connect(15000);
+#else
+    wm.connect();
+#endif
+
+    while (wm.get_state() != WiFiManager::State::CONNECTED_GOT_IP) {
+        vTaskDelay(pdMS_TO_TICKS(500));
+    }
+
+    wm.disconnect();
+    wm.stop();
+    wm.deinit();
+}
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""Flash and RAM cost of the wifi_manager component per build profile.
+
+Builds the reference application once per profiles/<name>.defaults (layered on
+sdkconfig.defaults), reads `idf.py size-components` and keeps the contribution of
+libwifi_manager.a split into .text, .rodata, .data and .bss.
+
+Results are printed as a table and written to build/size_report.jsonl, one
+"{"profile": ..., "target": ..., "text": ..., ...}" line per profile.
+
+Usage (ESP-IDF environment loaded):
+    python size_report.py [--target esp32c2] [--profile minimal ...]
+"""
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+APP_DIR = os.path.dirname(os.path.abspath(__file__))
+PROFILE_DIR = os.path.join(APP_DIR, "profiles")
+ARCHIVE = "libwifi_manager.a"
+CLASSES = ("text", "rodata", "data", "bss")
+
+
+def section_class(name):
+    """Maps a section or memory-type name (".flash.rodata", "dram_bss", "iram", ...) to CLASSES."""
+    name = name.lower()
+    if "bss" in name:
+        return "bss"
+    if "rodata" in name:
+        return "rodata"
+    if "data" in name:
+        return "data"
+    if "text" in name or "iram" in name or "vectors" in name:
+        return "text"
+    return None
+
+
+def find_archive(node):
+    """Returns the size record of the component archive, wherever the JSON layout nests it."""
+    if isinstance(node, dict):
+        for key, value in node.items():
+            if key.endswith(ARCHIVE) and isinstance(value, dict):
+                return value
+            found = find_archive(value)
+            if found is not None:
+                return found
+    elif isinstance(node, list):
+        for item in node:
+            found = find_archive(item)
+            if found is not None:
+                return found
+    return None
+
+
+def accumulate(node, totals):
+    """Sums section sizes (json2: ".section": {"size": n}) or memory types (json: "flash_text": n)."""
+    for key, value in node.items():
+        if key.startswith(".") and isinstance(value, dict) and isinstance(value.get("size"), int):
+            cls = section_class(key)
+            if cls:
+                totals[cls] += value["size"]
+        elif isinstance(value, dict):
+            accumulate(value, totals)
+        elif isinstance(value, int) and key not in ("size", "total"):
+            cls = section_class(key)
+            if cls:
+                totals[cls] += value
+
+
+def build_profile(profile, target):
+    build_dir = os.path.join(APP_DIR, "build", profile)
+    defaults = ";".join([os.path.join(APP_DIR, "sdkconfig.defaults"), os.path.join(PROFILE_DIR, profile + ".defaults")])
+    idf = ["idf.py", "-B", build_dir, "-D", "IDF_TARGET=" + target, "-D", "SDKCONFIG=" + os.path.join(build_dir, "sdkconfig"),
+           "-D", "SDKCONFIG_DEFAULTS=" + defaults]
+
+    print(f"Building profile {profile} for {target}...")
+    subprocess.run(idf + ["build"], cwd=APP_DIR, check=True, stdout=subprocess.DEVNULL)
+
+    size_file = os.path.join(build_dir, "size_components.json")
+    subprocess.run(idf + ["size-components", "--format", "json2", "--output-file", size_file], cwd=APP_DIR, check=True,
+                   stdout=subprocess.DEVNULL)
+    with open(size_file) as f:
+        archive = find_archive(json.load(f))
+    if archive is None:
+        sys.exit(f"{ARCHIVE} not found in {size_file}")
+
+    totals = dict.fromkeys(CLASSES, 0)
+    accumulate(archive, totals)
+    return totals
+
+
+def main():
+    profiles = sorted(name[:-len(".defaults")] for name in os.listdir(PROFILE_DIR) if name.endswith(".defaults"))
+
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--target", default="esp32c2")
+    parser.add_argument("--profile", action="append", choices=profiles, help="Profile to measure (default: all)")
+    args = parser.parse_args()
+
+    results = []
+    for profile in args.profile or profiles:
+        totals = build_profile(profile, args.target)
+        results.append(dict(profile=profile, target=args.target, **totals,
+                            flash=totals["text"] + totals["rodata"] + totals["data"],
+                            ram=totals["data"] + totals["bss"]))
+
+    os.makedirs(os.path.join(APP_DIR, "build"), exist_ok=True)
+    with open(os.path.join(APP_DIR, "build", "size_report.jsonl"), "w") as f:
+        f.write("".join(json.dumps(r) + "\n" for r in results))
+
+    print(f"\n{ARCHIVE} on {args.target} (bytes)")
+    print(f"{'profile':<14}{'.text':>8}{'.rodata':>9}{'.data':>7}{'.bss':>7}{'flash':>8}{'ram':>7}")
+    for r in results:
+        print(f"{r['profile']:<14}{r['text']:>8}{r['rodata']:>9}{r['data']:>7}{r['bss']:>7}{r['flash']:>8}{r['ram']:>7}")
+
+
+if __name__ == "__main__":
+    main()
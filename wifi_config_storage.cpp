@@ -1,8 +1,10 @@
+#include "sdkconfig.h"
+#define LOG_LOCAL_LEVEL CONFIG_WIFI_MANAGER_LOG_LEVEL
+
 #include "wifi_config_storage.hpp"
 #include "esp_log.h"
 #include "nvs.h"
 #include "nvs_flash.h"
-#include "sdkconfig.h"
 #include "wifi_driver_hal.hpp"
 #include <cstring>
 
@@ -12,6 +14,10 @@ WiFiConfigStorage::WiFiConfigStorage(WiFiDriverHAL &hal, const char *nvs_namespa
     : m_hal(hal)
     , m_nvs_namespace(nvs_namespace)
     , m_is_valid(false)
+    , m_hidden(false)
+    , m_channel(0)
+    , m_phy()
+    , m_eap()
 {
 }
 
@@ -30,17 +36,18 @@ esp_err_t WiFiConfigStorage::init()
         return err;
     }
 
-    return load_valid_flag();
+    return load_flags();
 }
 
-esp_err_t WiFiConfigStorage::save_credentials(const std::string &ssid, const std::string &password)
+esp_err_t WiFiConfigStorage::save_credentials(const char *ssid, const char *password, bool hidden)
 {
-    wifi_config_t wifi_config = {};
-    size_t ssid_len           = ssid.length() > 32 ? 32 : ssid.length();
-    memcpy(wifi_config.sta.ssid, ssid.c_str(), ssid_len);
+    if (ssid == nullptr || password == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    size_t pass_len = password.length() > 64 ? 64 : password.length();
-    memcpy(wifi_config.sta.password, password.c_str(), pass_len);
+    wifi_config_t wifi_config = {};
+    memcpy(wifi_config.sta.ssid, ssid, strnlen(ssid, SSID_MAX_LEN));
+    memcpy(wifi_config.sta.password, password, strnlen(password, PASSWORD_MAX_LEN));
 
     wifi_config.sta.scan_method        = WIFI_ALL_CHANNEL_SCAN;
     wifi_config.sta.failure_retry_cnt  = 0;
@@ -49,24 +56,64 @@ esp_err_t WiFiConfigStorage::save_credentials(const std::string &ssid, const std
     wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
 
     esp_err_t err = m_hal.set_config(&wifi_config);
+    if (err == ESP_OK) {
+        err = save_network(hidden);
+    }
     if (err == ESP_OK) {
         return save_valid_flag(true);
     }
     return err;
 }
 
-esp_err_t WiFiConfigStorage::load_credentials(std::string &ssid, std::string &password)
+esp_err_t WiFiConfigStorage::save_enterprise_credentials(const char *ssid, const wifi_manager::EnterpriseProfile &profile,
+                                                         bool hidden)
 {
+    if (!profile.is_valid()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The supplicant holds the EAP credentials; the driver only gets the SSID
+    wifi_config_t wifi_config = {};
+    memcpy(wifi_config.sta.ssid, ssid, strnlen(ssid, SSID_MAX_LEN));
+
+    wifi_config.sta.scan_method        = WIFI_ALL_CHANNEL_SCAN;
+    wifi_config.sta.failure_retry_cnt  = 0;
+    wifi_config.sta.pmf_cfg.capable    = true;
+    wifi_config.sta.pmf_cfg.required   = profile.wpa3_192;
+    wifi_config.sta.threshold.authmode = profile.wpa3_192 ? WIFI_AUTH_WPA3_ENT_192 : WIFI_AUTH_WPA2_ENTERPRISE;
+
+    esp_err_t err = m_hal.set_config(&wifi_config);
+    if (err == ESP_OK) {
+        err = save_network(hidden, profile);
+    }
+    if (err == ESP_OK) {
+        return save_valid_flag(true);
+    }
+    return err;
+}
+
+// Copies a driver field that is not NUL-terminated when full
+static void copy_field(char *dst, size_t dst_size, const uint8_t *src, size_t src_len)
+{
+    size_t len = strnlen((const char *)src, src_len);
+    if (len >= dst_size) {
+        len = dst_size - 1;
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+esp_err_t WiFiConfigStorage::load_credentials(char *ssid, size_t ssid_size, char *password, size_t password_size)
+{
+    if (ssid_size == 0 || password_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
     wifi_config_t conf;
     esp_err_t err = m_hal.get_config(&conf);
     if (err == ESP_OK) {
-        char ssid_buf[33] = {0};
-        memcpy(ssid_buf, conf.sta.ssid, 32);
-        ssid = ssid_buf;
-
-        char pass_buf[65] = {0};
-        memcpy(pass_buf, conf.sta.password, 64);
-        password = pass_buf;
+        copy_field(ssid, ssid_size, conf.sta.ssid, SSID_MAX_LEN);
+        copy_field(password, password_size, conf.sta.password, PASSWORD_MAX_LEN);
     }
     return err;
 }
@@ -82,6 +129,9 @@ esp_err_t WiFiConfigStorage::clear_credentials()
     saved_config.sta.password[0] = 0;
 
     err = m_hal.set_config(&saved_config);
+    if (err == ESP_OK) {
+        err = save_network(false);
+    }
     if (err == ESP_OK) {
         return save_valid_flag(false);
     }
@@ -100,6 +150,10 @@ esp_err_t WiFiConfigStorage::factory_reset()
     }
 
     m_is_valid = false;
+    m_hidden   = false;
+    m_channel  = 0;
+    m_phy      = {};
+    m_eap      = {};
     return ESP_OK;
 }
 
@@ -129,14 +183,132 @@ esp_err_t WiFiConfigStorage::save_valid_flag(bool valid)
     return err;
 }
 
-esp_err_t WiFiConfigStorage::load_valid_flag()
+esp_err_t WiFiConfigStorage::save_channel(uint8_t channel)
+{
+    if (channel == m_channel) {
+        return ESP_OK;
+    }
+
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(m_nvs_namespace, NVS_READWRITE, &h);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_set_u8(h, "channel", channel);
+    if (err == ESP_OK) {
+        err = nvs_commit(h);
+    }
+    nvs_close(h);
+
+    if (err == ESP_OK) {
+        m_channel = channel;
+    }
+    return err;
+}
+
+esp_err_t WiFiConfigStorage::save_phy(const wifi_manager::PhyConfig &phy)
+{
+    if (phy == m_phy) {
+        return ESP_OK;
+    }
+
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(m_nvs_namespace, NVS_READWRITE, &h);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_set_u8(h, "phy", phy.protocols);
+    if (err == ESP_OK) {
+        err = nvs_set_u8(h, "bw", (uint8_t)phy.bandwidth);
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(h);
+    }
+    nvs_close(h);
+
+    if (err == ESP_OK) {
+        m_phy = phy;
+    }
+    return err;
+}
+
+esp_err_t WiFiConfigStorage::save_network(bool hidden, const wifi_manager::EnterpriseProfile &eap)
+{
+    const wifi_manager::PhyConfig default_phy = {};
+    if (hidden == m_hidden && m_channel == 0 && m_phy == default_phy && !eap.is_enterprise() &&
+        !m_eap.is_enterprise()) {
+        return ESP_OK;
+    }
+
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(m_nvs_namespace, NVS_READWRITE, &h);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_set_u8(h, "hidden", hidden ? 1 : 0);
+    if (err == ESP_OK) {
+        err = nvs_set_u8(h, "channel", 0);
+    }
+    if (err == ESP_OK) {
+        err = nvs_set_u8(h, "phy", 0);
+    }
+    if (err == ESP_OK) {
+        err = nvs_set_u8(h, "bw", 0);
+    }
+    if (err == ESP_OK && eap.is_enterprise()) {
+        err = nvs_set_blob(h, "eap", &eap, sizeof(eap));
+    }
+    else if (err == ESP_OK) {
+        err = nvs_erase_key(h, "eap");
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            err = ESP_OK;
+        }
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(h);
+    }
+    nvs_close(h);
+
+    if (err == ESP_OK) {
+        m_hidden  = hidden;
+        m_channel = 0;
+        m_phy     = default_phy;
+        m_eap     = eap;
+    }
+    return err;
+}
+
+esp_err_t WiFiConfigStorage::load_flags()
 {
     nvs_handle_t h;
     esp_err_t err = nvs_open(m_nvs_namespace, NVS_READONLY, &h);
     if (err == ESP_OK) {
-        uint8_t valid = 0;
-        if (nvs_get_u8(h, "valid", &valid) == ESP_OK) {
-            m_is_valid = (valid != 0);
+        uint8_t value = 0;
+        if (nvs_get_u8(h, "valid", &value) == ESP_OK) {
+            m_is_valid = (value != 0);
+        }
+        if (nvs_get_u8(h, "hidden", &value) == ESP_OK) {
+            m_hidden = (value != 0);
+        }
+        if (nvs_get_u8(h, "channel", &value) == ESP_OK) {
+            m_channel = value;
+        }
+        if (nvs_get_u8(h, "phy", &value) == ESP_OK) {
+            m_phy.protocols = value;
+        }
+        if (nvs_get_u8(h, "bw", &value) == ESP_OK) {
+            m_phy.bandwidth = (wifi_manager::Bandwidth)value;
+        }
+        if (!m_phy.is_valid()) {
+            m_phy = {};
+        }
+        // A profile written by another layout of the struct is dropped, not misread
+        size_t eap_len = sizeof(m_eap);
+        if (nvs_get_blob(h, "eap", &m_eap, &eap_len) != ESP_OK || eap_len != sizeof(m_eap) || !m_eap.is_valid()) {
+            m_eap = {};
         }
         nvs_close(h);
     }
@@ -156,6 +328,7 @@ esp_err_t WiFiConfigStorage::ensure_config_fallback()
     }
 
     if (strlen((char *)current_conf.sta.ssid) == 0) {
+#if CONFIG_WIFI_MANAGER_KCONFIG_CREDENTIALS
         if (strlen(CONFIG_WIFI_SSID) > 0) {
             ESP_LOGI(TAG, "No SSID in driver, using Kconfig default: %s", CONFIG_WIFI_SSID);
             wifi_config_t wifi_config = {};
@@ -177,10 +350,18 @@ esp_err_t WiFiConfigStorage::ensure_config_fallback()
 
             err = m_hal.set_config(&wifi_config);
             if (err == ESP_OK) {
+#if CONFIG_WIFI_SSID_HIDDEN
+                err = save_network(true);
+#else
+                err = save_network(false);
+#endif
+            }
+            if (err == ESP_OK) {
                 return save_valid_flag(true);
             }
             return err;
         }
+#endif
     }
     else {
         // If driver has SSID but flag wasn't set, respect driver
@@ -1,5 +1,21 @@
+#include "sdkconfig.h"
+#define LOG_LOCAL_LEVEL CONFIG_WIFI_MANAGER_LOG_LEVEL
+
 #include "wifi_driver_hal.hpp"
+#include "esp_idf_version.h"
 #include "esp_log.h"
+#include <algorithm>
+#include <cstring>
+
+#if CONFIG_WIFI_MANAGER_TWT && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+#include "esp_wifi_he.h"
+#define WIFI_MANAGER_HAS_TWT 1
+#endif
+
+#if CONFIG_WIFI_MANAGER_ENTERPRISE && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+#include "esp_eap_client.h"
+#define WIFI_MANAGER_HAS_ENTERPRISE 1
+#endif
 
 static const char *TAG = "WiFiDriverHAL";
 
@@ -8,12 +24,23 @@ WiFiDriverHAL::WiFiDriverHAL()
     , m_wifi_event_instance(nullptr)
     , m_ip_event_instance(nullptr)
     , m_wifi_init_done(false)
+    , m_tx_power(0)
+    , m_default_tx_power(0)
+    , m_enterprise(false)
+    , m_scan_records()
+    , m_phy_defaults_read(false)
+    , m_default_protocol(0)
+    , m_default_bandwidth(WIFI_BW_HT20)
+    , m_phy_applied(false)
+    , m_applied_protocol(0)
+    , m_applied_bandwidth(WIFI_BW_HT20)
 {
 }
 
 WiFiDriverHAL::~WiFiDriverHAL()
 {
     deinit();
+    destroy_sta_netif();
 }
 
 esp_err_t WiFiDriverHAL::init_netif()
@@ -44,6 +71,11 @@ esp_err_t WiFiDriverHAL::create_default_event_loop()
 
 esp_err_t WiFiDriverHAL::setup_sta_netif()
 {
+    // Reuse the netif kept from a previous init/deinit cycle
+    if (m_sta_netif != nullptr) {
+        return ESP_OK;
+    }
+
     m_sta_netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
     if (m_sta_netif == nullptr) {
         m_sta_netif = esp_netif_create_default_wifi_sta();
@@ -126,6 +158,35 @@ esp_err_t WiFiDriverHAL::restore()
     return esp_wifi_restore();
 }
 
+esp_err_t WiFiDriverHAL::enable_ipv6()
+{
+#if CONFIG_LWIP_IPV6
+    if (m_sta_netif == nullptr) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return esp_netif_create_ip6_linklocal(m_sta_netif);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+bool WiFiDriverHAL::netif_has_ip(esp_netif_t *netif)
+{
+    esp_netif_ip_info_t info = {};
+    return esp_netif_get_ip_info(netif, &info) == ESP_OK && info.ip.addr != 0;
+}
+
+uint8_t WiFiDriverHAL::netif_index(esp_netif_t *netif)
+{
+    return (uint8_t)esp_netif_get_netif_impl_index(netif);
+}
+
+esp_err_t WiFiDriverHAL::set_default_netif(esp_netif_t *netif)
+{
+    // Also stops esp_netif from re-electing the default by route_prio on later netif events
+    return esp_netif_set_default_netif(netif);
+}
+
 esp_err_t WiFiDriverHAL::set_config(wifi_config_t *cfg)
 {
     return esp_wifi_set_config(WIFI_IF_STA, cfg);
@@ -136,6 +197,335 @@ esp_err_t WiFiDriverHAL::get_config(wifi_config_t *cfg)
     return esp_wifi_get_config(WIFI_IF_STA, cfg);
 }
 
+esp_err_t WiFiDriverHAL::apply_channel_plan(const wifi_manager::ChannelPlan &plan)
+{
+    if (!plan.is_valid()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    wifi_country_t country = {};
+    memcpy(country.cc, plan.country, sizeof(plan.country));
+    country.schan  = plan.first_channel;
+    country.nchan  = plan.channel_count;
+    country.policy = WIFI_COUNTRY_POLICY_MANUAL;
+    esp_err_t err  = esp_wifi_set_country(&country);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set country %s: %s", plan.country, esp_err_to_name(err));
+        return err;
+    }
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+    wifi_scan_default_params_t params = {};
+    params.scan_time.active.min       = plan.active_min_ms;
+    params.scan_time.active.max       = plan.active_max_ms;
+    params.scan_time.passive          = plan.passive_ms;
+    err                               = esp_wifi_set_scan_parameters(&params);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set scan dwell times: %s", esp_err_to_name(err));
+        return err;
+    }
+#else
+    if (plan.active_min_ms != 0 || plan.active_max_ms != 0 || plan.passive_ms != 0) {
+        ESP_LOGW(TAG, "Scan dwell times need ESP-IDF 5.2, keeping the driver defaults");
+    }
+#endif
+
+    // The method is part of the STA config: patch it, keeping the credentials
+    wifi_config_t cfg;
+    err = get_config(&cfg);
+    if (err != ESP_OK) {
+        return err;
+    }
+    cfg.sta.scan_method = plan.fast_scan ? WIFI_FAST_SCAN : WIFI_ALL_CHANNEL_SCAN;
+    return set_config(&cfg);
+}
+
+esp_err_t WiFiDriverHAL::set_phy(const wifi_manager::PhyConfig &phy)
+{
+    using wifi_manager::PhyConfig;
+
+    if (!phy.is_valid()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Nothing changed since esp_wifi_init(): the driver still runs its defaults
+    if (!m_phy_applied && phy == PhyConfig{}) {
+        return ESP_OK;
+    }
+
+    esp_err_t err;
+    if (!m_phy_defaults_read) {
+        err = esp_wifi_get_protocol(WIFI_IF_STA, &m_default_protocol);
+        if (err == ESP_OK) {
+            err = esp_wifi_get_bandwidth(WIFI_IF_STA, &m_default_bandwidth);
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+        m_phy_defaults_read = true;
+    }
+
+    uint8_t protocol = m_default_protocol;
+    if (phy.protocols != 0) {
+        protocol = 0;
+        protocol |= (phy.protocols & PhyConfig::PROTOCOL_11B) ? WIFI_PROTOCOL_11B : 0;
+        protocol |= (phy.protocols & PhyConfig::PROTOCOL_11G) ? WIFI_PROTOCOL_11G : 0;
+        protocol |= (phy.protocols & PhyConfig::PROTOCOL_11N) ? WIFI_PROTOCOL_11N : 0;
+        if (phy.protocols & PhyConfig::PROTOCOL_11AX) {
+#ifdef WIFI_PROTOCOL_11AX
+            protocol |= WIFI_PROTOCOL_11AX;
+#else
+            return ESP_ERR_NOT_SUPPORTED;
+#endif
+        }
+    }
+    wifi_bandwidth_t bandwidth = (phy.bandwidth == wifi_manager::Bandwidth::HT20)   ? WIFI_BW_HT20
+                                 : (phy.bandwidth == wifi_manager::Bandwidth::HT40) ? WIFI_BW_HT40
+                                                                                    : m_default_bandwidth;
+
+    if (m_phy_applied && protocol == m_applied_protocol && bandwidth == m_applied_bandwidth) {
+        return ESP_OK;
+    }
+
+    err = esp_wifi_set_protocol(WIFI_IF_STA, protocol);
+    if (err == ESP_OK) {
+        err = esp_wifi_set_bandwidth(WIFI_IF_STA, bandwidth);
+    }
+    if (err != ESP_OK) {
+        m_phy_applied = false;
+        ESP_LOGE(TAG, "Failed to set PHY 0x%x/%d: %s", protocol, (int)bandwidth, esp_err_to_name(err));
+        return err;
+    }
+    m_phy_applied       = true;
+    m_applied_protocol  = protocol;
+    m_applied_bandwidth = bandwidth;
+    return ESP_OK;
+}
+
+esp_err_t WiFiDriverHAL::setup_twt(const wifi_manager::TwtConfig &twt)
+{
+    if (!twt.is_enabled() || !twt.is_valid()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if WIFI_MANAGER_HAS_TWT
+    wifi_manager::TwtConfig::Encoding enc = twt.encode();
+
+    wifi_itwt_setup_config_t setup = {};
+    setup.setup_cmd                = TWT_REQUEST;
+    setup.trigger                  = 1;
+    setup.flow_type                = 0; // Announced: the AP buffers until the STA polls
+    setup.flow_id                  = 0;
+    setup.wake_invl_expn           = enc.exponent;
+    setup.wake_invl_mant           = enc.mantissa;
+    setup.min_wake_dura            = enc.duration;
+    setup.wake_duration_unit       = enc.duration_in_tu ? 1 : 0;
+    return esp_wifi_sta_itwt_setup(&setup);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t WiFiDriverHAL::teardown_twt()
+{
+#if WIFI_MANAGER_HAS_TWT
+    return esp_wifi_sta_itwt_teardown(0);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t WiFiDriverHAL::configure_enterprise(const wifi_manager::EnterpriseProfile &profile,
+                                              const wifi_manager::Certificate *ca_cert,
+                                              const wifi_manager::Certificate *client_cert,
+                                              const wifi_manager::Certificate *client_key)
+{
+    if (!profile.is_valid() ||
+        (profile.method == wifi_manager::EapMethod::TLS && (client_cert == nullptr || client_key == nullptr))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if WIFI_MANAGER_HAS_ENTERPRISE
+    // Start from a clean supplicant: the previous profile's credentials must not leak into this one
+    disable_enterprise();
+
+    esp_err_t err = esp_eap_client_set_identity((const unsigned char *)profile.identity, strlen(profile.identity));
+    if (err == ESP_OK && ca_cert != nullptr) {
+        err = esp_eap_client_set_ca_cert(ca_cert->data, (int)ca_cert->len);
+    }
+    else if (err == ESP_OK) {
+        ESP_LOGW(TAG, "No CA certificate: the RADIUS server is not authenticated");
+    }
+
+    if (err == ESP_OK && profile.method == wifi_manager::EapMethod::TLS) {
+        err = esp_eap_client_set_certificate_and_key(client_cert->data, (int)client_cert->len, client_key->data,
+                                                     (int)client_key->len, nullptr, 0);
+    }
+    else if (err == ESP_OK) {
+        err = esp_eap_client_set_username((const unsigned char *)profile.username, strlen(profile.username));
+        if (err == ESP_OK) {
+            err = esp_eap_client_set_password((const unsigned char *)profile.password, strlen(profile.password));
+        }
+        if (err == ESP_OK && profile.method == wifi_manager::EapMethod::TTLS) {
+            err = esp_eap_client_set_ttls_phase2_method(ESP_EAP_TTLS_PHASE2_MSCHAPV2);
+        }
+    }
+    if (err == ESP_OK) {
+        err = esp_eap_client_set_suiteb_192bit_certification(profile.wpa3_192);
+    }
+    if (err == ESP_OK) {
+        err = esp_wifi_sta_enterprise_enable();
+    }
+    m_enterprise = (err == ESP_OK);
+    return err;
+#else
+    (void)ca_cert;
+    (void)client_cert;
+    (void)client_key;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t WiFiDriverHAL::disable_enterprise()
+{
+#if WIFI_MANAGER_HAS_ENTERPRISE
+    if (!m_enterprise) {
+        return ESP_OK;
+    }
+    esp_err_t err = esp_wifi_sta_enterprise_disable();
+    esp_eap_client_clear_identity();
+    esp_eap_client_clear_username();
+    esp_eap_client_clear_password();
+    esp_eap_client_clear_ca_cert();
+    esp_eap_client_clear_certificate_and_key();
+    m_enterprise = false;
+    return err;
+#else
+    return ESP_OK;
+#endif
+}
+
+esp_err_t WiFiDriverHAL::set_max_tx_power(int8_t power)
+{
+    if (power == m_tx_power) {
+        return ESP_OK;
+    }
+    // First change since esp_wifi_init() or the last restore: remember what the driver ran with
+    if (m_default_tx_power == 0) {
+        esp_err_t err = esp_wifi_get_max_tx_power(&m_default_tx_power);
+        if (err != ESP_OK) {
+            m_default_tx_power = 0;
+            return err;
+        }
+    }
+    esp_err_t err = esp_wifi_set_max_tx_power(power);
+    m_tx_power    = (err == ESP_OK) ? power : 0;
+    return err;
+}
+
+esp_err_t WiFiDriverHAL::restore_max_tx_power()
+{
+    if (m_default_tx_power == 0) {
+        return ESP_OK; // Never changed
+    }
+    esp_err_t err = esp_wifi_set_max_tx_power(m_default_tx_power);
+    if (err == ESP_OK) {
+        m_tx_power         = 0;
+        m_default_tx_power = 0;
+    }
+    return err;
+}
+
+esp_err_t WiFiDriverHAL::get_rssi(int8_t &rssi)
+{
+    wifi_ap_record_t ap;
+    esp_err_t err = esp_wifi_sta_get_ap_info(&ap);
+    if (err == ESP_OK) {
+        rssi = ap.rssi;
+    }
+    return err;
+}
+
+esp_err_t WiFiDriverHAL::get_bssid(uint8_t (&bssid)[6])
+{
+    wifi_ap_record_t ap;
+    esp_err_t err = esp_wifi_sta_get_ap_info(&ap);
+    if (err == ESP_OK) {
+        memcpy(bssid, ap.bssid, sizeof(bssid));
+    }
+    return err;
+}
+
+esp_err_t WiFiDriverHAL::set_ft(bool enabled)
+{
+    wifi_config_t cfg;
+    esp_err_t err = esp_wifi_get_config(WIFI_IF_STA, &cfg);
+    if (err != ESP_OK || cfg.sta.ft_enabled == enabled) {
+        return err;
+    }
+    cfg.sta.ft_enabled = enabled;
+    return esp_wifi_set_config(WIFI_IF_STA, &cfg);
+}
+
+esp_err_t WiFiDriverHAL::pin_bssid(const wifi_manager::RoamCandidate *target)
+{
+    wifi_config_t cfg;
+    esp_err_t err = esp_wifi_get_config(WIFI_IF_STA, &cfg);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (target == nullptr) {
+        if (!cfg.sta.bssid_set) {
+            return ESP_OK;
+        }
+        cfg.sta.bssid_set = false;
+        cfg.sta.channel   = 0;
+    }
+    else {
+        if (cfg.sta.bssid_set && memcmp(cfg.sta.bssid, target->bssid, sizeof(target->bssid)) == 0 &&
+            cfg.sta.channel == target->channel) {
+            return ESP_OK;
+        }
+        cfg.sta.bssid_set = true;
+        memcpy(cfg.sta.bssid, target->bssid, sizeof(target->bssid));
+        cfg.sta.channel = target->channel;
+    }
+    return esp_wifi_set_config(WIFI_IF_STA, &cfg);
+}
+
+esp_err_t WiFiDriverHAL::start_roam_scan(uint8_t channel)
+{
+    wifi_config_t cfg;
+    esp_err_t err = esp_wifi_get_config(WIFI_IF_STA, &cfg);
+    if (err != ESP_OK) {
+        return err;
+    }
+    // Probes for the SSID on every channel: finds hidden APs of the network as well. The
+    // config field is not terminated for a 32-character SSID.
+    uint8_t ssid[sizeof(cfg.sta.ssid) + 1] = {};
+    memcpy(ssid, cfg.sta.ssid, sizeof(cfg.sta.ssid));
+    wifi_scan_config_t scan = {};
+    scan.ssid               = ssid;
+    scan.channel            = channel;
+    scan.show_hidden        = true;
+    return esp_wifi_scan_start(&scan, false);
+}
+
+esp_err_t WiFiDriverHAL::get_roam_candidates(wifi_manager::RoamCandidate *candidates, size_t &count)
+{
+    uint16_t records = (uint16_t)ROAM_RECORDS_MAX;
+    esp_err_t err    = esp_wifi_scan_get_ap_records(&records, m_scan_records);
+    if (err != ESP_OK) {
+        count = 0;
+        return err;
+    }
+    count = std::min<size_t>(count, records);
+    for (size_t i = 0; i < count; i++) {
+        memcpy(candidates[i].bssid, m_scan_records[i].bssid, sizeof(candidates[i].bssid));
+        candidates[i].rssi    = m_scan_records[i].rssi;
+        candidates[i].channel = m_scan_records[i].primary;
+    }
+    return ESP_OK;
+}
+
 esp_err_t WiFiDriverHAL::deinit()
 {
     esp_err_t err = ESP_OK;
@@ -143,14 +533,23 @@ esp_err_t WiFiDriverHAL::deinit()
     if (m_wifi_init_done) {
         err = esp_wifi_deinit();
         if (err == ESP_OK || err == ESP_ERR_WIFI_NOT_INIT) {
-            m_wifi_init_done = false;
+            m_wifi_init_done   = false;
+            m_phy_applied      = false; // The next esp_wifi_init() starts from the defaults
+            m_tx_power         = 0;
+            m_default_tx_power = 0;
+            m_enterprise       = false;
         }
     }
 
+    // The STA netif is intentionally kept: destroying and recreating it on every
+    // cycle is the most expensive part of a deinit/init round trip.
+    return err;
+}
+
+void WiFiDriverHAL::destroy_sta_netif()
+{
     if (m_sta_netif) {
         esp_netif_destroy_default_wifi(m_sta_netif);
         m_sta_netif = nullptr;
     }
-
-    return err;
 }
@@ -1,12 +1,27 @@
+#include "sdkconfig.h"
+#define LOG_LOCAL_LEVEL CONFIG_WIFI_MANAGER_LOG_LEVEL
+
 #include "wifi_event_handler.hpp"
+#include "wifi_state_machine.hpp"
 #include "esp_log.h"
 #include "esp_netif.h"
+#include "esp_timer.h"
+#include "esp_idf_version.h"
 #include "esp_wifi_types.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 
 namespace wifi_manager {
 
+// Event handlers run in the event loop task, so a regular (non-ISR) send is used:
+// it lets the scheduler switch to wifi_task right away when it has a higher priority
+// than the loop, instead of waiting for the loop to finish every remaining handler.
+static void forward_event(QueueHandle_t queue, Message &msg)
+{
+    msg.timestamp_us = (uint32_t)esp_timer_get_time();
+    xQueueSend(queue, &msg, 0);
+}
+
 void WiFiEventHandler::wifi_event_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
 {
     QueueHandle_t queue = static_cast<QueueHandle_t>(arg);
@@ -25,20 +40,41 @@ void WiFiEventHandler::wifi_event_handler(void *arg, esp_event_base_t base, int3
         break;
     case WIFI_EVENT_STA_CONNECTED:
         msg.event = EventId::STA_CONNECTED;
+        if (data != nullptr) {
+            msg.payload.channel = static_cast<wifi_event_sta_connected_t *>(data)->channel;
+        }
         break;
     case WIFI_EVENT_STA_DISCONNECTED:
         msg.event = EventId::STA_DISCONNECTED;
         if (data != nullptr) {
-            auto *disconn = static_cast<wifi_event_sta_disconnected_t *>(data);
-            msg.reason    = disconn->reason;
-            msg.rssi      = disconn->rssi;
+            auto *disconn                   = static_cast<wifi_event_sta_disconnected_t *>(data);
+            msg.payload.disconnected.reason = disconn->reason;
+            msg.payload.disconnected.rssi   = disconn->rssi;
         }
         break;
+    case WIFI_EVENT_SCAN_DONE:
+        msg.event = EventId::SCAN_DONE;
+        break;
+#if CONFIG_WIFI_MANAGER_TWT && ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+    case WIFI_EVENT_ITWT_SETUP:
+    {
+        // Alternate and dictate are counter-offers: no agreement is established
+        auto *setup     = static_cast<wifi_event_sta_itwt_setup_t *>(data);
+        bool accepted   = setup != nullptr && setup->config.setup_cmd == TWT_ACCEPT;
+        msg.event       = EventId::TWT;
+        msg.payload.twt = accepted ? TwtState::ACTIVE : TwtState::REJECTED;
+        break;
+    }
+    case WIFI_EVENT_ITWT_TEARDOWN:
+        msg.event       = EventId::TWT;
+        msg.payload.twt = TwtState::OFF;
+        break;
+#endif
     default:
         return; // Ignore unhandled events
     }
 
-    xQueueSendFromISR(queue, &msg, nullptr);
+    forward_event(queue, msg);
 }
 
 void WiFiEventHandler::ip_event_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
@@ -50,14 +86,33 @@ void WiFiEventHandler::ip_event_handler(void *arg, esp_event_base_t base, int32_
     Message msg = {};
     msg.type    = MessageType::EVENT;
 
-    if (id == IP_EVENT_STA_GOT_IP) {
-        msg.event = EventId::GOT_IP;
+    if (id == IP_EVENT_STA_GOT_IP || id == IP_EVENT_STA_LOST_IP) {
+        msg.event           = (id == IP_EVENT_STA_GOT_IP) ? EventId::GOT_IP : EventId::LOST_IP;
+        msg.payload.address = AddressKind::IPV4;
+    }
+    else if (id == IP_EVENT_GOT_IP6 && data != nullptr) {
+        // Posted for every netif: keep the STA ones
+        auto *got = static_cast<ip_event_got_ip6_t *>(data);
+        if (got->esp_netif != esp_netif_get_handle_from_ifkey("WIFI_STA_DEF")) {
+            return;
+        }
+        msg.event           = EventId::GOT_IP;
+        msg.payload.address = WiFiStateMachine::classify_ip6(reinterpret_cast<const uint8_t *>(got->ip6_info.ip.addr));
+    }
+    else if ((id == IP_EVENT_ETH_GOT_IP || id == IP_EVENT_ETH_LOST_IP || id == IP_EVENT_PPP_GOT_IP ||
+              id == IP_EVENT_PPP_LOST_IP) &&
+             data != nullptr) {
+        // Other uplinks, for the default route arbitration; the lost events carry the same struct
+        auto *got = static_cast<ip_event_got_ip_t *>(data);
+        msg.event = (id == IP_EVENT_ETH_GOT_IP || id == IP_EVENT_PPP_GOT_IP) ? EventId::UPLINK_UP
+                                                                             : EventId::UPLINK_DOWN;
+        msg.payload.netif_index = (uint8_t)esp_netif_get_netif_impl_index(got->esp_netif);
     }
     else {
         return;
     }
 
-    xQueueSendFromISR(queue, &msg, nullptr);
+    forward_event(queue, msg);
 }
 
 } // namespace wifi_manager
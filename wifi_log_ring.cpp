@@ -0,0 +1,374 @@
+#include <cstdio>
+
+#include "wifi_log_ring.hpp"
+#include "wifi_state_machine.hpp"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+namespace wifi_manager {
+
+static const char *rssi_quality(int32_t rssi)
+{
+    return (rssi >= WiFiStateMachine::RSSI_THRESHOLD_GOOD)     ? "GOOD"
+           : (rssi >= WiFiStateMachine::RSSI_THRESHOLD_MEDIUM) ? "MEDIUM"
+           : (rssi >= WiFiStateMachine::RSSI_THRESHOLD_WEAK)   ? "WEAK"
+                                                               : "CRITICAL";
+}
+
+static const char *address_name(int32_t kind)
+{
+    static const char *const names[] = {"IPv4", "IPv6 link-local", "IPv6 global"};
+    return (kind >= 0 && kind < (int32_t)AddressKind::COUNT) ? names[kind] : "?";
+}
+
+static const char *readiness_name(int32_t readiness)
+{
+    static const char *const names[] = {"IPv4", "IPv6 link-local", "IPv6 global", "IPv4 or IPv6 global"};
+    return (readiness >= 0 && readiness < (int32_t)IpReadiness::COUNT) ? names[readiness] : "?";
+}
+
+// Whether records of this level can be written at all; the text of the others stays out of the binary
+static constexpr bool is_linked(LogId id)
+{
+#ifdef ESP_PLATFORM
+    return (int)log_level(id) <= CONFIG_WIFI_MANAGER_LOG_LEVEL;
+#else
+    (void)id;
+    return true; // No Kconfig in the native core build
+#endif
+}
+
+size_t format_record(const LogRecord &record, char *buf, size_t size)
+{
+    const int32_t *a = record.args;
+    int len          = -1;
+
+    switch (record.id) {
+    case LogId::ECHO_IGNORED:
+        if constexpr (is_linked(LogId::ECHO_IGNORED)) {
+            len = snprintf(buf, size, "Ignoring the echo of our own disconnect.");
+        }
+        break;
+    case LogId::TRANSITION:
+        if constexpr (is_linked(LogId::TRANSITION)) {
+            len = snprintf(buf, size, "Event %ld: State transition %ld -> %ld", (long)a[0], (long)a[1], (long)a[2]);
+        }
+        break;
+    case LogId::STA_DISCONNECTED:
+        if constexpr (is_linked(LogId::STA_DISCONNECTED)) {
+            len = snprintf(buf, size, "Task Event: STA_DISCONNECTED (reason: %ld, RSSI=%ld dBm [%s])", (long)a[0],
+                           (long)a[1], rssi_quality(a[1]));
+        }
+        break;
+    case LogId::LEFT:
+        if constexpr (is_linked(LogId::LEFT)) {
+            len = snprintf(buf, size, "Disconnected (Reason: ASSOC_LEAVE).");
+        }
+        break;
+    case LogId::SUSPECT_INVALIDATE:
+        if constexpr (is_linked(LogId::SUSPECT_INVALIDATE)) {
+            len = snprintf(
+                buf, size, "Authentication failed due to too many suspect failures (Reason: %ld). Invalidating.",
+                (long)a[0]);
+        }
+        break;
+    case LogId::SUSPECT_RETRY:
+        if constexpr (is_linked(LogId::SUSPECT_RETRY)) {
+            len = snprintf(buf, size,
+                           "Suspect failure (Reason: %ld), retrying in %lu ms due to poor signal or allowed "
+                           "attempts...",
+                           (long)a[0], (unsigned long)a[1]);
+        }
+        break;
+    case LogId::RECONNECT_SCHEDULED:
+        if constexpr (is_linked(LogId::RECONNECT_SCHEDULED)) {
+            len = snprintf(buf, size, "Reconnection attempt %lu in %lu ms...", (unsigned long)a[0],
+                           (unsigned long)a[1]);
+        }
+        break;
+    case LogId::TIMEOUT_ASSOC:
+        if constexpr (is_linked(LogId::TIMEOUT_ASSOC)) {
+            len = snprintf(buf, size, "Task Event: TIMEOUT (association took too long), aborting attempt...");
+        }
+        break;
+    case LogId::TIMEOUT_DHCP:
+        if constexpr (is_linked(LogId::TIMEOUT_DHCP)) {
+            len = snprintf(buf, size, "Task Event: TIMEOUT (DHCP took too long), aborting attempt...");
+        }
+        break;
+    case LogId::CHAIN_CONNECT:
+        if constexpr (is_linked(LogId::CHAIN_CONNECT)) {
+            len = snprintf(buf, size, "Driver started, chaining into connect...");
+        }
+        break;
+    case LogId::ASSOCIATED:
+        if constexpr (is_linked(LogId::ASSOCIATED)) {
+            len = snprintf(buf, size, "Associated on channel %ld, %lu ms after esp_wifi_connect()", (long)a[0],
+                           (unsigned long)a[1]);
+        }
+        break;
+    case LogId::PROBE_MISSED:
+        if constexpr (is_linked(LogId::PROBE_MISSED)) {
+            len = snprintf(buf, size, "Hidden SSID not found on channel %ld, scanning all channels next", (long)a[0]);
+        }
+        break;
+    case LogId::PHY_FALLBACK:
+        if constexpr (is_linked(LogId::PHY_FALLBACK)) {
+            len = snprintf(buf, size, "Association refused for PHY reasons (Reason: %ld), falling back to %s",
+                           (long)a[1], (a[0] >= 2) ? "802.11b/g" : "802.11b/g/n HT20");
+        }
+        break;
+    case LogId::PHY_FAILED:
+        if constexpr (is_linked(LogId::PHY_FAILED)) {
+            len = snprintf(buf, size, "Failed to apply the PHY modes (0x%lx)", (unsigned long)a[0]);
+        }
+        break;
+    case LogId::TWT_REQUESTED:
+        if constexpr (is_linked(LogId::TWT_REQUESTED)) {
+            len = snprintf(buf, size, "Requesting TWT: %ld us awake every %ld ms", (long)a[1], (long)a[0]);
+        }
+        break;
+    case LogId::TWT_STATE:
+        if constexpr (is_linked(LogId::TWT_STATE)) {
+            len = snprintf(buf, size, "TWT %s by the AP",
+                           (a[0] == (int32_t)TwtState::ACTIVE)     ? "accepted"
+                           : (a[0] == (int32_t)TwtState::REJECTED) ? "rejected"
+                                                                   : "torn down");
+        }
+        break;
+    case LogId::TWT_FAILED:
+        if constexpr (is_linked(LogId::TWT_FAILED)) {
+            len = snprintf(buf, size, "TWT setup not sent (0x%lx)", (unsigned long)a[0]);
+        }
+        break;
+    case LogId::TX_POWER:
+        if constexpr (is_linked(LogId::TX_POWER)) {
+            len = snprintf(buf, size, "TX power limit %ld.%02ld dBm (RSSI: %ld)", (long)(a[0] / 4),
+                           (long)(a[0] % 4) * 25, (long)a[1]);
+        }
+        break;
+    case LogId::TX_POWER_FAILED:
+        if constexpr (is_linked(LogId::TX_POWER_FAILED)) {
+            len = snprintf(buf, size, "Failed to set the TX power limit (0x%lx)", (unsigned long)a[0]);
+        }
+        break;
+    case LogId::EAP_HANDSHAKE:
+        if constexpr (is_linked(LogId::EAP_HANDSHAKE)) {
+            len = snprintf(buf, size, "EAP handshake %s in %ld ms (about %ld ms saved so far)",
+                           a[1] ? "likely resumed" : "completed", (long)a[0], (long)a[2]);
+        }
+        break;
+    case LogId::EAP_FAILED:
+        if constexpr (is_linked(LogId::EAP_FAILED)) {
+            len = snprintf(buf, size, "Failed to configure the EAP supplicant (0x%lx)", (unsigned long)a[0]);
+        }
+        break;
+    case LogId::ROAM_SCAN:
+        if constexpr (is_linked(LogId::ROAM_SCAN)) {
+            len = snprintf(buf, size, "RSSI %ld dBm below %ld dBm, scanning for a better AP", (long)a[0], (long)a[1]);
+        }
+        break;
+    case LogId::ROAM_START:
+        if constexpr (is_linked(LogId::ROAM_START)) {
+            len = snprintf(buf, size, "Roaming to the AP at %ld dBm on channel %ld (%s)", (long)a[1], (long)a[2],
+                           a[0] ? "fast transition" : "reconnect");
+        }
+        break;
+    case LogId::ROAM_DONE:
+        if constexpr (is_linked(LogId::ROAM_DONE)) {
+            len = snprintf(buf, size, "Roamed by %s, link gap %ld.%03ld ms", a[0] ? "fast transition" : "reconnect",
+                           (long)(a[1] / 1000), (long)(a[1] % 1000));
+        }
+        break;
+    case LogId::ROAM_FAILED:
+        if constexpr (is_linked(LogId::ROAM_FAILED)) {
+            len = snprintf(buf, size, "%s", a[0] ? "Fast transition failed, falling back to a regular reconnect"
+                                                 : "Roam did not reach the candidate AP");
+        }
+        break;
+    case LogId::UPLINK_SWITCH:
+        if constexpr (is_linked(LogId::UPLINK_SWITCH)) {
+            len = snprintf(buf, size, "Default route on uplink %ld (priority %ld)%s", (long)a[0], (long)a[1],
+                           a[2] ? ", failover" : "");
+        }
+        break;
+    case LogId::UPLINK_NONE:
+        if constexpr (is_linked(LogId::UPLINK_NONE)) {
+            len = snprintf(buf, size, "No usable uplink left for the default route");
+        }
+        break;
+    case LogId::UPLINK_FAILED:
+        if constexpr (is_linked(LogId::UPLINK_FAILED)) {
+            len = snprintf(buf, size, "Failed to move the default route to uplink %ld (0x%lx)", (long)a[0],
+                           (unsigned long)a[1]);
+        }
+        break;
+    case LogId::CHANNEL_CHANGE:
+        if constexpr (is_linked(LogId::CHANNEL_CHANGE)) {
+            len = snprintf(buf, size, "Channel %ld -> %ld%s", (long)a[0], (long)a[1], a[2] ? ", roam pending" : "");
+        }
+        break;
+    case LogId::GOT_IP:
+        if constexpr (is_linked(LogId::GOT_IP)) {
+            len = snprintf(buf, size, "Task Event: GOT_IP (%s)", address_name(a[0]));
+        }
+        break;
+    case LogId::ADDRESS_PENDING:
+        if constexpr (is_linked(LogId::ADDRESS_PENDING)) {
+            len = snprintf(buf, size, "%s address assigned, waiting for %s", address_name(a[0]), readiness_name(a[1]));
+        }
+        break;
+    case LogId::IPV6_FAILED:
+        if constexpr (is_linked(LogId::IPV6_FAILED)) {
+            len = snprintf(buf, size, "Failed to enable IPv6 on the STA netif (0x%lx)", (unsigned long)a[0]);
+        }
+        break;
+    case LogId::SUPERSEDED:
+        if constexpr (is_linked(LogId::SUPERSEDED)) {
+            len = snprintf(buf, size, "Command %ld superseded by a later STOP or cancellation, dropping", (long)a[0]);
+        }
+        break;
+    case LogId::COMMAND_DROPPED:
+        if constexpr (is_linked(LogId::COMMAND_DROPPED)) {
+            len = snprintf(buf, size, "Command %ld no longer applies in state %ld, dropping", (long)a[0], (long)a[1]);
+        }
+        break;
+    case LogId::BOOT_BACKOFF:
+        if constexpr (is_linked(LogId::BOOT_BACKOFF)) {
+            len = snprintf(buf, size, "Resuming reconnect backoff after reset: attempt %lu in %lu ms...",
+                           (unsigned long)a[0], (unsigned long)a[1]);
+        }
+        break;
+    case LogId::BUDGET_EXHAUSTED:
+        if constexpr (is_linked(LogId::BUDGET_EXHAUSTED)) {
+            len = snprintf(buf, size, "Hourly budget of %ld attempts exhausted, next retry in %lu s.", (long)a[0],
+                           (unsigned long)a[1]);
+        }
+        break;
+    case LogId::BACKOFF_DONE:
+        if constexpr (is_linked(LogId::BACKOFF_DONE)) {
+            len = snprintf(buf, size, "Backoff finished. Retrying connection...");
+        }
+        break;
+    case LogId::LINK_STABLE:
+        if constexpr (is_linked(LogId::LINK_STABLE)) {
+            len = snprintf(buf, size, "Link stable, clearing the boot counter.");
+        }
+        break;
+    default:
+        len = snprintf(buf, size, "Unknown record %d", (int)record.id);
+        break;
+    }
+    if (len < 0) {
+        // Level compiled out
+        len = snprintf(buf, size, "Record %d (%ld, %ld, %ld)", (int)record.id, (long)a[0], (long)a[1], (long)a[2]);
+    }
+
+    if (len < 0) {
+        len = 0;
+    }
+    return (size == 0) ? 0 : ((size_t)len < size ? (size_t)len : size - 1);
+}
+
+WiFiLogRing::WiFiLogRing(LogRecord *storage, uint32_t capacity, uint32_t rate_per_s, uint32_t burst)
+    : m_storage(storage)
+    , m_capacity(capacity)
+    , m_head(0)
+    , m_tail(0)
+    , m_rate_per_s(rate_per_s)
+    , m_burst_milli((burst ? burst : 1) * 1000)
+    , m_tokens_milli((burst ? burst : 1) * 1000)
+    , m_refill_us(-1)
+    , m_written(0)
+    , m_dropped_full(0)
+    , m_dropped_rate(0)
+    , m_dropped_reported(0)
+{
+}
+
+bool WiFiLogRing::take_token(int64_t now_us)
+{
+    if (m_rate_per_s == 0) {
+        return true;
+    }
+
+    if (m_refill_us < 0) {
+        m_refill_us = now_us;
+    }
+    // rate_per_s tokens per second is rate_per_s milli-tokens per millisecond
+    int64_t elapsed_ms = (now_us - m_refill_us) / 1000;
+    if (elapsed_ms > 0) {
+        uint64_t tokens = m_tokens_milli + (uint64_t)elapsed_ms * m_rate_per_s;
+        m_tokens_milli  = (tokens > m_burst_milli) ? m_burst_milli : (uint32_t)tokens;
+        m_refill_us += elapsed_ms * 1000;
+    }
+
+    if (m_tokens_milli < 1000) {
+        return false;
+    }
+    m_tokens_milli -= 1000;
+    return true;
+}
+
+bool WiFiLogRing::write(int64_t now_us, LogId id, int32_t a0, int32_t a1, int32_t a2, bool &was_empty)
+{
+    uint32_t head = m_head.load(std::memory_order_relaxed);
+    uint32_t tail = m_tail.load(std::memory_order_acquire);
+    was_empty     = (head == tail);
+
+    if (!take_token(now_us)) {
+        m_dropped_rate.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (head - tail >= m_capacity) {
+        m_dropped_full.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    LogRecord &slot = m_storage[head % m_capacity];
+    slot.time       = (uint32_t)(now_us >> LogRecord::TIME_SHIFT) & LogRecord::TIME_MASK;
+    slot.id         = id;
+    slot.args[0]    = a0;
+    slot.args[1]    = a1;
+    slot.args[2]    = a2;
+
+    // Publish the slot: the consumer's acquire load of m_head sees the stores above
+    m_head.store(head + 1, std::memory_order_release);
+    m_written.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool WiFiLogRing::read(LogRecord &out)
+{
+    uint32_t tail = m_tail.load(std::memory_order_relaxed);
+    uint32_t head = m_head.load(std::memory_order_acquire);
+    if (tail == head) {
+        return false;
+    }
+
+    out = m_storage[tail % m_capacity];
+    // Hand the slot back only once it has been copied out
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+uint32_t WiFiLogRing::take_dropped()
+{
+    uint32_t total = m_dropped_full.load(std::memory_order_relaxed) + m_dropped_rate.load(std::memory_order_relaxed);
+    uint32_t delta = total - m_dropped_reported;
+    m_dropped_reported = total;
+    return delta;
+}
+
+LogRingStats WiFiLogRing::stats() const
+{
+    LogRingStats s;
+    s.written      = m_written.load(std::memory_order_relaxed);
+    s.dropped_full = m_dropped_full.load(std::memory_order_relaxed);
+    s.dropped_rate = m_dropped_rate.load(std::memory_order_relaxed);
+    return s;
+}
+
+} // namespace wifi_manager
@@ -1,11 +1,14 @@
+// Messages above CONFIG_WIFI_MANAGER_LOG_LEVEL are compiled out with their format strings
+#include "sdkconfig.h"
+#define LOG_LOCAL_LEVEL CONFIG_WIFI_MANAGER_LOG_LEVEL
+
 #include <cstring>
 
 #include "esp_event.h"
-#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_timer.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "nvs_flash.h"
-#include "sdkconfig.h"
 
 #include "wifi_event_handler.hpp"
 #include "wifi_manager.hpp"
@@ -22,13 +25,139 @@ WiFiManager &WiFiManager::get_instance()
     return instance;
 }
 
+const char *WiFiManager::err_to_name(esp_err_t err)
+{
+    switch (err) {
+    case wifi_manager::ERR_SUPERSEDED:
+        return "ERR_SUPERSEDED";
+    case wifi_manager::ERR_CANCELLED:
+        return "ERR_CANCELLED";
+    default:
+        return esp_err_to_name(err);
+    }
+}
+
+// Kconfig limits of the TX power controller (0.25 dBm units on the driver side), also used when
+// set_tx_power_control() enables it at runtime
+static wifi_manager::WiFiTxPowerController::Config tx_power_kconfig()
+{
+    wifi_manager::WiFiTxPowerController::Config config = {};
+    config.target_rssi                                 = CONFIG_WIFI_MANAGER_TX_POWER_TARGET_RSSI;
+    config.margin_db                                   = CONFIG_WIFI_MANAGER_TX_POWER_MARGIN_DB;
+    config.min_power                                   = CONFIG_WIFI_MANAGER_TX_POWER_MIN_DBM * 4;
+    config.max_power                                   = CONFIG_WIFI_MANAGER_TX_POWER_MAX_DBM * 4;
+    config.step                                        = CONFIG_WIFI_MANAGER_TX_POWER_STEP_DB * 4;
+    config.stable_samples                              = CONFIG_WIFI_MANAGER_TX_POWER_STABLE_SAMPLES;
+    return config;
+}
+
+// Kconfig defaults of the roam policy; runtime changes go through set_roam_config()
+static wifi_manager::RoamConfig roam_kconfig()
+{
+    wifi_manager::RoamConfig config = {};
+    config.hysteresis_db            = 8;
+    config.scan_interval_ms         = 30000;
+    config.channel_bias_db          = 4;
+#if CONFIG_WIFI_MANAGER_ROAM
+    config.trigger_rssi     = CONFIG_WIFI_MANAGER_ROAM_RSSI;
+    config.hysteresis_db    = CONFIG_WIFI_MANAGER_ROAM_HYSTERESIS_DB;
+    config.scan_interval_ms = CONFIG_WIFI_MANAGER_ROAM_SCAN_INTERVAL_MS;
+    config.channel_bias_db  = CONFIG_WIFI_MANAGER_ROAM_CHANNEL_BIAS_DB;
+#if CONFIG_WIFI_MANAGER_FT
+    config.ft = true;
+#endif
+#endif
+    return config;
+}
+
 WiFiManager::WiFiManager()
     : storage(driver_hal, "wifi_manager")
     , state_machine()
     , driver_hal()
+    , timers()
+    , task_handle(nullptr)
+    , task_exit_sem(nullptr)
+    , init_timing()
+    , async_init_pending(false)
+    , async_init_failed(false)
+    , async_init_error(ESP_OK)
+    , auto_start_pending(false)
+    , auto_connect_pending(false)
+    , metrics()
+    , connect_timeout_ms(CONFIG_WIFI_MANAGER_CONNECT_TIMEOUT_MS)
+    , dhcp_timeout_ms(CONFIG_WIFI_MANAGER_DHCP_TIMEOUT_MS)
+    , disconnect_echoes(0)
+    , channel_plan()
+    , channel_plan_set(false)
+    , connect_issued_us(0)
+    , probe_channel(0)
+    , probe_missed(false)
+    , twt_config()
+    , tx_power(tx_power_kconfig())
+#if CONFIG_WIFI_MANAGER_TX_POWER_CONTROL
+    , tx_power_control(true)
+#else
+    , tx_power_control(false)
+#endif
+    , last_rssi(0)
+    , roam_policy(roam_kconfig())
+    , roam_scan_pending(false)
+    , channel_lock(0)
+    , sta_channel(0)
+    , notified_channel(0)
+    , notified_pending(false)
+    , channel_listener(nullptr)
+    , channel_listener_arg(nullptr)
+    , roam_notice_pending(false)
+    , roam_notice_target()
+    , uplinks(CONFIG_WIFI_MANAGER_UPLINK_HOLD_MS)
+    , uplink_netifs()
+    , wifi_uplink(wifi_manager::WiFiUplinkArbiter::NONE)
+    , certificates()
+    , eap_status()
+    , eap_configured(false)
+    , eap_session_cached(false)
+    , retry_guard(wifi_manager::WiFiRetryGuard::rtc_record())
+    , boot_recorded(false)
+    , boot_backoff_retries(0)
+#if CONFIG_WIFI_MANAGER_DEFERRED_LOG
+    , log_storage()
+    , log_ring(log_storage, CONFIG_WIFI_MANAGER_LOG_RING_SIZE, CONFIG_WIFI_MANAGER_LOG_RATE,
+               CONFIG_WIFI_MANAGER_LOG_BURST)
+    , log_task_handle(nullptr)
+    , log_task_exit(false)
+#endif
+#if CONFIG_WIFI_MANAGER_SYNC_API
+    , txn_slot()
+    , txn_deadline_us(0)
+    , txn_busy(false)
+    , txn_done(false)
+    , txn_abandoned(false)
+    , txn_cancelled(false)
+    , txn_generation(0)
+#endif
 {
-    // Mutex is created once and persists for the lifetime of the singleton.
-    state_mutex = xSemaphoreCreateRecursiveMutex();
+    // The mutex and the exit semaphore are created once and persist for the lifetime of the singleton.
+    state_mutex   = xSemaphoreCreateRecursiveMutex();
+    task_exit_sem = xSemaphoreCreateBinary();
+    state_machine.set_ip_readiness((wifi_manager::IpReadiness)CONFIG_WIFI_MANAGER_IP_READINESS);
+
+#if CONFIG_WIFI_MANAGER_CHANNEL_PLAN
+    strncpy(channel_plan.country, CONFIG_WIFI_MANAGER_COUNTRY, sizeof(channel_plan.country) - 1);
+    channel_plan.first_channel = CONFIG_WIFI_MANAGER_FIRST_CHANNEL;
+    channel_plan.channel_count = CONFIG_WIFI_MANAGER_CHANNEL_COUNT;
+    channel_plan.active_min_ms = CONFIG_WIFI_MANAGER_SCAN_ACTIVE_MIN_MS;
+    channel_plan.active_max_ms = CONFIG_WIFI_MANAGER_SCAN_ACTIVE_MAX_MS;
+    channel_plan.passive_ms    = CONFIG_WIFI_MANAGER_SCAN_PASSIVE_MS;
+#if CONFIG_WIFI_MANAGER_FAST_SCAN
+    channel_plan.fast_scan = true;
+#endif
+    channel_plan_set = true;
+#endif
+#if CONFIG_WIFI_MANAGER_TWT
+    twt_config.wake_interval_us = CONFIG_WIFI_MANAGER_TWT_WAKE_INTERVAL_MS * 1000UL;
+    twt_config.wake_duration_us = CONFIG_WIFI_MANAGER_TWT_WAKE_DURATION_US;
+#endif
 }
 
 WiFiManager::~WiFiManager()
@@ -37,10 +166,18 @@ WiFiManager::~WiFiManager()
     if (task_handle != nullptr) {
         vTaskDelete(task_handle);
     }
+#if CONFIG_WIFI_MANAGER_DEFERRED_LOG
+    if (log_task_handle != nullptr) {
+        vTaskDelete(log_task_handle);
+    }
+#endif
     sync_manager.deinit();
     if (state_mutex != nullptr) {
         vSemaphoreDelete(state_mutex);
     }
+    if (task_exit_sem != nullptr) {
+        vSemaphoreDelete(task_exit_sem);
+    }
 }
 
 // =================================================================================================
@@ -62,79 +199,164 @@ esp_err_t WiFiManager::init_nvs()
     return err;
 }
 
-esp_err_t WiFiManager::init()
+esp_err_t WiFiManager::begin_init()
 {
     xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
-    if (state_machine.get_current_state() != State::UNINITIALIZED) {
+    State state       = state_machine.get_current_state();
+    bool stale_failed = (state == State::INITIALIZING) && async_init_failed;
+    if (state != State::UNINITIALIZED && !stale_failed) {
         xSemaphoreGiveRecursive(state_mutex);
         ESP_LOGI(TAG, "Already initialized or initializing.");
-        return ESP_OK;
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreGiveRecursive(state_mutex);
+
+    // A previous init_async() failed and nobody collected it: clean it up first
+    if (stale_failed) {
+        deinit();
+    }
+
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    if (state_machine.get_current_state() != State::UNINITIALIZED) {
+        xSemaphoreGiveRecursive(state_mutex);
+        return ESP_ERR_INVALID_STATE;
     }
     // Set to INITIALIZING to prevent concurrent init calls
     state_machine.transition_to(State::INITIALIZING);
+    async_init_failed = false;
+    init_timing       = {};
     xSemaphoreGiveRecursive(state_mutex);
+    return ESP_OK;
+}
 
-    // Global NVS init - and component storage init
+void WiFiManager::restore_retry_state()
+{
+    retry_guard.begin_boot(esp_timer_get_time());
+    boot_recorded = true;
+
+    // A reset in the middle of a backoff resumes it instead of retrying at once
+    uint32_t retries = retry_guard.get_retry_count();
+    if (retry_guard.is_crash_loop(CONFIG_WIFI_MANAGER_CRASH_LOOP_BOOTS)) {
+        uint32_t loop_retries = retry_guard.get_boot_count() - CONFIG_WIFI_MANAGER_CRASH_LOOP_BOOTS;
+        ESP_LOGW(TAG, "Boot %lu without a stable connection, backing off.",
+                 (unsigned long)retry_guard.get_boot_count());
+        if (loop_retries > retries) {
+            retries = loop_retries;
+        }
+    }
+    boot_backoff_retries = retries;
+}
+
+esp_err_t WiFiManager::bring_up()
+{
+    int64_t t_begin = esp_timer_get_time();
+    int64_t t_step  = t_begin;
+
+    // Records the elapsed time of the step that just finished
+    auto lap = [&t_step](uint32_t &slot) {
+        int64_t now = esp_timer_get_time();
+        slot        = (uint32_t)(now - t_step);
+        t_step      = now;
+    };
+
+    // 1. Global NVS init - and component storage init
     esp_err_t err = storage.init();
+    lap(init_timing.storage_us);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize Storage/NVS: %s", esp_err_to_name(err));
         return err;
     }
 
-    // 4. Global Netif init via HAL
+    // 2. Global Netif init via HAL
     err = driver_hal.init_netif();
+    lap(init_timing.netif_us);
     if (err != ESP_OK)
         return err;
 
-    // 5. Default event loop via HAL
+    // 3. Default event loop via HAL
     err = driver_hal.create_default_event_loop();
-    if (err != ESP_OK) {
-        deinit();
+    lap(init_timing.event_loop_us);
+    if (err != ESP_OK)
         return err;
-    }
 
-    // 6. Setup Station Netif via HAL
+    // 4. Setup Station Netif via HAL
     err = driver_hal.setup_sta_netif();
-    if (err != ESP_OK) {
-        deinit();
+    lap(init_timing.sta_netif_us);
+    if (err != ESP_OK)
         return err;
-    }
 
-    // 7. Initialize WiFi via HAL
+    // 5. Initialize WiFi via HAL
     err = driver_hal.init_wifi();
-    if (err != ESP_OK) {
-        deinit();
+    lap(init_timing.wifi_init_us);
+    if (err != ESP_OK)
         return err;
-    }
 
-    // 8. Set mode to STA via HAL
+    // 6. Set mode to STA via HAL
     err = driver_hal.set_mode_sta();
+    lap(init_timing.set_mode_us);
+    if (err != ESP_OK)
+        return err;
+
+    // 7. Register event handlers via HAL
+    err =
+        driver_hal.register_event_handlers(&wifi_manager::WiFiEventHandler::wifi_event_handler,
+                                           &wifi_manager::WiFiEventHandler::ip_event_handler, sync_manager.get_queue());
+    lap(init_timing.handlers_us);
+    if (err != ESP_OK)
+        return err;
+
+    // 8. Ensure driver is configured, fallback to Kconfig if necessary
+    storage.ensure_config_fallback();
+
+    // 9. Channel plan of the connect scan (a bad plan is rejected by set_channel_plan())
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    if (channel_plan_set) {
+        err = driver_hal.apply_channel_plan(channel_plan);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Channel plan not applied: %s", esp_err_to_name(err));
+        }
+    }
+    xSemaphoreGiveRecursive(state_mutex);
+    lap(init_timing.config_us);
+
+    ESP_LOGD(TAG, "Bring-up took %lu us", (unsigned long)(t_step - t_begin));
+    return ESP_OK;
+}
+
+esp_err_t WiFiManager::init()
+{
+    if (begin_init() != ESP_OK) {
+        return ESP_OK;
+    }
+    int64_t t_begin = esp_timer_get_time();
+
+    // Synchronization primitives come first: the event handlers post into the queue
+    esp_err_t err = sync_manager.init();
+    init_timing.sync_us = (uint32_t)(esp_timer_get_time() - t_begin);
     if (err != ESP_OK) {
         deinit();
         return err;
     }
 
-    // 9. Initialize synchronization primitives
-    err = sync_manager.init();
+#if CONFIG_WIFI_MANAGER_DEFERRED_LOG
+    err = start_log_task();
     if (err != ESP_OK) {
         deinit();
         return err;
     }
+#endif
 
-    // 10. Register event handlers via HAL
-    err =
-        driver_hal.register_event_handlers(&wifi_manager::WiFiEventHandler::wifi_event_handler,
-                                           &wifi_manager::WiFiEventHandler::ip_event_handler, sync_manager.get_queue());
+    err = bring_up();
     if (err != ESP_OK) {
         deinit();
         return err;
     }
 
-    // 11. Ensure driver is configured, fallback to Kconfig if necessary
-    storage.ensure_config_fallback();
-
-    // 12. Launch the consumer task that executes all driver operations
-    BaseType_t task_created = xTaskCreate(wifi_task, "wifi_task", 4096, this, 5, &task_handle);
+    // Launch the consumer task that executes all driver operations
+    int64_t t_task          = esp_timer_get_time();
+    BaseType_t task_created = xTaskCreate(wifi_task, "wifi_task", CONFIG_WIFI_MANAGER_TASK_STACK_SIZE, this,
+                                          CONFIG_WIFI_MANAGER_TASK_PRIORITY, &task_handle);
+    init_timing.task_us     = (uint32_t)(esp_timer_get_time() - t_task);
     if (task_created != pdPASS) {
         ESP_LOGE(TAG, "Failed to create wifi task");
         deinit();
@@ -142,215 +364,491 @@ esp_err_t WiFiManager::init()
     }
 
     xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    init_timing.total_us = (uint32_t)(esp_timer_get_time() - t_begin);
     state_machine.transition_to(State::INITIALIZED);
     xSemaphoreGiveRecursive(state_mutex);
     ESP_LOGI(TAG, "WiFi Manager initialized.");
     return ESP_OK;
 }
 
-esp_err_t WiFiManager::deinit()
+esp_err_t WiFiManager::init_async(bool auto_start, bool auto_connect)
 {
-    State state = get_state();
-    ESP_LOGI(TAG, "Deinitializing WiFi Manager...");
-    if (state == State::UNINITIALIZED) {
-        ESP_LOGI(TAG, "Already uninitialized.");
+    if (begin_init() != ESP_OK) {
         return ESP_OK;
     }
+    int64_t t_begin = esp_timer_get_time();
 
-    // 1. Ensure WiFi is stopped before deinitializing the stack
-    if (state_machine.is_active()) {
-        ESP_LOGI(TAG, "WiFi is running, stopping first...");
-        stop(2000);
-    }
-
-    // 2. Terminate the manager task gracefully using the EXIT command
-    if (task_handle != nullptr) {
-        ESP_LOGI(TAG, "Stopping WiFi task...");
-        Message msg = {};
-        msg.type    = MessageType::COMMAND;
-        msg.cmd     = CommandId::EXIT;
-        if (sync_manager.is_initialized() && sync_manager.post_message(msg) == ESP_OK) {
-            // Wait for the task to self-delete and nullify its handle
-            int retry = 0;
-            while (task_handle != nullptr && retry < 100) {
-                vTaskDelay(pdMS_TO_TICKS(10));
-                retry++;
-            }
-            // Small safety delay to ensure FreeRTOS has finished task cleanup
-            if (task_handle == nullptr) {
-                vTaskDelay(pdMS_TO_TICKS(50));
-            }
-        }
-
-        // Forced deletion if graceful exit fails
-        if (task_handle != nullptr) {
-            ESP_LOGW(TAG, "WiFi task did not exit gracefully, deleting...");
-            vTaskDelete(task_handle);
-            task_handle = nullptr;
-        }
-        ESP_LOGI(TAG, "WiFi task terminated.");
+    esp_err_t err = sync_manager.init();
+    init_timing.sync_us = (uint32_t)(esp_timer_get_time() - t_begin);
+    if (err != ESP_OK) {
+        deinit();
+        return err;
     }
+    sync_manager.clear_bits(wifi_manager::INIT_DONE_BIT | wifi_manager::INIT_FAILED_BIT);
 
-    // 3. Deinit the driver stack via HAL
-    esp_err_t ret = driver_hal.deinit();
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "WiFi stack deinitialized.");
+#if CONFIG_WIFI_MANAGER_DEFERRED_LOG
+    err = start_log_task();
+    if (err != ESP_OK) {
+        deinit();
+        return err;
     }
+#endif
 
-    // 4. Unregister event handlers via HAL
-    driver_hal.unregister_event_handlers();
-
-    // 5. Clean up internal RTOS synchronization objects
-    sync_manager.deinit();
+    // The task runs the bring-up itself, then optionally chains into START/CONNECT
+    async_init_pending   = true;
+    auto_start_pending   = auto_start || auto_connect;
+    auto_connect_pending = auto_connect;
 
-    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
-    state_machine.transition_to(State::UNINITIALIZED);
-    xSemaphoreGiveRecursive(state_mutex);
+    int64_t t_task          = esp_timer_get_time();
+    BaseType_t task_created = xTaskCreate(wifi_task, "wifi_task", CONFIG_WIFI_MANAGER_TASK_STACK_SIZE, this,
+                                          CONFIG_WIFI_MANAGER_TASK_PRIORITY, &task_handle);
+    init_timing.task_us     = (uint32_t)(esp_timer_get_time() - t_task);
+    if (task_created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create wifi task");
+        async_init_pending   = false;
+        auto_start_pending   = false;
+        auto_connect_pending = false;
+        deinit();
+        return ESP_ERR_NO_MEM;
+    }
 
-    ESP_LOGI(TAG, "WiFi Manager deinitialized.");
+    ESP_LOGI(TAG, "WiFi Manager initializing in background...");
     return ESP_OK;
 }
 
-esp_err_t WiFiManager::start(uint32_t timeout_ms)
+esp_err_t WiFiManager::wait_for_init(uint32_t timeout_ms, CancellationToken *token)
 {
-    if (!sync_manager.is_initialized()) {
-        return ESP_ERR_INVALID_STATE;
-    }
-
-    Action action = state_machine.validate_command(CommandId::START);
-
-    if (action == Action::ERROR) {
+    State state = get_state();
+    if (state == State::UNINITIALIZED) {
         return ESP_ERR_INVALID_STATE;
     }
-    if (action == Action::SKIP) {
+    if (state != State::INITIALIZING) {
         return ESP_OK;
     }
 
-    ESP_LOGD(TAG, "API: Requesting to start WiFi (sync)...");
-    Message msg = {};
-    msg.type    = MessageType::COMMAND;
-    msg.cmd     = CommandId::START;
-
-    sync_manager.clear_bits(wifi_manager::STARTED_BIT | wifi_manager::START_FAILED_BIT |
-                            wifi_manager::INVALID_STATE_BIT);
-    esp_err_t err = post_message(msg, false);
-    if (err != ESP_OK) {
-        return err;
-    }
-
-    // Wait for the Task to set the success or failure bit
-    uint32_t bits = sync_manager.wait_for_bits(
-        wifi_manager::STARTED_BIT | wifi_manager::START_FAILED_BIT | wifi_manager::INVALID_STATE_BIT, timeout_ms);
+    uint32_t bits = wait_for_result(wifi_manager::INIT_DONE_BIT | wifi_manager::INIT_FAILED_BIT, timeout_ms, token);
 
-    if (bits & wifi_manager::INVALID_STATE_BIT) {
-        return ESP_ERR_INVALID_STATE;
+    if (bits == wifi_manager::CANCEL_BIT) {
+        return wifi_manager::ERR_CANCELLED;
     }
-    if (bits & wifi_manager::STARTED_BIT) {
+    if (bits & wifi_manager::INIT_DONE_BIT) {
         return ESP_OK;
     }
-    if (bits & wifi_manager::START_FAILED_BIT) {
-        return ESP_FAIL;
+    if (bits & wifi_manager::INIT_FAILED_BIT) {
+        esp_err_t err = async_init_error;
+        deinit();
+        return err;
     }
-
-    // Rollback: if we timed out waiting for the driver, try to stop it to reset state
-    ESP_LOGW(TAG, "Start timed out, cancelling...");
-    stop();
     return ESP_ERR_TIMEOUT;
 }
 
-esp_err_t WiFiManager::start()
+wifi_manager::LatencyStats WiFiManager::get_event_latency() const
 {
-    if (!sync_manager.is_initialized()) {
-        return ESP_ERR_INVALID_STATE;
-    }
-
-    Action action = state_machine.validate_command(CommandId::START);
-
-    if (action == Action::ERROR) {
-        return ESP_ERR_INVALID_STATE;
-    }
-    if (action == Action::SKIP) {
-        return ESP_OK;
-    }
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    wifi_manager::LatencyStats stats = metrics.dwell[(int)MessageType::EVENT];
+    xSemaphoreGiveRecursive(state_mutex);
+    return stats;
+}
 
-    ESP_LOGD(TAG, "API: Requesting to start WiFi (async)...");
-    Message msg = {};
-    msg.type    = MessageType::COMMAND;
-    msg.cmd     = CommandId::START;
-    return post_message(msg, true);
+wifi_manager::DispatchMetrics WiFiManager::get_metrics() const
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    wifi_manager::DispatchMetrics snapshot = metrics;
+    xSemaphoreGiveRecursive(state_mutex);
+    return snapshot;
 }
 
-esp_err_t WiFiManager::stop(uint32_t timeout_ms)
+esp_err_t WiFiManager::set_twt_config(const wifi_manager::TwtConfig &twt)
 {
-    if (!sync_manager.is_initialized()) {
-        return ESP_ERR_INVALID_STATE;
+    if (!twt.is_valid()) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    Action action = state_machine.validate_command(CommandId::STOP);
-
-    if (action == Action::ERROR) {
-        return ESP_ERR_INVALID_STATE;
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    wifi_manager::TwtState previous = state_machine.get_twt_state();
+    if (previous == wifi_manager::TwtState::ACTIVE || previous == wifi_manager::TwtState::PENDING) {
+        driver_hal.teardown_twt();
     }
-    if (action == Action::SKIP) {
-        return ESP_OK;
+    twt_config = twt;
+    state_machine.reset_twt();
+    if (state_machine.get_current_state() == State::CONNECTED_GOT_IP) {
+        request_twt();
     }
+    xSemaphoreGiveRecursive(state_mutex);
+    return ESP_OK;
+}
 
-    ESP_LOGI(TAG, "API: Requesting to stop WiFi (sync)...");
-    Message msg = {};
-    msg.type    = MessageType::COMMAND;
-    msg.cmd     = CommandId::STOP;
+wifi_manager::TwtStatus WiFiManager::get_twt_status() const
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    wifi_manager::TwtConfig::Encoding enc = twt_config.encode();
+    wifi_manager::TwtStatus status        = {};
+    status.state                          = state_machine.get_twt_state();
+    status.wake_interval_us               = enc.interval_us();
+    status.wake_duration_us               = enc.duration_us();
+    status.duty_cycle_ppm                 = 1000000;
+    if (status.state == wifi_manager::TwtState::ACTIVE) {
+        status.duty_cycle_ppm = (uint32_t)((uint64_t)status.wake_duration_us * 1000000 / status.wake_interval_us);
+    }
+    status.setups         = state_machine.get_twt_setups();
+    status.renegotiations = state_machine.get_twt_renegotiations();
+    xSemaphoreGiveRecursive(state_mutex);
+    return status;
+}
 
-    sync_manager.clear_bits(wifi_manager::STOPPED_BIT | wifi_manager::STOP_FAILED_BIT |
-                            wifi_manager::INVALID_STATE_BIT);
-    esp_err_t err = post_message(msg, false);
-    if (err != ESP_OK) {
-        return err;
+esp_err_t WiFiManager::set_tx_power_control(bool enabled,
+                                            const wifi_manager::WiFiTxPowerController::Config *config)
+{
+    if (config != nullptr && !wifi_manager::WiFiTxPowerController::is_valid(*config)) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    uint32_t bits = sync_manager.wait_for_bits(
-        wifi_manager::STOPPED_BIT | wifi_manager::STOP_FAILED_BIT | wifi_manager::INVALID_STATE_BIT, timeout_ms);
-
-    if (bits & wifi_manager::INVALID_STATE_BIT) {
-        return ESP_ERR_INVALID_STATE;
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    if (config != nullptr) {
+        tx_power = wifi_manager::WiFiTxPowerController(*config);
     }
-    if (bits & wifi_manager::STOPPED_BIT) {
-        return ESP_OK;
+    else {
+        tx_power.on_link_failure();
     }
-    if (bits & wifi_manager::STOP_FAILED_BIT) {
-        return ESP_FAIL;
+    tx_power_control = enabled;
+    if (enabled) {
+        apply_tx_power();
     }
-    return ESP_ERR_TIMEOUT;
+    else if (state_machine.is_sta_ready()) {
+        // Not the controller's full power: whatever limit the driver ran with before the first change
+        esp_err_t err = driver_hal.restore_max_tx_power();
+        if (err != ESP_OK) {
+            log_event<LogId::TX_POWER_FAILED>(err);
+        }
+    }
+    xSemaphoreGiveRecursive(state_mutex);
+    return ESP_OK;
 }
 
-esp_err_t WiFiManager::stop()
+wifi_manager::TxPowerStatus WiFiManager::get_tx_power_status() const
 {
-    if (!sync_manager.is_initialized()) {
-        return ESP_ERR_INVALID_STATE;
-    }
-
-    Action action = state_machine.validate_command(CommandId::STOP);
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    wifi_manager::TxPowerStatus status = {};
+    status.enabled                     = tx_power_control;
+    status.power                       = tx_power.get_power();
+    status.last_rssi                   = last_rssi;
+    status.decreases                   = tx_power.get_decreases();
+    status.increases                   = tx_power.get_increases();
+    xSemaphoreGiveRecursive(state_mutex);
+    return status;
+}
 
-    if (action == Action::ERROR) {
-        return ESP_ERR_INVALID_STATE;
-    }
-    if (action == Action::SKIP) {
-        return ESP_OK;
+esp_err_t WiFiManager::set_roam_config(const wifi_manager::RoamConfig &config)
+{
+    if (!config.is_valid()) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGD(TAG, "API: Requesting to stop WiFi (async)...");
-    Message msg = {};
-    msg.type    = MessageType::COMMAND;
-    msg.cmd     = CommandId::STOP;
-    return post_message(msg, true);
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    // A roam in progress completes; ft_enabled follows at the next association
+    roam_policy.set_config(config);
+    xSemaphoreGiveRecursive(state_mutex);
+    return ESP_OK;
 }
 
-esp_err_t WiFiManager::connect(uint32_t timeout_ms)
+wifi_manager::RoamStatus WiFiManager::get_roam_status() const
 {
-    if (!sync_manager.is_initialized()) {
-        return ESP_ERR_INVALID_STATE;
-    }
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    wifi_manager::RoamStatus status = roam_policy.get_status();
+    xSemaphoreGiveRecursive(state_mutex);
+    return status;
+}
 
-    Action action = state_machine.validate_command(CommandId::CONNECT);
+esp_err_t WiFiManager::set_channel_lock(uint8_t channel)
+{
+    if (channel > 177) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    // An announced roam checks the lock again when its notice expires
+    channel_lock = channel;
+    roam_policy.set_channel_lock(channel);
+    xSemaphoreGiveRecursive(state_mutex);
+    return ESP_OK;
+}
+
+void WiFiManager::set_channel_listener(wifi_manager::ChannelListener listener, void *arg)
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    channel_listener     = listener;
+    channel_listener_arg = arg;
+    xSemaphoreGiveRecursive(state_mutex);
+}
+
+uint8_t WiFiManager::get_channel() const
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    uint8_t channel = sta_channel;
+    xSemaphoreGiveRecursive(state_mutex);
+    return channel;
+}
+
+esp_err_t WiFiManager::add_uplink(esp_netif_t *netif, uint8_t priority)
+{
+    if (netif == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    esp_netif_t *sta = driver_hal.get_sta_netif();
+    if (sta == nullptr || !sync_manager.is_initialized()) {
+        xSemaphoreGiveRecursive(state_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // The STA is always an uplink; its readiness follows the state
+    if (wifi_uplink == wifi_manager::WiFiUplinkArbiter::NONE) {
+        wifi_uplink                = uplinks.add(CONFIG_WIFI_MANAGER_UPLINK_WIFI_PRIORITY);
+        uplink_netifs[wifi_uplink] = sta;
+    }
+
+    esp_err_t err = ESP_OK;
+    int8_t slot   = find_uplink(netif);
+    if (slot != wifi_manager::WiFiUplinkArbiter::NONE) {
+        uplinks.set_priority(slot, priority);
+    }
+    else if ((slot = uplinks.add(priority)) != wifi_manager::WiFiUplinkArbiter::NONE) {
+        uplink_netifs[slot] = netif;
+        uplinks.set_ready(slot, driver_hal.netif_has_ip(netif), (uint32_t)esp_timer_get_time());
+    }
+    else {
+        err = ESP_ERR_NO_MEM;
+    }
+    xSemaphoreGiveRecursive(state_mutex);
+
+    if (err == ESP_OK) {
+        // wifi_task arbitrates (and plans the failback hold) after any message; a full
+        // queue already guarantees one
+        Message msg = {};
+        msg.type    = MessageType::EVENT;
+        msg.event   = EventId::UPLINK_UP;
+        post_message(msg, true);
+    }
+    return err;
+}
+
+esp_err_t WiFiManager::set_uplink_health(esp_netif_t *netif, bool healthy)
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    int8_t slot = find_uplink(netif);
+    if (slot == wifi_manager::WiFiUplinkArbiter::NONE) {
+        xSemaphoreGiveRecursive(state_mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    uplinks.set_healthy(slot, healthy, (uint32_t)esp_timer_get_time());
+    xSemaphoreGiveRecursive(state_mutex);
+
+    // Same as add_uplink(): the failover runs in wifi_task, timed from this post
+    Message msg = {};
+    msg.type    = MessageType::EVENT;
+    msg.event   = healthy ? EventId::UPLINK_UP : EventId::UPLINK_DOWN;
+    post_message(msg, true);
+    return ESP_OK;
+}
+
+esp_netif_t *WiFiManager::get_active_uplink() const
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    int8_t active      = uplinks.get_active();
+    esp_netif_t *netif = active != wifi_manager::WiFiUplinkArbiter::NONE ? uplink_netifs[active] : nullptr;
+    xSemaphoreGiveRecursive(state_mutex);
+    return netif;
+}
+
+wifi_manager::UplinkStatus WiFiManager::get_uplink_status() const
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    wifi_manager::UplinkStatus status = uplinks.get_status();
+    xSemaphoreGiveRecursive(state_mutex);
+    return status;
+}
+
+wifi_manager::LatencyStats WiFiManager::get_association_latency() const
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    wifi_manager::LatencyStats stats = metrics.association;
+    xSemaphoreGiveRecursive(state_mutex);
+    return stats;
+}
+
+void WiFiManager::reset_metrics()
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    metrics = {};
+    xSemaphoreGiveRecursive(state_mutex);
+}
+
+#if CONFIG_WIFI_MANAGER_DEFERRED_LOG
+wifi_manager::LogRingStats WiFiManager::get_log_stats() const
+{
+    return log_ring.stats();
+}
+#endif
+
+WiFiManager::InitTiming WiFiManager::get_init_timing() const
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    InitTiming timing = init_timing;
+    xSemaphoreGiveRecursive(state_mutex);
+    return timing;
+}
+
+void WiFiManager::run_async_init()
+{
+    int64_t t_begin = esp_timer_get_time();
+    esp_err_t err   = bring_up();
+
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    async_init_pending   = false;
+    init_timing.total_us = init_timing.sync_us + init_timing.task_us + (uint32_t)(esp_timer_get_time() - t_begin);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Background init failed: %s", esp_err_to_name(err));
+        // Stay in INITIALIZING: deinit() (or wait_for_init()) releases everything
+        async_init_error     = err;
+        async_init_failed    = true;
+        auto_start_pending   = false;
+        auto_connect_pending = false;
+        xSemaphoreGiveRecursive(state_mutex);
+        sync_manager.set_bits(wifi_manager::INIT_FAILED_BIT);
+        return;
+    }
+
+    state_machine.transition_to(State::INITIALIZED);
+    sync_manager.set_bits(wifi_manager::INIT_DONE_BIT);
+    ESP_LOGI(TAG, "WiFi Manager initialized (background).");
+
+    if (auto_start_pending) {
+        auto_start_pending = false;
+        Message msg        = {};
+        msg.type           = MessageType::COMMAND;
+        msg.cmd            = CommandId::START;
+        process_message(msg, State::INITIALIZED);
+    }
+    xSemaphoreGiveRecursive(state_mutex);
+}
+
+esp_err_t WiFiManager::deinit()
+{
+    State state = get_state();
+    ESP_LOGI(TAG, "Deinitializing WiFi Manager...");
+    if (state == State::UNINITIALIZED) {
+        ESP_LOGI(TAG, "Already uninitialized.");
+        return ESP_OK;
+    }
+
+    // 1. Ensure WiFi is stopped before deinitializing the stack
+    if (state_machine.is_active()) {
+        ESP_LOGI(TAG, "WiFi is running, stopping first...");
+        // The asynchronous stop() plus our own wait: deinit() is built without the sync API too
+        uint32_t done_bits =
+            wifi_manager::STOPPED_BIT | wifi_manager::STOP_FAILED_BIT | wifi_manager::INVALID_STATE_BIT;
+        sync_manager.clear_bits(done_bits);
+        if (stop() == ESP_OK) {
+            sync_manager.wait_for_bits(done_bits, DEINIT_STOP_TIMEOUT_MS);
+        }
+    }
+
+    // 2. Terminate the manager task gracefully using the EXIT command
+    if (task_handle != nullptr) {
+        // A background init cannot be interrupted mid-way; let it finish first
+        if (state == State::INITIALIZING && async_init_pending) {
+            sync_manager.wait_for_bits(wifi_manager::INIT_DONE_BIT | wifi_manager::INIT_FAILED_BIT,
+                                       ASYNC_INIT_TIMEOUT_MS);
+        }
+
+        ESP_LOGI(TAG, "Stopping WiFi task...");
+        Message msg = {};
+        msg.type    = MessageType::COMMAND;
+        msg.cmd     = CommandId::EXIT;
+
+        // The task gives task_exit_sem right before deleting itself, so we join on it instead
+        // of polling the handle; the caller's own task notification stays untouched. Drop a
+        // give left over from a join that timed out first.
+        xSemaphoreTake(task_exit_sem, 0);
+
+        if (sync_manager.is_initialized() && sync_manager.post_message(msg) == ESP_OK) {
+            xSemaphoreTake(task_exit_sem, pdMS_TO_TICKS(TASK_EXIT_TIMEOUT_MS));
+        }
+
+        // Forced deletion if graceful exit fails
+        if (task_handle != nullptr) {
+            ESP_LOGW(TAG, "WiFi task did not exit gracefully, deleting...");
+            vTaskDelete(task_handle);
+            task_handle = nullptr;
+        }
+        ESP_LOGI(TAG, "WiFi task terminated.");
+    }
+
+#if CONFIG_WIFI_MANAGER_DEFERRED_LOG
+    // 3. Stop the log task once it has drained what wifi_task wrote; the next init starts it again
+    if (log_task_handle != nullptr) {
+        xSemaphoreTake(task_exit_sem, 0);
+        log_task_exit = true;
+        xTaskNotifyGive(log_task_handle);
+        xSemaphoreTake(task_exit_sem, pdMS_TO_TICKS(TASK_EXIT_TIMEOUT_MS));
+
+        if (log_task_handle != nullptr) {
+            vTaskDelete(log_task_handle);
+            log_task_handle = nullptr;
+        }
+    }
+#endif
+
+    // 4. Deinit the driver stack via HAL (the STA netif is kept for the next init)
+    esp_err_t ret = driver_hal.deinit();
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "WiFi stack deinitialized.");
+    }
+
+    // 5. Unregister event handlers via HAL
+    driver_hal.unregister_event_handlers();
+
+    // 6. Clean up internal RTOS synchronization objects
+    sync_manager.deinit();
+
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    state_machine.transition_to(State::UNINITIALIZED);
+    async_init_pending   = false;
+    async_init_failed    = false;
+    auto_start_pending   = false;
+    auto_connect_pending = false;
+#if CONFIG_WIFI_MANAGER_SYNC_API
+    txn_busy      = false;
+    txn_done      = false;
+    txn_abandoned = false;
+#endif
+    disconnect_echoes   = 0;
+    eap_configured      = false; // The supplicant went with the driver
+    eap_session_cached  = false;
+    sta_channel         = 0; // The next association is announced afresh
+    notified_channel    = 0;
+    notified_pending    = false;
+    roam_notice_pending = false;
+    timers.cancel_all();
+    // Nothing tracks the netif events any more
+    uplinks.clear();
+    wifi_uplink = wifi_manager::WiFiUplinkArbiter::NONE;
+    xSemaphoreGiveRecursive(state_mutex);
+
+    ESP_LOGI(TAG, "WiFi Manager deinitialized.");
+    return ESP_OK;
+}
+
+#if CONFIG_WIFI_MANAGER_SYNC_API
+esp_err_t WiFiManager::start(uint32_t timeout_ms, CancellationToken *token)
+{
+    if (!sync_manager.is_initialized()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    Action action = state_machine.validate_command(CommandId::START);
 
     if (action == Action::ERROR) {
         return ESP_ERR_INVALID_STATE;
@@ -359,46 +857,60 @@ esp_err_t WiFiManager::connect(uint32_t timeout_ms)
         return ESP_OK;
     }
 
-    ESP_LOGD(TAG, "API: Requesting to connect (sync)...");
+    if (token != nullptr && token->is_cancelled()) {
+        return wifi_manager::ERR_CANCELLED;
+    }
+
+    ESP_LOGD(TAG, "API: Requesting to start WiFi (sync)...");
     Message msg = {};
     msg.type    = MessageType::COMMAND;
-    msg.cmd     = CommandId::CONNECT;
+    msg.cmd     = CommandId::START;
 
-    sync_manager.clear_bits(wifi_manager::CONNECTED_BIT | wifi_manager::CONNECT_FAILED_BIT |
-                            wifi_manager::INVALID_STATE_BIT);
+    sync_manager.clear_bits(wifi_manager::STARTED_BIT | wifi_manager::START_FAILED_BIT |
+                            wifi_manager::INVALID_STATE_BIT | wifi_manager::START_SUPERSEDED_BIT);
     esp_err_t err = post_message(msg, false);
     if (err != ESP_OK) {
         return err;
     }
 
-    // Wait for either the GOT_IP event (SUCCESS) or a DISCONNECT/ERROR event (FAIL)
-    uint32_t bits = sync_manager.wait_for_bits(
-        wifi_manager::CONNECTED_BIT | wifi_manager::CONNECT_FAILED_BIT | wifi_manager::INVALID_STATE_BIT, timeout_ms);
+    // Wait for the Task to set the success or failure bit
+    uint32_t bits = wait_for_result(wifi_manager::STARTED_BIT | wifi_manager::START_FAILED_BIT |
+                                        wifi_manager::INVALID_STATE_BIT | wifi_manager::START_SUPERSEDED_BIT,
+                                    timeout_ms, token);
 
+    if (bits == wifi_manager::CANCEL_BIT) {
+        ESP_LOGW(TAG, "Start cancelled, aborting...");
+        post_cancel(CommandId::START);
+        return wifi_manager::ERR_CANCELLED;
+    }
     if (bits & wifi_manager::INVALID_STATE_BIT) {
         return ESP_ERR_INVALID_STATE;
     }
-    if (bits & wifi_manager::CONNECTED_BIT) {
+    if (bits & wifi_manager::START_SUPERSEDED_BIT) {
+        // A STOP queued behind us won: nothing to roll back
+        return wifi_manager::ERR_SUPERSEDED;
+    }
+    if (bits & wifi_manager::STARTED_BIT) {
         return ESP_OK;
     }
-    else if (bits & wifi_manager::CONNECT_FAILED_BIT) {
+    if (bits & wifi_manager::START_FAILED_BIT) {
         return ESP_FAIL;
     }
-    else {
-        // Rollback: if timeout occurs, cancel the driver connection attempt
-        ESP_LOGW(TAG, "Connect timed out, cancelling attempt...");
-        disconnect();
-        return ESP_ERR_TIMEOUT;
-    }
+
+    // Rollback: if we timed out waiting for the driver, try to stop it to reset state
+    ESP_LOGW(TAG, "Start timed out, cancelling...");
+    stop();
+    return ESP_ERR_TIMEOUT;
 }
+#endif
 
-esp_err_t WiFiManager::connect()
+esp_err_t WiFiManager::start()
 {
     if (!sync_manager.is_initialized()) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    Action action = state_machine.validate_command(CommandId::CONNECT);
+    Action action = state_machine.validate_command(CommandId::START);
 
     if (action == Action::ERROR) {
         return ESP_ERR_INVALID_STATE;
@@ -407,20 +919,21 @@ esp_err_t WiFiManager::connect()
         return ESP_OK;
     }
 
-    ESP_LOGD(TAG, "API: Requesting to connect (async)...");
+    ESP_LOGD(TAG, "API: Requesting to start WiFi (async)...");
     Message msg = {};
     msg.type    = MessageType::COMMAND;
-    msg.cmd     = CommandId::CONNECT;
+    msg.cmd     = CommandId::START;
     return post_message(msg, true);
 }
 
-esp_err_t WiFiManager::disconnect(uint32_t timeout_ms)
+#if CONFIG_WIFI_MANAGER_SYNC_API
+esp_err_t WiFiManager::stop(uint32_t timeout_ms, CancellationToken *token)
 {
     if (!sync_manager.is_initialized()) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    Action action = state_machine.validate_command(CommandId::DISCONNECT);
+    Action action = state_machine.validate_command(CommandId::STOP);
 
     if (action == Action::ERROR) {
         return ESP_ERR_INVALID_STATE;
@@ -429,41 +942,49 @@ esp_err_t WiFiManager::disconnect(uint32_t timeout_ms)
         return ESP_OK;
     }
 
-    ESP_LOGD(TAG, "API: Requesting to disconnect (sync)...");
+    if (token != nullptr && token->is_cancelled()) {
+        return wifi_manager::ERR_CANCELLED;
+    }
+
+    ESP_LOGI(TAG, "API: Requesting to stop WiFi (sync)...");
     Message msg = {};
     msg.type    = MessageType::COMMAND;
-    msg.cmd     = CommandId::DISCONNECT;
+    msg.cmd     = CommandId::STOP;
 
-    sync_manager.clear_bits(wifi_manager::DISCONNECTED_BIT | wifi_manager::CONNECT_FAILED_BIT |
+    sync_manager.clear_bits(wifi_manager::STOPPED_BIT | wifi_manager::STOP_FAILED_BIT |
                             wifi_manager::INVALID_STATE_BIT);
     esp_err_t err = post_message(msg, false);
     if (err != ESP_OK) {
         return err;
     }
 
-    uint32_t bits = sync_manager.wait_for_bits(wifi_manager::DISCONNECTED_BIT | wifi_manager::CONNECT_FAILED_BIT |
-                                                   wifi_manager::INVALID_STATE_BIT,
-                                               timeout_ms);
+    uint32_t bits = wait_for_result(
+        wifi_manager::STOPPED_BIT | wifi_manager::STOP_FAILED_BIT | wifi_manager::INVALID_STATE_BIT, timeout_ms, token);
 
+    if (bits == wifi_manager::CANCEL_BIT) {
+        // A driver stop cannot be aborted: only the wait is abandoned
+        return wifi_manager::ERR_CANCELLED;
+    }
     if (bits & wifi_manager::INVALID_STATE_BIT) {
         return ESP_ERR_INVALID_STATE;
     }
-    if (bits & wifi_manager::DISCONNECTED_BIT) {
+    if (bits & wifi_manager::STOPPED_BIT) {
         return ESP_OK;
     }
-    if (bits & wifi_manager::CONNECT_FAILED_BIT) {
+    if (bits & wifi_manager::STOP_FAILED_BIT) {
         return ESP_FAIL;
     }
     return ESP_ERR_TIMEOUT;
 }
+#endif
 
-esp_err_t WiFiManager::disconnect()
+esp_err_t WiFiManager::stop()
 {
     if (!sync_manager.is_initialized()) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    Action action = state_machine.validate_command(CommandId::DISCONNECT);
+    Action action = state_machine.validate_command(CommandId::STOP);
 
     if (action == Action::ERROR) {
         return ESP_ERR_INVALID_STATE;
@@ -472,351 +993,1904 @@ esp_err_t WiFiManager::disconnect()
         return ESP_OK;
     }
 
-    ESP_LOGD(TAG, "API: Requesting to disconnect (async)...");
+    ESP_LOGD(TAG, "API: Requesting to stop WiFi (async)...");
     Message msg = {};
     msg.type    = MessageType::COMMAND;
-    msg.cmd     = CommandId::DISCONNECT;
+    msg.cmd     = CommandId::STOP;
     return post_message(msg, true);
 }
 
-WiFiManager::State WiFiManager::get_state() const
+#if CONFIG_WIFI_MANAGER_SYNC_API
+esp_err_t WiFiManager::connect(uint32_t timeout_ms, CancellationToken *token)
 {
-    // The Mutex ensures that we don't read the state while the Task is mid-transition
-    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
-    State state = state_machine.get_current_state();
-    xSemaphoreGiveRecursive(state_mutex);
-    return state;
-}
+    if (!sync_manager.is_initialized()) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
-// =================================================================================================
-// Credentials and Reset
-// =================================================================================================
+    Action action = state_machine.validate_command(CommandId::CONNECT);
 
-esp_err_t WiFiManager::set_credentials(const std::string &ssid, const std::string &password)
-{
-    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
-    if (state_machine.get_current_state() == State::UNINITIALIZED) {
-        xSemaphoreGiveRecursive(state_mutex);
+    if (action == Action::ERROR) {
         return ESP_ERR_INVALID_STATE;
     }
+    if (action == Action::SKIP) {
+        return ESP_OK;
+    }
 
-    ESP_LOGI(TAG, "API: Setting credentials...");
-
-    // If we are currently active, we must stop the current connection first
-    if (state_machine.is_active()) {
-        ESP_LOGI(TAG, "Disconnecting before applying new credentials...");
-        driver_hal.disconnect();
+    if (token != nullptr && token->is_cancelled()) {
+        return wifi_manager::ERR_CANCELLED;
     }
 
-    esp_err_t err = storage.save_credentials(ssid, password);
-    if (err == ESP_OK) {
-        state_machine.reset_retries();
+    ESP_LOGD(TAG, "API: Requesting to connect (sync)...");
+    Message msg = {};
+    msg.type    = MessageType::COMMAND;
+    msg.cmd     = CommandId::CONNECT;
 
-        // Apply credentials to the driver via HAL
-        wifi_config_t cfg;
+    sync_manager.clear_bits(wifi_manager::CONNECTED_BIT | wifi_manager::CONNECT_FAILED_BIT |
+                            wifi_manager::INVALID_STATE_BIT | wifi_manager::CONNECT_SUPERSEDED_BIT);
+    esp_err_t err = post_message(msg, false);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Wait for either the GOT_IP event (SUCCESS) or a DISCONNECT/ERROR event (FAIL)
+    uint32_t bits = wait_for_result(wifi_manager::CONNECTED_BIT | wifi_manager::CONNECT_FAILED_BIT |
+                                        wifi_manager::INVALID_STATE_BIT | wifi_manager::CONNECT_SUPERSEDED_BIT,
+                                    timeout_ms, token);
+
+    if (bits == wifi_manager::CANCEL_BIT) {
+        ESP_LOGW(TAG, "Connect cancelled, aborting attempt...");
+        post_cancel(CommandId::CONNECT);
+        return wifi_manager::ERR_CANCELLED;
+    }
+    if (bits & wifi_manager::INVALID_STATE_BIT) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (bits & wifi_manager::CONNECT_SUPERSEDED_BIT) {
+        return wifi_manager::ERR_SUPERSEDED;
+    }
+    if (bits & wifi_manager::CONNECTED_BIT) {
+        return ESP_OK;
+    }
+    else if (bits & wifi_manager::CONNECT_FAILED_BIT) {
+        return ESP_FAIL;
+    }
+    else {
+        // Rollback: if timeout occurs, cancel the driver connection attempt
+        ESP_LOGW(TAG, "Connect timed out, cancelling attempt...");
+        disconnect();
+        return ESP_ERR_TIMEOUT;
+    }
+}
+#endif
+
+esp_err_t WiFiManager::connect()
+{
+    if (!sync_manager.is_initialized()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    Action action = state_machine.validate_command(CommandId::CONNECT);
+
+    if (action == Action::ERROR) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (action == Action::SKIP) {
+        return ESP_OK;
+    }
+
+    ESP_LOGD(TAG, "API: Requesting to connect (async)...");
+    Message msg = {};
+    msg.type    = MessageType::COMMAND;
+    msg.cmd     = CommandId::CONNECT;
+    return post_message(msg, true);
+}
+
+#if CONFIG_WIFI_MANAGER_SYNC_API
+esp_err_t WiFiManager::disconnect(uint32_t timeout_ms, CancellationToken *token)
+{
+    if (!sync_manager.is_initialized()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    Action action = state_machine.validate_command(CommandId::DISCONNECT);
+
+    if (action == Action::ERROR) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (action == Action::SKIP) {
+        return ESP_OK;
+    }
+
+    if (token != nullptr && token->is_cancelled()) {
+        return wifi_manager::ERR_CANCELLED;
+    }
+
+    ESP_LOGD(TAG, "API: Requesting to disconnect (sync)...");
+    Message msg = {};
+    msg.type    = MessageType::COMMAND;
+    msg.cmd     = CommandId::DISCONNECT;
+
+    sync_manager.clear_bits(wifi_manager::DISCONNECTED_BIT | wifi_manager::CONNECT_FAILED_BIT |
+                            wifi_manager::INVALID_STATE_BIT | wifi_manager::DISCONNECT_SUPERSEDED_BIT);
+    esp_err_t err = post_message(msg, false);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint32_t bits = wait_for_result(wifi_manager::DISCONNECTED_BIT | wifi_manager::CONNECT_FAILED_BIT |
+                                        wifi_manager::INVALID_STATE_BIT | wifi_manager::DISCONNECT_SUPERSEDED_BIT,
+                                    timeout_ms, token);
+
+    if (bits == wifi_manager::CANCEL_BIT) {
+        return wifi_manager::ERR_CANCELLED;
+    }
+    if (bits & wifi_manager::INVALID_STATE_BIT) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (bits & wifi_manager::DISCONNECT_SUPERSEDED_BIT) {
+        return wifi_manager::ERR_SUPERSEDED;
+    }
+    if (bits & wifi_manager::DISCONNECTED_BIT) {
+        return ESP_OK;
+    }
+    if (bits & wifi_manager::CONNECT_FAILED_BIT) {
+        return ESP_FAIL;
+    }
+    return ESP_ERR_TIMEOUT;
+}
+#endif
+
+esp_err_t WiFiManager::disconnect()
+{
+    if (!sync_manager.is_initialized()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    Action action = state_machine.validate_command(CommandId::DISCONNECT);
+
+    if (action == Action::ERROR) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (action == Action::SKIP) {
+        return ESP_OK;
+    }
+
+    ESP_LOGD(TAG, "API: Requesting to disconnect (async)...");
+    Message msg = {};
+    msg.type    = MessageType::COMMAND;
+    msg.cmd     = CommandId::DISCONNECT;
+    return post_message(msg, true);
+}
+
+void WiFiManager::CancellationToken::cancel()
+{
+    m_cancelled.store(true);
+    // Wake the task waiting on this token. Aborting its block fails while it is between its
+    // flag check and the block, so retry until it has either blocked or left the wait.
+    TaskHandle_t waiter;
+    while ((waiter = m_waiter.load()) != nullptr && xTaskAbortDelay(waiter) != pdPASS) {
+        vTaskDelay(1);
+    }
+}
+
+#if CONFIG_WIFI_MANAGER_SYNC_API
+esp_err_t WiFiManager::Transaction::add(Step step)
+{
+    if (count >= MAX_STEPS) {
+        return ESP_ERR_NO_MEM;
+    }
+    steps[count]   = step;
+    results[count] = ESP_ERR_NOT_FINISHED;
+    count++;
+    return ESP_OK;
+}
+
+esp_err_t WiFiManager::Transaction::add_credentials(const char *new_ssid, const char *new_password, bool new_hidden)
+{
+    if (new_ssid == nullptr || new_password == nullptr || strnlen(new_ssid, sizeof(ssid)) >= sizeof(ssid) ||
+        strnlen(new_password, sizeof(password)) >= sizeof(password)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = add(Step::SET_CREDENTIALS);
+    if (err != ESP_OK) {
+        return err;
+    }
+    strncpy(ssid, new_ssid, sizeof(ssid));
+    strncpy(password, new_password, sizeof(password));
+    hidden = new_hidden;
+    return ESP_OK;
+}
+
+esp_err_t WiFiManager::run_transaction(Transaction &txn, uint32_t timeout_ms, CancellationToken *token)
+{
+    if (!sync_manager.is_initialized()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (txn.count == 0 || txn.count > Transaction::MAX_STEPS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (token != nullptr && token->is_cancelled()) {
+        return wifi_manager::ERR_CANCELLED;
+    }
+
+    // Claim the single transaction slot
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    if (txn_busy) {
+        xSemaphoreGiveRecursive(state_mutex);
+        ESP_LOGW(TAG, "Another transaction is running");
+        return ESP_ERR_INVALID_STATE;
+    }
+    txn_slot        = txn;
+    txn_deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    txn_busy        = true;
+    txn_done        = false;
+    txn_abandoned   = false;
+    txn_cancelled   = false;
+    uint32_t id     = ++txn_generation;
+    xSemaphoreGiveRecursive(state_mutex);
+
+    ESP_LOGD(TAG, "API: Running transaction (%u steps)...", (unsigned)txn.count);
+    Message msg = {};
+    msg.type    = MessageType::TRANSACTION;
+
+    sync_manager.clear_bits(wifi_manager::TRANSACTION_DONE_BIT);
+    esp_err_t err = post_message(msg, false);
+    if (err != ESP_OK) {
+        xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+        txn_busy = false;
+        xSemaphoreGiveRecursive(state_mutex);
+        return err;
+    }
+
+    // wifi_task enforces the deadline itself; the grace period covers its final bookkeeping
+    uint32_t bits = wait_for_result(wifi_manager::TRANSACTION_DONE_BIT, timeout_ms + TRANSACTION_GRACE_MS, token);
+
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    if (!txn_busy || txn_generation != id) {
+        // The manager was deinitialized under us
+        xSemaphoreGiveRecursive(state_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    // The steps that ran so far, also when the caller gives up: wifi_task only writes them with
+    // the state mutex held
+    memcpy(txn.results, txn_slot.results, sizeof(txn.results));
+    if (!txn_done && bits == wifi_manager::CANCEL_BIT) {
+        // Abort the step in progress; wifi_task releases the slot once it has rolled back
+        txn_cancelled = true;
+        txn_abandoned = true;
+        xSemaphoreGiveRecursive(state_mutex);
+        post_cancel(CommandId::COUNT);
+        return wifi_manager::ERR_CANCELLED;
+    }
+    if (!txn_done) {
+        // Let wifi_task release the slot once the steps in flight settle
+        txn_abandoned = true;
+        xSemaphoreGiveRecursive(state_mutex);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    txn_busy = false;
+    xSemaphoreGiveRecursive(state_mutex);
+
+    for (uint8_t i = 0; i < txn.count; i++) {
+        if (txn.results[i] != ESP_OK) {
+            return txn.results[i];
+        }
+    }
+    return ESP_OK;
+}
+#endif
+
+esp_err_t WiFiManager::set_watchdog_timeouts(uint32_t connect_timeout_ms, uint32_t dhcp_timeout_ms)
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    this->connect_timeout_ms = connect_timeout_ms;
+    this->dhcp_timeout_ms    = dhcp_timeout_ms;
+    // Applies from the next phase entry; a running watchdog keeps its deadline
+    xSemaphoreGiveRecursive(state_mutex);
+    return ESP_OK;
+}
+
+esp_err_t WiFiManager::set_ip_readiness(wifi_manager::IpReadiness readiness)
+{
+    if ((int)readiness >= (int)wifi_manager::IpReadiness::COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    state_machine.set_ip_readiness(readiness);
+    xSemaphoreGiveRecursive(state_mutex);
+    return ESP_OK;
+}
+
+esp_err_t WiFiManager::set_phy_config(const wifi_manager::PhyConfig &phy)
+{
+    if (!phy.is_valid()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    State state = state_machine.get_current_state();
+    if (state == State::UNINITIALIZED || state == State::INITIALIZING) {
+        xSemaphoreGiveRecursive(state_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = storage.save_phy(phy);
+    if (err == ESP_OK) {
+        state_machine.reset_phy_fallback();
+    }
+    xSemaphoreGiveRecursive(state_mutex);
+    return err;
+}
+
+wifi_manager::PhyConfig WiFiManager::get_phy_config(bool effective) const
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    wifi_manager::PhyConfig phy = storage.get_phy();
+    if (effective) {
+        phy = state_machine.effective_phy(phy);
+    }
+    xSemaphoreGiveRecursive(state_mutex);
+    return phy;
+}
+
+esp_err_t WiFiManager::set_channel_plan(const wifi_manager::ChannelPlan &plan)
+{
+    if (!plan.is_valid()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    State state   = state_machine.get_current_state();
+    esp_err_t err = ESP_OK;
+    if (state == State::INITIALIZING) {
+        err = ESP_ERR_INVALID_STATE;
+    }
+    else {
+        if (state != State::UNINITIALIZED) {
+            err = driver_hal.apply_channel_plan(plan);
+        }
+        if (err == ESP_OK) {
+            channel_plan     = plan;
+            channel_plan_set = true;
+        }
+    }
+    xSemaphoreGiveRecursive(state_mutex);
+    return err;
+}
+
+WiFiManager::State WiFiManager::get_state() const
+{
+    // The Mutex ensures that we don't read the state while the Task is mid-transition
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    State state = state_machine.get_current_state();
+    xSemaphoreGiveRecursive(state_mutex);
+    return state;
+}
+
+// =================================================================================================
+// Credentials and Reset
+// =================================================================================================
+
+esp_err_t WiFiManager::set_credentials(const char *ssid, const char *password, bool hidden)
+{
+    if (ssid == nullptr || password == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    if (state_machine.get_current_state() == State::UNINITIALIZED) {
+        xSemaphoreGiveRecursive(state_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ESP_LOGI(TAG, "API: Setting credentials...");
+    esp_err_t err = apply_credentials(ssid, password, hidden);
+
+    xSemaphoreGiveRecursive(state_mutex);
+    return err;
+}
+
+esp_err_t WiFiManager::set_enterprise_credentials(const char *ssid, const wifi_manager::EnterpriseProfile &profile,
+                                                  bool hidden)
+{
+#if CONFIG_WIFI_MANAGER_ENTERPRISE
+    if (ssid == nullptr || !profile.is_valid()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    if (state_machine.get_current_state() == State::UNINITIALIZED) {
+        xSemaphoreGiveRecursive(state_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ESP_LOGI(TAG, "API: Setting enterprise credentials...");
+    esp_err_t err = apply_credentials(ssid, "", hidden, &profile);
+
+    xSemaphoreGiveRecursive(state_mutex);
+    return err;
+#else
+    (void)ssid;
+    (void)profile;
+    (void)hidden;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t WiFiManager::apply_credentials(const char *ssid, const char *password, bool hidden,
+                                         const wifi_manager::EnterpriseProfile *eap)
+{
+    // If we are currently active, we must stop the current connection first
+    if (state_machine.is_active()) {
+        ESP_LOGI(TAG, "Disconnecting before applying new credentials...");
+        driver_hal.disconnect();
+    }
+
+    esp_err_t err = (eap != nullptr) ? storage.save_enterprise_credentials(ssid, *eap, hidden)
+                                     : storage.save_credentials(ssid, password, hidden);
+    if (err == ESP_OK) {
+        state_machine.reset_retries();
+        state_machine.reset_phy_fallback();
+        probe_missed = false;
+
+        forget_enterprise();
+        // Another network: its mobility domain is unknown
+        roam_policy.abort(false);
+        roam_policy.reset();
+        roam_notice_pending = false;
+
+        // Apply credentials to the driver via HAL
+        wifi_config_t cfg;
         memset(&cfg, 0, sizeof(cfg));
-        strncpy((char *)cfg.sta.ssid, ssid.c_str(), sizeof(cfg.sta.ssid));
-        strncpy((char *)cfg.sta.password, password.c_str(), sizeof(cfg.sta.password));
+        strncpy((char *)cfg.sta.ssid, ssid, sizeof(cfg.sta.ssid));
+        if (eap != nullptr) {
+            // 802.1X: the supplicant holds the credentials
+            cfg.sta.pmf_cfg.capable    = true;
+            cfg.sta.pmf_cfg.required   = eap->wpa3_192;
+            cfg.sta.threshold.authmode = eap->wpa3_192 ? WIFI_AUTH_WPA3_ENT_192 : WIFI_AUTH_WPA2_ENTERPRISE;
+        }
+        else {
+            strncpy((char *)cfg.sta.password, password, sizeof(cfg.sta.password));
+        }
+        if (channel_plan_set) {
+            cfg.sta.scan_method = channel_plan.fast_scan ? WIFI_FAST_SCAN : WIFI_ALL_CHANNEL_SCAN;
+        }
+
+        driver_hal.set_config(&cfg);
+        ESP_LOGI(TAG, "Credentials applied successfully.");
+    }
+    else {
+        ESP_LOGE(TAG, "Failed to set wifi config: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+esp_err_t WiFiManager::register_certificate(const char *name, const uint8_t *data, size_t len)
+{
+    if (name == nullptr || name[0] == '\0' ||
+        strnlen(name, wifi_manager::EnterpriseProfile::CERT_NAME_MAX_LEN + 1) >
+            wifi_manager::EnterpriseProfile::CERT_NAME_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    wifi_manager::Certificate *slot = const_cast<wifi_manager::Certificate *>(find_certificate(name));
+    if (slot == nullptr && data != nullptr) {
+        for (wifi_manager::Certificate &free_slot : certificates) {
+            if (free_slot.name[0] == '\0') {
+                slot = &free_slot;
+                break;
+            }
+        }
+        if (slot == nullptr) {
+            xSemaphoreGiveRecursive(state_mutex);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (slot != nullptr) {
+        if (data != nullptr) {
+            strncpy(slot->name, name, sizeof(slot->name) - 1);
+            slot->data = data;
+            slot->len  = len;
+        }
+        else {
+            *slot = {};
+        }
+        // A certificate of the stored profile changed: configure the supplicant again
+        const wifi_manager::EnterpriseProfile &profile = storage.get_enterprise();
+        if (strcmp(profile.ca_cert, name) == 0 || strcmp(profile.client_cert, name) == 0 ||
+            strcmp(profile.client_key, name) == 0) {
+            eap_configured = false;
+        }
+    }
+    xSemaphoreGiveRecursive(state_mutex);
+    return ESP_OK;
+}
+
+const wifi_manager::Certificate *WiFiManager::find_certificate(const char *name) const
+{
+    if (name[0] == '\0') {
+        return nullptr;
+    }
+    for (const wifi_manager::Certificate &cert : certificates) {
+        if (strncmp(cert.name, name, sizeof(cert.name)) == 0) {
+            return &cert;
+        }
+    }
+    return nullptr;
+}
+
+wifi_manager::EapStatus WiFiManager::get_eap_status() const
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    wifi_manager::EapStatus status = eap_status;
+    xSemaphoreGiveRecursive(state_mutex);
+    return status;
+}
+
+esp_err_t WiFiManager::get_credentials(char *ssid, size_t ssid_size, char *password, size_t password_size)
+{
+    return storage.load_credentials(ssid, ssid_size, password, password_size);
+}
+
+esp_err_t WiFiManager::clear_credentials()
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    if (state_machine.get_current_state() == State::UNINITIALIZED) {
+        xSemaphoreGiveRecursive(state_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_LOGI(TAG, "API: Clearing credentials...");
+
+    esp_err_t err = storage.clear_credentials();
+    if (err == ESP_OK) {
+        state_machine.reset_retries();
+        forget_enterprise();
+    }
+    xSemaphoreGiveRecursive(state_mutex);
+    return err;
+}
+
+esp_err_t WiFiManager::factory_reset()
+{
+    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+    if (state_machine.get_current_state() == State::UNINITIALIZED) {
+        xSemaphoreGiveRecursive(state_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ESP_LOGI(TAG, "API: Factory reset...");
+    esp_err_t err = storage.factory_reset();
+
+    state_machine.reset_retries();
+    forget_enterprise();
+    state_machine.transition_to(State::INITIALIZED);
+
+    xSemaphoreGiveRecursive(state_mutex);
+    return err;
+}
+
+bool WiFiManager::is_credentials_valid() const
+{
+    return storage.is_valid();
+}
+
+WiFiManager::EventOutcome WiFiManager::resolve_event(EventId event) const
+{
+    return state_machine.resolve_event(event);
+}
+
+esp_err_t WiFiManager::save_valid_flag(bool valid)
+{
+    return storage.save_valid_flag(valid);
+}
+
+// =================================================================================================
+// Internal Implementation
+// =================================================================================================
+
+esp_err_t WiFiManager::post_message(const Message &msg, bool is_async)
+{
+    if (!sync_manager.is_initialized()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // For async calls, we use the non-blocking post_message
+    // For sync calls, we could enhance WiFiSyncManager to support blocking, but for now we use the same method
+    esp_err_t err = sync_manager.post_message(msg);
+    if (err != ESP_OK && msg.type == MessageType::COMMAND) {
+        ESP_LOGE(TAG, "Failed to send command to queue (full?)");
+    }
+    return err;
+}
+
+void WiFiManager::record_dispatch(const Message &msg, uint32_t dequeue_us, uint32_t dispatch_us, uint32_t done_us)
+{
+    if ((int)msg.type >= (int)MessageType::COUNT) {
+        return;
+    }
+
+    // Unsigned arithmetic keeps the deltas correct across the 32-bit timestamp wrap
+    metrics.dwell[(int)msg.type].record(dequeue_us - msg.timestamp_us);
+    metrics.dispatch[(int)msg.type].record(dispatch_us - msg.timestamp_us);
+
+    if (msg.type == MessageType::COMMAND) {
+        if ((int)msg.cmd < (int)CommandId::COUNT) {
+            metrics.command_exec[(int)msg.cmd].record(done_us - dispatch_us);
+        }
+    }
+    else if (msg.type == MessageType::EVENT) {
+        metrics.event_exec.record(done_us - dispatch_us);
+    }
+}
+
+uint32_t WiFiManager::wait_for_result(uint32_t done_bits, uint32_t timeout_ms, const CancellationToken *token)
+{
+    if (token == nullptr) {
+        return sync_manager.wait_for_bits(done_bits, timeout_ms);
+    }
+
+    // Register before checking the flag: a cancel() from then on aborts this task's block
+    token->m_waiter.store(xTaskGetCurrentTaskHandle());
+    uint32_t bits = 0;
+    if (!token->is_cancelled()) {
+        bits = sync_manager.wait_for_bits(done_bits, timeout_ms);
+    }
+    token->m_waiter.store(nullptr);
+
+    // A result that arrived together with the cancellation wins
+    if (!(bits & done_bits) && token->is_cancelled()) {
+        return wifi_manager::CANCEL_BIT;
+    }
+    return bits;
+}
+
+#if CONFIG_WIFI_MANAGER_SYNC_API
+esp_err_t WiFiManager::post_cancel(CommandId cmd)
+{
+    Message msg = {};
+    msg.type    = MessageType::CANCEL;
+    msg.cmd     = cmd;
+    return post_message(msg, true);
+}
+#endif
+
+void WiFiManager::supersede(const Message &msg)
+{
+    log_event<LogId::SUPERSEDED>((int32_t)msg.cmd);
+    if ((int)msg.cmd < (int)CommandId::COUNT) {
+        metrics.superseded[(int)msg.cmd]++;
+    }
+    sync_manager.set_bits(wifi_manager::superseded_bit_for(msg.cmd));
+}
+
+void WiFiManager::process_message(const Message &msg, State state)
+{
+    if (msg.type == MessageType::COMMAND) {
+        // Any explicit user command resets the retry counters (except EXIT)
+        if (msg.cmd != CommandId::EXIT) {
+            state_machine.reset_retries();
+        }
+
+        switch (msg.cmd) {
+        case CommandId::START:
+            handle_start(msg, state);
+            break;
+        case CommandId::STOP:
+            handle_stop(msg, state);
+            break;
+        case CommandId::CONNECT:
+            handle_connect(msg, state);
+            break;
+        case CommandId::DISCONNECT:
+            handle_disconnect(msg, state);
+            break;
+        default:
+            break;
+        }
+    }
+    else if (msg.type == MessageType::CANCEL) {
+        handle_cancel(msg, state);
+    }
+    else {
+        // Handle system event via Transition Matrix
+        handle_event(msg, state);
+    }
+
+    // The default route follows the STA state and the netif events
+    arbitrate_uplinks(msg.timestamp_us);
+
+    // Deadlines follow the state the message left us in
+    sync_timers();
+}
+
+void WiFiManager::handle_start(const Message &msg, State state)
+{
+    state_machine.transition_to(State::STARTING);
+    esp_err_t err = driver_hal.start();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start wifi: %s", esp_err_to_name(err));
+        auto_connect_pending = false;
+        state_machine.transition_to(state);
+        sync_manager.set_bits(wifi_manager::START_FAILED_BIT);
+    }
+}
+
+void WiFiManager::handle_stop(const Message &msg, State state)
+{
+    auto_connect_pending = false;
+
+    // Already stopped (e.g. the START queued before us was superseded): nothing to do
+    if (state == State::INITIALIZED) {
+        sync_manager.set_bits(wifi_manager::STOPPED_BIT);
+        return;
+    }
+
+    state_machine.transition_to(State::STOPPING);
+    esp_err_t err = driver_hal.stop();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to stop wifi: %s", esp_err_to_name(err));
+        state_machine.transition_to(state);
+        sync_manager.set_bits(wifi_manager::STOP_FAILED_BIT);
+        return;
+    }
+    // Only once the driver stopped: a failed stop leaves a fast transition running
+    roam_policy.abort(false);
+    roam_scan_pending = false; // The driver stops without reporting the scan
+
+    // STA_START will now find STOPPING: answer a start() still waiting for it
+    if (state == State::STARTING) {
+        sync_manager.set_bits(wifi_manager::START_SUPERSEDED_BIT);
+    }
+}
+
+void WiFiManager::handle_connect(const Message &msg, State state)
+{
+    // First connect after a reset that interrupted a backoff (or a boot loop): wait first
+    if (boot_backoff_retries > 0 && storage.is_valid()) {
+        uint32_t delay_ms;
+        state_machine.restore_retry_count(boot_backoff_retries);
+        boot_backoff_retries = 0;
+        state_machine.calculate_next_backoff(delay_ms);
+        log_event<LogId::BOOT_BACKOFF>((int32_t)state_machine.get_retry_count(), (int32_t)delay_ms);
+        return;
+    }
+    boot_backoff_retries = 0;
+
+    esp_err_t err = begin_association();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to connect wifi: %s", esp_err_to_name(err));
+        state_machine.transition_to(state);
+        sync_manager.set_bits(wifi_manager::CONNECT_FAILED_BIT);
+    }
+}
+
+esp_err_t WiFiManager::begin_association()
+{
+    // An unusable profile (e.g. an unregistered certificate) fails before the attempt starts
+    if (storage.get_enterprise().is_enterprise()) {
+        esp_err_t err = apply_enterprise();
+        if (err != ESP_OK) {
+            log_event<LogId::EAP_FAILED>(err);
+            return err;
+        }
+    }
+
+    state_machine.transition_to(State::CONNECTING);
+    // A roam leaves its association here rather than through an event: the TWT agreement goes too
+    state_machine.twt_link_lost();
+    // 802.11r where the AP offers it; a roam reconnect goes to its candidate, any other
+    // attempt lets the driver pick the AP (the hidden-SSID hint below then sets the channel)
+    driver_hal.set_ft(roam_policy.get_config().ft);
+    driver_hal.pin_bssid(roam_policy.in_progress() ? &roam_policy.get_target() : nullptr);
+    apply_scan_hint();
+
+    // Configured PHY modes, or the more robust ones the fallback has stepped down to
+    esp_err_t err = driver_hal.set_phy(state_machine.effective_phy(storage.get_phy()));
+    if (err != ESP_OK) {
+        log_event<LogId::PHY_FAILED>(err);
+    }
+    connect_issued_us = (uint32_t)esp_timer_get_time();
+    return driver_hal.connect();
+}
+
+void WiFiManager::forget_enterprise()
+{
+    driver_hal.disable_enterprise();
+    eap_configured     = false;
+    eap_session_cached = false;
+    eap_status         = {};
+}
+
+esp_err_t WiFiManager::apply_enterprise()
+{
+    const wifi_manager::EnterpriseProfile &profile = storage.get_enterprise();
+
+    // Configuring the supplicant drops its cached TLS session and PMK: only done without resumption
+    if (eap_configured && profile.resumption) {
+        return ESP_OK;
+    }
+
+    const wifi_manager::Certificate *ca_cert     = find_certificate(profile.ca_cert);
+    const wifi_manager::Certificate *client_cert = find_certificate(profile.client_cert);
+    const wifi_manager::Certificate *client_key  = find_certificate(profile.client_key);
+    if ((profile.ca_cert[0] != '\0' && ca_cert == nullptr) ||
+        (profile.client_cert[0] != '\0' && client_cert == nullptr) ||
+        (profile.client_key[0] != '\0' && client_key == nullptr)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t err      = driver_hal.configure_enterprise(profile, ca_cert, client_cert, client_key);
+    eap_configured     = (err == ESP_OK);
+    eap_session_cached = false;
+    return err;
+}
+
+void WiFiManager::request_twt()
+{
+    if (!twt_config.is_enabled() || !state_machine.twt_needs_setup()) {
+        return;
+    }
+
+    esp_err_t err = driver_hal.setup_twt(twt_config);
+    state_machine.record_twt_request(err == ESP_OK, err != ESP_ERR_NOT_SUPPORTED);
+    if (err == ESP_OK) {
+        wifi_manager::TwtConfig::Encoding enc = twt_config.encode();
+        log_event<LogId::TWT_REQUESTED>((int32_t)(enc.interval_us() / 1000), (int32_t)enc.duration_us());
+    }
+    else {
+        log_event<LogId::TWT_FAILED>(err);
+    }
+}
+
+void WiFiManager::start_roam(State state, uint32_t now_us)
+{
+    // Always fetched: the driver holds the records until they are read
+    wifi_manager::RoamCandidate candidates[WiFiDriverHAL::ROAM_RECORDS_MAX];
+    size_t count = WiFiDriverHAL::ROAM_RECORDS_MAX;
+    if (driver_hal.get_roam_candidates(candidates, count) != ESP_OK || state != State::CONNECTED_GOT_IP) {
+        return;
+    }
+
+    uint8_t current[6];
+    wifi_manager::RoamCandidate target;
+    if (driver_hal.get_bssid(current) != ESP_OK ||
+        !roam_policy.select(current, last_rssi, sta_channel, candidates, count, target)) {
+        return;
+    }
+
+    // Another channel: ESP-NOW peers are told first and get the lead time to follow
+    if (target.channel != sta_channel) {
+        notify_channel(target.channel, true);
+        if (CONFIG_WIFI_MANAGER_CHANNEL_NOTICE_MS > 0) {
+            // sync_timers() arms CHANNEL_NOTICE, which starts the roam
+            roam_notice_target  = target;
+            roam_notice_pending = true;
+            return;
+        }
+    }
+    execute_roam(current, target, now_us);
+}
+
+void WiFiManager::execute_roam(const uint8_t (&current)[6], const wifi_manager::RoamCandidate &target,
+                               uint32_t now_us)
+{
+    bool fast = roam_policy.begin(current, target, now_us) == wifi_manager::WiFiRoamPolicy::Mode::FAST_TRANSITION;
+    log_event<LogId::ROAM_START>(fast, target.rssi, target.channel);
+    if (fast) {
+        // Reassociation in place: the link keeps CONNECTED_GOT_IP and its address while the
+        // driver moves; ROAM_DEADLINE catches a transition that never completes
+        driver_hal.pin_bssid(&target);
+        if (driver_hal.connect() != ESP_OK) {
+            fall_back_from_roam();
+        }
+        return;
+    }
+
+    // Regular reconnect, pinned to the candidate by begin_association()
+    disconnect_echoes++;
+    driver_hal.disconnect();
+    if (begin_association() != ESP_OK) {
+        fall_back_from_roam();
+    }
+}
+
+void WiFiManager::finish_roam(uint32_t now_us)
+{
+    bool fast       = roam_policy.is_fast_transition();
+    uint32_t gap_us = roam_policy.finish(now_us);
+    log_event<LogId::ROAM_DONE>(fast, (int32_t)gap_us);
+}
+
+void WiFiManager::notify_channel(uint8_t channel, bool pending)
+{
+    wifi_manager::ChannelChange change = {notified_channel, channel, pending};
+    log_event<LogId::CHANNEL_CHANGE>(change.from, change.to, pending);
+    notified_channel = channel;
+    notified_pending = pending;
+    if (channel_listener != nullptr) {
+        channel_listener(change, channel_listener_arg);
+    }
+}
+
+void WiFiManager::fall_back_from_roam()
+{
+    log_event<LogId::ROAM_FAILED>(roam_policy.is_fast_transition());
+    roam_policy.abort(true);
+
+    // Regular reconnect to whichever AP of the network answers
+    disconnect_echoes++;
+    driver_hal.disconnect();
+    if (tx_power.on_link_failure()) {
+        apply_tx_power();
+    }
+    if (begin_association() != ESP_OK) {
+        uint32_t delay_ms;
+        state_machine.calculate_next_backoff(delay_ms);
+        log_event<LogId::RECONNECT_SCHEDULED>((int32_t)state_machine.get_retry_count(), (int32_t)delay_ms);
+    }
+}
+
+void WiFiManager::abort_roam(bool failed)
+{
+    if (roam_policy.is_fast_transition() && !roam_policy.link_lost()) {
+        disconnect_echoes++;
+    }
+    roam_policy.abort(failed);
+}
+
+int8_t WiFiManager::find_uplink(esp_netif_t *netif) const
+{
+    const wifi_manager::UplinkStatus &status = uplinks.get_status();
+    for (int8_t i = 0; i < (int8_t)status.count; i++) {
+        if (uplink_netifs[i] == netif) {
+            return i;
+        }
+    }
+    return wifi_manager::WiFiUplinkArbiter::NONE;
+}
+
+int8_t WiFiManager::find_uplink_by_index(uint8_t lwip_index)
+{
+    const wifi_manager::UplinkStatus &status = uplinks.get_status();
+    for (int8_t i = 0; i < (int8_t)status.count; i++) {
+        // The STA readiness follows the state, never these events
+        if (i != wifi_uplink && driver_hal.netif_index(uplink_netifs[i]) == lwip_index) {
+            return i;
+        }
+    }
+    return wifi_manager::WiFiUplinkArbiter::NONE;
+}
+
+void WiFiManager::arbitrate_uplinks(uint32_t event_us)
+{
+    if (wifi_uplink == wifi_manager::WiFiUplinkArbiter::NONE) {
+        return;
+    }
+
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    uplinks.set_ready(wifi_uplink, state_machine.get_current_state() == State::CONNECTED_GOT_IP, now_us);
+    uint32_t failovers = uplinks.get_status().failovers;
+    if (!uplinks.arbitrate(now_us, event_us)) {
+        return;
+    }
+
+    int8_t active = uplinks.get_active();
+    if (active == wifi_manager::WiFiUplinkArbiter::NONE) {
+        log_event<LogId::UPLINK_NONE>();
+        return;
+    }
+    esp_err_t err = driver_hal.set_default_netif(uplink_netifs[active]);
+    if (err != ESP_OK) {
+        log_event<LogId::UPLINK_FAILED>(active, err);
+        return;
+    }
+    log_event<LogId::UPLINK_SWITCH>(active, uplinks.get_priority(active), uplinks.get_status().failovers != failovers);
+}
+
+void WiFiManager::apply_tx_power()
+{
+    // The driver only takes a limit once started; the HAL skips unchanged values. Without the
+    // controller the driver keeps its own limit.
+    if (!tx_power_control || !state_machine.is_sta_ready()) {
+        return;
+    }
+    esp_err_t err = driver_hal.set_max_tx_power(tx_power.get_power());
+    if (err != ESP_OK) {
+        log_event<LogId::TX_POWER_FAILED>(err);
+    }
+}
+
+void WiFiManager::apply_scan_hint()
+{
+    probe_channel = 0;
+    if (roam_policy.in_progress()) {
+        return; // pin_bssid() set the channel of the candidate
+    }
+
+    // With a channel and WIFI_FAST_SCAN the driver starts the connect scan there and stops at
+    // the first answer: the locked channel, else the cached one of a hidden SSID (probed for)
+    bool hidden     = storage.is_hidden();
+    uint8_t channel = 0;
+    if (!probe_missed) {
+        channel = channel_lock != 0 ? channel_lock : hidden ? storage.get_channel() : 0;
+    }
+    // Without a hint a broadcast SSID scans as the credentials configured it
+    wifi_scan_method_t method = WIFI_FAST_SCAN;
+    if (channel == 0 && !hidden && channel_plan_set && !channel_plan.fast_scan) {
+        method = WIFI_ALL_CHANNEL_SCAN;
+    }
+
+    wifi_config_t cfg;
+    if (driver_hal.get_config(&cfg) != ESP_OK) {
+        return;
+    }
+    if (cfg.sta.channel != channel || cfg.sta.scan_method != method) {
+        cfg.sta.channel     = channel;
+        cfg.sta.scan_method = method;
+        driver_hal.set_config(&cfg);
+    }
+    probe_channel = hidden ? channel : 0;
+}
+
+void WiFiManager::handle_disconnect(const Message &msg, State state)
+{
+    abort_roam(false);
+
+    // SPECIAL CASE: Rollback during early connect phase or backoff. After a credential failure
+    // there is no link either, so the driver would never report the disconnect.
+    if (state == State::WAITING_RECONNECT || state == State::CONNECTING || state == State::ERROR_CREDENTIALS) {
+        state_machine.transition_to(State::DISCONNECTED);
+        // Mid-association the driver reports our disconnect; the caller is answered below
+        // already, and the echo must not abort a CONNECT queued right behind us
+        if (state == State::CONNECTING) {
+            disconnect_echoes++;
+        }
+        driver_hal.disconnect();
+        sync_manager.set_bits(wifi_manager::DISCONNECTED_BIT);
+        return;
+    }
+
+    state_machine.transition_to(State::DISCONNECTING);
+    esp_err_t err = driver_hal.disconnect();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to disconnect wifi: %s", esp_err_to_name(err));
+        state_machine.transition_to(state);
+        sync_manager.set_bits(wifi_manager::CONNECT_FAILED_BIT);
+    }
+}
+
+void WiFiManager::handle_cancel(const Message &msg, State state)
+{
+    // Only attempts still in flight are aborted; a finished operation is left alone
+    switch (msg.cmd) {
+    case CommandId::START:
+        if (state == State::STARTING) {
+            ESP_LOGI(TAG, "Start cancelled, stopping driver...");
+            handle_stop(msg, state);
+        }
+        break;
+    case CommandId::CONNECT:
+        auto_connect_pending = false;
+        if (state == State::CONNECTING || state == State::CONNECTED_NO_IP || state == State::WAITING_RECONNECT) {
+            ESP_LOGI(TAG, "Connect cancelled, disconnecting...");
+            handle_disconnect(msg, state);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void WiFiManager::handle_event(const Message &msg, State state)
+{
+    // Echo of a disconnect we issued ourselves (phase watchdog or rollback): the outcome is
+    // already settled, and a new attempt may have started since. Dropped before the matrix
+    // so that attempt keeps CONNECTING. DISCONNECTING waits for the first one to arrive.
+    if (msg.event == EventId::STA_DISCONNECTED && disconnect_echoes > 0 && state != State::DISCONNECTING &&
+        msg.payload.disconnected.reason == WIFI_REASON_ASSOC_LEAVE) {
+        disconnect_echoes--;
+        if (state == State::WAITING_RECONNECT || state == State::CONNECTING) {
+            log_event<LogId::ECHO_IGNORED>();
+            return;
+        }
+    }
+    // An address reported ahead of that echo belongs to the association the disconnect ended (a
+    // roam fallback reconnects within the batch); one of a new association follows its STA_CONNECTED
+    if (msg.event == EventId::GOT_IP && disconnect_echoes > 0 && state == State::CONNECTING) {
+        return;
+    }
+
+    // The driver left the old AP of a fast transition: the link is due back before ROAM_DEADLINE,
+    // whether or not a lease loss overtook the roam. The TWT agreement stayed with that AP.
+    bool connected = state == State::CONNECTED_NO_IP || state == State::CONNECTED_GOT_IP;
+    if (msg.event == EventId::STA_DISCONNECTED && connected && roam_policy.absorb_link_loss(msg.timestamp_us)) {
+        state_machine.twt_link_lost();
+        return;
+    }
+
+    // An address only completes the connection once the configured readiness is met
+    if (msg.event == EventId::GOT_IP && !state_machine.record_address(msg.payload.address)) {
+        log_event<LogId::ADDRESS_PENDING>((int32_t)msg.payload.address, (int32_t)state_machine.get_ip_readiness());
+        return;
+    }
+    // Losing one only ends it once the remaining addresses no longer meet it
+    if (msg.event == EventId::LOST_IP && state_machine.forget_address(msg.payload.address)) {
+        return;
+    }
+
+    EventOutcome outcome = state_machine.resolve_event(msg.event);
+
+    // 1. Perform state transition
+    if (outcome.next_state != state) {
+        log_event<LogId::TRANSITION>((int32_t)msg.event, (int32_t)state, (int32_t)outcome.next_state);
+        state_machine.transition_to(outcome.next_state);
+    }
+
+    // The association ended or was replaced (reconnect, roam), and its TWT agreement with it
+    if (msg.event == EventId::STA_CONNECTED || !state_machine.is_connected()) {
+        state_machine.twt_link_lost();
+    }
+    // No association, no channel; an announced roam has nothing left to leave
+    if (!state_machine.is_connected()) {
+        sta_channel         = 0;
+        roam_notice_pending = false;
+    }
+
+    // 2. Set synchronization bits for API callers
+    if (outcome.bits_to_set != 0) {
+        sync_manager.set_bits(outcome.bits_to_set);
+    }
+
+    // 3. Handle Side Effects (Complex logic)
+    switch (msg.event) {
+    case EventId::STA_DISCONNECTED:
+    {
+        const auto &disconnected = msg.payload.disconnected;
+        // The RSSI quality label is derived when the record is formatted
+        log_event<LogId::STA_DISCONNECTED>(disconnected.reason, disconnected.rssi);
+
+        // The candidate refused us, or the transition lost the link for good: the regular
+        // reconnect below takes over, to any AP
+        if (roam_policy.in_progress()) {
+            log_event<LogId::ROAM_FAILED>(roam_policy.is_fast_transition());
+            roam_policy.abort(true);
+        }
+
+        // The hidden AP did not answer on its cached channel: the next attempt scans them all
+        if (state == State::CONNECTING && disconnected.reason == WIFI_REASON_NO_AP_FOUND && probe_channel != 0) {
+            log_event<LogId::PROBE_MISSED>(probe_channel);
+            probe_missed = true;
+        }
+        // Lost link or failed attempt: reconnect at full power
+        if (tx_power.on_link_failure()) {
+            log_event<LogId::TX_POWER>(tx_power.get_power(), disconnected.rssi);
+            apply_tx_power();
+        }
+        // The AP refuses our PHY capabilities: step down after repeated refusals
+        if (state == State::CONNECTING && WiFiStateMachine::is_phy_failure(disconnected.reason) &&
+            state_machine.record_phy_failure(CONFIG_WIFI_MANAGER_PHY_FALLBACK_FAILURES)) {
+            log_event<LogId::PHY_FALLBACK>(state_machine.get_phy_fallback(), disconnected.reason);
+        }
+
+        switch (WiFiStateMachine::classify_disconnect(state, outcome.next_state, disconnected.reason)) {
+        case WiFiStateMachine::DisconnectClass::EXPECTED:
+            // Out of DISCONNECTING the transition table has set both bits at once: set again here,
+            // they could land after disconnect() returned and fail the connect() that follows
+            if (state != State::DISCONNECTING) {
+                sync_manager.set_bits(wifi_manager::DISCONNECTED_BIT | wifi_manager::CONNECT_FAILED_BIT);
+            }
+            break;
+
+        case WiFiStateMachine::DisconnectClass::LEFT:
+            log_event<LogId::LEFT>();
+            state_machine.transition_to(State::DISCONNECTED);
+            sync_manager.set_bits(wifi_manager::DISCONNECTED_BIT | wifi_manager::CONNECT_FAILED_BIT);
+            break;
+
+        case WiFiStateMachine::DisconnectClass::SUSPECT:
+            // RSSI decides between a wrong password and a bad signal
+            if (state_machine.handle_suspect_failure(disconnected.rssi)) {
+                log_event<LogId::SUSPECT_INVALIDATE>(disconnected.reason);
+                this->storage.save_valid_flag(false);
+                // State machine already transited to ERROR_CREDENTIALS in handle_suspect_failure
+            }
+            else {
+                uint32_t delay_ms;
+                state_machine.calculate_next_backoff(delay_ms);
+                log_event<LogId::SUSPECT_RETRY>(disconnected.reason, (int32_t)delay_ms);
+                // State machine already transited to WAITING_RECONNECT in calculate_next_backoff
+            }
+            sync_manager.set_bits(wifi_manager::CONNECT_FAILED_BIT);
+            break;
+
+        case WiFiStateMachine::DisconnectClass::RECOVERABLE:
+            if (this->storage.is_valid()) {
+                uint32_t delay_ms;
+                state_machine.calculate_next_backoff(delay_ms);
+                log_event<LogId::RECONNECT_SCHEDULED>((int32_t)state_machine.get_retry_count(), (int32_t)delay_ms);
+            }
+            else {
+                state_machine.transition_to(State::DISCONNECTED);
+            }
+            sync_manager.set_bits(wifi_manager::CONNECT_FAILED_BIT);
+            break;
+        }
+        break;
+    }
+
+    case EventId::TIMEOUT:
+        // Only CONNECTING and CONNECTED_NO_IP resolve TIMEOUT to WAITING_RECONNECT
+        if (outcome.next_state != State::WAITING_RECONNECT) {
+            break;
+        }
+        if (state == State::CONNECTING) {
+            log_event<LogId::TIMEOUT_ASSOC>();
+        }
+        else {
+            log_event<LogId::TIMEOUT_DHCP>();
+        }
+        if (roam_policy.in_progress()) {
+            log_event<LogId::ROAM_FAILED>(false);
+            abort_roam(true);
+        }
+        disconnect_echoes++;
+        driver_hal.disconnect();
+        if (tx_power.on_link_failure()) {
+            apply_tx_power();
+        }
+
+        // Same policy as a recoverable link failure
+        if (this->storage.is_valid()) {
+            uint32_t delay_ms;
+            state_machine.calculate_next_backoff(delay_ms);
+            log_event<LogId::RECONNECT_SCHEDULED>((int32_t)state_machine.get_retry_count(), (int32_t)delay_ms);
+        }
+        else {
+            state_machine.transition_to(State::DISCONNECTED);
+        }
+        break;
+
+    case EventId::STA_CONNECTED:
+    {
+        // Reassociated in place by a fast transition: the address and the lease carry over
+        bool roamed = connected && roam_policy.is_fast_transition();
+        if (roamed) {
+            finish_roam(msg.timestamp_us);
+        }
+
+        // A new association: any echo still expected came before it. One left over from
+        // an aborted attempt finds another state and must not clear the flag.
+        if (state == State::CONNECTING) {
+            disconnect_echoes = 0;
+            // Post time of the event: the queue dwell is not part of the connect scan
+            uint32_t association_us = msg.timestamp_us - connect_issued_us;
+            metrics.association.record(association_us);
+            log_event<LogId::ASSOCIATED>(msg.payload.channel, (int32_t)(association_us / 1000));
+
+            // The 802.1X exchange completes before STA_CONNECTED: the association time includes it
+            if (storage.get_enterprise().is_enterprise()) {
+                uint32_t resumed = eap_status.likely_resumed;
+                eap_status.record(association_us, eap_session_cached);
+                log_event<LogId::EAP_HANDSHAKE>((int32_t)(association_us / 1000),
+                                                eap_status.likely_resumed != resumed,
+                                                (int32_t)(eap_status.est_saved_us / 1000));
+                eap_session_cached = storage.get_enterprise().resumption;
+            }
+        }
+        state_machine.clear_phy_failures();
+        // Where the next attempt on a hidden network probes first
+        probe_missed = false;
+        if (storage.is_hidden()) {
+            storage.save_channel(msg.payload.channel);
+        }
+        // ESP-NOW peers follow: a new channel, or the end of an announced roam
+        sta_channel = msg.payload.channel;
+        if (sta_channel != 0 && (sta_channel != notified_channel || notified_pending)) {
+            notify_channel(sta_channel, false);
+        }
+        if (roamed) {
+            request_twt(); // The agreement stayed with the old AP
+            break;
+        }
+        // New association: addresses start over, and SLAAC runs alongside DHCPv4
+        state_machine.clear_addresses();
+        if (outcome.next_state == State::CONNECTED_NO_IP) {
+            esp_err_t err = driver_hal.enable_ipv6();
+            if (err != ESP_OK && err != ESP_ERR_NOT_SUPPORTED) {
+                log_event<LogId::IPV6_FAILED>(err);
+            }
+        }
+        break;
+    }
+
+    case EventId::STA_START:
+        // Chained connect requested by init_async()
+        if (auto_connect_pending && state_machine.get_current_state() == State::STARTED) {
+            auto_connect_pending = false;
+            log_event<LogId::CHAIN_CONNECT>();
+            handle_connect(msg, State::STARTED);
+        }
+        break;
+
+    case EventId::GOT_IP:
+        log_event<LogId::GOT_IP>((int32_t)msg.payload.address);
+        // A further address or a lease renewal on an established connection changes nothing
+        if (state == State::CONNECTED_GOT_IP || outcome.next_state != State::CONNECTED_GOT_IP) {
+            break;
+        }
+        state_machine.reset_retries();
+        if (!this->storage.is_valid()) {
+            this->storage.save_valid_flag(true);
+        }
+        if (roam_policy.get_mode() == wifi_manager::WiFiRoamPolicy::Mode::RECONNECT) {
+            finish_roam(msg.timestamp_us);
+        }
+        request_twt();
+        break;
+
+    case EventId::SCAN_DONE:
+        // Only the roam scan: the records of a scan the application started are its own
+        if (roam_scan_pending) {
+            roam_scan_pending = false;
+            start_roam(state, msg.timestamp_us);
+        }
+        break;
+
+    case EventId::UPLINK_UP:
+    case EventId::UPLINK_DOWN:
+    {
+        // netif index 0: posted by add_uplink() or set_uplink_health(), which updated the arbiter
+        int8_t slot = msg.payload.netif_index != 0 ? find_uplink_by_index(msg.payload.netif_index)
+                                                   : wifi_manager::WiFiUplinkArbiter::NONE;
+        if (slot != wifi_manager::WiFiUplinkArbiter::NONE) {
+            uplinks.set_ready(slot, msg.event == EventId::UPLINK_UP, msg.timestamp_us);
+        }
+        break;
+    }
+
+    case EventId::TWT:
+        if (state_machine.record_twt_event(msg.payload.twt)) {
+            log_event<LogId::TWT_STATE>((int32_t)msg.payload.twt);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+#if CONFIG_WIFI_MANAGER_SYNC_API
+esp_err_t WiFiManager::step_status(CommandId cmd) const
+{
+    State state = state_machine.get_current_state();
+    switch (cmd) {
+    case CommandId::START:
+        if (state == State::STARTING) {
+            return STEP_IN_PROGRESS;
+        }
+        return state_machine.is_sta_ready() ? ESP_OK : ESP_FAIL;
+    case CommandId::STOP:
+        if (state == State::STOPPING) {
+            return STEP_IN_PROGRESS;
+        }
+        return (state == State::STOPPED) ? ESP_OK : ESP_FAIL;
+    case CommandId::CONNECT:
+        if (state == State::CONNECTING || state == State::CONNECTED_NO_IP) {
+            return STEP_IN_PROGRESS;
+        }
+        return (state == State::CONNECTED_GOT_IP) ? ESP_OK : ESP_FAIL;
+    case CommandId::DISCONNECT:
+        if (state == State::DISCONNECTING) {
+            return STEP_IN_PROGRESS;
+        }
+        return (state == State::DISCONNECTED) ? ESP_OK : ESP_FAIL;
+    default:
+        return ESP_FAIL;
+    }
+}
+
+esp_err_t WiFiManager::await_step(CommandId cmd, int64_t deadline_us, Message *deferred, size_t &deferred_count)
+{
+    while (true) {
+        if (txn_cancelled) {
+            return wifi_manager::ERR_CANCELLED;
+        }
+
+        esp_err_t status = step_status(cmd);
+        if (status != STEP_IN_PROGRESS) {
+            return status;
+        }
+
+        int64_t remaining_us = deadline_us - esp_timer_get_time();
+        if (remaining_us <= 0) {
+            return ESP_ERR_TIMEOUT;
+        }
+
+        // Release the state while blocked so API readers are not stalled by the transaction
+        Message msg;
+        xSemaphoreGiveRecursive(state_mutex);
+        BaseType_t received =
+            xQueueReceive(sync_manager.get_queue(), &msg, pdMS_TO_TICKS(remaining_us / 1000) + 1);
+        xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+        if (received != pdTRUE) {
+            continue;
+        }
+
+        // The transaction's own cancellation is checked at the top of the loop
+        if (msg.type == MessageType::CANCEL && msg.cmd == CommandId::COUNT) {
+            continue;
+        }
+
+        if (msg.type == MessageType::EVENT) {
+            uint32_t dispatch_us = (uint32_t)esp_timer_get_time();
+            process_message(msg, state_machine.get_current_state());
+            record_dispatch(msg, dispatch_us, dispatch_us, (uint32_t)esp_timer_get_time());
+            continue;
+        }
+
+        // Other commands wait until the transaction has finished. The last slot is kept for
+        // EXIT: deinit() must get through however many commands came before it.
+        bool exit = msg.type == MessageType::COMMAND && msg.cmd == CommandId::EXIT;
+        if (exit || deferred_count < wifi_manager::WiFiSyncManager::QUEUE_SIZE - 1) {
+            deferred[deferred_count++] = msg;
+            if (exit) {
+                return ESP_ERR_INVALID_STATE; // deinit() in progress: abort the remaining steps
+            }
+        }
+        else if (msg.type == MessageType::COMMAND) {
+            // Only the caller of the rejected command is woken, not every sync waiter
+            ESP_LOGW(TAG, "Too many commands during a transaction, rejecting command %d", (int)msg.cmd);
+            uint32_t bits = msg.cmd == CommandId::STOP ? wifi_manager::STOP_FAILED_BIT
+                                                       : wifi_manager::superseded_bit_for(msg.cmd);
+            if (bits != 0) {
+                sync_manager.set_bits(bits);
+            }
+        }
+    }
+}
+
+void WiFiManager::execute_transaction(Message *deferred, size_t &deferred_count)
+{
+    Transaction &txn = txn_slot;
+    esp_err_t failed = ESP_OK;
+
+    for (uint8_t i = 0; i < txn.count; i++) {
+        if (failed == ESP_OK && txn_cancelled) {
+            failed = wifi_manager::ERR_CANCELLED;
+        }
+        if (failed != ESP_OK) {
+            txn.results[i] = ESP_ERR_NOT_FINISHED;
+            continue;
+        }
+
+        Transaction::Step step = txn.steps[i];
+        esp_err_t err          = ESP_OK;
+
+        if (step == Transaction::Step::SET_CREDENTIALS) {
+            err = apply_credentials(txn.ssid, txn.password, txn.hidden);
+        }
+        else {
+            CommandId cmd = (step == Transaction::Step::START)     ? CommandId::START
+                            : (step == Transaction::Step::CONNECT) ? CommandId::CONNECT
+                            : (step == Transaction::Step::STOP)    ? CommandId::STOP
+                                                                   : CommandId::DISCONNECT;
+
+            Action action = state_machine.validate_command(cmd);
+            if (action == Action::ERROR) {
+                err = ESP_ERR_INVALID_STATE;
+            }
+            else {
+                if (action == Action::EXECUTE) {
+                    Message msg = {};
+                    msg.type    = MessageType::COMMAND;
+                    msg.cmd     = cmd;
+                    process_message(msg, state_machine.get_current_state());
+                }
+                err = await_step(cmd, txn_deadline_us, deferred, deferred_count);
+
+                // Same rollback as the synchronous API on timeout or cancellation
+                if ((err == ESP_ERR_TIMEOUT || err == wifi_manager::ERR_CANCELLED) &&
+                    (cmd == CommandId::START || cmd == CommandId::CONNECT)) {
+                    Message rollback = {};
+                    rollback.type    = MessageType::COMMAND;
+                    rollback.cmd     = (cmd == CommandId::START) ? CommandId::STOP : CommandId::DISCONNECT;
+                    if (state_machine.validate_command(rollback.cmd) == Action::EXECUTE) {
+                        process_message(rollback, state_machine.get_current_state());
+                    }
+                }
+            }
+        }
+
+        txn.results[i] = err;
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Transaction step %u failed: %s", (unsigned)i, err_to_name(err));
+            failed = err;
+        }
+    }
 
-        driver_hal.set_config(&cfg);
-        ESP_LOGI(TAG, "Credentials applied successfully.");
+    txn_done = true;
+    if (txn_abandoned) {
+        txn_busy      = false;
+        txn_abandoned = false;
     }
     else {
-        ESP_LOGE(TAG, "Failed to set wifi config: %s", esp_err_to_name(err));
+        sync_manager.set_bits(wifi_manager::TRANSACTION_DONE_BIT);
     }
-
-    xSemaphoreGiveRecursive(state_mutex);
-    return err;
 }
+#endif
 
-esp_err_t WiFiManager::get_credentials(std::string &ssid, std::string &password)
+bool WiFiManager::dispatch_batch(Message *batch, size_t count, uint32_t dequeue_us)
 {
-    return storage.load_credentials(ssid, password);
-}
+    uint32_t superseded = WiFiStateMachine::find_superseded(batch, count);
 
-esp_err_t WiFiManager::clear_credentials()
-{
-    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
-    if (state_machine.get_current_state() == State::UNINITIALIZED) {
-        xSemaphoreGiveRecursive(state_mutex);
-        return ESP_ERR_INVALID_STATE;
-    }
-    ESP_LOGI(TAG, "API: Clearing credentials...");
+    for (size_t i = 0; i < count; i++) {
+        const Message &msg = batch[i];
 
-    esp_err_t err = storage.clear_credentials();
-    if (err == ESP_OK) {
-        state_machine.reset_retries();
-    }
-    xSemaphoreGiveRecursive(state_mutex);
-    return err;
-}
+        // A message leaves the batch when its turn comes: the handlers of the messages ahead
+        // of it are part of its dwell
+        uint32_t picked_us = i == 0 ? dequeue_us : (uint32_t)esp_timer_get_time();
 
-esp_err_t WiFiManager::factory_reset()
-{
-    xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
-    if (state_machine.get_current_state() == State::UNINITIALIZED) {
-        xSemaphoreGiveRecursive(state_mutex);
-        return ESP_ERR_INVALID_STATE;
-    }
+        // Let API callers observe the state between two messages of the batch
+        if (i > 0) {
+            xSemaphoreGiveRecursive(state_mutex);
+            xSemaphoreTakeRecursive(state_mutex, portMAX_DELAY);
+        }
 
-    ESP_LOGI(TAG, "API: Factory reset...");
-    esp_err_t err = storage.factory_reset();
+        if (superseded & (1UL << i)) {
+            supersede(msg);
+            continue;
+        }
 
-    state_machine.reset_retries();
-    state_machine.transition_to(State::INITIALIZED);
+        if (msg.type == MessageType::COMMAND && msg.cmd == CommandId::EXIT) {
+            return false;
+        }
 
-    xSemaphoreGiveRecursive(state_mutex);
-    return err;
-}
+        // The API validated the command when it was posted; a message processed since may
+        // have moved the state (e.g. a DISCONNECT queued behind a STOP)
+        if (msg.type == MessageType::COMMAND && state_machine.validate_command(msg.cmd) != Action::EXECUTE) {
+            log_event<LogId::COMMAND_DROPPED>((int32_t)msg.cmd, (int32_t)state_machine.get_current_state());
+            EventBits_t bits = state_machine.resolve_stale_command(msg.cmd);
+            if (bits != 0) {
+                sync_manager.set_bits(bits);
+            }
+            continue;
+        }
 
-bool WiFiManager::is_credentials_valid() const
-{
-    return storage.is_valid();
+        uint32_t dispatch_us = (uint32_t)esp_timer_get_time();
+#if CONFIG_WIFI_MANAGER_SYNC_API
+        if (msg.type == MessageType::TRANSACTION) {
+            Message deferred[wifi_manager::WiFiSyncManager::QUEUE_SIZE];
+            size_t deferred_count = 0;
+            execute_transaction(deferred, deferred_count);
+            record_dispatch(msg, picked_us, dispatch_us, (uint32_t)esp_timer_get_time());
+
+            // Commands held back by the transaction run now, in their original order
+            if (!dispatch_batch(deferred, deferred_count, (uint32_t)esp_timer_get_time())) {
+                return false;
+            }
+            continue;
+        }
+#endif
+
+        process_message(msg, state_machine.get_current_state());
+        record_dispatch(msg, picked_us, dispatch_us, (uint32_t)esp_timer_get_time());
+    }
+    return true;
 }
 
-WiFiManager::EventOutcome WiFiManager::resolve_event(EventId event) const
+void WiFiManager::handle_timer(wifi_manager::TimerId id)
 {
-    return state_machine.resolve_event(event);
+    switch (id) {
+    case wifi_manager::TimerId::RECONNECT:
+        // Reconnect Backoff Timeout
+        if (state_machine.get_current_state() == State::WAITING_RECONNECT) {
+            if (storage.is_valid()) {
+                uint32_t budget_wait_ms =
+                    retry_guard.acquire_attempt(esp_timer_get_time(), CONFIG_WIFI_MANAGER_ATTEMPT_BUDGET);
+                if (budget_wait_ms != 0) {
+                    log_event<LogId::BUDGET_EXHAUSTED>(CONFIG_WIFI_MANAGER_ATTEMPT_BUDGET,
+                                                       (int32_t)(budget_wait_ms / 1000));
+                    state_machine.schedule_reconnect(budget_wait_ms);
+                    break;
+                }
+                log_event<LogId::BACKOFF_DONE>();
+                if (begin_association() != ESP_OK) {
+                    // Nothing reached the driver: no event will end the attempt, the next backoff does
+                    uint32_t delay_ms;
+                    state_machine.calculate_next_backoff(delay_ms);
+                    log_event<LogId::RECONNECT_SCHEDULED>((int32_t)state_machine.get_retry_count(),
+                                                          (int32_t)delay_ms);
+                }
+            }
+            else {
+                state_machine.transition_to(State::DISCONNECTED);
+            }
+        }
+        break;
+    case wifi_manager::TimerId::CONNECT_WATCHDOG:
+    case wifi_manager::TimerId::DHCP_TIMEOUT:
+    {
+        // Stuck phase: feed a synthetic event through the transition matrix
+        Message msg = {};
+        msg.type    = MessageType::EVENT;
+        msg.event   = EventId::TIMEOUT;
+        process_message(msg, state_machine.get_current_state());
+        break;
+    }
+    case wifi_manager::TimerId::RSSI_SAMPLE:
+        if (state_machine.get_current_state() != State::CONNECTED_GOT_IP ||
+            driver_hal.get_rssi(last_rssi) != ESP_OK) {
+            break;
+        }
+        if (tx_power_control && tx_power.on_rssi_sample(last_rssi)) {
+            log_event<LogId::TX_POWER>(tx_power.get_power(), last_rssi);
+            apply_tx_power();
+        }
+        if (!roam_scan_pending && !roam_notice_pending &&
+            roam_policy.should_scan(last_rssi, (uint32_t)esp_timer_get_time()) &&
+            driver_hal.start_roam_scan(channel_lock) == ESP_OK) {
+            log_event<LogId::ROAM_SCAN>(last_rssi, roam_policy.get_config().trigger_rssi);
+            roam_scan_pending = true;
+        }
+        break;
+    case wifi_manager::TimerId::ROAM_DEADLINE:
+        if (roam_policy.is_fast_transition()) {
+            fall_back_from_roam();
+        }
+        break;
+    case wifi_manager::TimerId::CHANNEL_NOTICE:
+    {
+        // The peers had their lead time: roam unless a lock or another roam got in the way
+        roam_notice_pending = false;
+        uint8_t current[6];
+        if (state_machine.get_current_state() == State::CONNECTED_GOT_IP && !roam_policy.in_progress() &&
+            (channel_lock == 0 || channel_lock == roam_notice_target.channel) &&
+            driver_hal.get_bssid(current) == ESP_OK) {
+            execute_roam(current, roam_notice_target, (uint32_t)esp_timer_get_time());
+        }
+        else if (sta_channel != 0) {
+            notify_channel(sta_channel, false); // Called off: the peers stay
+        }
+        break;
+    }
+    case wifi_manager::TimerId::LINK_STABLE:
+        log_event<LogId::LINK_STABLE>();
+        retry_guard.mark_stable();
+        break;
+    case wifi_manager::TimerId::UPLINK_HOLD:
+        break; // Arbitrated below
+    default:
+        ESP_LOGD(TAG, "Timer %d expired with no handler", (int)id);
+        break;
+    }
+
+    // The timer may have moved the STA out of CONNECTED_GOT_IP (roam fallback), or ended a hold
+    arbitrate_uplinks((uint32_t)esp_timer_get_time());
 }
 
-esp_err_t WiFiManager::save_valid_flag(bool valid)
+void WiFiManager::sync_timers()
 {
-    return storage.save_valid_flag(valid);
-}
+    State state = state_machine.get_current_state();
 
-// =================================================================================================
-// Internal Implementation
-// =================================================================================================
+    if (state == State::WAITING_RECONNECT) {
+        timers.arm(wifi_manager::TimerId::RECONNECT, (int64_t)state_machine.get_next_reconnect_ms() * 1000);
+    }
+    else {
+        timers.cancel(wifi_manager::TimerId::RECONNECT);
+    }
 
-esp_err_t WiFiManager::post_message(const Message &msg, bool is_async)
-{
-    if (!sync_manager.is_initialized()) {
-        return ESP_ERR_INVALID_STATE;
+    // Watchdogs are armed on phase entry and keep their deadline while the phase lasts
+    if (state == State::CONNECTING && connect_timeout_ms != 0) {
+        if (!timers.is_armed(wifi_manager::TimerId::CONNECT_WATCHDOG)) {
+            timers.arm(wifi_manager::TimerId::CONNECT_WATCHDOG,
+                       esp_timer_get_time() + (int64_t)connect_timeout_ms * 1000);
+        }
+    }
+    else {
+        timers.cancel(wifi_manager::TimerId::CONNECT_WATCHDOG);
     }
 
-    // For async calls, we use the non-blocking post_message
-    // For sync calls, we could enhance WiFiSyncManager to support blocking, but for now we use the same method
-    esp_err_t err = sync_manager.post_message(msg);
-    if (err != ESP_OK && msg.type == MessageType::COMMAND) {
-        ESP_LOGE(TAG, "Failed to send command to queue (full?)");
+    if (state == State::CONNECTED_NO_IP && dhcp_timeout_ms != 0) {
+        if (!timers.is_armed(wifi_manager::TimerId::DHCP_TIMEOUT)) {
+            timers.arm(wifi_manager::TimerId::DHCP_TIMEOUT, esp_timer_get_time() + (int64_t)dhcp_timeout_ms * 1000);
+        }
+    }
+    else {
+        timers.cancel(wifi_manager::TimerId::DHCP_TIMEOUT);
     }
-    return err;
-}
 
-void WiFiManager::process_message(const Message &msg, State state)
-{
-    if (msg.type == MessageType::COMMAND) {
-        // Any explicit user command resets the retry counters (except EXIT)
-        if (msg.cmd != CommandId::EXIT) {
-            state_machine.reset_retries();
+    if (state == State::CONNECTED_GOT_IP && retry_guard.get_boot_count() > 1) {
+        if (!timers.is_armed(wifi_manager::TimerId::LINK_STABLE)) {
+            timers.arm(wifi_manager::TimerId::LINK_STABLE,
+                       esp_timer_get_time() + (int64_t)CONFIG_WIFI_MANAGER_STABLE_LINK_MS * 1000);
         }
+    }
+    else {
+        timers.cancel(wifi_manager::TimerId::LINK_STABLE);
+    }
 
-        switch (msg.cmd) {
-        case CommandId::START:
-            handle_start(msg, state);
-            break;
-        case CommandId::STOP:
-            handle_stop(msg, state);
-            break;
-        case CommandId::CONNECT:
-            handle_connect(msg, state);
-            break;
-        case CommandId::DISCONNECT:
-            handle_disconnect(msg, state);
-            break;
-        default:
-            break;
+    if (state == State::CONNECTED_GOT_IP && CONFIG_WIFI_MANAGER_RSSI_SAMPLE_MS != 0) {
+        if (!timers.is_armed(wifi_manager::TimerId::RSSI_SAMPLE)) {
+            timers.arm(wifi_manager::TimerId::RSSI_SAMPLE,
+                       esp_timer_get_time() + (int64_t)CONFIG_WIFI_MANAGER_RSSI_SAMPLE_MS * 1000);
         }
     }
     else {
-        // Handle system event via Transition Matrix
-        handle_event(msg, state);
+        timers.cancel(wifi_manager::TimerId::RSSI_SAMPLE);
     }
-}
 
-void WiFiManager::handle_start(const Message &msg, State state)
-{
-    state_machine.transition_to(State::STARTING);
-    esp_err_t err = driver_hal.start();
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to start wifi: %s", esp_err_to_name(err));
-        state_machine.transition_to(state);
-        sync_manager.set_bits(wifi_manager::START_FAILED_BIT);
+    // A fast transition stays in CONNECTED_GOT_IP: no phase watchdog covers it
+    if (roam_policy.is_fast_transition()) {
+        if (!timers.is_armed(wifi_manager::TimerId::ROAM_DEADLINE)) {
+            timers.arm(wifi_manager::TimerId::ROAM_DEADLINE,
+                       esp_timer_get_time() + (int64_t)CONFIG_WIFI_MANAGER_ROAM_TIMEOUT_MS * 1000);
+        }
+    }
+    else {
+        timers.cancel(wifi_manager::TimerId::ROAM_DEADLINE);
     }
-}
 
-void WiFiManager::handle_stop(const Message &msg, State state)
-{
-    state_machine.transition_to(State::STOPPING);
-    esp_err_t err = driver_hal.stop();
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to stop wifi: %s", esp_err_to_name(err));
-        state_machine.transition_to(state);
-        sync_manager.set_bits(wifi_manager::STOP_FAILED_BIT);
+    // Lead time of the ESP-NOW peers before a roam to another channel
+    if (roam_notice_pending) {
+        if (!timers.is_armed(wifi_manager::TimerId::CHANNEL_NOTICE)) {
+            timers.arm(wifi_manager::TimerId::CHANNEL_NOTICE,
+                       esp_timer_get_time() + (int64_t)CONFIG_WIFI_MANAGER_CHANNEL_NOTICE_MS * 1000);
+        }
+    }
+    else {
+        timers.cancel(wifi_manager::TimerId::CHANNEL_NOTICE);
     }
-}
 
-void WiFiManager::handle_connect(const Message &msg, State state)
-{
-    state_machine.transition_to(State::CONNECTING);
-    esp_err_t err = driver_hal.connect();
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to connect wifi: %s", esp_err_to_name(err));
-        state_machine.transition_to(state);
-        sync_manager.set_bits(wifi_manager::CONNECT_FAILED_BIT);
+    // A preferred uplink takes the default route back at the end of its hold
+    uint32_t hold_us;
+    if (uplinks.failback_pending((uint32_t)esp_timer_get_time(), hold_us)) {
+        timers.arm(wifi_manager::TimerId::UPLINK_HOLD, esp_timer_get_time() + hold_us);
+    }
+    else {
+        timers.cancel(wifi_manager::TimerId::UPLINK_HOLD);
+    }
+
+    // RTC store, written only when the backoff exponent moved
+    uint32_t retries = state_machine.get_retry_count();
+    if (retries != retry_guard.get_retry_count()) {
+        retry_guard.save_retry_count(retries);
     }
 }
 
-void WiFiManager::handle_disconnect(const Message &msg, State state)
+void WiFiManager::run_expired_timers()
 {
-    // SPECIAL CASE: Rollback during early connect phase or backoff.
-    if (state == State::WAITING_RECONNECT || state == State::CONNECTING) {
-        state_machine.transition_to(State::DISCONNECTED);
-        driver_hal.disconnect();
-        sync_manager.set_bits(wifi_manager::DISCONNECTED_BIT);
-        return;
+    wifi_manager::TimerId id;
+    while (timers.pop_expired(esp_timer_get_time(), id)) {
+        handle_timer(id);
+        sync_timers();
     }
+}
 
-    state_machine.transition_to(State::DISCONNECTING);
-    esp_err_t err = driver_hal.disconnect();
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to disconnect wifi: %s", esp_err_to_name(err));
-        state_machine.transition_to(state);
-        sync_manager.set_bits(wifi_manager::CONNECT_FAILED_BIT);
+// =================================================================================================
+// Hot path logging
+// =================================================================================================
+
+template <WiFiManager::LogId ID> void WiFiManager::log_event(int32_t a0, int32_t a1, int32_t a2)
+{
+    constexpr esp_log_level_t level = (esp_log_level_t)wifi_manager::log_level(ID);
+    if constexpr (level <= LOG_LOCAL_LEVEL) {
+#if CONFIG_WIFI_MANAGER_DEFERRED_LOG
+        bool was_empty;
+        if (log_ring.write(esp_timer_get_time(), ID, a0, a1, a2, was_empty) && was_empty) {
+            xTaskNotifyGive(log_task_handle);
+        }
+#else
+        wifi_manager::LogRecord record = {0, ID, {a0, a1, a2}};
+        char line[LOG_LINE_MAX];
+        wifi_manager::format_record(record, line, sizeof(line));
+        ESP_LOG_LEVEL(level, TAG, "%s", line);
+#endif
     }
 }
 
-void WiFiManager::handle_event(const Message &msg, State state)
+#if CONFIG_WIFI_MANAGER_DEFERRED_LOG
+esp_err_t WiFiManager::start_log_task()
 {
-    EventOutcome outcome = state_machine.resolve_event(msg.event);
-
-    // 1. Perform state transition
-    if (outcome.next_state != state) {
-        ESP_LOGD(TAG, "Event %d: State transition %d -> %d", (int)msg.event, (int)state, (int)outcome.next_state);
-        state_machine.transition_to(outcome.next_state);
+    if (log_task_handle != nullptr) {
+        return ESP_OK;
     }
-
-    // 2. Set synchronization bits for API callers
-    if (outcome.bits_to_set != 0) {
-        sync_manager.set_bits(outcome.bits_to_set);
+    log_task_exit = false;
+    if (xTaskCreate(log_task, "wifi_log", CONFIG_WIFI_MANAGER_LOG_TASK_STACK_SIZE, this,
+                    CONFIG_WIFI_MANAGER_LOG_TASK_PRIORITY, &log_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create log task");
+        log_task_handle = nullptr;
+        return ESP_ERR_NO_MEM;
     }
+    return ESP_OK;
+}
 
-    // 3. Handle Side Effects (Complex logic)
-    switch (msg.event) {
-    case EventId::STA_DISCONNECTED:
-    {
-        const char *quality = (msg.rssi >= WiFiStateMachine::RSSI_THRESHOLD_GOOD)     ? "GOOD"
-                              : (msg.rssi >= WiFiStateMachine::RSSI_THRESHOLD_MEDIUM) ? "MEDIUM"
-                              : (msg.rssi >= WiFiStateMachine::RSSI_THRESHOLD_WEAK)   ? "WEAK"
-                                                                                      : "CRITICAL";
-
-        ESP_LOGI(TAG, "Task Event: STA_DISCONNECTED (reason: %d, RSSI=%d dBm [%s])", msg.reason, msg.rssi, quality);
-
-        // Case A: Disconnection was intended or while driver is inactive
-        if (state == State::DISCONNECTING || state == State::STOPPING || !state_machine.is_active()) {
-            sync_manager.set_bits(wifi_manager::DISCONNECTED_BIT | wifi_manager::CONNECT_FAILED_BIT);
-            break;
-        }
+void WiFiManager::log_task(void *pvParameters)
+{
+    WiFiManager *self = static_cast<WiFiManager *>(pvParameters);
+    wifi_manager::LogRecord record;
+    char line[LOG_LINE_MAX];
 
-        // Case B: Intentional disconnect from AP side (usually leave)
-        if (msg.reason == WIFI_REASON_ASSOC_LEAVE) {
-            ESP_LOGI(TAG, "Disconnected (Reason: ASSOC_LEAVE).");
-            state_machine.transition_to(State::DISCONNECTED);
-            sync_manager.set_bits(wifi_manager::DISCONNECTED_BIT | wifi_manager::CONNECT_FAILED_BIT);
-            break;
+    while (true) {
+        // wifi_task only notifies when it writes into an empty ring; the period covers a record
+        // written while this loop was emptying it
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS));
+
+        while (self->log_ring.read(record)) {
+            wifi_manager::format_record(record, line, sizeof(line));
+            uint32_t age_ms = record.age_us(esp_timer_get_time()) / 1000;
+            ESP_LOG_LEVEL((esp_log_level_t)wifi_manager::log_level(record.id), TAG, "%s [%lu ms ago]", line,
+                          (unsigned long)age_ms);
         }
 
-        // Case C: Definite credential failure (Currently NONE, all moved to Suspect to be RSSI-aware)
-        // We could keep some here if we were sure they are NEVER caused by bad signal.
-
-        // Case D: Suspect failure (potential wrong password or bad signal)
-        // These reasons can be caused by both wrong credentials and poor signal/interference.
-        // We handle this in a dynamic way based on RSSI, passing rssi to handle_suspect_failure()
-        if (msg.reason == WIFI_REASON_AUTH_FAIL || msg.reason == WIFI_REASON_802_1X_AUTH_FAILED ||
-            msg.reason == WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT || msg.reason == WIFI_REASON_HANDSHAKE_TIMEOUT ||
-            msg.reason == WIFI_REASON_CONNECTION_FAIL) {
-            if (state_machine.handle_suspect_failure(msg.rssi)) {
-                ESP_LOGE(TAG, "Authentication failed due to too many suspect failures (Reason: %d). Invalidating.",
-                         msg.reason);
-                this->storage.save_valid_flag(false);
-                // State machine already transited to ERROR_CREDENTIALS in handle_suspect_failure
-            }
-            else {
-                uint32_t delay_ms;
-                state_machine.calculate_next_backoff(delay_ms);
-                ESP_LOGW(TAG,
-                         "Suspect failure (Reason: %d), retrying in %lu ms due to poor signal or allowed attempts...",
-                         msg.reason, (unsigned long)delay_ms);
-                // State machine already transited to WAITING_RECONNECT in calculate_next_backoff
-            }
-            sync_manager.set_bits(wifi_manager::CONNECT_FAILED_BIT);
-            break;
-        }
-        // Case E: Recoverable failure (signal loss, congestion, etc.)
-        if (this->storage.is_valid()) {
-            uint32_t delay_ms;
-            state_machine.calculate_next_backoff(delay_ms);
-            ESP_LOGI(TAG, "Reconnection attempt %lu in %lu ms...", (unsigned long)state_machine.get_retry_count(),
-                     (unsigned long)delay_ms);
-        }
-        else {
-            state_machine.transition_to(State::DISCONNECTED);
+        uint32_t dropped = self->log_ring.take_dropped();
+        if (dropped != 0) {
+            ESP_LOGW(TAG, "%lu log records dropped (rate limit or full ring)", (unsigned long)dropped);
         }
-        sync_manager.set_bits(wifi_manager::CONNECT_FAILED_BIT);
-        break;
-    }
 
-    case EventId::GOT_IP:
-        ESP_LOGI(TAG, "Task Event: GOT_IP");
-        state_machine.reset_retries();
-        if (!this->storage.is_valid()) {
-            this->storage.save_valid_flag(true);
+        // deinit(): wifi_task is gone and its last records are printed
+        if (self->log_task_exit.load()) {
+            self->log_task_handle = nullptr;
+            xSemaphoreGive(self->task_exit_sem);
+            vTaskDelete(NULL);
+            return;
         }
-        break;
-
-    default:
-        break;
     }
 }
+#endif
 
 void WiFiManager::wifi_task(void *pvParameters)
 {
     WiFiManager *self = static_cast<WiFiManager *>(pvParameters);
-    Message msg;
+    Message batch[wifi_manager::WiFiSyncManager::QUEUE_SIZE];
+
+    // Count the boot once per reset, before the first command can schedule a reconnect
+    xSemaphoreTakeRecursive(self->state_mutex, portMAX_DELAY);
+    if (!self->boot_recorded) {
+        self->restore_retry_state();
+    }
+    xSemaphoreGiveRecursive(self->state_mutex);
+
+    // Background bring-up requested by init_async()
+    if (self->async_init_pending) {
+        self->run_async_init();
+    }
 
     while (true) {
-        // Ask the state machine how long to wait (it handles all backoff logic internally)
-        TickType_t wait_ticks = self->state_machine.get_wait_ticks();
+        // Sleep on the queue until the next message or the earliest deadline
+        TickType_t wait_ticks = self->timers.get_wait_ticks(esp_timer_get_time());
 
-        if (xQueueReceive(self->sync_manager.get_queue(), &msg, wait_ticks) == pdTRUE) {
+        if (xQueueReceive(self->sync_manager.get_queue(), &batch[0], wait_ticks) == pdTRUE) {
+            uint32_t dequeue_us = (uint32_t)esp_timer_get_time();
             xSemaphoreTakeRecursive(self->state_mutex, portMAX_DELAY);
 
-            // Handle Task Termination
-            if (msg.type == MessageType::COMMAND && msg.cmd == CommandId::EXIT) {
+            // Take everything queued behind the first message so superseded commands can be
+            // dropped before their blocking driver calls run
+            size_t count = 1 + self->sync_manager.drain(&batch[1], wifi_manager::WiFiSyncManager::QUEUE_SIZE - 1);
+
+            if (!self->dispatch_batch(batch, count, dequeue_us)) {
+                // Handle Task Termination
                 ESP_LOGI(TAG, "WiFi Task exiting...");
-                xSemaphoreGiveRecursive(self->state_mutex);
                 self->task_handle = nullptr;
+                xSemaphoreGiveRecursive(self->state_mutex);
+                // Wake deinit() only once we no longer touch any other manager resource
+                xSemaphoreGive(self->task_exit_sem);
                 vTaskDelete(NULL);
                 return;
             }
-
-            self->process_message(msg, self->state_machine.get_current_state());
-            xSemaphoreGiveRecursive(self->state_mutex);
+            self->sync_timers();
         }
         else {
-            // Reconnect Backoff Timeout
+            // The wait ended on the earliest deadline. It is rounded up to whole ticks, so the
+            // deadline has passed unless the tick count ran ahead of esp_timer; then the next
+            // wait is at least one tick instead of firing the timer early.
             xSemaphoreTakeRecursive(self->state_mutex, portMAX_DELAY);
-            if (self->state_machine.get_current_state() == State::WAITING_RECONNECT) {
-                if (self->storage.is_valid()) {
-                    ESP_LOGI(TAG, "Backoff finished. Retrying connection...");
-                    self->state_machine.transition_to(State::CONNECTING);
-                    self->driver_hal.connect();
-                }
-                else {
-                    self->state_machine.transition_to(State::DISCONNECTED);
-                }
-            }
-            xSemaphoreGiveRecursive(self->state_mutex);
         }
+
+        // Fire the expired deadlines; a busy queue must not starve them either
+        self->run_expired_timers();
+        xSemaphoreGiveRecursive(self->state_mutex);
     }
 }
@@ -0,0 +1,114 @@
+#include "wifi_retry_guard.hpp"
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#include "sdkconfig.h"
+#endif
+
+namespace wifi_manager {
+
+#if !defined(ESP_PLATFORM) || CONFIG_IDF_TARGET_LINUX
+static WiFiRetryGuard::Record s_rtc_record;
+#else
+static RTC_NOINIT_ATTR WiFiRetryGuard::Record s_rtc_record;
+#endif
+
+WiFiRetryGuard::Record &WiFiRetryGuard::rtc_record()
+{
+    return s_rtc_record;
+}
+
+WiFiRetryGuard::WiFiRetryGuard(Record &record)
+    : m_record(record)
+    , m_window_start_us(0)
+{
+}
+
+void WiFiRetryGuard::begin_boot(int64_t now_us)
+{
+    if (!is_intact()) {
+        reset();
+    }
+
+    m_record.boot_count++;
+    seal();
+
+    m_window_start_us = now_us - (int64_t)m_record.window_elapsed_ms * 1000;
+}
+
+bool WiFiRetryGuard::is_crash_loop(uint32_t threshold) const
+{
+    return threshold != 0 && m_record.boot_count > threshold;
+}
+
+void WiFiRetryGuard::save_retry_count(uint32_t retry_count)
+{
+    if (m_record.retry_count == retry_count) {
+        return;
+    }
+    m_record.retry_count = retry_count;
+    seal();
+}
+
+void WiFiRetryGuard::mark_stable()
+{
+    if (m_record.boot_count <= 1) {
+        return;
+    }
+    // This boot is the one that made it: it counts as the first of a healthy run
+    m_record.boot_count = 1;
+    seal();
+}
+
+uint32_t WiFiRetryGuard::acquire_attempt(int64_t now_us, uint32_t budget)
+{
+    int64_t elapsed_ms = (now_us - m_window_start_us) / 1000;
+    if (elapsed_ms < 0 || elapsed_ms >= (int64_t)BUDGET_WINDOW_MS) {
+        m_window_start_us        = now_us;
+        elapsed_ms               = 0;
+        m_record.window_attempts = 0;
+    }
+
+    if (budget != 0 && m_record.window_attempts >= budget) {
+        return (uint32_t)(BUDGET_WINDOW_MS - elapsed_ms);
+    }
+
+    m_record.window_attempts++;
+    m_record.window_elapsed_ms = (uint32_t)elapsed_ms;
+    seal();
+    return 0;
+}
+
+bool WiFiRetryGuard::is_intact() const
+{
+    return m_record.magic == MAGIC && m_record.checksum == compute_checksum();
+}
+
+void WiFiRetryGuard::reset()
+{
+    m_record       = {};
+    m_record.magic = MAGIC;
+    seal();
+}
+
+void WiFiRetryGuard::seal()
+{
+    m_record.checksum = compute_checksum();
+}
+
+uint32_t WiFiRetryGuard::compute_checksum() const
+{
+    // FNV-1a over every field but the checksum itself
+    const uint32_t words[] = {m_record.magic, m_record.boot_count, m_record.retry_count, m_record.window_attempts,
+                              m_record.window_elapsed_ms};
+    uint32_t hash = 2166136261UL;
+    for (uint32_t word : words) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            hash ^= (word >> shift) & 0xFF;
+            hash *= 16777619UL;
+        }
+    }
+    return hash;
+}
+
+} // namespace wifi_manager
@@ -0,0 +1,175 @@
+#include "wifi_roam_policy.hpp"
+
+#include <cstring>
+
+namespace wifi_manager {
+
+WiFiRoamPolicy::WiFiRoamPolicy(const RoamConfig &config)
+    : m_config(config)
+    , m_ft(FtState::DISABLED)
+    , m_mode(Mode::NONE)
+    , m_target()
+    , m_origin()
+    , m_start_us(0)
+    , m_link_lost(false)
+    , m_scanned(false)
+    , m_last_scan_us(0)
+    , m_domain()
+    , m_domain_next(0)
+    , m_channel_lock(0)
+    , m_status()
+{
+    reset();
+}
+
+void WiFiRoamPolicy::set_config(const RoamConfig &config)
+{
+    m_config = config;
+    reset();
+}
+
+void WiFiRoamPolicy::reset()
+{
+    m_ft          = m_config.ft ? FtState::UNKNOWN : FtState::DISABLED;
+    m_scanned     = false;
+    m_domain_next = 0;
+    m_status      = {};
+    m_status.ft   = m_ft;
+}
+
+bool WiFiRoamPolicy::should_scan(int8_t rssi, uint32_t now_us)
+{
+    if (!m_config.is_enabled() || m_mode != Mode::NONE || rssi >= m_config.trigger_rssi) {
+        return false;
+    }
+    // Unsigned difference: correct across the 32-bit wrap for intervals below ~71 min
+    if (m_scanned && now_us - m_last_scan_us < m_config.scan_interval_ms * 1000) {
+        return false;
+    }
+    m_scanned      = true;
+    m_last_scan_us = now_us;
+    m_status.scans++;
+    return true;
+}
+
+bool WiFiRoamPolicy::select(const uint8_t (&current)[6], int8_t current_rssi, uint8_t current_channel,
+                            const RoamCandidate *candidates, size_t count, RoamCandidate &target) const
+{
+    bool found = false;
+    int best   = current_rssi + m_config.hysteresis_db;
+    for (size_t i = 0; i < count; i++) {
+        const RoamCandidate &candidate = candidates[i];
+        if (memcmp(candidate.bssid, current, sizeof(current)) == 0 ||
+            (m_channel_lock != 0 && candidate.channel != m_channel_lock)) {
+            continue;
+        }
+        // Staying on the channel spares the ESP-NOW peers a move: compare with the bias
+        int score = candidate.rssi;
+        if (current_channel != 0 && candidate.channel == current_channel) {
+            score += m_config.channel_bias_db;
+        }
+        if (score < best) {
+            continue;
+        }
+        // Equal score: an AP of the known domain roams faster
+        if (found && score == best && !in_domain(candidate.bssid)) {
+            continue;
+        }
+        target = candidate;
+        best   = score;
+        found  = true;
+    }
+    return found;
+}
+
+WiFiRoamPolicy::Mode WiFiRoamPolicy::begin(const uint8_t (&current)[6], const RoamCandidate &target,
+                                           uint32_t now_us)
+{
+    bool fast = m_config.ft && (m_ft != FtState::UNAVAILABLE || in_domain(target.bssid));
+    m_mode    = fast ? Mode::FAST_TRANSITION : Mode::RECONNECT;
+    m_target  = target;
+    memcpy(m_origin, current, sizeof(m_origin));
+    m_start_us  = now_us;
+    m_link_lost = false;
+    return m_mode;
+}
+
+bool WiFiRoamPolicy::absorb_link_loss(uint32_t now_us)
+{
+    if (m_mode != Mode::FAST_TRANSITION || m_link_lost) {
+        return false;
+    }
+    m_link_lost = true;
+    m_start_us  = now_us;
+    return true;
+}
+
+uint32_t WiFiRoamPolicy::finish(uint32_t now_us)
+{
+    uint32_t gap_us = now_us - m_start_us;
+    if (m_mode == Mode::FAST_TRANSITION) {
+        m_status.fast_transitions++;
+        m_status.ft_gap.record(gap_us);
+        // Nothing to learn if FT was disabled while the transition ran
+        if (m_config.ft && gap_us <= FT_GAP_MAX_US) {
+            m_ft = FtState::AVAILABLE;
+            learn_domain(m_origin);
+            learn_domain(m_target.bssid);
+        }
+        else if (m_config.ft) {
+            // Reassociated, but through a full authentication: the APs share no domain
+            m_ft = FtState::UNAVAILABLE;
+        }
+    }
+    else if (m_mode == Mode::RECONNECT) {
+        m_status.reconnects++;
+        m_status.reconnect_gap.record(gap_us);
+    }
+    m_mode      = Mode::NONE;
+    m_status.ft = m_ft;
+    return gap_us;
+}
+
+void WiFiRoamPolicy::abort(bool failed)
+{
+    if (m_mode == Mode::NONE) {
+        return;
+    }
+    if (failed) {
+        m_status.failures++;
+        if (m_mode == Mode::FAST_TRANSITION && m_config.ft) {
+            m_ft = FtState::UNAVAILABLE;
+        }
+    }
+    m_mode      = Mode::NONE;
+    m_status.ft = m_ft;
+}
+
+bool WiFiRoamPolicy::in_domain(const uint8_t (&bssid)[6]) const
+{
+    for (uint8_t i = 0; i < m_status.domain_size; i++) {
+        if (memcmp(m_domain[i], bssid, sizeof(bssid)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WiFiRoamPolicy::learn_domain(const uint8_t (&bssid)[6])
+{
+    if (in_domain(bssid)) {
+        return;
+    }
+    uint8_t slot;
+    if (m_status.domain_size < DOMAIN_MAX) {
+        slot = m_status.domain_size++;
+    }
+    else {
+        // Full: replace the oldest member
+        slot          = m_domain_next;
+        m_domain_next = (uint8_t)((m_domain_next + 1) % DOMAIN_MAX);
+    }
+    memcpy(m_domain[slot], bssid, sizeof(bssid));
+}
+
+} // namespace wifi_manager
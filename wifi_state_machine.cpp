@@ -1,5 +1,4 @@
 #include "wifi_state_machine.hpp"
-#include "esp_timer.h"
 #include <algorithm>
 
 // Re-defining bits here or mapping them? Let's use the same values for consistency.
@@ -46,6 +45,11 @@ const WiFiStateMachine::Action WiFiStateMachine::s_command_matrix[(int)State::CO
 const WiFiStateMachine::EventOutcome WiFiStateMachine::s_transition_matrix[(int)State::COUNT][(int)EventId::COUNT] = {
     /* UNINITIALIZED  */
     {{State::UNINITIALIZED, 0},
+     {State::UNINITIALIZED, 0},
+     {State::UNINITIALIZED, 0},
+     {State::UNINITIALIZED, 0},
+     {State::UNINITIALIZED, 0},
+     {State::UNINITIALIZED, 0},
      {State::UNINITIALIZED, 0},
      {State::UNINITIALIZED, 0},
      {State::UNINITIALIZED, 0},
@@ -53,6 +57,11 @@ const WiFiStateMachine::EventOutcome WiFiStateMachine::s_transition_matrix[(int)
      {State::UNINITIALIZED, 0}},
     /* INITIALIZING   */
     {{State::INITIALIZING, 0},
+     {State::INITIALIZING, 0},
+     {State::INITIALIZING, 0},
+     {State::INITIALIZING, 0},
+     {State::INITIALIZING, 0},
+     {State::INITIALIZING, 0},
      {State::INITIALIZING, 0},
      {State::INITIALIZING, 0},
      {State::INITIALIZING, 0},
@@ -60,6 +69,11 @@ const WiFiStateMachine::EventOutcome WiFiStateMachine::s_transition_matrix[(int)
      {State::INITIALIZING, 0}},
     /* INITIALIZED    */
     {{State::INITIALIZED, 0},
+     {State::INITIALIZED, 0},
+     {State::INITIALIZED, 0},
+     {State::INITIALIZED, 0},
+     {State::INITIALIZED, 0},
+     {State::INITIALIZED, 0},
      {State::INITIALIZED, 0},
      {State::INITIALIZED, 0},
      {State::INITIALIZED, 0},
@@ -71,9 +85,19 @@ const WiFiStateMachine::EventOutcome WiFiStateMachine::s_transition_matrix[(int)
      {State::STARTING, 0},
      {State::INITIALIZED, START_FAILED_BIT},
      {State::STARTING, 0},
+     {State::STARTING, 0},
+     {State::STARTING, 0},
+     {State::STARTING, 0},
+     {State::STARTING, 0},
+     {State::STARTING, 0},
      {State::STARTING, 0}},
     /* STARTED        */
     {{State::STARTED, 0},
+     {State::STARTED, 0},
+     {State::STARTED, 0},
+     {State::STARTED, 0},
+     {State::STARTED, 0},
+     {State::STARTED, 0},
      {State::STARTED, 0},
      {State::STARTED, 0},
      {State::STARTED, 0},
@@ -85,6 +109,11 @@ const WiFiStateMachine::EventOutcome WiFiStateMachine::s_transition_matrix[(int)
      {State::CONNECTED_NO_IP, 0},
      {State::WAITING_RECONNECT, 0},
      {State::CONNECTED_GOT_IP, CONNECTED_BIT},
+     {State::CONNECTING, 0},
+     {State::WAITING_RECONNECT, CONNECT_FAILED_BIT},
+     {State::CONNECTING, 0},
+     {State::CONNECTING, 0},
+     {State::CONNECTING, 0},
      {State::CONNECTING, 0}},
     /* CONNECTED_NO_IP*/
     {{State::CONNECTED_NO_IP, 0},
@@ -92,6 +121,11 @@ const WiFiStateMachine::EventOutcome WiFiStateMachine::s_transition_matrix[(int)
      {State::CONNECTED_NO_IP, 0},
      {State::WAITING_RECONNECT, 0},
      {State::CONNECTED_GOT_IP, CONNECTED_BIT},
+     {State::CONNECTED_NO_IP, 0},
+     {State::WAITING_RECONNECT, CONNECT_FAILED_BIT},
+     {State::CONNECTED_NO_IP, 0},
+     {State::CONNECTED_NO_IP, 0},
+     {State::CONNECTED_NO_IP, 0},
      {State::CONNECTED_NO_IP, 0}},
     /* CONNECTED_GOT_IP*/
     {{State::CONNECTED_GOT_IP, 0},
@@ -99,16 +133,31 @@ const WiFiStateMachine::EventOutcome WiFiStateMachine::s_transition_matrix[(int)
      {State::CONNECTED_GOT_IP, 0},
      {State::WAITING_RECONNECT, 0},
      {State::CONNECTED_GOT_IP, 0},
-     {State::CONNECTED_NO_IP, 0}},
+     {State::CONNECTED_NO_IP, 0},
+     {State::CONNECTED_GOT_IP, 0},
+     {State::CONNECTED_GOT_IP, 0},
+     {State::CONNECTED_GOT_IP, 0},
+     {State::CONNECTED_GOT_IP, 0},
+     {State::CONNECTED_GOT_IP, 0}},
     /* DISCONNECTING  */
     {{State::DISCONNECTING, 0},
      {State::DISCONNECTING, 0},
      {State::DISCONNECTING, 0},
-     {State::STARTED, DISCONNECTED_BIT},
+     {State::STARTED, DISCONNECTED_BIT | CONNECT_FAILED_BIT},
+     {State::DISCONNECTING, 0},
+     {State::DISCONNECTING, 0},
+     {State::DISCONNECTING, 0},
+     {State::DISCONNECTING, 0},
+     {State::DISCONNECTING, 0},
      {State::DISCONNECTING, 0},
      {State::DISCONNECTING, 0}},
     /* WAITING_RECON  */
     {{State::WAITING_RECONNECT, 0},
+     {State::WAITING_RECONNECT, 0},
+     {State::WAITING_RECONNECT, 0},
+     {State::WAITING_RECONNECT, 0},
+     {State::WAITING_RECONNECT, 0},
+     {State::WAITING_RECONNECT, 0},
      {State::WAITING_RECONNECT, 0},
      {State::WAITING_RECONNECT, 0},
      {State::WAITING_RECONNECT, 0},
@@ -116,6 +165,11 @@ const WiFiStateMachine::EventOutcome WiFiStateMachine::s_transition_matrix[(int)
      {State::WAITING_RECONNECT, 0}},
     /* ERROR_CRED     */
     {{State::ERROR_CREDENTIALS, 0},
+     {State::ERROR_CREDENTIALS, 0},
+     {State::ERROR_CREDENTIALS, 0},
+     {State::ERROR_CREDENTIALS, 0},
+     {State::ERROR_CREDENTIALS, 0},
+     {State::ERROR_CREDENTIALS, 0},
      {State::ERROR_CREDENTIALS, 0},
      {State::ERROR_CREDENTIALS, 0},
      {State::ERROR_CREDENTIALS, 0},
@@ -127,6 +181,11 @@ const WiFiStateMachine::EventOutcome WiFiStateMachine::s_transition_matrix[(int)
      {State::STOPPING, 0},
      {State::STOPPING, 0},
      {State::STOPPING, 0},
+     {State::STOPPING, 0},
+     {State::STOPPING, 0},
+     {State::STOPPING, 0},
+     {State::STOPPING, 0},
+     {State::STOPPING, 0},
      {State::STOPPING, 0}},
 };
 
@@ -135,6 +194,14 @@ WiFiStateMachine::WiFiStateMachine()
     , m_retry_count(0)
     , m_suspect_retry_count(0)
     , m_next_reconnect_ms(0)
+    , m_ip_readiness(IpReadiness::IPV4)
+    , m_addresses(0)
+    , m_phy_failures(0)
+    , m_phy_fallback(0)
+    , m_twt_state(TwtState::OFF)
+    , m_twt_lost(false)
+    , m_twt_setups(0)
+    , m_twt_renegotiations(0)
 {
 }
 
@@ -152,6 +219,130 @@ WiFiStateMachine::EventOutcome WiFiStateMachine::resolve_event(EventId event) co
     return s_transition_matrix[(int)m_current_state][(int)event];
 }
 
+EventBits_t WiFiStateMachine::resolve_stale_command(CommandId cmd) const
+{
+    if (validate_command(cmd) == Action::ERROR) {
+        return INVALID_STATE_BIT;
+    }
+
+    State state = m_current_state;
+    switch (cmd) {
+    case CommandId::START:
+        return (state == State::STARTING) ? 0 : STARTED_BIT;
+    case CommandId::STOP:
+        return (state == State::STOPPING) ? 0 : STOPPED_BIT;
+    case CommandId::CONNECT:
+        return (state == State::CONNECTING || state == State::CONNECTED_NO_IP) ? 0 : CONNECTED_BIT;
+    case CommandId::DISCONNECT:
+        return (state == State::DISCONNECTING) ? 0 : DISCONNECTED_BIT;
+    default:
+        return 0;
+    }
+}
+
+uint32_t WiFiStateMachine::find_superseded(const wifi_manager::Message *batch, size_t count)
+{
+    uint32_t superseded     = 0;
+    bool stop_pending       = false;
+    uint32_t cancel_pending = 0; // One bit per CommandId with a CANCEL queued after it
+
+    // Walk backwards so every command sees whether a STOP or CANCEL follows it
+    for (size_t i = std::min(count, (size_t)32); i-- > 0;) {
+        const wifi_manager::Message &msg = batch[i];
+        if (msg.type == wifi_manager::MessageType::CANCEL) {
+            cancel_pending |= (1UL << (int)msg.cmd);
+            continue;
+        }
+        if (msg.type != wifi_manager::MessageType::COMMAND) {
+            continue;
+        }
+        if (msg.cmd == CommandId::STOP) {
+            stop_pending = true;
+        }
+        else if (msg.cmd == CommandId::START || msg.cmd == CommandId::CONNECT || msg.cmd == CommandId::DISCONNECT) {
+            if (stop_pending || (cancel_pending & (1UL << (int)msg.cmd))) {
+                superseded |= (1UL << i);
+            }
+        }
+    }
+    return superseded;
+}
+
+WiFiStateMachine::DisconnectClass WiFiStateMachine::classify_disconnect(State state, State next_state, uint8_t reason)
+{
+    // Case A: Disconnection was intended or while driver is inactive
+    if (state == State::DISCONNECTING || state == State::STOPPING || !s_state_props[(int)next_state].is_active) {
+        return DisconnectClass::EXPECTED;
+    }
+
+    // Case B: Intentional disconnect from AP side (usually leave)
+    if (reason == WIFI_REASON_ASSOC_LEAVE) {
+        return DisconnectClass::LEFT;
+    }
+
+    // Case C: Definite credential failure (Currently NONE, all moved to Suspect to be RSSI-aware)
+    // We could keep some here if we were sure they are NEVER caused by bad signal.
+
+    // Case D: Suspect failure (potential wrong password or bad signal)
+    // These reasons can be caused by both wrong credentials and poor signal/interference.
+    if (reason == WIFI_REASON_AUTH_FAIL || reason == WIFI_REASON_802_1X_AUTH_FAILED ||
+        reason == WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT || reason == WIFI_REASON_HANDSHAKE_TIMEOUT ||
+        reason == WIFI_REASON_CONNECTION_FAIL) {
+        return DisconnectClass::SUSPECT;
+    }
+
+    // Case E: Recoverable failure (signal loss, congestion, etc.)
+    return DisconnectClass::RECOVERABLE;
+}
+
+WiFiStateMachine::AddressKind WiFiStateMachine::classify_ip6(const uint8_t addr[16])
+{
+    if (addr[0] == 0xfe && (addr[1] & 0xc0) == 0x80) {
+        return AddressKind::IPV6_LINK_LOCAL;
+    }
+    return AddressKind::IPV6_GLOBAL;
+}
+
+bool WiFiStateMachine::record_address(AddressKind kind)
+{
+    if ((int)kind < (int)AddressKind::COUNT) {
+        m_addresses |= (uint8_t)(1U << (int)kind);
+    }
+    return is_ip_ready();
+}
+
+bool WiFiStateMachine::forget_address(AddressKind kind)
+{
+    if ((int)kind < (int)AddressKind::COUNT) {
+        m_addresses &= (uint8_t)~(1U << (int)kind);
+    }
+    return is_ip_ready();
+}
+
+void WiFiStateMachine::clear_addresses()
+{
+    m_addresses = 0;
+}
+
+bool WiFiStateMachine::is_ip_ready() const
+{
+    const uint8_t v4        = 1U << (int)AddressKind::IPV4;
+    const uint8_t v6_local  = 1U << (int)AddressKind::IPV6_LINK_LOCAL;
+    const uint8_t v6_global = 1U << (int)AddressKind::IPV6_GLOBAL;
+
+    switch (m_ip_readiness) {
+    case IpReadiness::IPV6_LINK_LOCAL:
+        return (m_addresses & v6_local) != 0;
+    case IpReadiness::IPV6_GLOBAL:
+        return (m_addresses & v6_global) != 0;
+    case IpReadiness::ANY:
+        return (m_addresses & (v4 | v6_global)) != 0;
+    case IpReadiness::IPV4:
+    default:
+        return (m_addresses & v4) != 0;
+    }
+}
+
 void WiFiStateMachine::transition_to(State next_state)
 {
     m_current_state = next_state;
@@ -193,6 +384,106 @@ bool WiFiStateMachine::handle_suspect_failure(int8_t rssi)
     return false;
 }
 
+bool WiFiStateMachine::is_phy_failure(uint8_t reason)
+{
+    return reason == WIFI_REASON_DISASSOC_PWRCAP_BAD || reason == WIFI_REASON_DISASSOC_SUPCHAN_BAD ||
+           reason == WIFI_REASON_IE_INVALID || reason == WIFI_REASON_ASSOC_FAIL;
+}
+
+bool WiFiStateMachine::record_phy_failure(uint32_t threshold)
+{
+    if (threshold == 0 || m_phy_fallback >= MAX_PHY_FALLBACK) {
+        return false;
+    }
+    if (++m_phy_failures < threshold) {
+        return false;
+    }
+    m_phy_failures = 0;
+    m_phy_fallback++;
+    return true;
+}
+
+void WiFiStateMachine::reset_phy_fallback()
+{
+    m_phy_failures = 0;
+    m_phy_fallback = 0;
+}
+
+WiFiStateMachine::PhyConfig WiFiStateMachine::effective_phy(const PhyConfig &configured) const
+{
+    if (m_phy_fallback == 0) {
+        return configured;
+    }
+
+    uint8_t protocols = configured.protocols;
+    if (protocols == 0) {
+        protocols = PhyConfig::PROTOCOL_11B | PhyConfig::PROTOCOL_11G | PhyConfig::PROTOCOL_11N;
+    }
+    protocols &= (uint8_t)~PhyConfig::PROTOCOL_11AX;
+    if (m_phy_fallback >= 2) {
+        protocols &= (uint8_t)~PhyConfig::PROTOCOL_11N;
+    }
+    // A set without 802.11b/g (only reachable from an invalid configuration) would read as the
+    // driver default, undoing the fallback
+    if ((protocols & (PhyConfig::PROTOCOL_11B | PhyConfig::PROTOCOL_11G)) == 0) {
+        protocols |= PhyConfig::PROTOCOL_11B | PhyConfig::PROTOCOL_11G;
+    }
+
+    PhyConfig phy;
+    phy.protocols = protocols;
+    phy.bandwidth = wifi_manager::Bandwidth::HT20;
+    return phy;
+}
+
+void WiFiStateMachine::record_twt_request(bool sent, bool supported)
+{
+    if (!sent) {
+        m_twt_state = supported ? TwtState::REJECTED : TwtState::UNSUPPORTED;
+        return;
+    }
+    m_twt_state = TwtState::PENDING;
+    m_twt_setups++;
+    if (m_twt_lost) {
+        m_twt_renegotiations++;
+        m_twt_lost = false;
+    }
+}
+
+bool WiFiStateMachine::record_twt_event(TwtState result)
+{
+    if (result == TwtState::OFF) {
+        // Teardown by the AP: no new request before the next association
+        if (m_twt_state != TwtState::ACTIVE) {
+            return false;
+        }
+        m_twt_state = TwtState::REJECTED;
+        return true;
+    }
+    if (m_twt_state != TwtState::PENDING) {
+        return false;
+    }
+    m_twt_state = (result == TwtState::ACTIVE) ? TwtState::ACTIVE : TwtState::REJECTED;
+    return true;
+}
+
+void WiFiStateMachine::twt_link_lost()
+{
+    if (m_twt_state == TwtState::ACTIVE) {
+        m_twt_lost = true;
+    }
+    if (m_twt_state != TwtState::UNSUPPORTED) {
+        m_twt_state = TwtState::OFF;
+    }
+}
+
+void WiFiStateMachine::reset_twt()
+{
+    m_twt_state          = TwtState::OFF;
+    m_twt_lost           = false;
+    m_twt_setups         = 0;
+    m_twt_renegotiations = 0;
+}
+
 void WiFiStateMachine::calculate_next_backoff(uint32_t &delay_ms_out)
 {
     m_retry_count++;
@@ -211,6 +502,17 @@ void WiFiStateMachine::calculate_next_backoff(uint32_t &delay_ms_out)
     m_current_state     = State::WAITING_RECONNECT;
 }
 
+void WiFiStateMachine::restore_retry_count(uint32_t retry_count)
+{
+    m_retry_count = retry_count;
+}
+
+void WiFiStateMachine::schedule_reconnect(uint32_t delay_ms)
+{
+    m_next_reconnect_ms = (esp_timer_get_time() / 1000) + delay_ms;
+    m_current_state     = State::WAITING_RECONNECT;
+}
+
 bool WiFiStateMachine::is_sta_ready() const
 {
     return s_state_props[(int)m_current_state].is_sta_ready;
@@ -221,6 +523,11 @@ bool WiFiStateMachine::is_active() const
     return s_state_props[(int)m_current_state].is_active;
 }
 
+bool WiFiStateMachine::is_connected() const
+{
+    return s_state_props[(int)m_current_state].is_connected;
+}
+
 TickType_t WiFiStateMachine::get_wait_ticks() const
 {
     // Only calculate wait time if we're in the WAITING_RECONNECT state
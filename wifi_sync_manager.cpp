@@ -1,5 +1,9 @@
+#include "sdkconfig.h"
+#define LOG_LOCAL_LEVEL CONFIG_WIFI_MANAGER_LOG_LEVEL
+
 #include "wifi_sync_manager.hpp"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 namespace wifi_manager {
 
@@ -58,7 +62,11 @@ esp_err_t WiFiSyncManager::post_message(const Message &msg)
         return ESP_ERR_INVALID_STATE;
     }
 
-    if (xQueueSend(m_command_queue, &msg, 0) != pdTRUE) {
+    // Stamp the enqueue time so the task can measure queue dwell and dispatch latency
+    Message stamped      = msg;
+    stamped.timestamp_us = (uint32_t)esp_timer_get_time();
+
+    if (xQueueSend(m_command_queue, &stamped, 0) != pdTRUE) {
         ESP_LOGE(TAG, "Command queue full, failed to post message");
         return ESP_FAIL;
     }
@@ -66,6 +74,19 @@ esp_err_t WiFiSyncManager::post_message(const Message &msg)
     return ESP_OK;
 }
 
+size_t WiFiSyncManager::drain(Message *out, size_t max)
+{
+    if (m_command_queue == nullptr) {
+        return 0;
+    }
+
+    size_t count = 0;
+    while (count < max && xQueueReceive(m_command_queue, &out[count], 0) == pdTRUE) {
+        count++;
+    }
+    return count;
+}
+
 void WiFiSyncManager::clear_bits(uint32_t bits_to_clear)
 {
     if (m_event_group != nullptr) {
@@ -0,0 +1,179 @@
+#include "wifi_timer_scheduler.hpp"
+
+namespace wifi_manager {
+
+WiFiTimerScheduler::WiFiTimerScheduler()
+    : m_heap()
+    , m_size(0)
+{
+    for (uint8_t i = 0; i < CAPACITY; i++) {
+        m_index[i] = NOT_ARMED;
+    }
+}
+
+void WiFiTimerScheduler::arm(TimerId id, int64_t deadline_us)
+{
+    if ((int)id >= CAPACITY) {
+        return;
+    }
+
+    int8_t pos = m_index[(int)id];
+    if (pos == NOT_ARMED) {
+        pos              = (int8_t)m_size++;
+        m_heap[pos]      = {deadline_us, id};
+        m_index[(int)id] = pos;
+        sift_up((uint8_t)pos);
+        return;
+    }
+
+    // Re-arm in place: the new deadline may move the entry either way
+    int64_t previous        = m_heap[pos].deadline_us;
+    m_heap[pos].deadline_us = deadline_us;
+    if (deadline_us < previous) {
+        sift_up((uint8_t)pos);
+    }
+    else {
+        sift_down((uint8_t)pos);
+    }
+}
+
+void WiFiTimerScheduler::cancel(TimerId id)
+{
+    if ((int)id >= CAPACITY || m_index[(int)id] == NOT_ARMED) {
+        return;
+    }
+    remove_at((uint8_t)m_index[(int)id]);
+}
+
+void WiFiTimerScheduler::cancel_all()
+{
+    for (uint8_t i = 0; i < CAPACITY; i++) {
+        m_index[i] = NOT_ARMED;
+    }
+    m_size = 0;
+}
+
+bool WiFiTimerScheduler::is_armed(TimerId id) const
+{
+    return (int)id < CAPACITY && m_index[(int)id] != NOT_ARMED;
+}
+
+int64_t WiFiTimerScheduler::get_deadline(TimerId id) const
+{
+    if (!is_armed(id)) {
+        return -1;
+    }
+    return m_heap[m_index[(int)id]].deadline_us;
+}
+
+TickType_t WiFiTimerScheduler::get_wait_ticks(int64_t now_us) const
+{
+    if (m_size == 0) {
+        return portMAX_DELAY;
+    }
+
+    int64_t remaining_us = m_heap[0].deadline_us - now_us;
+    if (remaining_us <= 0) {
+        return 0;
+    }
+
+    // Round up in ticks, not in milliseconds: pdMS_TO_TICKS() would truncate again and wake
+    // the task up to a tick early
+    constexpr uint64_t TICK_US = 1000000ULL / configTICK_RATE_HZ;
+    uint64_t wait_ticks        = ((uint64_t)remaining_us + TICK_US - 1) / TICK_US;
+    // Sanity check: avoid converting unreasonably large values
+    if (wait_ticks >= portMAX_DELAY) {
+        return portMAX_DELAY;
+    }
+    return (TickType_t)wait_ticks;
+}
+
+bool WiFiTimerScheduler::pop_expired(int64_t now_us, TimerId &id_out)
+{
+    if (m_size == 0 || m_heap[0].deadline_us > now_us) {
+        return false;
+    }
+    return pop_next(id_out);
+}
+
+bool WiFiTimerScheduler::pop_next(TimerId &id_out)
+{
+    if (m_size == 0) {
+        return false;
+    }
+    id_out = m_heap[0].id;
+    remove_at(0);
+    return true;
+}
+
+bool WiFiTimerScheduler::before(uint8_t a, uint8_t b) const
+{
+    // Ties are broken by TimerId so the expiry order is deterministic
+    if (m_heap[a].deadline_us != m_heap[b].deadline_us) {
+        return m_heap[a].deadline_us < m_heap[b].deadline_us;
+    }
+    return m_heap[a].id < m_heap[b].id;
+}
+
+void WiFiTimerScheduler::swap_entries(uint8_t a, uint8_t b)
+{
+    Entry tmp = m_heap[a];
+    m_heap[a] = m_heap[b];
+    m_heap[b] = tmp;
+
+    m_index[(int)m_heap[a].id] = (int8_t)a;
+    m_index[(int)m_heap[b].id] = (int8_t)b;
+}
+
+void WiFiTimerScheduler::sift_up(uint8_t pos)
+{
+    while (pos > 0) {
+        uint8_t parent = (pos - 1) / 2;
+        if (!before(pos, parent)) {
+            break;
+        }
+        swap_entries(pos, parent);
+        pos = parent;
+    }
+}
+
+void WiFiTimerScheduler::sift_down(uint8_t pos)
+{
+    while (true) {
+        uint8_t left     = 2 * pos + 1;
+        uint8_t right    = left + 1;
+        uint8_t smallest = pos;
+
+        if (left < m_size && before(left, smallest)) {
+            smallest = left;
+        }
+        if (right < m_size && before(right, smallest)) {
+            smallest = right;
+        }
+        if (smallest == pos) {
+            break;
+        }
+        swap_entries(pos, smallest);
+        pos = smallest;
+    }
+}
+
+void WiFiTimerScheduler::remove_at(uint8_t pos)
+{
+    TimerId removed = m_heap[pos].id;
+    uint8_t last    = m_size - 1;
+
+    if (pos != last) {
+        swap_entries(pos, last);
+    }
+    m_size--;
+    m_index[(int)removed] = NOT_ARMED;
+
+    // The entry moved into pos may need to go either way
+    if (pos < m_size) {
+        sift_up(pos);
+        sift_down(pos);
+    }
+}
+
+} // namespace wifi_manager
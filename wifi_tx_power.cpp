@@ -0,0 +1,66 @@
+#include "wifi_tx_power.hpp"
+
+#include <algorithm>
+
+namespace wifi_manager {
+
+WiFiTxPowerController::WiFiTxPowerController(const Config &config)
+    : m_config(config)
+    , m_power(config.max_power)
+    , m_stable(0)
+    , m_decreases(0)
+    , m_increases(0)
+{
+}
+
+bool WiFiTxPowerController::is_valid(const Config &config)
+{
+    return config.min_power >= DRIVER_MIN_POWER && config.max_power <= DRIVER_MAX_POWER &&
+           config.min_power <= config.max_power && config.step != 0;
+}
+
+int8_t WiFiTxPowerController::required_power(int8_t rssi) const
+{
+    // Path loss = max_power - rssi; the uplink arrives at power - path loss
+    int32_t required = ((int32_t)m_config.target_rssi + m_config.margin_db - rssi) * 4 + m_config.max_power;
+    return (int8_t)std::clamp<int32_t>(required, m_config.min_power, m_config.max_power);
+}
+
+bool WiFiTxPowerController::on_rssi_sample(int8_t rssi)
+{
+    int8_t required = required_power(rssi);
+
+    if (required > m_power) {
+        // The link got worse: no waiting for stability
+        m_power  = required;
+        m_stable = 0;
+        m_increases++;
+        return true;
+    }
+    if (required > m_power - m_config.step) {
+        // Not a full step of headroom: fading noise, not a better link
+        m_stable = 0;
+        return false;
+    }
+
+    if (++m_stable < m_config.stable_samples) {
+        return false;
+    }
+    m_stable = 0;
+    m_power  = (int8_t)(m_power - m_config.step);
+    m_decreases++;
+    return true;
+}
+
+bool WiFiTxPowerController::on_link_failure()
+{
+    m_stable = 0;
+    if (m_power == m_config.max_power) {
+        return false;
+    }
+    m_power = m_config.max_power;
+    m_increases++;
+    return true;
+}
+
+} // namespace wifi_manager
@@ -0,0 +1,107 @@
+#include "wifi_uplink_arbiter.hpp"
+
+namespace wifi_manager {
+
+WiFiUplinkArbiter::WiFiUplinkArbiter(uint32_t hold_ms)
+    : m_hold_us(hold_ms * 1000)
+    , m_uplinks()
+    , m_status()
+{
+    clear();
+}
+
+int8_t WiFiUplinkArbiter::add(uint8_t priority)
+{
+    if (m_status.count >= UPLINK_MAX) {
+        return NONE;
+    }
+    int8_t slot     = (int8_t)m_status.count++;
+    m_uplinks[slot] = {priority, false, true, 0};
+    return slot;
+}
+
+void WiFiUplinkArbiter::clear()
+{
+    m_status        = {};
+    m_status.active = NONE;
+}
+
+void WiFiUplinkArbiter::set_priority(int8_t slot, uint8_t priority)
+{
+    m_uplinks[slot].priority = priority;
+}
+
+void WiFiUplinkArbiter::set_ready(int8_t slot, bool ready, uint32_t now_us)
+{
+    bool was_usable       = is_usable(slot);
+    m_uplinks[slot].ready = ready;
+    update(slot, was_usable, now_us);
+}
+
+void WiFiUplinkArbiter::set_healthy(int8_t slot, bool healthy, uint32_t now_us)
+{
+    bool was_usable         = is_usable(slot);
+    m_uplinks[slot].healthy = healthy;
+    update(slot, was_usable, now_us);
+}
+
+void WiFiUplinkArbiter::update(int8_t slot, bool was_usable, uint32_t now_us)
+{
+    if (!was_usable && is_usable(slot)) {
+        m_uplinks[slot].usable_since_us = now_us;
+    }
+}
+
+int8_t WiFiUplinkArbiter::best() const
+{
+    int8_t best = NONE;
+    for (int8_t i = 0; i < (int8_t)m_status.count; i++) {
+        if (is_usable(i) && (best == NONE || m_uplinks[i].priority > m_uplinks[best].priority)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool WiFiUplinkArbiter::arbitrate(uint32_t now_us, uint32_t event_us)
+{
+    int8_t active    = m_status.active;
+    int8_t candidate = best();
+
+    if (active != NONE && is_usable(active)) {
+        // Still usable: only a preferred uplink past its hold takes over
+        if (candidate == active || m_uplinks[candidate].priority <= m_uplinks[active].priority ||
+            now_us - m_uplinks[candidate].usable_since_us < m_hold_us) {
+            return false;
+        }
+        m_status.failbacks++;
+    }
+    else if (candidate == NONE) {
+        if (active == NONE) {
+            return false;
+        }
+        m_status.outages++;
+    }
+    else if (active != NONE) {
+        m_status.failovers++;
+        m_status.failover_latency.record(now_us - event_us);
+    }
+    // else: the first usable uplink, nothing was lost
+
+    m_status.active = candidate;
+    return true;
+}
+
+bool WiFiUplinkArbiter::failback_pending(uint32_t now_us, uint32_t &remaining_us) const
+{
+    int8_t active    = m_status.active;
+    int8_t candidate = best();
+    if (active == NONE || candidate == NONE || m_uplinks[candidate].priority <= m_uplinks[active].priority) {
+        return false;
+    }
+    uint32_t held_us = now_us - m_uplinks[candidate].usable_since_us;
+    remaining_us     = held_us < m_hold_us ? m_hold_us - held_us : 0;
+    return true;
+}
+
+} // namespace wifi_manager